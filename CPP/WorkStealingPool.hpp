@@ -0,0 +1,474 @@
+#pragma once
+
+// Work-stealing thread pool for irregular work (per-point refinement that
+// converges after a varying number of iterations, RANSAC hypotheses, recursive
+// splits) where static loops and a shared OpenMP queue balance poorly.
+//
+// Every worker owns a Chase-Lev deque: it pushes and pops its own tasks at the
+// bottom (LIFO, cache warm) and, when that runs dry, steals the oldest task at
+// the top of a random victim (FIFO, usually the largest piece left). Threads
+// outside the pool submit through a locked injection queue.
+//
+//   WorkStealingPool pool;                      // one slot per core
+//   pool.parallel_for(0, n, [&](int64_t i0, int64_t i1) { ... });
+//
+//   TaskGroup g(pool);
+//   g.run([&] { left(); });
+//   g.run([&] { right(); });
+//   g.wait();                                   // helps until both are done
+//
+// parallel_for splits lazily: a range is halved (and the half pushed for
+// thieves) only while the running thread's deque is empty, otherwise it keeps
+// working through grain-sized chunks. Uniform loops end up with about one task
+// per thread; skewed ones keep splitting where the work is.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace xr {
+
+class TaskGroup;
+
+struct Task {
+  virtual ~Task() = default;
+  virtual void run() = 0;
+  TaskGroup* group = nullptr;
+};
+
+template <typename F>
+struct FnTask final : Task {
+  explicit FnTask(F fn) : f(std::move(fn)) {}
+  void run() override { f(); }
+  F f;
+};
+
+// Chase-Lev deque after Le et al., "Correct and Efficient Work-Stealing for
+// Weak Memory Models" (PPoPP 2013), with the fences folded into seq_cst
+// accesses (same code on x86, and visible to ThreadSanitizer). push / take
+// belong to the owner, steal may be called from any thread. The buffer doubles
+// when full; old buffers are kept until the deque dies because a thief may
+// still read one.
+class ChaseLevDeque {
+ public:
+  explicit ChaseLevDeque(int log_capacity = 8) {
+    buffers_.emplace_back(new Buffer(log_capacity));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+  }
+
+  ChaseLevDeque(const ChaseLevDeque&) = delete;
+  ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+  void push(Task* task) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_acquire);
+    Buffer* a = buffer_.load(std::memory_order_relaxed);
+    if (b - t > a->mask) a = grow(a, t, b);
+    a->put(b, task);
+    bottom_.store(b + 1, std::memory_order_release);
+  }
+
+  // newest task, nullptr when empty
+  Task* take() {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer* a = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_seq_cst);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    Task* task = a->get(b);
+    if (t == b) {
+      // last element: race the thieves for it
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) task = nullptr;
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  // oldest task, nullptr when empty or when another thread won the race
+  Task* steal() {
+    int64_t t = top_.load(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_seq_cst);
+    if (t >= b) return nullptr;
+    Buffer* a = buffer_.load(std::memory_order_acquire);
+    Task* task = a->get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+    return task;
+  }
+
+  // exact for the owner, a snapshot for everyone else
+  int64_t size() const {
+    const int64_t n = bottom_.load(std::memory_order_relaxed) - top_.load(std::memory_order_relaxed);
+    return n > 0 ? n : 0;
+  }
+
+ private:
+  struct Buffer {
+    explicit Buffer(int log_capacity)
+        : mask((int64_t(1) << log_capacity) - 1), slots(new std::atomic<Task*>[(size_t)mask + 1]) {}
+    Task* get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+    void put(int64_t i, Task* task) { slots[i & mask].store(task, std::memory_order_relaxed); }
+    int64_t mask;
+    std::unique_ptr<std::atomic<Task*>[]> slots;
+  };
+
+  Buffer* grow(Buffer* a, int64_t t, int64_t b) {
+    int log_capacity = 0;
+    while ((int64_t(1) << log_capacity) <= a->mask) log_capacity++;
+    buffers_.emplace_back(new Buffer(log_capacity + 1));
+    Buffer* bigger = buffers_.back().get();
+    for (int64_t i = t; i < b; i++) bigger->put(i, a->get(i));
+    buffer_.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  alignas(64) std::atomic<int64_t> top_{0};
+  alignas(64) std::atomic<int64_t> bottom_{0};
+  alignas(64) std::atomic<Buffer*> buffer_{nullptr};
+  std::vector<std::unique_ptr<Buffer>> buffers_;  // touched by the owner only
+};
+
+class WorkStealingPool {
+ public:
+  // threads <= 0 takes std::thread::hardware_concurrency(). The pool starts
+  // threads - 1 workers; slot 0 is lent to the outside thread that is waiting
+  // on the pool, so that thread works instead of blocking. With pin set,
+  // worker i is bound to the i-th CPU of the process affinity mask (Linux).
+  explicit WorkStealingPool(int threads = 0, bool pin = false) {
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < threads; i++) {
+      slots_.emplace_back(new Slot);
+      slots_.back()->rng = 0x9E3779B97F4A7C15ull * (i + 1);
+    }
+    std::vector<int> cpus = pin ? affinity_cpus() : std::vector<int>();
+    for (int i = 1; i < threads; i++) {
+      workers_.emplace_back([this, i, cpus] {
+        if (!cpus.empty()) pin_current_thread(cpus[i % cpus.size()]);
+        worker_loop(i);
+      });
+    }
+  }
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stop_.store(true, std::memory_order_release);
+    }
+    sleep_cv_.notify_all();
+    for (auto& w : workers_) w.join();
+  }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  // worker threads plus the lent slot
+  int size() const { return (int)slots_.size(); }
+
+  // successful steals since construction
+  uint64_t steals() const {
+    uint64_t n = 0;
+    for (const auto& s : slots_) n += s->steals.load(std::memory_order_relaxed);
+    return n;
+  }
+
+  // fn(i0, i1) over disjoint pieces covering [begin, end), none longer than
+  // grain unless it could not be split. grain <= 0 picks about 64 pieces per
+  // thread. Returns when every piece has run; the first exception is rethrown.
+  template <typename F>
+  void parallel_for(int64_t begin, int64_t end, int64_t grain, F&& fn);
+
+  template <typename F>
+  void parallel_for(int64_t begin, int64_t end, F&& fn) {
+    parallel_for(begin, end, 0, std::forward<F>(fn));
+  }
+
+ private:
+  friend class TaskGroup;
+
+  struct alignas(64) Slot {
+    ChaseLevDeque deque;
+    uint64_t rng = 0;
+    std::atomic<uint64_t> steals{0};
+  };
+
+  // borrows slot 0 for an outside thread for the scope's lifetime, if it is
+  // free; nested scopes and pool threads keep what they have
+  class SlotScope {
+   public:
+    explicit SlotScope(WorkStealingPool& pool) : pool_(pool) {
+      if (tls_pool_ == &pool || pool.master_busy_.exchange(true, std::memory_order_acquire)) return;
+      saved_pool_ = tls_pool_;
+      saved_slot_ = tls_slot_;
+      tls_pool_ = &pool;
+      tls_slot_ = 0;
+      owner_ = true;
+    }
+    ~SlotScope() {
+      if (!owner_) return;
+      tls_pool_ = saved_pool_;
+      tls_slot_ = saved_slot_;
+      pool_.master_busy_.store(false, std::memory_order_release);
+    }
+    SlotScope(const SlotScope&) = delete;
+    SlotScope& operator=(const SlotScope&) = delete;
+
+   private:
+    WorkStealingPool& pool_;
+    WorkStealingPool* saved_pool_ = nullptr;
+    int saved_slot_ = -1;
+    bool owner_ = false;
+  };
+
+  static constexpr int kIdleSpins = 64;
+
+  int current_slot() const { return tls_pool_ == this ? tls_slot_ : -1; }
+
+  void spawn(Task* task) {
+    const int self = current_slot();
+    if (self >= 0) {
+      slots_[self]->deque.push(task);
+    } else {
+      std::lock_guard<std::mutex> lock(inject_mutex_);
+      inject_.push_back(task);
+      inject_size_.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake_one();
+  }
+
+  // A sleeper bumps sleeping_ and then reads epoch_; a spawner bumps epoch_
+  // and then reads sleeping_. Both are seq_cst, so either the spawner sees the
+  // sleeper or the sleeper sees the new epoch, and no wakeup is lost.
+  void wake_one() {
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_seq_cst) == 0) return;
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    sleep_cv_.notify_one();
+  }
+
+  Task* find_task(int self) {
+    if (self >= 0) {
+      if (Task* task = slots_[self]->deque.take()) return task;
+    }
+    if (inject_size_.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(inject_mutex_);
+      if (!inject_.empty()) {
+        Task* task = inject_.front();
+        inject_.pop_front();
+        inject_size_.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+      }
+    }
+    const int n = size();
+    uint64_t& rng = self >= 0 ? slots_[self]->rng : tls_rng_;
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    const int start = (int)(rng % (uint64_t)n);
+    for (int k = 0; k < n; k++) {
+      const int victim = (start + k) % n;
+      if (victim == self) continue;
+      if (Task* task = slots_[victim]->deque.steal()) {
+        if (self >= 0) slots_[self]->steals.fetch_add(1, std::memory_order_relaxed);
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  void execute(Task* task);
+
+  // runs tasks (any group's) until pending drops to 0
+  void help_until_done(const std::atomic<int64_t>& pending) {
+    SlotScope scope(*this);
+    const int self = current_slot();
+    while (pending.load(std::memory_order_acquire) > 0) {
+      if (Task* task = find_task(self)) {
+        execute(task);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  template <typename F>
+  void run_range(TaskGroup& group, int64_t begin, int64_t end, int64_t grain, F& fn);
+
+  void worker_loop(int self) {
+    tls_pool_ = this;
+    tls_slot_ = self;
+    int idle = 0;
+    while (!stop_.load(std::memory_order_acquire)) {
+      if (Task* task = find_task(self)) {
+        execute(task);
+        idle = 0;
+        continue;
+      }
+      if (++idle < kIdleSpins) {
+        std::this_thread::yield();
+        continue;
+      }
+      sleeping_.fetch_add(1, std::memory_order_seq_cst);
+      const uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+      if (Task* task = find_task(self)) {
+        sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        execute(task);
+        idle = 0;
+        continue;
+      }
+      {
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.wait(lock, [&] {
+          return epoch_.load(std::memory_order_seq_cst) != epoch || stop_.load(std::memory_order_acquire);
+        });
+      }
+      sleeping_.fetch_sub(1, std::memory_order_relaxed);
+      idle = 0;
+    }
+  }
+
+  static std::vector<int> affinity_cpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+      for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &mask)) cpus.push_back(c);
+      }
+    }
+#endif
+    return cpus;
+  }
+
+  static void pin_current_thread(int cpu) {
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+#else
+    (void)cpu;
+#endif
+  }
+
+  std::vector<std::unique_ptr<Slot>> slots_;
+  std::vector<std::thread> workers_;
+  std::atomic<bool> master_busy_{false};
+
+  std::mutex inject_mutex_;
+  std::deque<Task*> inject_;
+  std::atomic<int64_t> inject_size_{0};
+
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  std::atomic<uint64_t> epoch_{0};
+  std::atomic<int> sleeping_{0};
+  std::atomic<bool> stop_{false};
+
+  inline static thread_local WorkStealingPool* tls_pool_ = nullptr;
+  inline static thread_local int tls_slot_ = -1;
+  inline static thread_local uint64_t tls_rng_ = 0x2545F4914F6CDD1Dull;
+};
+
+// A set of tasks joined together. wait() runs pool work until every task of
+// the group has finished and rethrows the first exception one of them threw;
+// the destructor waits too but drops the exception. Tasks may create and wait
+// on their own groups.
+class TaskGroup {
+ public:
+  explicit TaskGroup(WorkStealingPool& pool) : pool_(pool) {}
+  ~TaskGroup() { pool_.help_until_done(pending_); }
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  template <typename F>
+  void run(F&& fn) {
+    Task* task = new FnTask<std::decay_t<F>>(std::forward<F>(fn));
+    task->group = this;
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.spawn(task);
+  }
+
+  void wait() {
+    pool_.help_until_done(pending_);
+    if (!failed_.load(std::memory_order_acquire)) return;
+    std::exception_ptr error;
+    {
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      std::swap(error, error_);
+      failed_.store(false, std::memory_order_relaxed);
+    }
+    if (error) std::rethrow_exception(error);
+  }
+
+ private:
+  friend class WorkStealingPool;
+
+  void record(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    if (!error_) error_ = std::move(error);
+    failed_.store(true, std::memory_order_release);
+  }
+
+  WorkStealingPool& pool_;
+  std::atomic<int64_t> pending_{0};
+  std::mutex error_mutex_;  // taken only once something has thrown
+  std::exception_ptr error_;
+  std::atomic<bool> failed_{false};
+};
+
+inline void WorkStealingPool::execute(Task* task) {
+  TaskGroup* group = task->group;
+  try {
+    task->run();
+  } catch (...) {
+    group->record(std::current_exception());
+  }
+  delete task;
+  group->pending_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+template <typename F>
+void WorkStealingPool::run_range(TaskGroup& group, int64_t begin, int64_t end, int64_t grain, F& fn) {
+  const int self = current_slot();
+  while (end - begin > grain) {
+    if (self >= 0 && slots_[self]->deque.size() > 0) {
+      // thieves have not taken what is already queued: no demand, keep going
+      fn(begin, begin + grain);
+      begin += grain;
+      continue;
+    }
+    const int64_t mid = begin + (end - begin) / 2;
+    group.run([this, &group, &fn, mid, end, grain] { run_range(group, mid, end, grain, fn); });
+    end = mid;
+  }
+  fn(begin, end);
+}
+
+template <typename F>
+void WorkStealingPool::parallel_for(int64_t begin, int64_t end, int64_t grain, F&& fn) {
+  if (end <= begin) return;
+  if (grain <= 0) grain = std::max<int64_t>(1, (end - begin) / ((int64_t)size() * 64));
+  SlotScope scope(*this);
+  TaskGroup group(*this);
+  run_range(group, begin, end, grain, fn);
+  group.wait();
+}
+
+}  // namespace xr
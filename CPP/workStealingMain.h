@@ -0,0 +1,263 @@
+#pragma once
+
+// Checks WorkStealingPool (every index of parallel_for visited once, nested
+// task groups, exceptions, outside threads sharing a pool), then times skewed
+// workloads against OpenMP static, dynamic and guided loops and OpenMP tasks:
+//
+//   flow refine   20000 points, most converge in a few iterations, clustered
+//                 occlusion regions need 60x more
+//   ransac        4096 hypotheses whose cost ramps up with the index
+//   random cost   heavy-tailed per-item cost, no structure
+//   tree          unbalanced recursive split, task groups vs omp task
+//
+// For the pool's pinning to mean anything, let OpenMP pin too:
+//   OMP_PROC_BIND=close OMP_PLACES=cores ./ws_demo
+//
+// g++ -O3 -fopenmp -std=c++17 -pthread main.cpp -o ws_demo
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "WorkStealingPool.hpp"
+
+namespace xr {
+
+// iters rounds of dependent arithmetic, about 10 ns each
+inline double ws_burn(int iters, double x) {
+  for (int i = 0; i < iters; i++) x = x * 0.999999 + std::sqrt(x + 1.0);
+  return x;
+}
+
+inline std::vector<int> ws_costs(const char* kind, int n) {
+  std::vector<int> cost(n);
+  uint32_t seed = 12345;
+  for (int i = 0; i < n; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    const double u = (seed >> 8) * (1.0 / (1 << 24));
+    if (kind[0] == 'f') {
+      // flow: 3..6 iterations, 300 in clusters of 120 points every 2000
+      cost[i] = i % 2000 < 120 ? 300 : 3 + (int)(u * 4);
+    } else if (kind[0] == 'r') {
+      cost[i] = 1 + (int)(200.0 * i / n);
+    } else {
+      // Pareto-like, capped so one item cannot dominate
+      cost[i] = std::min(5000, (int)(5.0 / std::pow(1.0 - u * 0.999, 1.5)));
+    }
+  }
+  return cost;
+}
+
+// unbalanced tree: 4-ary for 4 levels, then a hash-chosen 0 or 2..4
+// children (about one on average) down to depth 40, so subtrees range from a
+// single node to thousands
+inline int ws_children(int depth, uint32_t id) {
+  if (depth < 4) return 4;
+  if (depth >= 40) return 0;
+  uint32_t h = id * 2654435761u ^ (uint32_t)depth * 40503u;
+  h ^= h >> 15;
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  return h % 3 == 0 ? 2 + (int)((h >> 8) % 3) : 0;
+}
+
+inline double ws_tree_serial(int depth, uint32_t id) {
+  double s = ws_burn(200, id);
+  const int c = ws_children(depth, id);
+  for (int k = 0; k < c; k++) s += ws_tree_serial(depth + 1, id * 5 + k + 1);
+  return s;
+}
+
+inline double ws_tree_pool(WorkStealingPool& pool, int depth, uint32_t id) {
+  double s = ws_burn(200, id);
+  const int c = ws_children(depth, id);
+  if (c == 0) return s;
+  double part[4] = {};
+  TaskGroup g(pool);
+  for (int k = 1; k < c; k++) g.run([&pool, &part, depth, id, k] { part[k] = ws_tree_pool(pool, depth + 1, id * 5 + k + 1); });
+  part[0] = ws_tree_pool(pool, depth + 1, id * 5 + 1);
+  g.wait();
+  return s + part[0] + part[1] + part[2] + part[3];
+}
+
+inline double ws_tree_omp(int depth, uint32_t id) {
+  double s = ws_burn(200, id);
+  const int c = ws_children(depth, id);
+  double part[4] = {};
+  for (int k = 0; k < c; k++) {
+#pragma omp task default(none) shared(part) firstprivate(depth, id, k)
+    part[k] = ws_tree_omp(depth + 1, id * 5 + k + 1);
+  }
+#pragma omp taskwait
+  return s + part[0] + part[1] + part[2] + part[3];
+}
+
+inline int ws_fib(WorkStealingPool& pool, int n) {
+  if (n < 2) return n;
+  int a = 0, b = 0;
+  TaskGroup g(pool);
+  g.run([&] { a = ws_fib(pool, n - 1); });
+  b = ws_fib(pool, n - 2);
+  g.wait();
+  return a + b;
+}
+
+inline bool ws_check(WorkStealingPool& pool) {
+  bool ok = true;
+  std::atomic<bool> pieces_ok{true};
+  for (int64_t n : {0, 1, 7, 1000, 100003}) {
+    for (int64_t grain : {0, 1, 13, 1 << 20}) {
+      std::unique_ptr<std::atomic<int>[]> hits(new std::atomic<int>[(size_t)n + 1]);
+      for (int64_t i = 0; i < n; i++) hits[i] = 0;
+      pool.parallel_for(0, n, grain, [&](int64_t i0, int64_t i1) {
+        if (i0 >= i1 || (grain > 0 && i1 - i0 > grain)) pieces_ok = false;
+        for (int64_t i = i0; i < i1; i++) hits[i]++;
+      });
+      for (int64_t i = 0; i < n; i++) ok &= hits[i] == 1;
+    }
+  }
+  ok &= pieces_ok;
+
+  ok &= ws_fib(pool, 20) == 6765;
+  ok &= std::fabs(ws_tree_pool(pool, 0, 0) - ws_tree_serial(0, 0)) < 1e-6 * ws_tree_serial(0, 0);
+
+  bool caught = false;
+  try {
+    pool.parallel_for(0, 1000, 1, [](int64_t i0, int64_t) {
+      if (i0 == 500) throw std::runtime_error("item 500");
+    });
+  } catch (const std::runtime_error&) {
+    caught = true;
+  }
+  ok &= caught;
+
+  // two outside threads at once: one borrows slot 0, the other goes through
+  // the injection queue
+  std::atomic<int64_t> total{0};
+  std::vector<std::thread> callers;
+  for (int t = 0; t < 2; t++) {
+    callers.emplace_back([&] {
+      for (int rep = 0; rep < 20; rep++) {
+        pool.parallel_for(0, 10000, 16, [&](int64_t i0, int64_t i1) { total += i1 - i0; });
+      }
+    });
+  }
+  for (auto& c : callers) c.join();
+  ok &= total == 2 * 20 * 10000;
+  return ok;
+}
+
+inline double ws_now_ms() {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F>
+inline double ws_time_ms(F&& f) {
+  f();
+  int runs = 0;
+  double t0 = ws_now_ms();
+  do {
+    f();
+    runs++;
+  } while (ws_now_ms() - t0 < 100.0);
+  return (ws_now_ms() - t0) / runs;
+}
+
+}  // namespace xr
+
+inline int workStealingMain() {
+  using namespace xr;
+
+  bool pass = true;
+  for (int threads : {1, 2, 4, 0}) {
+    WorkStealingPool pool(threads, threads == 0);
+    bool ok = ws_check(pool);
+    pass &= ok;
+    printf("pool of %2d%s %s\n", pool.size(), threads == 0 ? " (pinned)" : "         ", ok ? "ok" : "FAILED");
+  }
+
+  WorkStealingPool pool(0, true);
+#ifdef _OPENMP
+  const int omp_threads = omp_get_max_threads();
+#else
+  const int omp_threads = 1;
+#endif
+  printf("\npool %d threads, OpenMP %d threads, ms (speedup over serial)\n", pool.size(), omp_threads);
+
+  const char* kinds[] = {"flow refine", "ransac", "random cost"};
+  const int sizes[] = {20000, 4096, 50000};
+  for (int w = 0; w < 3; w++) {
+    const int n = sizes[w];
+    const std::vector<int> cost = ws_costs(kinds[w], n);
+    std::vector<double> out(n);
+    auto item = [&](int64_t i) { out[i] = ws_burn(cost[i], (double)i); };
+
+    struct Variant {
+      const char* name;
+      std::function<void()> run;
+    };
+    const Variant variants[] = {
+        {"serial", [&] { for (int i = 0; i < n; i++) item(i); }},
+        {"omp static",
+         [&] {
+#pragma omp parallel for schedule(static)
+           for (int i = 0; i < n; i++) item(i);
+         }},
+        {"omp dynamic,1",
+         [&] {
+#pragma omp parallel for schedule(dynamic, 1)
+           for (int i = 0; i < n; i++) item(i);
+         }},
+        {"omp dynamic,16",
+         [&] {
+#pragma omp parallel for schedule(dynamic, 16)
+           for (int i = 0; i < n; i++) item(i);
+         }},
+        {"omp guided",
+         [&] {
+#pragma omp parallel for schedule(guided)
+           for (int i = 0; i < n; i++) item(i);
+         }},
+        {"steal for",
+         [&] {
+           pool.parallel_for(0, n, [&](int64_t i0, int64_t i1) {
+             for (int64_t i = i0; i < i1; i++) item(i);
+           });
+         }},
+    };
+
+    double serial = 0.0;
+    printf("\n%s, n %d\n", kinds[w], n);
+    for (const Variant& v : variants) {
+      const uint64_t steals = pool.steals();
+      double ms = ws_time_ms(v.run);
+      if (serial == 0.0) serial = ms;
+      printf("  %-16s %9.2f (%5.2fx)", v.name, ms, serial / ms);
+      if (v.name[0] == 's' && v.name[1] == 't') printf("  %llu steals", (unsigned long long)(pool.steals() - steals));
+      printf("\n");
+    }
+  }
+
+  double ref = 0.0, got = 0.0;
+  double serial = ws_time_ms([&] { ref = ws_tree_serial(0, 0); });
+  double omp = ws_time_ms([&] {
+#pragma omp parallel
+#pragma omp single
+    got = ws_tree_omp(0, 0);
+  });
+  pass &= std::fabs(got - ref) < 1e-6 * ref;
+  double steal = ws_time_ms([&] { got = ws_tree_pool(pool, 0, 0); });
+  pass &= std::fabs(got - ref) < 1e-6 * ref;
+  printf("\ntree\n  %-16s %9.2f\n  %-16s %9.2f (%5.2fx)\n  %-16s %9.2f (%5.2fx)\n", "serial", serial, "omp task", omp,
+         serial / omp, "task group", steal, serial / steal);
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
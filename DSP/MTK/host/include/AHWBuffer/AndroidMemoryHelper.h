@@ -0,0 +1,19 @@
+#ifndef ANDROIDMEMORYHELPER_H_
+#define ANDROIDMEMORYHELPER_H_
+// Host stand-in with the interface of lib64/AHWBuffer/AndroidMemoryHelper.h;
+// buffers are memfds instead of gralloc / ion.
+#include <android/hardware_buffer.h>
+class AndroidMemoryHelper
+{
+public:
+    AndroidMemoryHelper();
+    virtual ~AndroidMemoryHelper();
+    bool mem_alloc(unsigned int length, bool cacheable, AHardwareBuffer** buffer, int *buf_share_fd, void **buf_va);
+    void mem_free(AHardwareBuffer* buffer);
+    bool mem_cache_sync(AHardwareBuffer* buffer);
+
+    int getHandleId();
+private:
+    AHardwareBuffer_Desc desc;
+};
+#endif
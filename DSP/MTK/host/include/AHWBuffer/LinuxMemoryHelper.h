@@ -0,0 +1,86 @@
+#ifndef LINUXMEMORYHELPER_H_
+#define LINUXMEMORYHELPER_H_
+// Linux counterpart of AndroidMemoryHelper: fd-backed buffers that any process
+// holding the fd can mmap. The fd is a dma-buf made with /dev/udmabuf when that
+// device is usable, a sealed memfd otherwise; CPU access is bracketed with
+// DMA_BUF_IOCTL_SYNC on dma-bufs, as the device helper does.
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#define LINUX_SYNC_READ 1
+#define LINUX_SYNC_WRITE 2
+#define LINUX_SYNC_RW (LINUX_SYNC_READ | LINUX_SYNC_WRITE)
+
+struct LinuxBuffer {
+    int fd;       // shareable fd, owned by the buffer
+    size_t size;  // mapped length, a whole number of pages
+    void *va;
+    bool dmabuf;  // fd is a dma-buf and takes sync ioctls
+};
+
+class LinuxMemoryHelper
+{
+public:
+    explicit LinuxMemoryHelper(bool use_udmabuf = true);
+    virtual ~LinuxMemoryHelper();
+    // cacheable is kept for AndroidMemoryHelper parity; host pages are always
+    // cached and the begin / end brackets do the maintenance dma-bufs need
+    bool mem_alloc(unsigned int length, bool cacheable, LinuxBuffer** buffer, int *buf_share_fd, void **buf_va);
+    // maps an fd received from another process, taking ownership of it on
+    // success; length 0 maps the whole file
+    bool mem_import(int fd, unsigned int length, LinuxBuffer** buffer, void **buf_va);
+    void mem_free(LinuxBuffer* buffer);
+    bool mem_begin_cpu_access(LinuxBuffer* buffer, int flags);
+    bool mem_end_cpu_access(LinuxBuffer* buffer, int flags);
+    bool mem_cache_sync(LinuxBuffer* buffer);
+
+    bool has_udmabuf() const { return udmabuf_dev >= 0; }
+private:
+    int udmabuf_dev;
+};
+
+// fd passing over AF_UNIX sockets (SCM_RIGHTS). Up to LINUX_MAX_SEND_FDS fds
+// travel with size bytes of data; recv returns the fd count or -1, and the data
+// is received whole.
+#define LINUX_MAX_SEND_FDS 16
+bool linux_send_fds(int sock, const int *fds, int count, const void *data, size_t size);
+int linux_recv_fds(int sock, int *fds, int max_count, void *data, size_t size);
+bool linux_send_all(int sock, const void *data, size_t size);
+bool linux_recv_all(int sock, void *data, size_t size);
+
+// Fixed set of equally sized buffers, allocated once and reused. The owning
+// process create()s the pool and share()s it over a socket once; the peer
+// attach()es and from then on only buffer indices need to cross the socket.
+// acquire / release keep the free list of the owning side (thread safe).
+class LinuxBufferPool
+{
+public:
+    explicit LinuxBufferPool(LinuxMemoryHelper &helper) : helper(helper) {}
+    ~LinuxBufferPool();
+    bool create(unsigned int length, int count, bool cacheable = true);
+    bool share(int sock) const;
+    bool attach(int sock);
+
+    int acquire();
+    int try_acquire();
+    void release(int index);
+
+    int count() const { return (int)buffers.size(); }
+    unsigned int length() const { return bytes; }
+    LinuxBuffer *at(int index) const { return buffers[index]; }
+    void *data(int index) const { return buffers[index]->va; }
+private:
+    void clear();
+
+    LinuxMemoryHelper &helper;
+    std::vector<LinuxBuffer*> buffers;
+    unsigned int bytes = 0;
+    std::vector<int> free_list;
+    std::mutex m;
+    std::condition_variable cv;
+};
+#endif
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for lib64/AHWBuffer/hardware_buffer.h (the vndk additions to
+ * the NDK header). Nothing beyond the NDK subset is needed on the host.
+ */
+#ifndef MCVE_HOST_AHWBUFFER_HARDWARE_BUFFER_H_
+#define MCVE_HOST_AHWBUFFER_HARDWARE_BUFFER_H_
+
+#include <android/hardware_buffer.h>
+
+#endif  // MCVE_HOST_AHWBUFFER_HARDWARE_BUFFER_H_
@@ -0,0 +1,43 @@
+/*
+ * Host stand-in for the subset of <android/hardware_buffer.h> that
+ * AndroidMemoryHelper uses: BLOB buffers backed by a Linux memfd, so the fd
+ * handed to mcvMemImport maps the same pages.
+ */
+#ifndef MCVE_HOST_ANDROID_HARDWARE_BUFFER_H_
+#define MCVE_HOST_ANDROID_HARDWARE_BUFFER_H_
+
+#include <cstdint>
+
+enum {
+    AHARDWAREBUFFER_FORMAT_BLOB = 0x21,
+};
+
+enum {
+    AHARDWAREBUFFER_USAGE_CPU_READ_RARELY = 2UL,
+    AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN = 3UL,
+    AHARDWAREBUFFER_USAGE_CPU_WRITE_RARELY = 2UL << 4,
+    AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN = 3UL << 4,
+};
+
+typedef struct AHardwareBuffer_Desc {
+    uint32_t width;
+    uint32_t height;
+    uint32_t layers;
+    uint32_t format;
+    uint64_t usage;
+    uint32_t stride;
+    uint32_t rfu0;
+    uint64_t rfu1;
+} AHardwareBuffer_Desc;
+
+typedef struct AHardwareBuffer AHardwareBuffer;
+
+int AHardwareBuffer_allocate(const AHardwareBuffer_Desc *desc, AHardwareBuffer **out_buffer);
+void AHardwareBuffer_release(AHardwareBuffer *buffer);
+int AHardwareBuffer_lock(AHardwareBuffer *buffer, uint64_t usage, int32_t fence, const void *rect,
+                         void **out_virtual_address);
+int AHardwareBuffer_unlock(AHardwareBuffer *buffer, int32_t *fence);
+// host only: the memfd behind the buffer
+int AHardwareBuffer_getFd(const AHardwareBuffer *buffer);
+
+#endif  // MCVE_HOST_ANDROID_HARDWARE_BUFFER_H_
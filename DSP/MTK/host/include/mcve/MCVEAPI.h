@@ -0,0 +1,63 @@
+/*
+ * Host stand-in for the MCVE runtime API.
+ *
+ * Declares the part of the API the demos in DSP/MTK use, so that
+ * main/swat_add_main.cpp and mtk_device_demo/kernel_api_w_ahwbuffer/src/main.cpp
+ * build and run unmodified on Linux. The "device" is a thread pool on the
+ * host; see host/README.txt for how it maps the device semantics.
+ *
+ * Error codes are host values: MCV_SUCCESS is 0 as on the device, the
+ * others are negative.
+ */
+#ifndef MCVE_HOST_MCVEAPI_H_
+#define MCVE_HOST_MCVEAPI_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#define MCV_SUCCESS 0
+#define MCV_ERROR_INVALID_VALUE (-1)
+#define MCV_ERROR_OUT_OF_MEMORY (-2)
+#define MCV_ERROR_INVALID_BINARY (-3)
+#define MCV_ERROR_KERNEL_FAILED (-4)
+
+typedef enum {
+    // cached memory: the device works on its own copy, synced explicitly
+    MCV_BUF_TYPE_DEFAULT = 0,
+    // shared memory: host and device see the same pages, syncs only order
+    MCV_BUF_TYPE_DMA = 1,
+} mcv_buf_type_t;
+
+typedef struct mcv_env_s mcv_env_t;
+typedef struct mcv_buffer_s mcv_buffer_t;
+typedef struct mcv_algo_s mcv_algo_t;
+typedef struct mcv_event_s *mcv_event_t;
+
+int mcvInitEnv(mcv_env_t **env);
+int mcvDeinitEnv(mcv_env_t *env);
+
+mcv_buffer_t *mcvMemAlloc(mcv_env_t *env, size_t size, int *err, const char *name, mcv_buf_type_t type);
+// maps the memory behind *fd (an AHardwareBuffer / dma-buf fd on the device,
+// a memfd here); host and device share it
+mcv_buffer_t *mcvMemImport(mcv_env_t *env, size_t size, const int *fd, int *err, const char *name);
+int mcvMemFree(mcv_buffer_t *buffer);
+int mcvMemUnImport(mcv_buffer_t *buffer);
+void *getHostPtr(mcv_buffer_t *buffer);
+
+int mcvSyncBufferHostToDevice(mcv_env_t *env, mcv_buffer_t *buffer);
+int mcvSyncBufferDeviceToHost(mcv_env_t *env, mcv_buffer_t *buffer);
+
+// binary is what gen_mcve_binary produced on the device; on the host it is
+// the kernel's JSON spec (or just its entry name), which selects a registered
+// CPU implementation. Scalar parameters are copied here, buffers are bound.
+mcv_algo_t *mcvCreateCustomAlgo(mcv_env_t *env, const void *binary, size_t binary_size, mcv_buffer_t **buffers,
+                                size_t buffer_count, void **params, size_t param_count, int *err);
+int mcvReleaseAlgo(mcv_algo_t *algo);
+
+// Queues one run that starts once every event of wait_list has completed;
+// *event (may be null) completes when the run has finished.
+int mcvRunAlgo(mcv_algo_t *algo, uint32_t wait_count, const mcv_event_t *wait_list, mcv_event_t *event);
+int mcvWaitForEvents(uint32_t count, const mcv_event_t *events);
+int mcvReleaseEvent(mcv_event_t *event);
+
+#endif  // MCVE_HOST_MCVEAPI_H_
@@ -0,0 +1,54 @@
+/*
+ * Host-only extensions of the MCVE stand-in: registering CPU implementations
+ * of custom kernels, and the timing of every sync and run.
+ *
+ * Environment variables read by mcvInitEnv:
+ *   MCVE_HOST_THREADS   pool workers that run algos (default: one per core)
+ *   MCVE_HOST_PROFILE   when set, mcvDeinitEnv prints the timing summary
+ */
+#ifndef MCVE_HOST_MCVE_HOST_H_
+#define MCVE_HOST_MCVE_HOST_H_
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "mcve/MCVEAPI.h"
+
+// What a kernel sees: device pointers and sizes of the bound buffers in
+// kernel argument order, and the copied scalar parameters.
+struct McvHostArgs {
+    std::vector<void *> buffers;
+    std::vector<size_t> sizes;
+    std::vector<const void *> params;
+
+    template <typename T>
+    T *buffer(size_t i) const { return static_cast<T *>(buffers[i]); }
+    template <typename T>
+    T param(size_t i) const { return *static_cast<const T *>(params[i]); }
+};
+
+// returns MCV_SUCCESS or an error code, which the run's event then carries
+using McvHostKernel = std::function<int(const McvHostArgs &)>;
+
+// Registers (or replaces) the CPU implementation of kernel entry name. It
+// takes buffer_count buffers and one scalar per entry of param_sizes, in
+// bytes. vector_add and CustomKernel are registered by default.
+void mcvHostRegisterAlgo(const char *name, size_t buffer_count, const std::vector<size_t> &param_sizes,
+                         McvHostKernel kernel);
+
+struct McvHostRecord {
+    std::string op;    // "h2d", "d2h", "run"
+    std::string name;  // buffer name or kernel entry name
+    size_t bytes = 0;
+    double queued_ms = 0.0;  // run: from mcvRunAlgo until it started
+    double ms = 0.0;         // the copy, or the kernel's execution
+};
+
+// every sync and run of the environment so far, in completion order
+std::vector<McvHostRecord> mcvHostProfile(mcv_env_t *env);
+// count, total, mean and max per (op, name)
+void mcvHostPrintProfile(mcv_env_t *env, FILE *out);
+
+#endif  // MCVE_HOST_MCVE_HOST_H_
@@ -0,0 +1,10 @@
+/*
+ * On the device mcve_shim.h resolves the MCVE API with dlopen. The host
+ * stand-in is linked in directly, so the shim is just the API.
+ */
+#ifndef MCVE_HOST_MCVE_SHIM_H_
+#define MCVE_HOST_MCVE_SHIM_H_
+
+#include "mcve/MCVEAPI.h"
+
+#endif  // MCVE_HOST_MCVE_SHIM_H_
@@ -0,0 +1,129 @@
+// Host version of lib64/AHWBuffer/AndroidMemoryHelper.cpp: the AHardwareBuffer
+// is a memfd mapped MAP_SHARED, and its fd is what mem_alloc hands out, so
+// mcvMemImport maps the very same pages (no copy), as ion / dma-buf fds do on
+// the device.
+#include "AHWBuffer/AndroidMemoryHelper.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#define INVALID_ID -1
+
+struct AHardwareBuffer {
+    int fd;
+    size_t size;
+    void *va;
+};
+
+static int host_memfd(const char *name) {
+#ifdef SYS_memfd_create
+    return (int)syscall(SYS_memfd_create, name, 0);
+#else
+    (void)name;
+    char path[] = "/tmp/ahwb-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) unlink(path);
+    return fd;
+#endif
+}
+
+int AHardwareBuffer_allocate(const AHardwareBuffer_Desc *desc, AHardwareBuffer **out_buffer) {
+    if (desc == nullptr || out_buffer == nullptr || desc->format != AHARDWAREBUFFER_FORMAT_BLOB) return -1;
+    *out_buffer = nullptr;
+    const size_t size = (size_t)desc->width * desc->height * desc->layers;
+    if (size == 0) return -1;
+    int fd = host_memfd("AHardwareBuffer");
+    if (fd < 0) return -1;
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return -1;
+    }
+    void *va = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (va == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    *out_buffer = new AHardwareBuffer{fd, size, va};
+    return 0;
+}
+
+void AHardwareBuffer_release(AHardwareBuffer *buffer) {
+    if (buffer == nullptr) return;
+    munmap(buffer->va, buffer->size);
+    close(buffer->fd);
+    delete buffer;
+}
+
+int AHardwareBuffer_lock(AHardwareBuffer *buffer, uint64_t usage, int32_t fence, const void *rect,
+                         void **out_virtual_address) {
+    (void)usage;
+    (void)rect;
+    if (buffer == nullptr || out_virtual_address == nullptr) return -1;
+    if (fence >= 0) close(fence);
+    *out_virtual_address = buffer->va;
+    return 0;
+}
+
+int AHardwareBuffer_unlock(AHardwareBuffer *buffer, int32_t *fence) {
+    if (buffer == nullptr) return -1;
+    if (fence != nullptr) *fence = -1;
+    return 0;
+}
+
+int AHardwareBuffer_getFd(const AHardwareBuffer *buffer) {
+    return buffer == nullptr ? INVALID_ID : buffer->fd;
+}
+
+AndroidMemoryHelper::AndroidMemoryHelper() {
+    memset(&desc, 0, sizeof(AHardwareBuffer_Desc));
+}
+
+AndroidMemoryHelper::~AndroidMemoryHelper() {}
+
+// Same contract as the device version: a BLOB buffer of length bytes, its
+// shareable fd and a CPU pointer that stays valid until mem_free.
+bool AndroidMemoryHelper::mem_alloc(unsigned int length, bool cacheable, AHardwareBuffer** buffer, int *buf_share_fd, void **buf_va){
+    uint64_t usage = 0;
+    if (cacheable) {
+        usage = AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN | AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN;
+    } else {
+        usage = AHARDWAREBUFFER_USAGE_CPU_READ_RARELY | AHARDWAREBUFFER_USAGE_CPU_WRITE_RARELY;
+    }
+    memset(&desc, 0, sizeof(AHardwareBuffer_Desc));
+    desc.width = length;
+    desc.format = AHARDWAREBUFFER_FORMAT_BLOB;
+    desc.height = 1;
+    desc.layers = 1;
+    desc.usage = usage;
+    desc.stride = length;
+    if (AHardwareBuffer_allocate(&desc, buffer) != 0) {
+        fprintf(stderr, "Can't acquire AHardwareBuffer\n");
+        return false;
+    }
+    *buf_share_fd = AHardwareBuffer_getFd(*buffer);
+    if (AHardwareBuffer_lock(*buffer, desc.usage, INVALID_ID, nullptr, buf_va) != 0) {
+        AHardwareBuffer_release(*buffer);
+        return false;
+    }
+    int32_t fence = -1;
+    AHardwareBuffer_unlock(*buffer, &fence);
+    return true;
+}
+
+// MAP_SHARED memory is coherent on the host
+bool AndroidMemoryHelper::mem_cache_sync(AHardwareBuffer* buffer){
+    return buffer != nullptr;
+}
+
+void AndroidMemoryHelper::mem_free(AHardwareBuffer* buffer) {
+    AHardwareBuffer_release(buffer);
+}
+
+int AndroidMemoryHelper::getHandleId() {
+    return INVALID_ID;
+}
@@ -0,0 +1,387 @@
+// Linux shared buffers in the shape of lib64/AHWBuffer/AndroidMemoryHelper.cpp.
+// A buffer is a memfd; with /dev/udmabuf it is wrapped into a dma-buf, which
+// is what a V4L2 or DRM driver on the other end can import, and whose CPU
+// access is bracketed with DMA_BUF_IOCTL_SYNC. Plain memfds are coherent and
+// their brackets only order memory. Either fd can be mmapped by any process it
+// is passed to, so frames move between processes without a copy.
+#include "AHWBuffer/LinuxMemoryHelper.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#define INVALID_ID -1
+
+// dma-buf sync and udmabuf structures from the Linux uapi headers
+struct dma_buf_sync {
+    uint64_t flags;
+};
+#define DMA_BUF_BASE 'b'
+#define DMA_BUF_SYNC_END (1 << 2)
+#define DMA_BUF_SYNC_START (0 << 2)
+#define DMA_BUF_SYNC_READ (1 << 0)
+#define DMA_BUF_SYNC_WRITE (2 << 0)
+#define DMA_BUF_IOCTL_SYNC _IOW(DMA_BUF_BASE, 0, struct dma_buf_sync)
+
+struct udmabuf_create {
+    uint32_t memfd;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t size;
+};
+#define UDMABUF_FLAGS_CLOEXEC 0x01
+#define UDMABUF_CREATE _IOW('u', 0x42, struct udmabuf_create)
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS (1024 + 9)
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
+static int host_memfd(const char *name) {
+#ifdef SYS_memfd_create
+    return (int)syscall(SYS_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+    (void)name;
+    errno = ENOSYS;
+    return INVALID_ID;
+#endif
+}
+
+static size_t page_round(size_t length) {
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (length + page - 1) / page * page;
+}
+
+static bool dmabuf_sync(int fd, uint64_t flags) {
+    dma_buf_sync sync = {flags};
+    int ret;
+    do {
+        ret = ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
+    } while (ret != 0 && (errno == EINTR || errno == EAGAIN));
+    return ret == 0;
+}
+
+static uint64_t dmabuf_flags(int flags) {
+    return ((flags & LINUX_SYNC_READ) ? DMA_BUF_SYNC_READ : 0) | ((flags & LINUX_SYNC_WRITE) ? DMA_BUF_SYNC_WRITE : 0);
+}
+
+LinuxMemoryHelper::LinuxMemoryHelper(bool use_udmabuf) : udmabuf_dev(INVALID_ID) {
+    if (use_udmabuf) udmabuf_dev = open("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+}
+
+LinuxMemoryHelper::~LinuxMemoryHelper() {
+    if (udmabuf_dev >= 0) close(udmabuf_dev);
+}
+
+bool LinuxMemoryHelper::mem_alloc(unsigned int length, bool cacheable, LinuxBuffer** buffer, int *buf_share_fd, void **buf_va){
+    (void)cacheable;
+    if (buffer == nullptr || buf_share_fd == nullptr || buf_va == nullptr || length == 0) return false;
+    *buffer = nullptr;
+    const size_t size = page_round(length);
+    int fd = host_memfd("LinuxBuffer");
+    if (fd < 0 || ftruncate(fd, (off_t)size) != 0) {
+        fprintf(stderr, "Can't create memfd of %zu bytes: %s\n", size, strerror(errno));
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    // a peer that mapped the buffer must not see it shrink under it (SIGBUS)
+    bool dmabuf = false;
+    if (udmabuf_dev >= 0 && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK) == 0) {
+        udmabuf_create create = {(uint32_t)fd, UDMABUF_FLAGS_CLOEXEC, 0, size};
+        int dfd = ioctl(udmabuf_dev, UDMABUF_CREATE, &create);
+        if (dfd >= 0) {
+            close(fd);
+            fd = dfd;
+            dmabuf = true;
+        }
+    }
+    if (!dmabuf) fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    void *va = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (va == MAP_FAILED) {
+        fprintf(stderr, "Can't map LinuxBuffer: %s\n", strerror(errno));
+        close(fd);
+        return false;
+    }
+    *buffer = new LinuxBuffer{fd, size, va, dmabuf};
+    *buf_share_fd = fd;
+    *buf_va = va;
+    return true;
+}
+
+bool LinuxMemoryHelper::mem_import(int fd, unsigned int length, LinuxBuffer** buffer, void **buf_va){
+    if (buffer == nullptr || buf_va == nullptr || fd < 0) return false;
+    *buffer = nullptr;
+    // lseek gives the size of memfds and dma-bufs alike
+    const off_t end = lseek(fd, 0, SEEK_END);
+    const size_t size = length != 0 ? page_round(length) : (size_t)std::max<off_t>(end, 0);
+    if (end < 0 || size == 0 || (size_t)end < size) {
+        fprintf(stderr, "Can't import fd %d: %zu bytes wanted, %lld available\n", fd, size, (long long)end);
+        return false;
+    }
+    void *va = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (va == MAP_FAILED) {
+        fprintf(stderr, "Can't map fd %d: %s\n", fd, strerror(errno));
+        return false;
+    }
+    // only dma-bufs accept the sync ioctl
+    const bool dmabuf = dmabuf_sync(fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ) &&
+                        dmabuf_sync(fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+    *buffer = new LinuxBuffer{fd, size, va, dmabuf};
+    *buf_va = va;
+    return true;
+}
+
+void LinuxMemoryHelper::mem_free(LinuxBuffer* buffer) {
+    if (buffer == nullptr) return;
+    munmap(buffer->va, buffer->size);
+    close(buffer->fd);
+    delete buffer;
+}
+
+bool LinuxMemoryHelper::mem_begin_cpu_access(LinuxBuffer* buffer, int flags) {
+    if (buffer == nullptr) return false;
+    if (buffer->dmabuf) return dmabuf_sync(buffer->fd, DMA_BUF_SYNC_START | dmabuf_flags(flags));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+bool LinuxMemoryHelper::mem_end_cpu_access(LinuxBuffer* buffer, int flags) {
+    if (buffer == nullptr) return false;
+    if (buffer->dmabuf) return dmabuf_sync(buffer->fd, DMA_BUF_SYNC_END | dmabuf_flags(flags));
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+}
+
+bool LinuxMemoryHelper::mem_cache_sync(LinuxBuffer* buffer) {
+    return mem_begin_cpu_access(buffer, LINUX_SYNC_RW) && mem_end_cpu_access(buffer, LINUX_SYNC_RW);
+}
+
+bool linux_send_fds(int sock, const int *fds, int count, const void *data, size_t size) {
+    if (count < 0 || count > LINUX_MAX_SEND_FDS || size == 0) return false;
+    union {
+        char buf[CMSG_SPACE(LINUX_MAX_SEND_FDS * sizeof(int))];
+        cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    iovec iov = {const_cast<void *>(data), size};
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (count > 0) {
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(count * sizeof(int));
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(count * sizeof(int));
+        memcpy(CMSG_DATA(cmsg), fds, count * sizeof(int));
+    }
+    ssize_t sent;
+    do {
+        sent = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (sent <= 0) return false;
+    // the fds went with the first byte; the rest is plain data
+    return linux_send_all(sock, static_cast<const char *>(data) + sent, size - sent);
+}
+
+int linux_recv_fds(int sock, int *fds, int max_count, void *data, size_t size) {
+    if (max_count < 0 || max_count > LINUX_MAX_SEND_FDS || size == 0) return -1;
+    union {
+        char buf[CMSG_SPACE(LINUX_MAX_SEND_FDS * sizeof(int))];
+        cmsghdr align;
+    } control;
+    iovec iov = {data, size};
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = CMSG_SPACE(max_count * sizeof(int));
+    ssize_t got;
+    do {
+        got = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (got < 0 && errno == EINTR);
+    if (got <= 0) return -1;
+    int count = 0;
+    bool extra = false;
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+        const int n = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        // CMSG_SPACE rounds up to 8 bytes, so an odd max_count leaves room
+        // for one fd more than fds holds: close those instead of copying
+        const int keep = std::min(n, max_count - count);
+        memcpy(fds + count, CMSG_DATA(cmsg), keep * sizeof(int));
+        for (int i = keep; i < n; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            close(fd);
+            extra = true;
+        }
+        count += keep;
+    }
+    if ((msg.msg_flags & MSG_CTRUNC) != 0 || extra ||
+        !linux_recv_all(sock, static_cast<char *>(data) + got, size - got)) {
+        for (int i = 0; i < count; i++) close(fds[i]);
+        return -1;
+    }
+    return count;
+}
+
+bool linux_send_all(int sock, const void *data, size_t size) {
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        const ssize_t n = send(sock, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool linux_recv_all(int sock, void *data, size_t size) {
+    char *p = static_cast<char *>(data);
+    while (size > 0) {
+        const ssize_t n = recv(sock, p, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+namespace {
+
+struct PoolHeader {
+    uint32_t count;
+    uint32_t length;
+};
+
+struct PoolChunk {
+    uint32_t first;
+    uint32_t count;
+};
+
+}  // namespace
+
+LinuxBufferPool::~LinuxBufferPool() {
+    clear();
+}
+
+void LinuxBufferPool::clear() {
+    for (LinuxBuffer *b : buffers) helper.mem_free(b);
+    buffers.clear();
+    std::lock_guard<std::mutex> lock(m);
+    free_list.clear();
+}
+
+bool LinuxBufferPool::create(unsigned int length, int count, bool cacheable) {
+    clear();
+    if (count <= 0) return false;
+    for (int i = 0; i < count; i++) {
+        LinuxBuffer *b = nullptr;
+        int fd;
+        void *va;
+        if (!helper.mem_alloc(length, cacheable, &b, &fd, &va)) {
+            clear();
+            return false;
+        }
+        buffers.push_back(b);
+    }
+    bytes = length;
+    std::lock_guard<std::mutex> lock(m);
+    for (int i = count - 1; i >= 0; i--) free_list.push_back(i);
+    return true;
+}
+
+bool LinuxBufferPool::share(int sock) const {
+    const PoolHeader header = {(uint32_t)buffers.size(), bytes};
+    if (!linux_send_all(sock, &header, sizeof(header))) return false;
+    for (size_t first = 0; first < buffers.size(); first += LINUX_MAX_SEND_FDS) {
+        PoolChunk chunk = {(uint32_t)first, (uint32_t)std::min<size_t>(LINUX_MAX_SEND_FDS, buffers.size() - first)};
+        int fds[LINUX_MAX_SEND_FDS];
+        for (uint32_t i = 0; i < chunk.count; i++) fds[i] = buffers[first + i]->fd;
+        if (!linux_send_fds(sock, fds, (int)chunk.count, &chunk, sizeof(chunk))) return false;
+    }
+    return true;
+}
+
+bool LinuxBufferPool::attach(int sock) {
+    clear();
+    PoolHeader header;
+    if (!linux_recv_all(sock, &header, sizeof(header)) || header.count == 0) return false;
+    buffers.assign(header.count, nullptr);
+    bytes = header.length;
+    bool ok = true;
+    for (uint32_t done = 0; done < header.count;) {
+        PoolChunk chunk;
+        int fds[LINUX_MAX_SEND_FDS];
+        const int n = linux_recv_fds(sock, fds, LINUX_MAX_SEND_FDS, &chunk, sizeof(chunk));
+        if (n < 0) {
+            ok = false;
+            break;
+        }
+        // a chunk must carry the fds it announces; one without SCM_RIGHTS would
+        // otherwise leave done where it is and block on the next message
+        if (n == 0 || (uint32_t)n != chunk.count) {
+            for (int i = 0; i < n; i++) close(fds[i]);
+            ok = false;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            void *va;
+            const uint32_t index = chunk.first + i;
+            if (index >= header.count || buffers[index] != nullptr ||
+                !helper.mem_import(fds[i], bytes, &buffers[index], &va)) {
+                close(fds[i]);
+                ok = false;
+            }
+        }
+        done += (uint32_t)n;
+        if (!ok) break;
+    }
+    if (!ok) clear();
+    return ok;
+}
+
+int LinuxBufferPool::acquire() {
+    std::unique_lock<std::mutex> lock(m);
+    cv.wait(lock, [this] { return !free_list.empty(); });
+    const int index = free_list.back();
+    free_list.pop_back();
+    return index;
+}
+
+int LinuxBufferPool::try_acquire() {
+    std::lock_guard<std::mutex> lock(m);
+    if (free_list.empty()) return INVALID_ID;
+    const int index = free_list.back();
+    free_list.pop_back();
+    return index;
+}
+
+void LinuxBufferPool::release(int index) {
+    if (index < 0 || index >= (int)buffers.size()) return;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        free_list.push_back(index);
+    }
+    cv.notify_one();
+}
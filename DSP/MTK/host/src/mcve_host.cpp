@@ -0,0 +1,456 @@
+// Host implementation of the MCVE runtime API (include/mcve/MCVEAPI.h).
+//
+// The "device" is an xr::WorkStealingPool: mcvRunAlgo returns at once, the
+// run is spawned into the environment's task group when the last event of its
+// wait list completes, and its own event completes when the CPU kernel
+// returns. Events are reference counted, so releasing one before it completes
+// is fine. Every sync and run is timed into the environment's profile.
+#include "mcve/mcve_host.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "../../../../CPP/WorkStealingPool.hpp"
+
+// defined in mcve_host_algos.cpp
+void mcvHostRegisterBuiltins();
+
+namespace {
+
+struct AlgoEntry {
+    size_t buffer_count = 0;
+    std::vector<size_t> param_sizes;
+    McvHostKernel kernel;
+};
+
+std::mutex &registry_mutex() {
+    static std::mutex m;
+    return m;
+}
+
+std::map<std::string, AlgoEntry> &registry() {
+    static std::map<std::string, AlgoEntry> r;
+    return r;
+}
+
+double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Completion state of one run, shared by its event handles and by the runs
+// waiting on it.
+struct EventState {
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = false;
+    int status = MCV_SUCCESS;
+    std::vector<std::function<void(int)>> then;
+
+    void complete(int s) {
+        std::vector<std::function<void(int)>> waiting;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            done = true;
+            status = s;
+            waiting.swap(then);
+        }
+        cv.notify_all();
+        for (auto &f : waiting) f(s);
+    }
+
+    // f(status) once complete; right away when it already is
+    void on_done(std::function<void(int)> f) {
+        std::unique_lock<std::mutex> lock(m);
+        if (!done) {
+            then.push_back(std::move(f));
+            return;
+        }
+        const int s = status;
+        lock.unlock();
+        f(s);
+    }
+
+    int wait() {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [this] { return done; });
+        return status;
+    }
+};
+
+// kernel entry name from a JSON spec, or the trimmed blob itself
+std::string entry_name(const void *binary, size_t size) {
+    std::string s(static_cast<const char *>(binary), size);
+    size_t k = s.find("\"kernel_entry_name\"");
+    if (k != std::string::npos) {
+        const size_t q0 = s.find('"', s.find(':', k) + 1);
+        const size_t q1 = q0 == std::string::npos ? q0 : s.find('"', q0 + 1);
+        return q1 == std::string::npos ? std::string() : s.substr(q0 + 1, q1 - q0 - 1);
+    }
+    const char *space = " \t\r\n";
+    s.erase(std::find(s.begin(), s.end(), '\0'), s.end());
+    const size_t b = s.find_first_not_of(space);
+    return b == std::string::npos ? std::string() : s.substr(b, s.find_last_not_of(space) - b + 1);
+}
+
+int env_threads() {
+    const char *v = std::getenv("MCVE_HOST_THREADS");
+    const int n = v ? std::atoi(v) : 0;
+    return n > 0 ? n : (int)std::max(1u, std::thread::hardware_concurrency());
+}
+
+void *alloc_aligned(size_t size) {
+    void *p = nullptr;
+    return posix_memalign(&p, 64, std::max<size_t>(size, 1)) == 0 ? p : nullptr;
+}
+
+}  // namespace
+
+struct mcv_env_s {
+    // one slot more than workers: slot 0 is lent to a thread waiting on the
+    // group, the workers alone run queued algos
+    explicit mcv_env_s(int workers) : pool(workers + 1), group(pool) {}
+
+    void record(McvHostRecord r) {
+        std::lock_guard<std::mutex> lock(profile_mutex);
+        profile.push_back(std::move(r));
+    }
+
+    xr::WorkStealingPool pool;
+    xr::TaskGroup group;
+    std::mutex profile_mutex;
+    std::vector<McvHostRecord> profile;
+};
+
+struct mcv_buffer_s {
+    mcv_env_t *env = nullptr;
+    std::string name;
+    size_t size = 0;
+    bool imported = false;
+    mcv_buf_type_t type = MCV_BUF_TYPE_DEFAULT;
+    void *host = nullptr;
+    void *device = nullptr;  // == host unless DEFAULT
+};
+
+struct mcv_algo_s {
+    mcv_env_t *env = nullptr;
+    std::string name;
+    McvHostKernel kernel;
+    McvHostArgs args;
+    std::vector<std::vector<unsigned char>> param_store;
+    std::mutex m;
+    std::condition_variable cv;
+    int inflight = 0;
+};
+
+struct mcv_event_s {
+    std::shared_ptr<EventState> state;
+};
+
+void mcvHostRegisterAlgo(const char *name, size_t buffer_count, const std::vector<size_t> &param_sizes,
+                         McvHostKernel kernel) {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    AlgoEntry &e = registry()[name];
+    e.buffer_count = buffer_count;
+    e.param_sizes = param_sizes;
+    e.kernel = std::move(kernel);
+}
+
+int mcvInitEnv(mcv_env_t **env) {
+    if (env == nullptr) return MCV_ERROR_INVALID_VALUE;
+    static std::once_flag builtins;
+    std::call_once(builtins, mcvHostRegisterBuiltins);
+    *env = new mcv_env_s(env_threads());
+    return MCV_SUCCESS;
+}
+
+int mcvDeinitEnv(mcv_env_t *env) {
+    if (env == nullptr) return MCV_ERROR_INVALID_VALUE;
+    env->group.wait();
+    if (std::getenv("MCVE_HOST_PROFILE")) mcvHostPrintProfile(env, stdout);
+    delete env;
+    return MCV_SUCCESS;
+}
+
+mcv_buffer_t *mcvMemAlloc(mcv_env_t *env, size_t size, int *err, const char *name, mcv_buf_type_t type) {
+    int dummy;
+    if (err == nullptr) err = &dummy;
+    if (env == nullptr || size == 0) {
+        *err = MCV_ERROR_INVALID_VALUE;
+        return nullptr;
+    }
+    mcv_buffer_t *b = new mcv_buffer_s;
+    b->env = env;
+    b->name = name ? name : "";
+    b->size = size;
+    b->type = type;
+    b->host = alloc_aligned(size);
+    b->device = type == MCV_BUF_TYPE_DEFAULT ? alloc_aligned(size) : b->host;
+    if (b->host == nullptr || b->device == nullptr) {
+        if (b->device != b->host) std::free(b->device);
+        std::free(b->host);
+        delete b;
+        *err = MCV_ERROR_OUT_OF_MEMORY;
+        return nullptr;
+    }
+    std::memset(b->host, 0, size);
+    if (b->device != b->host) std::memset(b->device, 0, size);
+    *err = MCV_SUCCESS;
+    return b;
+}
+
+mcv_buffer_t *mcvMemImport(mcv_env_t *env, size_t size, const int *fd, int *err, const char *name) {
+    int dummy;
+    if (err == nullptr) err = &dummy;
+    if (env == nullptr || size == 0 || fd == nullptr || *fd < 0) {
+        *err = MCV_ERROR_INVALID_VALUE;
+        return nullptr;
+    }
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+    if (p == MAP_FAILED) {
+        *err = MCV_ERROR_INVALID_VALUE;
+        return nullptr;
+    }
+    mcv_buffer_t *b = new mcv_buffer_s;
+    b->env = env;
+    b->name = name ? name : "";
+    b->size = size;
+    b->imported = true;
+    b->type = MCV_BUF_TYPE_DMA;
+    b->host = b->device = p;
+    *err = MCV_SUCCESS;
+    return b;
+}
+
+static int release_buffer(mcv_buffer_t *buffer, bool as_import) {
+    if (buffer == nullptr) return MCV_ERROR_INVALID_VALUE;
+    if (buffer->imported != as_import) {
+        // tolerated, but the device runtime may not be as forgiving
+        fprintf(stderr, "[mcve host] %s on %s buffer \"%s\"\n", as_import ? "mcvMemUnImport" : "mcvMemFree",
+                buffer->imported ? "imported" : "allocated", buffer->name.c_str());
+    }
+    if (buffer->imported) {
+        munmap(buffer->host, buffer->size);
+    } else {
+        if (buffer->device != buffer->host) std::free(buffer->device);
+        std::free(buffer->host);
+    }
+    delete buffer;
+    return MCV_SUCCESS;
+}
+
+int mcvMemFree(mcv_buffer_t *buffer) { return release_buffer(buffer, false); }
+
+int mcvMemUnImport(mcv_buffer_t *buffer) { return release_buffer(buffer, true); }
+
+void *getHostPtr(mcv_buffer_t *buffer) { return buffer ? buffer->host : nullptr; }
+
+// DEFAULT buffers copy between the two sides; shared ones only order memory
+static int sync_buffer(mcv_env_t *env, mcv_buffer_t *buffer, bool to_device) {
+    if (env == nullptr || buffer == nullptr) return MCV_ERROR_INVALID_VALUE;
+    const double t0 = now_ms();
+    if (buffer->device != buffer->host) {
+        if (to_device) {
+            std::memcpy(buffer->device, buffer->host, buffer->size);
+        } else {
+            std::memcpy(buffer->host, buffer->device, buffer->size);
+        }
+    } else {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    McvHostRecord r;
+    r.op = to_device ? "h2d" : "d2h";
+    r.name = buffer->name;
+    r.bytes = buffer->device != buffer->host ? buffer->size : 0;
+    r.ms = now_ms() - t0;
+    env->record(std::move(r));
+    return MCV_SUCCESS;
+}
+
+int mcvSyncBufferHostToDevice(mcv_env_t *env, mcv_buffer_t *buffer) { return sync_buffer(env, buffer, true); }
+
+int mcvSyncBufferDeviceToHost(mcv_env_t *env, mcv_buffer_t *buffer) { return sync_buffer(env, buffer, false); }
+
+mcv_algo_t *mcvCreateCustomAlgo(mcv_env_t *env, const void *binary, size_t binary_size, mcv_buffer_t **buffers,
+                                size_t buffer_count, void **params, size_t param_count, int *err) {
+    int dummy;
+    if (err == nullptr) err = &dummy;
+    *err = MCV_ERROR_INVALID_VALUE;
+    if (env == nullptr || binary == nullptr || (buffer_count && !buffers) || (param_count && !params)) return nullptr;
+    const std::string name = entry_name(binary, binary_size);
+    AlgoEntry entry;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        auto it = registry().find(name);
+        if (it == registry().end()) {
+            fprintf(stderr, "[mcve host] no CPU implementation registered for kernel \"%s\"\n", name.c_str());
+            *err = MCV_ERROR_INVALID_BINARY;
+            return nullptr;
+        }
+        entry = it->second;
+    }
+    if (buffer_count != entry.buffer_count || param_count != entry.param_sizes.size()) {
+        fprintf(stderr, "[mcve host] %s takes %zu buffers and %zu params, got %zu and %zu\n", name.c_str(),
+                entry.buffer_count, entry.param_sizes.size(), buffer_count, param_count);
+        return nullptr;
+    }
+    for (size_t i = 0; i < buffer_count; i++) {
+        if (buffers[i] == nullptr) return nullptr;
+    }
+    for (size_t i = 0; i < param_count; i++) {
+        if (params[i] == nullptr) return nullptr;
+    }
+
+    mcv_algo_t *algo = new mcv_algo_s;
+    algo->env = env;
+    algo->name = name;
+    algo->kernel = std::move(entry.kernel);
+    for (size_t i = 0; i < buffer_count; i++) {
+        algo->args.buffers.push_back(buffers[i]->device);
+        algo->args.sizes.push_back(buffers[i]->size);
+    }
+    // values, not pointers: the caller's variables may be gone by the run
+    algo->param_store.resize(param_count);
+    for (size_t i = 0; i < param_count; i++) {
+        const unsigned char *p = static_cast<const unsigned char *>(params[i]);
+        algo->param_store[i].assign(p, p + entry.param_sizes[i]);
+        algo->args.params.push_back(algo->param_store[i].data());
+    }
+    *err = MCV_SUCCESS;
+    return algo;
+}
+
+// waits for the algo's queued and running runs
+int mcvReleaseAlgo(mcv_algo_t *algo) {
+    if (algo == nullptr) return MCV_ERROR_INVALID_VALUE;
+    {
+        std::unique_lock<std::mutex> lock(algo->m);
+        algo->cv.wait(lock, [algo] { return algo->inflight == 0; });
+    }
+    delete algo;
+    return MCV_SUCCESS;
+}
+
+int mcvRunAlgo(mcv_algo_t *algo, uint32_t wait_count, const mcv_event_t *wait_list, mcv_event_t *event) {
+    if (algo == nullptr || (wait_count > 0 && wait_list == nullptr)) return MCV_ERROR_INVALID_VALUE;
+    for (uint32_t i = 0; i < wait_count; i++) {
+        if (wait_list[i] == nullptr) return MCV_ERROR_INVALID_VALUE;
+    }
+    {
+        std::lock_guard<std::mutex> lock(algo->m);
+        algo->inflight++;
+    }
+    auto done = std::make_shared<EventState>();
+    const double queued = now_ms();
+    // The notify stays under algo->m: mcvReleaseAlgo can only see inflight
+    // reach 0 once the lock is released, and after that the algo may be gone.
+    auto finish = [algo, done](int status) {
+        {
+            std::lock_guard<std::mutex> lock(algo->m);
+            algo->inflight--;
+            algo->cv.notify_all();
+        }
+        done->complete(status);
+    };
+    auto start = [algo, queued, finish] {
+        algo->env->group.run([algo, queued, finish] {
+            const double t0 = now_ms();
+            int status;
+            try {
+                status = algo->kernel(algo->args);
+            } catch (...) {
+                status = MCV_ERROR_KERNEL_FAILED;
+            }
+            McvHostRecord r;
+            r.op = "run";
+            r.name = algo->name;
+            r.queued_ms = t0 - queued;
+            r.ms = now_ms() - t0;
+            algo->env->record(std::move(r));
+            finish(status);
+        });
+    };
+
+    // one count per dependency plus one for this call, so the run cannot start
+    // before every continuation is attached; a failed dependency fails the run
+    // without running it
+    auto pending = std::make_shared<std::atomic<int>>((int)wait_count + 1);
+    auto failed = std::make_shared<std::atomic<int>>(MCV_SUCCESS);
+    auto arrive = [pending, failed, start, finish] {
+        if (pending->fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        const int f = failed->load(std::memory_order_acquire);
+        if (f != MCV_SUCCESS) {
+            finish(f);
+        } else {
+            start();
+        }
+    };
+    for (uint32_t i = 0; i < wait_count; i++) {
+        wait_list[i]->state->on_done([failed, arrive](int status) {
+            if (status != MCV_SUCCESS) failed->store(status, std::memory_order_release);
+            arrive();
+        });
+    }
+    arrive();
+    if (event != nullptr) *event = new mcv_event_s{done};
+    return MCV_SUCCESS;
+}
+
+int mcvWaitForEvents(uint32_t count, const mcv_event_t *events) {
+    if (count > 0 && events == nullptr) return MCV_ERROR_INVALID_VALUE;
+    int result = MCV_SUCCESS;
+    for (uint32_t i = 0; i < count; i++) {
+        if (events[i] == nullptr) return MCV_ERROR_INVALID_VALUE;
+        const int s = events[i]->state->wait();
+        if (result == MCV_SUCCESS) result = s;
+    }
+    return result;
+}
+
+int mcvReleaseEvent(mcv_event_t *event) {
+    if (event == nullptr || *event == nullptr) return MCV_ERROR_INVALID_VALUE;
+    delete *event;
+    *event = nullptr;
+    return MCV_SUCCESS;
+}
+
+std::vector<McvHostRecord> mcvHostProfile(mcv_env_t *env) {
+    if (env == nullptr) return {};
+    std::lock_guard<std::mutex> lock(env->profile_mutex);
+    return env->profile;
+}
+
+void mcvHostPrintProfile(mcv_env_t *env, FILE *out) {
+    struct Sum {
+        int count = 0;
+        size_t bytes = 0;
+        double total = 0.0, worst = 0.0, queued = 0.0;
+    };
+    std::map<std::pair<std::string, std::string>, Sum> sums;
+    for (const McvHostRecord &r : mcvHostProfile(env)) {
+        Sum &s = sums[{r.op, r.name}];
+        s.count++;
+        s.bytes += r.bytes;
+        s.total += r.ms;
+        s.worst = std::max(s.worst, r.ms);
+        s.queued += r.queued_ms;
+    }
+    fprintf(out, "[mcve host] %-4s %-20s %6s %10s %9s %9s %9s %9s\n", "op", "name", "count", "total ms", "mean ms",
+            "max ms", "queue ms", "GB/s");
+    for (const auto &kv : sums) {
+        const Sum &s = kv.second;
+        const double gbs = s.bytes && s.total > 0.0 ? s.bytes / (s.total * 1e6) : 0.0;
+        fprintf(out, "[mcve host] %-4s %-20s %6d %10.3f %9.3f %9.3f %9.3f %9.2f\n", kv.first.first.c_str(),
+                kv.first.second.c_str(), s.count, s.total, s.total / s.count, s.worst, s.queued / s.count, gbs);
+    }
+}
@@ -0,0 +1,87 @@
+// CPU implementations of the custom kernels in this directory tree, registered
+// with the host MCVE stand-in under their kernel entry names:
+//
+//   vector_add    cl/swat_add.cl
+//   CustomKernel  mtk_device_demo/kernel_api_w_ahwbuffer/cl/CustomKernel.cl,
+//                 LK flow, RANSAC homography and bilinear warp with the
+//                 host modules of simd/ (xr::flow, xr::homography, xr::warp)
+//
+// Argument order follows the kernels' JSON specs; internal_buffer and
+// const_param entries are not passed by the host code and are not expected.
+#include "mcve/mcve_host.h"
+
+#include "../../../../simd/flow/flow.h"
+#include "../../../../simd/homography/homography.h"
+#include "../../../../simd/warp/warp.h"
+
+namespace {
+
+int vector_add(const McvHostArgs &args) {
+    const int len = args.param<int>(0);
+    const size_t bytes = (size_t)std::max(len, 0) * sizeof(int);
+    if (len < 0 || bytes > args.sizes[0] || bytes > args.sizes[1] || bytes > args.sizes[2]) {
+        return MCV_ERROR_INVALID_VALUE;
+    }
+    const int *a = args.buffer<int>(0);
+    const int *b = args.buffer<int>(1);
+    int *c = args.buffer<int>(2);
+    for (int i = 0; i < len; i++) c[i] = a[i] + b[i];
+    return MCV_SUCCESS;
+}
+
+// buffers: prev_img, next_img, prev_pts, next_pts, pts_num, status,
+//          tmp_buf_lk, random_seed, homography_matrix, warp_result
+// params:  stride_img, width_img, height_img, win_width, win_height,
+//          max_level, criteria_cnt, criteria_eps, max_iters, threshold,
+//          confidence
+// The warp output is prev_img mapped by H (cv::warpPerspective's convention:
+// H maps source to destination, so the sampling map is its inverse).
+int custom_kernel(const McvHostArgs &args) {
+    const uint32_t stride = args.param<uint32_t>(0), width = args.param<uint32_t>(1);
+    const uint32_t height = args.param<uint32_t>(2);
+    xr::flow::LkParams lk;
+    lk.win_width = args.param<uint8_t>(3);
+    lk.win_height = args.param<uint8_t>(4);
+    lk.max_level = args.param<uint8_t>(5);
+    lk.criteria_cnt = (int)args.param<uint32_t>(6);
+    lk.criteria_eps = args.param<float>(7);
+    xr::homography::RansacParams ransac;
+    ransac.max_iters = args.param<int32_t>(8);
+    ransac.threshold = args.param<float>(9);
+    ransac.confidence = args.param<float>(10);
+
+    const size_t image = (size_t)stride * height;
+    if (args.sizes[4] < sizeof(int32_t)) return MCV_ERROR_INVALID_VALUE;
+    const int count = *args.buffer<int32_t>(4);
+    const size_t pts = (size_t)std::max(count, 0) * 2 * sizeof(float);
+    if (count < 0 || stride < width || args.sizes[0] < image || args.sizes[1] < image || args.sizes[9] < image ||
+        args.sizes[2] < pts || args.sizes[3] < pts || args.sizes[5] < (size_t)count ||
+        args.sizes[7] < xr::homography::kRansacSeeds * sizeof(uint32_t) || args.sizes[8] < 9 * sizeof(float)) {
+        return MCV_ERROR_INVALID_VALUE;
+    }
+    ransac.random_seed = args.buffer<uint32_t>(7);
+
+    const uint8_t *prev = args.buffer<uint8_t>(0);
+    const float *prev_pts = args.buffer<float>(2);
+    float *next_pts = args.buffer<float>(3);
+    if (!xr::flow::calc_optical_flow_pyr_lk(prev, args.buffer<uint8_t>(1), (int)stride, (int)width, (int)height,
+                                            prev_pts, count, next_pts, args.buffer<uint8_t>(5), lk)) {
+        return MCV_ERROR_INVALID_VALUE;
+    }
+    float *h = args.buffer<float>(8);
+    float m[9];
+    if (!xr::homography::find_homography_ransac(prev_pts, next_pts, count, h, ransac) ||
+        !xr::warp::invert_homography(h, m)) {
+        return MCV_ERROR_KERNEL_FAILED;
+    }
+    xr::warp::warp_perspective(prev, (int)stride, (int)width, (int)height, args.buffer<uint8_t>(9), (int)stride,
+                               (int)width, (int)height, m, 0);
+    return MCV_SUCCESS;
+}
+
+}  // namespace
+
+void mcvHostRegisterBuiltins() {
+    mcvHostRegisterAlgo("vector_add", 3, {sizeof(int)}, vector_add);
+    mcvHostRegisterAlgo("CustomKernel", 10, {4, 4, 4, 1, 1, 1, 4, 4, 4, 4, 4}, custom_kernel);
+}
@@ -0,0 +1,129 @@
+// Generated by tools/gen_mcve_launch.py from mtk_device_demo/kernel_api_w_ahwbuffer/CustomKernel.json. Do not edit.
+#ifndef CUSTOMKERNEL_LAUNCH_H_
+#define CUSTOMKERNEL_LAUNCH_H_
+
+#include "mcve_launch.h"
+
+// CustomKernel, arguments in kernel order:
+//   prev_img           buffer          uchar
+//   next_img           buffer          uchar
+//   prev_pts           buffer          float
+//   next_pts           buffer          float
+//   pts_num            buffer          int
+//   status             buffer          uchar
+//   tmp_buf_lk         buffer          uchar
+//   random_seed        buffer          uint
+//   homography_matrix  buffer          float
+//   warp_result        buffer          uchar
+//   tmp_buf            internal_buffer uchar = 400000
+//   ui_tmp_buf_size    const_param     uint = 400000
+//   stride_img         param           uint
+//   width_img          param           uint
+//   height_img         param           uint
+//   win_width          param           uchar
+//   win_height         param           uchar
+//   max_level          param           uchar
+//   criteria_cnt       param           uint
+//   criteria_eps       param           float
+//   max_iters          param           int
+//   threshold          param           float
+//   confidence         param           float
+struct CustomKernelArgs {
+    static constexpr const char *kEntry = "CustomKernel";
+    static constexpr int kBufferCount = 10;
+    static constexpr int kParamCount = 11;
+    static constexpr size_t tmp_buf_bytes = 400000 * sizeof(uint8_t);  // internal_buffer
+    static constexpr uint32_t ui_tmp_buf_size = 400000;  // const_param, in the binary
+
+    McvBuffer<uint8_t> prev_img;
+    McvBuffer<uint8_t> next_img;
+    McvBuffer<float> prev_pts;
+    McvBuffer<float> next_pts;
+    McvBuffer<int32_t> pts_num;
+    McvBuffer<uint8_t> status;
+    McvBuffer<uint8_t> tmp_buf_lk;
+    McvBuffer<uint32_t> random_seed;
+    McvBuffer<float> homography_matrix;
+    McvBuffer<uint8_t> warp_result;
+    uint32_t stride_img = 0;
+    uint32_t width_img = 0;
+    uint32_t height_img = 0;
+    uint8_t win_width = 0;
+    uint8_t win_height = 0;
+    uint8_t max_level = 0;
+    uint32_t criteria_cnt = 0;
+    float criteria_eps = 0;
+    int32_t max_iters = 0;
+    float threshold = 0;
+    float confidence = 0;
+
+    CustomKernelArgs(McvBuffer<uint8_t> prev_img_,
+                     McvBuffer<uint8_t> next_img_,
+                     McvBuffer<float> prev_pts_,
+                     McvBuffer<float> next_pts_,
+                     McvBuffer<int32_t> pts_num_,
+                     McvBuffer<uint8_t> status_,
+                     McvBuffer<uint8_t> tmp_buf_lk_,
+                     McvBuffer<uint32_t> random_seed_,
+                     McvBuffer<float> homography_matrix_,
+                     McvBuffer<uint8_t> warp_result_,
+                     uint32_t stride_img_,
+                     uint32_t width_img_,
+                     uint32_t height_img_,
+                     uint8_t win_width_,
+                     uint8_t win_height_,
+                     uint8_t max_level_,
+                     uint32_t criteria_cnt_,
+                     float criteria_eps_,
+                     int32_t max_iters_,
+                     float threshold_,
+                     float confidence_)
+        : prev_img(prev_img_),
+          next_img(next_img_),
+          prev_pts(prev_pts_),
+          next_pts(next_pts_),
+          pts_num(pts_num_),
+          status(status_),
+          tmp_buf_lk(tmp_buf_lk_),
+          random_seed(random_seed_),
+          homography_matrix(homography_matrix_),
+          warp_result(warp_result_),
+          stride_img(stride_img_),
+          width_img(width_img_),
+          height_img(height_img_),
+          win_width(win_width_),
+          win_height(win_height_),
+          max_level(max_level_),
+          criteria_cnt(criteria_cnt_),
+          criteria_eps(criteria_eps_),
+          max_iters(max_iters_),
+          threshold(threshold_),
+          confidence(confidence_) {}
+
+    void marshal(mcv_buffer_t **buffers, void **params) {
+        buffers[0] = prev_img.get();
+        buffers[1] = next_img.get();
+        buffers[2] = prev_pts.get();
+        buffers[3] = next_pts.get();
+        buffers[4] = pts_num.get();
+        buffers[5] = status.get();
+        buffers[6] = tmp_buf_lk.get();
+        buffers[7] = random_seed.get();
+        buffers[8] = homography_matrix.get();
+        buffers[9] = warp_result.get();
+        params[0] = &stride_img;
+        params[1] = &width_img;
+        params[2] = &height_img;
+        params[3] = &win_width;
+        params[4] = &win_height;
+        params[5] = &max_level;
+        params[6] = &criteria_cnt;
+        params[7] = &criteria_eps;
+        params[8] = &max_iters;
+        params[9] = &threshold;
+        params[10] = &confidence;
+    }
+};
+using CustomKernelLaunch = McvLaunch<CustomKernelArgs>;
+
+#endif  // CUSTOMKERNEL_LAUNCH_H_
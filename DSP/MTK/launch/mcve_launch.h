@@ -0,0 +1,112 @@
+/*
+ * Support code for the launch descriptors that tools/gen_mcve_launch.py
+ * generates from kernel JSON specs.
+ *
+ * A generated <Kernel>Args struct has one typed field per host-side kernel
+ * argument, in kernel order, and a marshal() that writes the buffer and
+ * parameter lists mcvCreateCustomAlgo takes. McvLaunch<Args> owns those
+ * lists as fixed arrays and the algo built from them, so a launch repeated
+ * every frame neither allocates nor rebuilds an argument list.
+ *
+ * Buffers are McvBuffer<T>, tagged with the element type of the spec. Passing
+ * a float buffer where the kernel declares uchar does not compile, and neither
+ * does a missing argument: Args and McvLaunch have no default constructor.
+ */
+#ifndef MCVE_LAUNCH_H_
+#define MCVE_LAUNCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "mcve/MCVEAPI.h"
+
+template <typename T>
+class McvBuffer {
+public:
+    McvBuffer() = default;
+    // tags an untyped buffer: the one place where the element type is taken on trust
+    static McvBuffer wrap(mcv_buffer_t *buffer) {
+        McvBuffer b;
+        b.buffer_ = buffer;
+        return b;
+    }
+    // a T buffer can be passed where the kernel only reads (const T)
+    template <typename U>
+    McvBuffer(const McvBuffer<U> &other, typename std::enable_if<std::is_same<const U, T>::value>::type * = nullptr)
+        : buffer_(other.get()) {}
+
+    mcv_buffer_t *get() const { return buffer_; }
+    T *host() const { return static_cast<T *>(getHostPtr(buffer_)); }
+
+private:
+    mcv_buffer_t *buffer_ = nullptr;
+};
+
+// mcvMemAlloc of count elements of T
+template <typename T>
+McvBuffer<T> mcvMemAllocT(mcv_env_t *env, size_t count, int *err, const char *name, mcv_buf_type_t type) {
+    return McvBuffer<T>::wrap(mcvMemAlloc(env, count * sizeof(T), err, name, type));
+}
+
+// mcvMemImport of count elements of T
+template <typename T>
+McvBuffer<T> mcvMemImportT(mcv_env_t *env, size_t count, const int *fd, int *err, const char *name) {
+    return McvBuffer<T>::wrap(mcvMemImport(env, count * sizeof(T), fd, err, name));
+}
+
+// An algo built from a generated Args struct. Scalar parameters are read when
+// the algo is created (the runtime copies them), so after changing a
+// parameter field call create() again; buffer contents can change freely
+// between runs.
+template <typename Args>
+class McvLaunch {
+public:
+    Args args;
+
+    // no default constructor, here or in Args: the full Args constructor is
+    // the only way to get one
+    explicit McvLaunch(const Args &a) : args(a) {}
+    McvLaunch(const McvLaunch &) = delete;
+    McvLaunch &operator=(const McvLaunch &) = delete;
+    ~McvLaunch() { release(); }
+
+    int create(mcv_env_t *env, const void *binary, size_t binary_size) {
+        release();
+        args.marshal(buffers_, params_);
+        int err = MCV_SUCCESS;
+        algo_ = mcvCreateCustomAlgo(env, binary, binary_size, buffers_, Args::kBufferCount, params_,
+                                    Args::kParamCount, &err);
+        if (algo_ == nullptr && err == MCV_SUCCESS) err = MCV_ERROR_INVALID_VALUE;
+        return err;
+    }
+
+    int run(mcv_event_t *event, uint32_t wait_count = 0, const mcv_event_t *wait_list = nullptr) {
+        if (algo_ == nullptr) return MCV_ERROR_INVALID_VALUE;
+        return mcvRunAlgo(algo_, wait_count, wait_list, event);
+    }
+
+    // run and wait
+    int run_sync() {
+        mcv_event_t event = nullptr;
+        int err = run(&event);
+        if (err != MCV_SUCCESS) return err;
+        err = mcvWaitForEvents(1, &event);
+        mcvReleaseEvent(&event);
+        return err;
+    }
+
+    void release() {
+        if (algo_ != nullptr) mcvReleaseAlgo(algo_);
+        algo_ = nullptr;
+    }
+
+    mcv_algo_t *algo() const { return algo_; }
+
+private:
+    mcv_buffer_t *buffers_[Args::kBufferCount > 0 ? Args::kBufferCount : 1] = {};
+    void *params_[Args::kParamCount > 0 ? Args::kParamCount : 1] = {};
+    mcv_algo_t *algo_ = nullptr;
+};
+
+#endif  // MCVE_LAUNCH_H_
@@ -0,0 +1,34 @@
+// Generated by tools/gen_mcve_launch.py from json/swat_add.json. Do not edit.
+#ifndef VECTOR_ADD_LAUNCH_H_
+#define VECTOR_ADD_LAUNCH_H_
+
+#include "mcve_launch.h"
+
+// vector_add, arguments in kernel order:
+//   a    i_buffer        int
+//   b    i_buffer        int
+//   c    o_buffer        int
+//   len  param           int
+struct VectorAddArgs {
+    static constexpr const char *kEntry = "vector_add";
+    static constexpr int kBufferCount = 3;
+    static constexpr int kParamCount = 1;
+
+    McvBuffer<const int32_t> a;
+    McvBuffer<const int32_t> b;
+    McvBuffer<int32_t> c;
+    int32_t len = 0;
+
+    VectorAddArgs(McvBuffer<const int32_t> a_, McvBuffer<const int32_t> b_, McvBuffer<int32_t> c_, int32_t len_)
+        : a(a_), b(b_), c(c_), len(len_) {}
+
+    void marshal(mcv_buffer_t **buffers, void **params) {
+        buffers[0] = a.get();
+        buffers[1] = b.get();
+        buffers[2] = c.get();
+        params[0] = &len;
+    }
+};
+using VectorAddLaunch = McvLaunch<VectorAddArgs>;
+
+#endif  // VECTOR_ADD_LAUNCH_H_
@@ -0,0 +1,217 @@
+// Frame exchange between a capture process and a processing process, three ways:
+//   pipe    every frame is written into a pipe and read out again
+//   socket  the same over an AF_UNIX stream socket
+//   shared  a LinuxBufferPool is shared once (fds over SCM_RIGHTS); per frame
+//           only the buffer index goes to the consumer and comes back when it
+//           is done, so the frame itself is never copied
+// The producer writes every frame and the consumer reads and checks every byte
+// in all three modes, so the difference is the cost of moving the data.
+//
+// g++ -O2 -std=c++17 -pthread -Ihost/include main/frame_exchange_main.cpp host/src/LinuxMemoryHelper.cpp -o frame_exchange
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "AHWBuffer/LinuxMemoryHelper.h"
+
+namespace {
+
+const int kPoolSize = 4;
+
+struct FrameMsg {
+    int32_t index;  // pool buffer, -1 ends the stream
+    uint32_t frame;
+};
+
+uint64_t pattern(uint32_t frame) {
+    return 0x0101010101010101ull * ((frame * 37u + 11u) & 0xff);
+}
+
+// frame number in the first word, a per-frame pattern in the rest
+void produce(uint8_t *data, size_t size, uint32_t frame) {
+    uint64_t *w = reinterpret_cast<uint64_t *>(data);
+    const uint64_t p = pattern(frame);
+    w[0] = frame;
+    for (size_t i = 1; i < size / 8; i++) w[i] = p;
+}
+
+long consume(const uint8_t *data, size_t size, uint32_t frame) {
+    const uint64_t *w = reinterpret_cast<const uint64_t *>(data);
+    const uint64_t p = pattern(frame);
+    long bad = w[0] != frame;
+    for (size_t i = 1; i < size / 8; i++) bad += w[i] != p;
+    return bad;
+}
+
+bool write_all(int fd, const void *data, size_t size) {
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        const ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool read_all(int fd, void *data, size_t size) {
+    char *p = static_cast<char *>(data);
+    while (size > 0) {
+        const ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+struct Result {
+    double ms = 0;
+    long bad = -1;
+};
+
+// pipe and socket: the bytes go through the kernel, one copy in, one copy out
+Result run_copy(bool use_pipe, size_t size, uint32_t frames) {
+    Result r;
+    int fds[2], done[2];
+    if (use_pipe ? pipe(fds) != 0 : socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) return r;
+    if (pipe(done) != 0) return r;
+    if (use_pipe) {
+        fcntl(fds[1], F_SETPIPE_SZ, 1 << 20);
+    } else {
+        const int buf = 1 << 20;
+        setsockopt(fds[0], SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+        setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &buf, sizeof(buf));
+    }
+    std::vector<uint8_t> frame(size);
+    const auto t0 = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[1]);
+        long bad = 0;
+        for (uint32_t n = 0; n < frames; n++) {
+            if (!read_all(fds[0], frame.data(), size)) {
+                bad = -1;
+                break;
+            }
+            bad += consume(frame.data(), size, n);
+        }
+        write_all(done[1], &bad, sizeof(bad));
+        _exit(0);
+    }
+    close(fds[0]);
+    for (uint32_t n = 0; n < frames; n++) {
+        produce(frame.data(), size, n);
+        if (!write_all(fds[1], frame.data(), size)) break;
+    }
+    close(fds[1]);
+    if (!read_all(done[0], &r.bad, sizeof(r.bad))) r.bad = -1;
+    r.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    waitpid(pid, nullptr, 0);
+    close(done[0]);
+    close(done[1]);
+    return r;
+}
+
+// shared: indices travel, the frames stay where the producer wrote them
+Result run_shared(LinuxMemoryHelper &helper, size_t size, uint32_t frames) {
+    Result r;
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) return r;
+    LinuxBufferPool pool(helper);
+    if (!pool.create((unsigned int)size, kPoolSize)) return r;
+    const auto t0 = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        close(sv[0]);
+        LinuxBufferPool view(helper);
+        long bad = view.attach(sv[1]) ? 0 : -1;
+        FrameMsg msg;
+        while (bad >= 0 && linux_recv_all(sv[1], &msg, sizeof(msg)) && msg.index >= 0) {
+            if (msg.index >= view.count()) {
+                bad = -1;
+                break;
+            }
+            LinuxBuffer *b = view.at(msg.index);
+            helper.mem_begin_cpu_access(b, LINUX_SYNC_READ);
+            bad += consume(static_cast<const uint8_t *>(b->va), size, msg.frame);
+            helper.mem_end_cpu_access(b, LINUX_SYNC_READ);
+            linux_send_all(sv[1], &msg.index, sizeof(msg.index));
+        }
+        linux_send_all(sv[1], &bad, sizeof(bad));
+        _exit(0);
+    }
+    close(sv[1]);
+    bool ok = pool.share(sv[0]);
+    for (uint32_t n = 0; ok && n < frames; n++) {
+        int index = pool.try_acquire();
+        if (index < 0) {
+            // all buffers are with the consumer: wait for one to come back
+            int32_t back = -1;
+            ok = linux_recv_all(sv[0], &back, sizeof(back));
+            pool.release(back);
+            index = pool.acquire();
+        }
+        LinuxBuffer *b = pool.at(index);
+        helper.mem_begin_cpu_access(b, LINUX_SYNC_WRITE);
+        produce(static_cast<uint8_t *>(b->va), size, n);
+        helper.mem_end_cpu_access(b, LINUX_SYNC_WRITE);
+        const FrameMsg msg = {index, n};
+        ok = ok && linux_send_all(sv[0], &msg, sizeof(msg));
+    }
+    const FrameMsg end = {-1, 0};
+    linux_send_all(sv[0], &end, sizeof(end));
+    // drain the returned indices, then the consumer's result
+    for (int outstanding = pool.count(); ok;) {
+        while (pool.try_acquire() >= 0) outstanding--;
+        if (outstanding == 0) break;
+        int32_t back = -1;
+        ok = linux_recv_all(sv[0], &back, sizeof(back));
+        pool.release(back);
+    }
+    if (!ok || !linux_recv_all(sv[0], &r.bad, sizeof(r.bad))) r.bad = -1;
+    r.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    waitpid(pid, nullptr, 0);
+    close(sv[0]);
+    return r;
+}
+
+}  // namespace
+
+int main() {
+    LinuxMemoryHelper helper;
+    printf("shared buffers: %s\n", helper.has_udmabuf() ? "udmabuf (dma-buf)" : "memfd");
+
+    struct Shape {
+        const char *name;
+        size_t size;
+    };
+    const Shape shapes[] = {{"640x480 gray", 640 * 480}, {"1080p NV12", 1920 * 1080 * 3 / 2},
+                            {"4K NV12", 3840 * 2160 * 3 / 2}};
+    bool pass = true;
+    printf("%-14s %-7s %8s %9s %9s %8s\n", "frame", "mode", "frames", "fps", "GB/s", "vs pipe");
+    for (const Shape &s : shapes) {
+        const uint32_t frames = (uint32_t)std::max<size_t>(60, std::min<size_t>(2000, (1u << 30) / s.size));
+        const Result results[3] = {run_copy(true, s.size, frames), run_copy(false, s.size, frames),
+                                   run_shared(helper, s.size, frames)};
+        const char *modes[3] = {"pipe", "socket", "shared"};
+        for (int m = 0; m < 3; m++) {
+            const Result &r = results[m];
+            pass = pass && r.bad == 0;
+            printf("%-14s %-7s %8u %9.1f %9.2f %7.2fx%s\n", s.name, modes[m], frames, frames * 1e3 / r.ms,
+                   (double)s.size * frames / r.ms / 1e6, results[0].ms / r.ms, r.bad == 0 ? "" : "  MISMATCH");
+        }
+    }
+    printf(pass ? "Test Passed!\n" : "Test Failed!\n");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+// Lifetime checks of the host MCVE stand-in: an algo released while its runs
+// are queued or running, and an event waited on after its algo is gone.
+// Build it with -fsanitize=thread and MCVE_HOST_THREADS=3 to check for races
+// between a finishing run and mcvReleaseAlgo.
+//
+// g++ -O1 -g -std=c++17 -fopenmp -pthread -Ihost/include main/host_runtime_main.cpp host/src/*.cpp -o host_runtime
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "mcve/MCVEAPI.h"
+#include "mcve/mcve_host.h"
+
+namespace {
+
+const int kLen = 256;
+const char kBinary[] = "slow_add";
+
+// vector_add that runs long enough for mcvReleaseAlgo to find it running
+int slow_add(const McvHostArgs &args) {
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    const int len = args.param<int>(0);
+    const int *a = args.buffer<int>(0);
+    const int *b = args.buffer<int>(1);
+    int *c = args.buffer<int>(2);
+    for (int i = 0; i < len; i++) c[i] = a[i] + b[i];
+    return MCV_SUCCESS;
+}
+
+}  // namespace
+
+int main() {
+    mcv_env_t *env;
+    if (mcvInitEnv(&env) != MCV_SUCCESS) return -1;
+    mcvHostRegisterAlgo(kBinary, 3, {sizeof(int)}, slow_add);
+    int err = 0;
+    mcv_buffer_t *a = mcvMemAlloc(env, kLen * sizeof(int), &err, "a", MCV_BUF_TYPE_DMA);
+    mcv_buffer_t *b = mcvMemAlloc(env, kLen * sizeof(int), &err, "b", MCV_BUF_TYPE_DMA);
+    mcv_buffer_t *c = mcvMemAlloc(env, kLen * sizeof(int), &err, "c", MCV_BUF_TYPE_DMA);
+    if (err != MCV_SUCCESS) return -1;
+    int *pa = static_cast<int *>(getHostPtr(a));
+    int *pb = static_cast<int *>(getHostPtr(b));
+    int *pc = static_cast<int *>(getHostPtr(c));
+    for (int i = 0; i < kLen; i++) {
+        pa[i] = i;
+        pb[i] = 7 * i;
+    }
+    int len = kLen;
+    mcv_buffer_t *buffers[3] = {a, b, c};
+    void *params[1] = {&len};
+    bool pass = true;
+
+    // run, release at once (the run is queued or running), then wait
+    const int rounds = 500;
+    for (int r = 0; r < rounds && pass; r++) {
+        pc[0] = -1;
+        mcv_algo_t *algo = mcvCreateCustomAlgo(env, kBinary, sizeof(kBinary), buffers, 3, params, 1, &err);
+        mcv_event_t event = nullptr;
+        pass &= algo != nullptr && mcvRunAlgo(algo, 0, nullptr, &event) == MCV_SUCCESS;
+        pass &= mcvReleaseAlgo(algo) == MCV_SUCCESS;
+        pass &= mcvWaitForEvents(1, &event) == MCV_SUCCESS && pc[0] == 0 && pc[kLen - 1] == 8 * (kLen - 1);
+        mcvReleaseEvent(&event);
+    }
+    printf("release while running: %d rounds %s\n", rounds, pass ? "ok" : "failed");
+
+    // a chain of runs of one algo, released before the first has finished
+    {
+        mcv_algo_t *algo = mcvCreateCustomAlgo(env, kBinary, sizeof(kBinary), buffers, 3, params, 1, &err);
+        mcv_event_t events[4] = {};
+        for (int i = 0; i < 4 && algo != nullptr; i++) {
+            pass &= mcvRunAlgo(algo, i > 0 ? 1 : 0, i > 0 ? &events[i - 1] : nullptr, &events[i]) == MCV_SUCCESS;
+        }
+        pass &= algo != nullptr && mcvReleaseAlgo(algo) == MCV_SUCCESS;
+        pass &= mcvWaitForEvents(4, events) == MCV_SUCCESS;
+        for (int i = 0; i < 4; i++) mcvReleaseEvent(&events[i]);
+        printf("release during a chain: %s\n", pass ? "ok" : "failed");
+    }
+
+    mcvMemFree(a);
+    mcvMemFree(b);
+    mcvMemFree(c);
+    mcvDeinitEnv(env);
+    printf(pass ? "Test Passed!\n" : "Test Failed!\n");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+// Launch overhead of a small kernel (vector_add, 64 ints) repeated per frame:
+//
+//   marshal only       building the argument lists: std::vector push_backs as
+//                      in swat_add_main.cpp / main.cpp, against the generated
+//                      VectorAddArgs::marshal into McvLaunch's fixed arrays
+//   by hand            per frame: vectors, mcvCreateCustomAlgo, run, wait,
+//                      release, as the demos launch once
+//   generated, create  per frame: McvLaunch::create from the prebuilt block
+//                      (what a frame with new scalar parameters needs), run
+//   generated, reuse   per frame: run the algo created once
+//
+// The runtime is the host stand-in, so the absolute numbers are the thread
+// pool's; the differences between the rows are the host-side launch code.
+//
+// g++ -O2 -std=c++17 -fopenmp -pthread -Ihost/include -Ilaunch main/launch_overhead_main.cpp host/src/*.cpp -o launch_overhead
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "vector_add_launch.h"
+
+namespace {
+
+const int kLen = 64;
+const char kBinary[] = "vector_add";
+
+double now_us() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// keeps the argument lists alive past the optimizer
+void *volatile g_sink;
+
+__attribute__((noinline)) void consume(mcv_buffer_t **buffers, void **params) {
+    g_sink = buffers[0];
+    g_sink = params[0];
+}
+
+bool check(McvBuffer<int32_t> c, int32_t len) {
+    for (int i = 0; i < len; i++) {
+        if (c.host()[i] != 3 * i) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    mcv_env_t *env;
+    if (mcvInitEnv(&env) != MCV_SUCCESS) return -1;
+    int err = 0;
+    McvBuffer<int32_t> a = mcvMemAllocT<int32_t>(env, kLen, &err, "a", MCV_BUF_TYPE_DMA);
+    McvBuffer<int32_t> b = mcvMemAllocT<int32_t>(env, kLen, &err, "b", MCV_BUF_TYPE_DMA);
+    McvBuffer<int32_t> c = mcvMemAllocT<int32_t>(env, kLen, &err, "c", MCV_BUF_TYPE_DMA);
+    if (err != MCV_SUCCESS) return -1;
+    for (int i = 0; i < kLen; i++) {
+        a.host()[i] = i;
+        b.host()[i] = 2 * i;
+    }
+    int32_t len = kLen;
+    bool pass = true;
+    const int frames = 20000;
+
+    // argument lists alone
+    double by_hand_ns, generated_ns;
+    {
+        const double t0 = now_us();
+        for (int f = 0; f < frames; f++) {
+            std::vector<mcv_buffer_t *> buffer_list;
+            buffer_list.push_back(a.get());
+            buffer_list.push_back(b.get());
+            buffer_list.push_back(c.get());
+            std::vector<void *> param_list;
+            param_list.push_back(&len);
+            consume(buffer_list.data(), param_list.data());
+        }
+        by_hand_ns = (now_us() - t0) * 1e3 / frames;
+        VectorAddArgs args(a, b, c, len);
+        mcv_buffer_t *buffers[VectorAddArgs::kBufferCount];
+        void *params[VectorAddArgs::kParamCount];
+        const double t1 = now_us();
+        for (int f = 0; f < frames; f++) {
+            args.marshal(buffers, params);
+            consume(buffers, params);
+        }
+        generated_ns = (now_us() - t1) * 1e3 / frames;
+    }
+    printf("%-20s %10s\n", "launch", "us/frame");
+    printf("%-20s %10.3f  (%.1f ns by hand, %.1f ns generated)\n", "marshal only", generated_ns / 1e3, by_hand_ns,
+           generated_ns);
+
+    // by hand, as the demos
+    {
+        std::memset(c.host(), 0, kLen * sizeof(int32_t));
+        const double t0 = now_us();
+        for (int f = 0; f < frames && pass; f++) {
+            std::vector<mcv_buffer_t *> buffer_list = {a.get(), b.get(), c.get()};
+            std::vector<void *> param_list = {(void *)&len};
+            mcv_algo_t *algo = mcvCreateCustomAlgo(env, kBinary, sizeof(kBinary), buffer_list.data(),
+                                                   buffer_list.size(), param_list.data(), param_list.size(), &err);
+            mcv_event_t event = nullptr;
+            pass &= algo != nullptr && mcvRunAlgo(algo, 0, nullptr, &event) == MCV_SUCCESS &&
+                    mcvWaitForEvents(1, &event) == MCV_SUCCESS;
+            mcvReleaseEvent(&event);
+            mcvReleaseAlgo(algo);
+        }
+        const double us = (now_us() - t0) / frames;
+        pass &= check(c, len);
+        printf("%-20s %10.3f\n", "by hand", us);
+    }
+
+    // generated: create from the prebuilt block every frame
+    VectorAddLaunch launch(VectorAddArgs(a, b, c, len));
+    {
+        std::memset(c.host(), 0, kLen * sizeof(int32_t));
+        const double t0 = now_us();
+        for (int f = 0; f < frames && pass; f++) {
+            pass &= launch.create(env, kBinary, sizeof(kBinary)) == MCV_SUCCESS && launch.run_sync() == MCV_SUCCESS;
+        }
+        const double us = (now_us() - t0) / frames;
+        pass &= check(c, len);
+        printf("%-20s %10.3f\n", "generated, create", us);
+    }
+
+    // generated: the algo is created once
+    {
+        std::memset(c.host(), 0, kLen * sizeof(int32_t));
+        pass &= launch.create(env, kBinary, sizeof(kBinary)) == MCV_SUCCESS;
+        const double t0 = now_us();
+        for (int f = 0; f < frames && pass; f++) pass &= launch.run_sync() == MCV_SUCCESS;
+        const double us = (now_us() - t0) / frames;
+        pass &= check(c, len);
+        printf("%-20s %10.3f\n", "generated, reuse", us);
+    }
+    launch.release();
+
+    mcvMemFree(a.get());
+    mcvMemFree(b.get());
+    mcvMemFree(c.get());
+    mcvDeinitEnv(env);
+    printf(pass ? "Test Passed!\n" : "Test Failed!\n");
+    return pass ? 0 : 1;
+}
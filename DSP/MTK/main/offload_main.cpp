@@ -0,0 +1,97 @@
+// Offload cost model for vector_add: calibrates every backend, saves the model
+// to offload_model.txt (or the path given as argument) and reloads it, then
+// compares the model's prediction with a measurement per backend and size and
+// checks that the dispatcher's choice computes the right result.
+//
+// The MCVE backend loads vector_add.bin like swat_add_main.cpp; without it the
+// kernel entry name is passed, which the host stand-in accepts.
+//
+// g++ -O2 -std=c++17 -fopenmp -pthread -Ihost/include main/offload_main.cpp host/src/*.cpp -o offload
+// with OpenCL: add -DOFFLOAD_WITH_OPENCL -lOpenCL
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "../offload/offload_vector_add.h"
+
+int main(int argc, char **argv) {
+    const char *model_path = argc > 1 ? argv[1] : "offload_model.txt";
+    mcv_env_t *env = nullptr;
+    if (mcvInitEnv(&env) != MCV_SUCCESS) env = nullptr;
+    std::vector<char> binary;
+    std::ifstream fin("vector_add.bin", std::ios::binary);
+    if (fin) {
+        binary.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+    } else {
+        const char entry[] = "vector_add";
+        binary.assign(entry, entry + sizeof(entry));
+    }
+
+    OffloadVectorAdd o;
+    offload_vector_add_init(&o, env, binary.data(), binary.size());
+    bool pass = offload_vector_add_calibrate(&o);
+    printf("calibration\n");
+    offload_model_print(o.model, stdout);
+
+    // the saved model must come back unchanged
+    OffloadModel loaded;
+    pass &= offload_model_save(o.model, model_path) && offload_model_load(&loaded, model_path);
+    for (int b = 0; b < OFFLOAD_BACKEND_COUNT; b++) {
+        pass &= memcmp(&loaded.cost[b], &o.model.cost[b], sizeof(OffloadCost)) == 0;
+    }
+    offload_vector_add_use_model(&o, loaded);
+    printf("model saved to %s\n\n", model_path);
+
+    const size_t sizes[] = {8, 64, 512, 4096, 32768, 262144, 2097152};
+    const size_t max_n = 2097152;
+    std::vector<int32_t> a(max_n), b(max_n), c(max_n);
+    for (size_t i = 0; i < max_n; i++) {
+        a[i] = (int32_t)i;
+        b[i] = (int32_t)(i * 10);
+    }
+    auto check = [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            if (c[i] != a[i] + b[i]) return false;
+        }
+        return true;
+    };
+
+    printf("%9s", "elems");
+    for (int be = 0; be < OFFLOAD_BACKEND_COUNT; be++) {
+        if (o.model.cost[be].available) printf(" %22s", offload_backend_name(be));
+    }
+    printf("  %-11s %-11s %s\n", "chosen", "fastest", "chosen/fastest");
+    printf("%9s", "");
+    for (int be = 0; be < OFFLOAD_BACKEND_COUNT; be++) {
+        if (o.model.cost[be].available) printf(" %22s", "predicted / measured us");
+    }
+    printf("\n");
+
+    for (size_t n : sizes) {
+        const OffloadShape shape = offload_vector_add_shape(n);
+        double measured[OFFLOAD_BACKEND_COUNT] = {};
+        int fastest = -1;
+        printf("%9zu", n);
+        for (int be = 0; be < OFFLOAD_BACKEND_COUNT; be++) {
+            if (!o.model.cost[be].available) continue;
+            std::fill(c.begin(), c.begin() + n, 0);
+            int err = 0;
+            measured[be] =
+                offload_time_us([&] { err |= offload_vector_add_on(&o, be, a.data(), b.data(), c.data(), n); });
+            pass &= err == 0 && check(n);
+            if (fastest < 0 || measured[be] < measured[fastest]) fastest = be;
+            printf(" %10.2f / %9.2f", offload_predict_us(o.model.cost[be], shape), measured[be]);
+        }
+        int used = -1;
+        std::fill(c.begin(), c.begin() + n, 0);
+        pass &= offload_vector_add(&o, a.data(), b.data(), c.data(), n, &used) == 0 && check(n);
+        printf("  %-11s %-11s %.2fx\n", offload_backend_name(used), offload_backend_name(fastest),
+               used >= 0 && fastest >= 0 ? measured[used] / measured[fastest] : 0.0);
+    }
+
+    offload_vector_add_release(&o);
+    if (env != nullptr) mcvDeinitEnv(env);
+    printf(pass ? "Test Passed!\n" : "Test Failed!\n");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+// Kernel file for offload_vector_add.h, expanded once per backend by
+// simd/xr_simd_foreach.h.
+
+inline void vector_add_i32(const int32_t *a, const int32_t *b, int32_t *c, size_t n) {
+    const size_t N = vi32::N;
+    size_t i = 0;
+    for (; i + N <= n; i += N) storeu(c + i, add(loadu(a + i), loadu(b + i)));
+    for (; i < n; i++) c[i] = (int32_t)((uint32_t)a[i] + (uint32_t)b[i]);
+}
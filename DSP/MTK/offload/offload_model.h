@@ -0,0 +1,170 @@
+/*
+ * Cost model for offloading a kernel call to one of several backends.
+ *
+ * Every backend is described by the costs a calibration run measures:
+ *
+ *   launch_us    fixed cost of one call (argument setup, enqueue, wait),
+ *                with the data already on the device
+ *   ns_per_elem  kernel time per element
+ *   h2d_us, h2d_gbs   fixed cost and bandwidth of moving one input buffer
+ *                from the caller's array to the device
+ *   d2h_us, d2h_gbs   the same for one output buffer back
+ *
+ * Backends that work on the caller's arrays directly (the CPU ones) have
+ * h2d_gbs == d2h_gbs == 0, which means no copy at all. A call then costs
+ *
+ *   launch_us + elems * ns_per_elem
+ *     + per input buffer:  h2d_us + bytes / h2d_gbs
+ *     + per output buffer: d2h_us + bytes / d2h_gbs
+ *
+ * and offload_choose picks the cheapest available backend for a call shape.
+ * The model is plain numbers: offload_model_save / offload_model_load keep a
+ * calibration across runs of the same machine.
+ */
+#ifndef OFFLOAD_MODEL_H_
+#define OFFLOAD_MODEL_H_
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+enum OffloadBackend {
+    OFFLOAD_CPU_SCALAR = 0,
+    OFFLOAD_CPU_SIMD,
+    OFFLOAD_OPENCL,
+    OFFLOAD_MCVE,
+    OFFLOAD_BACKEND_COUNT
+};
+
+inline const char *offload_backend_name(int backend) {
+    static const char *const kNames[OFFLOAD_BACKEND_COUNT] = {"cpu_scalar", "cpu_simd", "opencl", "mcve"};
+    return backend >= 0 && backend < OFFLOAD_BACKEND_COUNT ? kNames[backend] : "none";
+}
+
+struct OffloadCost {
+    int available = 0;
+    double launch_us = 0.0;
+    double ns_per_elem = 0.0;
+    double h2d_us = 0.0, h2d_gbs = 0.0;
+    double d2h_us = 0.0, d2h_gbs = 0.0;
+};
+
+struct OffloadModel {
+    OffloadCost cost[OFFLOAD_BACKEND_COUNT];
+};
+
+// What one call moves and computes.
+struct OffloadShape {
+    size_t elems = 0;
+    int in_buffers = 0;
+    size_t in_bytes = 0;  // per input buffer
+    int out_buffers = 0;
+    size_t out_bytes = 0;  // per output buffer
+};
+
+// GB/s is 1e3 bytes per us
+inline double offload_copy_us(double fixed_us, double gbs, size_t bytes) {
+    return gbs > 0.0 ? fixed_us + (double)bytes / (gbs * 1e3) : 0.0;
+}
+
+inline double offload_predict_us(const OffloadCost &c, const OffloadShape &s) {
+    return c.launch_us + (double)s.elems * c.ns_per_elem * 1e-3 +
+           s.in_buffers * offload_copy_us(c.h2d_us, c.h2d_gbs, s.in_bytes) +
+           s.out_buffers * offload_copy_us(c.d2h_us, c.d2h_gbs, s.out_bytes);
+}
+
+// cheapest available backend, or -1 when none is available
+inline int offload_choose(const OffloadModel &m, const OffloadShape &s, double *predicted_us = nullptr) {
+    int best = -1;
+    double best_us = 0.0;
+    for (int b = 0; b < OFFLOAD_BACKEND_COUNT; b++) {
+        if (!m.cost[b].available) continue;
+        const double us = offload_predict_us(m.cost[b], s);
+        if (best < 0 || us < best_us) {
+            best = b;
+            best_us = us;
+        }
+    }
+    if (predicted_us != nullptr) *predicted_us = best_us;
+    return best;
+}
+
+// Fits t = fixed + slope * x to calibration points. fixed is the time at the
+// smallest x, where the per-unit part is negligible, and slope the least
+// squares fit through it of the others; a least squares intercept would be
+// dominated by the noise of the large points. Both are clamped at 0.
+// The largest points set the slope, so for a memory-bound kernel the model
+// is tuned to data that does not fit in cache and overestimates small calls.
+inline void offload_fit(const std::vector<double> &x, const std::vector<double> &t, double *fixed, double *slope) {
+    size_t lo = 0;
+    for (size_t i = 1; i < x.size(); i++) {
+        if (x[i] < x[lo]) lo = i;
+    }
+    *fixed = x.empty() ? 0.0 : t[lo] > 0.0 ? t[lo] : 0.0;
+    double num = 0.0, den = 0.0;
+    for (size_t i = 0; i < x.size(); i++) {
+        const double dx = x[i] - x[lo];
+        num += dx * (t[i] - t[lo]);
+        den += dx * dx;
+    }
+    *slope = den > 0.0 && num > 0.0 ? num / den : 0.0;
+}
+
+// One line per backend:
+//   <name> <available> <launch_us> <ns_per_elem> <h2d_us> <h2d_gbs> <d2h_us> <d2h_gbs>
+inline bool offload_model_save(const OffloadModel &m, const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == nullptr) return false;
+    fprintf(f, "# backend available launch_us ns_per_elem h2d_us h2d_gbs d2h_us d2h_gbs\n");
+    for (int b = 0; b < OFFLOAD_BACKEND_COUNT; b++) {
+        const OffloadCost &c = m.cost[b];
+        fprintf(f, "%s %d %.17g %.17g %.17g %.17g %.17g %.17g\n", offload_backend_name(b), c.available, c.launch_us,
+                c.ns_per_elem, c.h2d_us, c.h2d_gbs, c.d2h_us, c.d2h_gbs);
+    }
+    return fclose(f) == 0;
+}
+
+// Backends missing from the file stay unavailable.
+inline bool offload_model_load(OffloadModel *m, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) return false;
+    *m = OffloadModel();
+    char line[256];
+    bool ok = true;
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        char name[32];
+        OffloadCost c;
+        if (sscanf(line, "%31s %d %lf %lf %lf %lf %lf %lf", name, &c.available, &c.launch_us, &c.ns_per_elem,
+                   &c.h2d_us, &c.h2d_gbs, &c.d2h_us, &c.d2h_gbs) != 8) {
+            ok = false;
+            break;
+        }
+        int b = 0;
+        while (b < OFFLOAD_BACKEND_COUNT && strcmp(name, offload_backend_name(b)) != 0) b++;
+        if (b == OFFLOAD_BACKEND_COUNT) {
+            ok = false;
+            break;
+        }
+        m->cost[b] = c;
+    }
+    fclose(f);
+    return ok;
+}
+
+inline void offload_model_print(const OffloadModel &m, FILE *out) {
+    fprintf(out, "%-11s %10s %11s %9s %9s %9s %9s\n", "backend", "launch_us", "ns/elem", "h2d_us", "h2d_GB/s",
+            "d2h_us", "d2h_GB/s");
+    for (int b = 0; b < OFFLOAD_BACKEND_COUNT; b++) {
+        const OffloadCost &c = m.cost[b];
+        if (!c.available) {
+            fprintf(out, "%-11s  unavailable\n", offload_backend_name(b));
+            continue;
+        }
+        fprintf(out, "%-11s %10.3f %11.4f %9.3f %9.2f %9.3f %9.2f\n", offload_backend_name(b), c.launch_us,
+                c.ns_per_elem, c.h2d_us, c.h2d_gbs, c.d2h_us, c.d2h_gbs);
+    }
+}
+
+#endif  // OFFLOAD_MODEL_H_
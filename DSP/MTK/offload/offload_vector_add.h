@@ -0,0 +1,412 @@
+/*
+ * vector_add (c = a + b on int32) on every backend of offload_model.h, a
+ * calibration that fills the cost model from measurements, and a dispatcher
+ * that runs each call on the backend the model predicts to be fastest for
+ * its size.
+ *
+ *   cpu_scalar  plain loop, not vectorized
+ *   cpu_simd    simd/ kernel at the best ISA of the CPU (XR_SIMD_DISPATCH)
+ *   opencl      cl/swat_add.cl on the first GPU, or any OpenCL device;
+ *               compiled only with -DOFFLOAD_WITH_OPENCL
+ *   mcve        the vector_add custom kernel through the launch descriptor of
+ *               launch/vector_add_launch.h, on MCV_BUF_TYPE_DEFAULT buffers
+ *
+ * The offloaded backends copy the caller's arrays in and the result out on
+ * every call; their buffers and the MCVE algo are kept between calls of the
+ * same size, so the model describes repeated calls (a per-frame kernel) and
+ * the first call of a new size also pays the allocation.
+ */
+#ifndef OFFLOAD_VECTOR_ADD_H_
+#define OFFLOAD_VECTOR_ADD_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "offload_model.h"
+#include "../launch/vector_add_launch.h"
+#include "../../../simd/xr_simd.h"
+
+#ifdef OFFLOAD_WITH_OPENCL
+#include <OpenCL/opencl.h>
+#endif
+
+namespace offload_simd {
+#define XR_SIMD_KERNELS "../DSP/MTK/offload/offload_kernels.inl"
+#include "../../../simd/xr_simd_foreach.h"
+}  // namespace offload_simd
+
+#if defined(__GNUC__) && !defined(__clang__)
+__attribute__((optimize("no-tree-vectorize")))
+#endif
+inline void vector_add_scalar(const int32_t *a, const int32_t *b, int32_t *c, size_t n) {
+#if defined(__clang__)
+#pragma clang loop vectorize(disable)
+#endif
+    for (size_t i = 0; i < n; i++) c[i] = (int32_t)((uint32_t)a[i] + (uint32_t)b[i]);
+}
+
+#ifdef OFFLOAD_WITH_OPENCL
+// same kernel as cl/swat_add.cl
+static const char *kOffloadVectorAddSource =
+    "__kernel void vector_add(__global const int* a,\n"
+    "                         __global const int* b,\n"
+    "                         __global int* c,\n"
+    "                         int len) {\n"
+    "    int id = get_global_id(0);\n"
+    "    if (id < len) {\n"
+    "        c[id] = a[id] + b[id];\n"
+    "    }\n"
+    "}\n";
+#endif
+
+struct OffloadVectorAdd {
+    OffloadModel model;
+    int ready[OFFLOAD_BACKEND_COUNT] = {};  // initialized and usable, calibrated or not
+
+    mcv_env_t *env = nullptr;
+    std::vector<char> binary;
+    std::unique_ptr<VectorAddLaunch> mcve;  // null before the first call
+    size_t mcve_elems = 0;                   // size of its buffers and algo
+
+#ifdef OFFLOAD_WITH_OPENCL
+    cl_context cl_ctx = nullptr;
+    cl_command_queue cl_queue = nullptr;
+    cl_program cl_prog = nullptr;
+    cl_kernel cl_kern = nullptr;
+    cl_mem cl_buf[3] = {};
+    size_t cl_capacity = 0;  // elements of cl_buf
+#endif
+};
+
+#ifdef OFFLOAD_WITH_OPENCL
+inline void offload_opencl_release(OffloadVectorAdd *o) {
+    for (int i = 0; i < 3; i++) {
+        if (o->cl_buf[i] != nullptr) clReleaseMemObject(o->cl_buf[i]);
+        o->cl_buf[i] = nullptr;
+    }
+    o->cl_capacity = 0;
+    if (o->cl_kern != nullptr) clReleaseKernel(o->cl_kern);
+    if (o->cl_prog != nullptr) clReleaseProgram(o->cl_prog);
+    if (o->cl_queue != nullptr) clReleaseCommandQueue(o->cl_queue);
+    if (o->cl_ctx != nullptr) clReleaseContext(o->cl_ctx);
+    o->cl_kern = nullptr;
+    o->cl_prog = nullptr;
+    o->cl_queue = nullptr;
+    o->cl_ctx = nullptr;
+}
+
+// The OpenCL backend is optional: any failure leaves it unavailable instead
+// of exiting like CHECK_ERROR.
+inline bool offload_opencl_init(OffloadVectorAdd *o) {
+    cl_uint num_platforms = 0;
+    if (clGetPlatformIDs(0, NULL, &num_platforms) != CL_SUCCESS || num_platforms == 0) return false;
+    std::vector<cl_platform_id> platforms(num_platforms);
+    clGetPlatformIDs(num_platforms, platforms.data(), NULL);
+    cl_device_id device = NULL;
+    const cl_device_type types[2] = {CL_DEVICE_TYPE_GPU, CL_DEVICE_TYPE_ALL};
+    for (int t = 0; t < 2 && device == NULL; t++) {
+        for (cl_uint p = 0; p < num_platforms && device == NULL; p++) {
+            if (clGetDeviceIDs(platforms[p], types[t], 1, &device, NULL) != CL_SUCCESS) device = NULL;
+        }
+    }
+    if (device == NULL) return false;
+
+    cl_int err;
+    o->cl_ctx = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    if (err == CL_SUCCESS) o->cl_queue = clCreateCommandQueue(o->cl_ctx, device, 0, &err);
+    if (err == CL_SUCCESS) o->cl_prog = clCreateProgramWithSource(o->cl_ctx, 1, &kOffloadVectorAddSource, NULL, &err);
+    if (err == CL_SUCCESS) err = clBuildProgram(o->cl_prog, 1, &device, NULL, NULL, NULL);
+    if (err == CL_SUCCESS) o->cl_kern = clCreateKernel(o->cl_prog, "vector_add", &err);
+    if (err != CL_SUCCESS) {
+        offload_opencl_release(o);
+        return false;
+    }
+    return true;
+}
+
+inline bool offload_opencl_reserve(OffloadVectorAdd *o, size_t n) {
+    if (n <= o->cl_capacity) return true;
+    const cl_mem_flags flags[3] = {CL_MEM_READ_ONLY, CL_MEM_READ_ONLY, CL_MEM_WRITE_ONLY};
+    for (int i = 0; i < 3; i++) {
+        if (o->cl_buf[i] != nullptr) clReleaseMemObject(o->cl_buf[i]);
+        cl_int err;
+        o->cl_buf[i] = clCreateBuffer(o->cl_ctx, flags[i], n * sizeof(int32_t), NULL, &err);
+        if (err != CL_SUCCESS) {
+            for (int k = 0; k <= i; k++) {
+                if (o->cl_buf[k] != nullptr) clReleaseMemObject(o->cl_buf[k]);
+                o->cl_buf[k] = nullptr;
+            }
+            o->cl_capacity = 0;
+            return false;
+        }
+    }
+    o->cl_capacity = n;
+    return true;
+}
+
+// enqueues the kernel on len elements of the device buffers
+inline cl_int offload_opencl_enqueue(OffloadVectorAdd *o, size_t n) {
+    const int len = (int)n;
+    clSetKernelArg(o->cl_kern, 0, sizeof(cl_mem), &o->cl_buf[0]);
+    clSetKernelArg(o->cl_kern, 1, sizeof(cl_mem), &o->cl_buf[1]);
+    clSetKernelArg(o->cl_kern, 2, sizeof(cl_mem), &o->cl_buf[2]);
+    clSetKernelArg(o->cl_kern, 3, sizeof(int), &len);
+    return clEnqueueNDRangeKernel(o->cl_queue, o->cl_kern, 1, NULL, &n, NULL, 0, NULL, NULL);
+}
+
+inline int offload_opencl_run(OffloadVectorAdd *o, const int32_t *a, const int32_t *b, int32_t *c, size_t n) {
+    if (!offload_opencl_reserve(o, n)) return -1;
+    const size_t bytes = n * sizeof(int32_t);
+    cl_int err = clEnqueueWriteBuffer(o->cl_queue, o->cl_buf[0], CL_FALSE, 0, bytes, a, 0, NULL, NULL);
+    if (err == CL_SUCCESS) err = clEnqueueWriteBuffer(o->cl_queue, o->cl_buf[1], CL_FALSE, 0, bytes, b, 0, NULL, NULL);
+    if (err == CL_SUCCESS) err = offload_opencl_enqueue(o, n);
+    if (err == CL_SUCCESS) err = clEnqueueReadBuffer(o->cl_queue, o->cl_buf[2], CL_TRUE, 0, bytes, c, 0, NULL, NULL);
+    return err == CL_SUCCESS ? 0 : -1;
+}
+#endif  // OFFLOAD_WITH_OPENCL
+
+// Buffers of exactly n elements, since the sync calls copy whole buffers, and
+// the algo created for len = n (params are copied at create).
+inline void offload_mcve_free(OffloadVectorAdd *o) {
+    if (o->mcve == nullptr) return;
+    o->mcve->release();
+    mcvMemFree(o->mcve->args.a.get());
+    mcvMemFree(o->mcve->args.b.get());
+    mcvMemFree(o->mcve->args.c.get());
+    o->mcve.reset();
+    o->mcve_elems = 0;
+}
+
+inline int offload_mcve_prepare(OffloadVectorAdd *o, size_t n) {
+    if (o->mcve != nullptr && n == o->mcve_elems && o->mcve->algo() != nullptr) return 0;
+    offload_mcve_free(o);
+    int err = MCV_SUCCESS;
+    McvBuffer<int32_t> a = mcvMemAllocT<int32_t>(o->env, n, &err, "offload_a", MCV_BUF_TYPE_DEFAULT);
+    McvBuffer<int32_t> b = mcvMemAllocT<int32_t>(o->env, n, &err, "offload_b", MCV_BUF_TYPE_DEFAULT);
+    McvBuffer<int32_t> c = mcvMemAllocT<int32_t>(o->env, n, &err, "offload_c", MCV_BUF_TYPE_DEFAULT);
+    if (a.get() == nullptr || b.get() == nullptr || c.get() == nullptr) {
+        if (a.get() != nullptr) mcvMemFree(a.get());
+        if (b.get() != nullptr) mcvMemFree(b.get());
+        if (c.get() != nullptr) mcvMemFree(c.get());
+        return -1;
+    }
+    o->mcve.reset(new VectorAddLaunch(VectorAddArgs(a, b, c, (int32_t)n)));
+    o->mcve_elems = n;
+    return o->mcve->create(o->env, o->binary.data(), o->binary.size()) == MCV_SUCCESS ? 0 : -1;
+}
+
+inline int offload_mcve_h2d(OffloadVectorAdd *o, mcv_buffer_t *buffer, const int32_t *src, size_t n) {
+    memcpy(getHostPtr(buffer), src, n * sizeof(int32_t));
+    return mcvSyncBufferHostToDevice(o->env, buffer);
+}
+
+inline int offload_mcve_d2h(OffloadVectorAdd *o, mcv_buffer_t *buffer, int32_t *dst, size_t n) {
+    const int err = mcvSyncBufferDeviceToHost(o->env, buffer);
+    memcpy(dst, getHostPtr(buffer), n * sizeof(int32_t));
+    return err;
+}
+
+inline int offload_mcve_run(OffloadVectorAdd *o, const int32_t *a, const int32_t *b, int32_t *c, size_t n) {
+    if (offload_mcve_prepare(o, n) != 0) return -1;
+    const VectorAddArgs &args = o->mcve->args;
+    if (offload_mcve_h2d(o, args.a.get(), a, n) != MCV_SUCCESS ||
+        offload_mcve_h2d(o, args.b.get(), b, n) != MCV_SUCCESS ||
+        o->mcve->run_sync() != MCV_SUCCESS || offload_mcve_d2h(o, args.c.get(), c, n) != MCV_SUCCESS) {
+        return -1;
+    }
+    return 0;
+}
+
+// Readies every backend this build and machine have. env may be null (no
+// MCVE backend); binary is what mcvCreateCustomAlgo gets for vector_add. The
+// model starts uncalibrated: calibrate, or load a saved one with
+// offload_vector_add_use_model.
+inline int offload_vector_add_init(OffloadVectorAdd *o, mcv_env_t *env, const void *binary, size_t binary_size) {
+    o->model = OffloadModel();
+    o->ready[OFFLOAD_CPU_SCALAR] = 1;
+    o->ready[OFFLOAD_CPU_SIMD] = 1;
+#ifdef OFFLOAD_WITH_OPENCL
+    o->ready[OFFLOAD_OPENCL] = offload_opencl_init(o) ? 1 : 0;
+#endif
+    if (env != nullptr && binary != nullptr && binary_size > 0) {
+        o->env = env;
+        o->binary.assign((const char *)binary, (const char *)binary + binary_size);
+        o->ready[OFFLOAD_MCVE] = 1;
+    }
+    return 0;
+}
+
+inline void offload_vector_add_release(OffloadVectorAdd *o) {
+    offload_mcve_free(o);
+#ifdef OFFLOAD_WITH_OPENCL
+    offload_opencl_release(o);
+#endif
+    for (int b = 0; b < OFFLOAD_BACKEND_COUNT; b++) o->ready[b] = 0;
+}
+
+// Takes a saved model; backends not ready here stay unavailable.
+inline void offload_vector_add_use_model(OffloadVectorAdd *o, const OffloadModel &m) {
+    o->model = m;
+    for (int b = 0; b < OFFLOAD_BACKEND_COUNT; b++) {
+        if (!o->ready[b]) o->model.cost[b].available = 0;
+    }
+}
+
+inline OffloadShape offload_vector_add_shape(size_t n) {
+    OffloadShape s;
+    s.elems = n;
+    s.in_buffers = 2;
+    s.in_bytes = n * sizeof(int32_t);
+    s.out_buffers = 1;
+    s.out_bytes = n * sizeof(int32_t);
+    return s;
+}
+
+// c = a + b on one backend; 0 on success
+inline int offload_vector_add_on(OffloadVectorAdd *o, int backend, const int32_t *a, const int32_t *b, int32_t *c,
+                                 size_t n) {
+    if (backend < 0 || backend >= OFFLOAD_BACKEND_COUNT || !o->ready[backend] || n > (size_t)INT32_MAX) return -1;
+    if (n == 0) return 0;
+    switch (backend) {
+        case OFFLOAD_CPU_SCALAR:
+            vector_add_scalar(a, b, c, n);
+            return 0;
+        case OFFLOAD_CPU_SIMD:
+            XR_SIMD_DISPATCH_IN(::offload_simd, vector_add_i32)(a, b, c, n);
+            return 0;
+#ifdef OFFLOAD_WITH_OPENCL
+        case OFFLOAD_OPENCL:
+            return offload_opencl_run(o, a, b, c, n);
+#endif
+        case OFFLOAD_MCVE:
+            return offload_mcve_run(o, a, b, c, n);
+        default:
+            return -1;
+    }
+}
+
+// c = a + b on the backend the model predicts to be fastest for n, which is
+// returned in *used. Before calibration the model has no backend and the
+// call runs on cpu_simd.
+inline int offload_vector_add(OffloadVectorAdd *o, const int32_t *a, const int32_t *b, int32_t *c, size_t n,
+                              int *used = nullptr) {
+    int backend = offload_choose(o->model, offload_vector_add_shape(n));
+    if (backend < 0) backend = OFFLOAD_CPU_SIMD;
+    if (used != nullptr) *used = backend;
+    return offload_vector_add_on(o, backend, a, b, c, n);
+}
+
+// Median over batches of the time of one fn() call, in us; a batch repeats fn
+// until it has run for at least min_batch_us.
+template <typename F>
+double offload_time_us(F fn, int batches = 7, double min_batch_us = 300.0) {
+    using clock = std::chrono::steady_clock;
+    fn();
+    int reps = 1;
+    std::vector<double> per_call;
+    while ((int)per_call.size() < batches) {
+        const clock::time_point t0 = clock::now();
+        for (int r = 0; r < reps; r++) fn();
+        const double us = std::chrono::duration<double, std::micro>(clock::now() - t0).count();
+        if (us < min_batch_us && reps < (1 << 20)) {
+            reps *= 2;
+            continue;
+        }
+        per_call.push_back(us / reps);
+    }
+    std::sort(per_call.begin(), per_call.end());
+    return per_call[per_call.size() / 2];
+}
+
+// Measures every ready backend and fills o->model:
+//   launch_us, ns_per_elem   the call with the data already on the device,
+//                            fitted over sizes from 1 to 1M elements
+//   h2d / d2h                moving one buffer in or out, from 4 bytes to 4 MB
+// Returns false when a backend fails during calibration; it is then left
+// unavailable and the others are still calibrated.
+inline bool offload_vector_add_calibrate(OffloadVectorAdd *o) {
+    const size_t sizes[] = {1, 256, 4096, 65536, 1 << 20};
+    const size_t max_n = 1 << 20;
+    std::vector<int32_t> a(max_n), b(max_n), c(max_n);
+    for (size_t i = 0; i < max_n; i++) {
+        a[i] = (int32_t)i;
+        b[i] = (int32_t)(3 * i);
+    }
+    bool ok = true;
+    for (int backend = 0; backend < OFFLOAD_BACKEND_COUNT; backend++) {
+        OffloadCost cost;
+        if (!o->ready[backend]) {
+            o->model.cost[backend] = cost;
+            continue;
+        }
+        std::vector<double> x, run, h2d, d2h;
+        bool failed = false;
+        for (size_t n : sizes) {
+            x.push_back((double)n);
+            int err = 0;
+            if (backend == OFFLOAD_CPU_SCALAR || backend == OFFLOAD_CPU_SIMD) {
+                run.push_back(offload_time_us(
+                    [&] { err |= offload_vector_add_on(o, backend, a.data(), b.data(), c.data(), n); }));
+            }
+#ifdef OFFLOAD_WITH_OPENCL
+            if (backend == OFFLOAD_OPENCL) {
+                const size_t bytes = n * sizeof(int32_t);
+                err |= offload_opencl_reserve(o, n) ? 0 : -1;
+                if (err == 0) {
+                    run.push_back(offload_time_us([&] {
+                        err |= offload_opencl_enqueue(o, n);
+                        err |= clFinish(o->cl_queue);
+                    }));
+                    h2d.push_back(offload_time_us([&] {
+                        err |= clEnqueueWriteBuffer(o->cl_queue, o->cl_buf[0], CL_TRUE, 0, bytes, a.data(), 0, NULL,
+                                                    NULL);
+                    }));
+                    d2h.push_back(offload_time_us([&] {
+                        err |= clEnqueueReadBuffer(o->cl_queue, o->cl_buf[2], CL_TRUE, 0, bytes, c.data(), 0, NULL,
+                                                   NULL);
+                    }));
+                }
+            }
+#endif
+            if (backend == OFFLOAD_MCVE) {
+                err |= offload_mcve_prepare(o, n);
+                if (err == 0) {
+                    const VectorAddArgs &args = o->mcve->args;
+                    run.push_back(offload_time_us([&] { err |= o->mcve->run_sync(); }));
+                    h2d.push_back(offload_time_us([&] { err |= offload_mcve_h2d(o, args.a.get(), a.data(), n); }));
+                    d2h.push_back(offload_time_us([&] { err |= offload_mcve_d2h(o, args.c.get(), c.data(), n); }));
+                }
+            }
+            if (err != 0) {
+                failed = true;
+                break;
+            }
+        }
+        if (failed) {
+            ok = false;
+            o->model.cost[backend] = cost;
+            continue;
+        }
+        double slope;
+        offload_fit(x, run, &cost.launch_us, &slope);
+        cost.ns_per_elem = slope * 1e3;
+        if (!h2d.empty()) {
+            // x in bytes: us per byte -> GB/s
+            std::vector<double> bytes(x);
+            for (double &v : bytes) v *= sizeof(int32_t);
+            offload_fit(bytes, h2d, &cost.h2d_us, &slope);
+            cost.h2d_gbs = slope > 0.0 ? 1e-3 / slope : 1e6;
+            offload_fit(bytes, d2h, &cost.d2h_us, &slope);
+            cost.d2h_gbs = slope > 0.0 ? 1e-3 / slope : 1e6;
+        }
+        cost.available = 1;
+        o->model.cost[backend] = cost;
+    }
+    return ok;
+}
+
+#endif  // OFFLOAD_VECTOR_ADD_H_
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""Generates typed launch descriptors from MCVE kernel JSON specs.
+
+For every kernel of a spec (the file gen_mcve_binary compiles), writes a
+header with a <Kernel>Args struct for launch/mcve_launch.h:
+
+  - i_buffer / o_buffer / buffer arguments become McvBuffer<T> fields
+    (McvBuffer<const T> for i_buffer), param arguments plain T fields, all in
+    kernel order; marshal() fills the argument lists mcvCreateCustomAlgo takes
+  - const_param and internal_buffer arguments are baked into the binary and
+    not passed by the host; they become constants of the struct
+
+Usage:
+    tools/gen_mcve_launch.py json/swat_add.json -o launch/vector_add_launch.h
+    tools/gen_mcve_launch.py spec.json -o out.h --source-name spec.json
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+# OpenCL C scalar types of the specs -> C++ types
+TYPES = {
+    "char": "int8_t",
+    "uchar": "uint8_t",
+    "short": "int16_t",
+    "ushort": "uint16_t",
+    "int": "int32_t",
+    "uint": "uint32_t",
+    "long": "int64_t",
+    "ulong": "uint64_t",
+    "float": "float",
+    "double": "double",
+}
+
+BUFFER_KINDS = ("i_buffer", "o_buffer", "buffer")
+KINDS = BUFFER_KINDS + ("param", "const_param", "internal_buffer")
+
+
+class SpecError(Exception):
+    pass
+
+
+def camel(name):
+    parts = re.split(r"[^0-9A-Za-z]+", name)
+    return "".join(p[:1].upper() + p[1:] for p in parts if p)
+
+
+def parse_kernel(kernel):
+    entry = kernel.get("kernel_entry_name")
+    if not entry or not re.match(r"^[A-Za-z_]\w*$", entry):
+        raise SpecError("kernel_entry_name %r is not a C identifier" % entry)
+    args = []
+    names = set()
+    for i, item in enumerate(kernel.get("kernel_argument", [])):
+        if not isinstance(item, dict) or len(item) != 1:
+            raise SpecError("%s: argument %d must be a one-key object" % (entry, i))
+        kind, value = next(iter(item.items()))
+        if kind not in KINDS:
+            raise SpecError("%s: argument %d has unknown kind %r" % (entry, i, kind))
+        want = 3 if kind in ("const_param", "internal_buffer") else 2
+        if not isinstance(value, list) or len(value) != want:
+            raise SpecError("%s: %s argument %d needs %d fields" % (entry, kind, i, want))
+        ctype, name = value[0], value[1]
+        if ctype not in TYPES:
+            raise SpecError("%s: argument %r has unsupported type %r" % (entry, name, ctype))
+        if not re.match(r"^[A-Za-z_]\w*$", name) or name in names:
+            raise SpecError("%s: argument name %r is not a unique C identifier" % (entry, name))
+        names.add(name)
+        args.append({"kind": kind, "type": TYPES[ctype], "cl_type": ctype, "name": name,
+                     "value": value[2] if want == 3 else None})
+    return entry, args
+
+
+def emit_kernel(entry, args):
+    struct = camel(entry) + "Args"
+    buffers = [a for a in args if a["kind"] in BUFFER_KINDS]
+    params = [a for a in args if a["kind"] == "param"]
+    consts = [a for a in args if a["kind"] in ("const_param", "internal_buffer")]
+
+    def field_type(a):
+        if a["kind"] == "i_buffer":
+            return "McvBuffer<const %s>" % a["type"]
+        if a["kind"] in BUFFER_KINDS:
+            return "McvBuffer<%s>" % a["type"]
+        return a["type"]
+
+    out = []
+    width = max([len(a["name"]) for a in args] + [1])
+    out.append("// %s, arguments in kernel order:" % entry)
+    for a in args:
+        extra = "" if a["value"] is None else " = %s" % a["value"]
+        out.append("//   %-*s  %-15s %s%s" % (width, a["name"], a["kind"], a["cl_type"], extra))
+    out.append("struct %s {" % struct)
+    out.append('    static constexpr const char *kEntry = "%s";' % entry)
+    out.append("    static constexpr int kBufferCount = %d;" % len(buffers))
+    out.append("    static constexpr int kParamCount = %d;" % len(params))
+    for a in consts:
+        if a["kind"] == "const_param":
+            out.append("    static constexpr %s %s = %s;  // const_param, in the binary" %
+                       (a["type"], a["name"], a["value"]))
+        else:
+            out.append("    static constexpr size_t %s_bytes = %d * sizeof(%s);  // internal_buffer" %
+                       (a["name"], int(a["value"]), a["type"]))
+    out.append("")
+    for a in buffers + params:
+        init = "" if a["kind"] in BUFFER_KINDS else " = 0"
+        out.append("    %s %s%s;" % (field_type(a), a["name"], init))
+    out.append("")
+    ctor_args = ["%s %s_" % (field_type(a), a["name"]) for a in buffers + params]
+    inits = ["%s(%s_)" % (a["name"], a["name"]) for a in buffers + params]
+    line = "    %s(%s)" % (struct, ", ".join(ctor_args))
+    if len(line) <= 120:
+        out.append(line)
+        out.append("        : %s {}" % ", ".join(inits))
+    else:
+        # one argument per line
+        out.append("    %s(%s)" % (struct, (",\n" + " " * (5 + len(struct))).join(ctor_args)))
+        out.append("        : %s {}" % ",\n          ".join(inits))
+    out.append("")
+    out.append("    void marshal(mcv_buffer_t **buffers, void **params) {")
+    for i, a in enumerate(buffers):
+        out.append("        buffers[%d] = %s.get();" % (i, a["name"]))
+    for i, a in enumerate(params):
+        out.append("        params[%d] = &%s;" % (i, a["name"]))
+    if not buffers:
+        out.append("        (void)buffers;")
+    if not params:
+        out.append("        (void)params;")
+    out.append("    }")
+    out.append("};")
+    out.append("using %sLaunch = McvLaunch<%s>;" % (camel(entry), struct))
+    return "\n".join(out)
+
+
+def generate(spec, source, header):
+    kernels = spec.get("batch_binary")
+    if not isinstance(kernels, list) or not kernels:
+        raise SpecError("no batch_binary kernels")
+    guard = "%s_H_" % re.sub(r"\W", "_", os.path.splitext(os.path.basename(header))[0]).upper()
+    body = [emit_kernel(*parse_kernel(k)) for k in kernels]
+    return "\n".join([
+        "// Generated by tools/gen_mcve_launch.py from %s. Do not edit." % source,
+        "#ifndef %s" % guard,
+        "#define %s" % guard,
+        "",
+        '#include "mcve_launch.h"',
+        "",
+        "\n\n".join(body),
+        "",
+        "#endif  // %s" % guard,
+        "",
+    ])
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("spec", help="kernel JSON spec")
+    ap.add_argument("-o", "--output", help="header to write (stdout if omitted)")
+    ap.add_argument("--source-name", help="spec path to name in the header comment")
+    a = ap.parse_args()
+    try:
+        with open(a.spec) as f:
+            spec = json.load(f)
+        text = generate(spec, a.source_name or a.spec, a.output or "mcve_launch_" + os.path.basename(a.spec))
+    except (OSError, ValueError, SpecError) as e:
+        sys.stderr.write("gen_mcve_launch: %s: %s\n" % (a.spec, e))
+        return 1
+    if a.output:
+        with open(a.output, "w") as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
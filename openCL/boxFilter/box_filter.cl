@@ -21,3 +21,29 @@ __kernel void box_filter_3x3(
     dst_img[y * width + x] = sum / 9;
 }
 
+
+// 任意半径的均值滤波，边界处理和 box_filter_3x3 一样用 clamp；radius = 1 时结果和 box_filter_3x3 相同
+__kernel void box_filter_nxn(
+    __global const uchar* src_img,
+    __global uchar* dst_img,
+    const int width,
+    const int height,
+    const int radius
+) {
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+
+    if (x >= width || y >= height) return;
+
+    int sum = 0;
+    for (int dy = -radius; dy <= radius; dy++) {
+        int yy = clamp(y + dy, 0, height - 1);
+        for (int dx = -radius; dx <= radius; dx++) {
+            int xx = clamp(x + dx, 0, width - 1);
+            sum += src_img[yy * width + xx];
+        }
+    }
+
+    int taps = 2 * radius + 1;
+    dst_img[y * width + x] = sum / (taps * taps);
+}
@@ -43,8 +43,27 @@ char *read_source(const char *filename) {
     return source;
 }
 
+// 从字符串构建 program，编译失败时打印 build log
+cl_program build_program_from_source(cl_context context, cl_device_id device,
+                                     const char *source, const char *options) {
+    cl_int err;
+    cl_program program = clCreateProgramWithSource(context, 1, &source, NULL, &err);
+    CHECK_ERROR(err, "clCreateProgramWithSource");
+
+    err = clBuildProgram(program, 1, &device, options, NULL, NULL);
+    if (err != CL_SUCCESS) {
+        char log[4096];
+        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, sizeof(log), log, NULL);
+        fprintf(stderr, "Build Error:\n%s\n", log);
+        exit(1);
+    }
+    return program;
+}
+
 // 初始化 OpenCL，并构建 kernel
-OpenCLObjects init_opencl(const char *source_file, const char *kernel_name) {
+// queue_props 传 CL_QUEUE_PROFILING_ENABLE 可以打开 event 计时
+OpenCLObjects init_opencl_with_props(const char *source_file, const char *kernel_name,
+                                     cl_command_queue_properties queue_props) {
     OpenCLObjects ocl;
     cl_int err;
 
@@ -57,20 +76,11 @@ OpenCLObjects init_opencl(const char *source_file, const char *kernel_name) {
     ocl.context = clCreateContext(NULL, 1, &ocl.device, NULL, NULL, &err);
     CHECK_ERROR(err, "clCreateContext");
 
-    ocl.queue = clCreateCommandQueue(ocl.context, ocl.device, 0, &err);
+    ocl.queue = clCreateCommandQueue(ocl.context, ocl.device, queue_props, &err);
     CHECK_ERROR(err, "clCreateCommandQueue");
 
     char *source = read_source(source_file);
-    ocl.program = clCreateProgramWithSource(ocl.context, 1, (const char **)&source, NULL, &err);
-    CHECK_ERROR(err, "clCreateProgramWithSource");
-
-    err = clBuildProgram(ocl.program, 1, &ocl.device, NULL, NULL, NULL);
-    if (err != CL_SUCCESS) {
-        char log[4096];
-        clGetProgramBuildInfo(ocl.program, ocl.device, CL_PROGRAM_BUILD_LOG, sizeof(log), log, NULL);
-        fprintf(stderr, "Build Error:\n%s\n", log);
-        exit(1);
-    }
+    ocl.program = build_program_from_source(ocl.context, ocl.device, source, NULL);
 
     ocl.kernel = clCreateKernel(ocl.program, kernel_name, &err);
     CHECK_ERROR(err, "clCreateKernel");
@@ -79,6 +89,10 @@ OpenCLObjects init_opencl(const char *source_file, const char *kernel_name) {
     return ocl;
 }
 
+OpenCLObjects init_opencl(const char *source_file, const char *kernel_name) {
+    return init_opencl_with_props(source_file, kernel_name, 0);
+}
+
 void release_opencl(OpenCLObjects *ocl) {
     clReleaseKernel(ocl->kernel);
     clReleaseProgram(ocl->program);
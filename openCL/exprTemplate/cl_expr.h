@@ -0,0 +1,395 @@
+//
+// Created by zixhu on 2026/10/19.
+//
+
+#ifndef COMPUTERVISION_CL_EXPR_H
+#define COMPUTERVISION_CL_EXPR_H
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "../pipeline/cl_kernel_cache.h"
+
+// 表达式模板：a * b + c * d - e 这样的数组表达式在赋值时只生成一个 kernel，
+// 中间不产生临时数组。kernel 源码本身就是签名，编译一次后缓存。
+// 没有 OpenCL 设备时走 CPU：表达式在循环里直接内联求值，OpenMP 多线程 + omp simd 向量化。
+
+class ClArray;
+
+// 生成 kernel 时收集的叶子：数组变成 __global 参数，标量变成 float 参数
+struct ExprArgs {
+  std::vector<const ClArray*> arrays;
+  std::vector<float> scalars;
+};
+
+// 运行环境，全局一份；OpenCL 不可用时 use_device 为 false
+struct ClExprContext {
+  bool use_device;
+  cl_platform_id platform;
+  cl_device_id device;
+  cl_context context;
+  cl_command_queue queue;
+  std::unique_ptr<ClKernelCache> cache;
+
+  ClExprContext() : use_device(false), platform(NULL), device(NULL), context(NULL), queue(NULL) {
+    // 和 init_opencl 一样取第一个 platform 的默认设备，但失败时不退出，而是回退到 CPU
+    if (clGetPlatformIDs(1, &platform, NULL) != CL_SUCCESS) return;
+    if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_DEFAULT, 1, &device, NULL) != CL_SUCCESS) return;
+    cl_int err;
+    context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+    if (err != CL_SUCCESS) return;
+    queue = clCreateCommandQueue(context, device, 0, &err);
+    if (err != CL_SUCCESS) {
+      clReleaseContext(context);
+      return;
+    }
+    cache.reset(new ClKernelCache(context, device));
+    use_device = true;
+  }
+
+  ~ClExprContext() {
+    cache.reset();
+    if (queue) clReleaseCommandQueue(queue);
+    if (context) clReleaseContext(context);
+  }
+};
+
+inline ClExprContext& expr_context() {
+  static ClExprContext ctx;
+  return ctx;
+}
+
+// 强制走 CPU（对比或调试用）
+inline bool& expr_force_cpu() {
+  static bool force = false;
+  return force;
+}
+
+template <typename E>
+struct ExprBase {
+  const E& self() const { return static_cast<const E&>(*this); }
+};
+
+// 一维 float 数组。host / device 两份数据按需同步，连续的表达式赋值中间不回读
+class ClArray {
+ public:
+  ClArray() = default;
+  explicit ClArray(size_t n, float value = 0.0f) : host_(n, value) {}
+
+  ~ClArray() {
+    if (dev_) clReleaseMemObject(dev_);
+  }
+
+  ClArray(const ClArray& other) : host_(other.host()) {}
+  ClArray& operator=(const ClArray& other) {
+    if (this != &other) {
+      host_ = other.host();
+      host_valid_ = true;
+      dev_valid_ = false;
+    }
+    return *this;
+  }
+
+  template <typename E>
+  ClArray(const ExprBase<E>& e) {
+    assign(e.self());
+  }
+
+  template <typename E>
+  ClArray& operator=(const ExprBase<E>& e) {
+    assign(e.self());
+    return *this;
+  }
+
+  size_t size() const { return host_.size(); }
+
+  // 写访问：需要时从 device 读回，之后 device 数据失效
+  float* data() {
+    sync_host();
+    dev_valid_ = false;
+    return host_.data();
+  }
+
+  const std::vector<float>& host() const {
+    const_cast<ClArray*>(this)->sync_host();
+    return host_;
+  }
+
+  float operator[](size_t i) const { return host()[i]; }
+
+  // 保证 device 上有最新数据
+  cl_mem device_buffer() const {
+    ClArray* self = const_cast<ClArray*>(this);
+    self->alloc_device();
+    if (!dev_valid_) {
+      // 阻塞写：host_ 仍然有效，之后 data() 会直接交给调用方改写，非阻塞写完成前不能动它
+      cl_int err = clEnqueueWriteBuffer(expr_context().queue, dev_, CL_TRUE, 0, size() * sizeof(float),
+                                        host_.data(), 0, NULL, NULL);
+      CHECK_ERROR(err, "clEnqueueWriteBuffer expr");
+      self->dev_valid_ = true;
+    }
+    return dev_;
+  }
+
+  // CPU 求值时的原始指针
+  const float* host_ptr() const { return host().data(); }
+
+ private:
+  template <typename E>
+  void assign(const E& e);
+
+  void alloc_device() {
+    if (dev_) return;
+    cl_int err;
+    dev_ = clCreateBuffer(expr_context().context, CL_MEM_READ_WRITE, size() * sizeof(float), NULL, &err);
+    CHECK_ERROR(err, "clCreateBuffer expr");
+  }
+
+  // 尺寸变化时旧的 device buffer 作废
+  void resize(size_t n) {
+    if (host_.size() == n) return;
+    if (dev_) clReleaseMemObject(dev_);
+    dev_ = NULL;
+    host_.assign(n, 0.0f);
+    host_valid_ = true;
+    dev_valid_ = false;
+  }
+
+  void sync_host() {
+    if (host_valid_) return;
+    cl_int err = clEnqueueReadBuffer(expr_context().queue, dev_, CL_TRUE, 0, size() * sizeof(float), host_.data(),
+                                     0, NULL, NULL);
+    CHECK_ERROR(err, "clEnqueueReadBuffer expr");
+    host_valid_ = true;
+  }
+
+  std::vector<float> host_;
+  cl_mem dev_ = NULL;
+  bool host_valid_ = true;
+  bool dev_valid_ = false;
+};
+
+// 叶子：数组
+struct ArrayExpr : ExprBase<ArrayExpr> {
+  const ClArray* arr;
+  const float* ptr;   // CPU 求值时用
+  explicit ArrayExpr(const ClArray& a) : arr(&a), ptr(NULL) {}
+
+  size_t size() const { return arr->size(); }
+  void bind_host() { ptr = arr->host_ptr(); }
+  float eval(size_t i) const { return ptr[i]; }
+  void emit(std::string& code, ExprArgs& args) const {
+    code += "a" + std::to_string(args.arrays.size()) + "[i]";
+    args.arrays.push_back(arr);
+  }
+};
+
+// 叶子：标量。值作为 kernel 参数传入，不进签名，换个常数不用重新编译
+struct ScalarExpr : ExprBase<ScalarExpr> {
+  float value;
+  explicit ScalarExpr(float v) : value(v) {}
+
+  size_t size() const { return 0; }
+  void bind_host() {}
+  float eval(size_t) const { return value; }
+  void emit(std::string& code, ExprArgs& args) const {
+    code += "s" + std::to_string(args.scalars.size());
+    args.scalars.push_back(value);
+  }
+};
+
+#define CL_EXPR_BINARY_OP(NAME, CPU_EXPR, CL_PREFIX, CL_INFIX, CL_SUFFIX)    \
+  struct NAME {                                                              \
+    static float apply(float x, float y) { return CPU_EXPR; }                \
+    static const char* prefix() { return CL_PREFIX; }                        \
+    static const char* infix() { return CL_INFIX; }                          \
+    static const char* suffix() { return CL_SUFFIX; }                        \
+  };
+
+CL_EXPR_BINARY_OP(OpAdd, x + y, "(", " + ", ")")
+CL_EXPR_BINARY_OP(OpSub, x - y, "(", " - ", ")")
+CL_EXPR_BINARY_OP(OpMul, x * y, "(", " * ", ")")
+CL_EXPR_BINARY_OP(OpDiv, x / y, "(", " / ", ")")
+CL_EXPR_BINARY_OP(OpMin, std::fmin(x, y), "fmin(", ", ", ")")
+CL_EXPR_BINARY_OP(OpMax, std::fmax(x, y), "fmax(", ", ", ")")
+#undef CL_EXPR_BINARY_OP
+
+#define CL_EXPR_UNARY_OP(NAME, CPU_EXPR, CL_PREFIX)         \
+  struct NAME {                                             \
+    static float apply(float x) { return CPU_EXPR; }        \
+    static const char* prefix() { return CL_PREFIX; }       \
+  };
+
+CL_EXPR_UNARY_OP(OpNeg, -x, "-(")
+CL_EXPR_UNARY_OP(OpAbs, std::fabs(x), "fabs(")
+CL_EXPR_UNARY_OP(OpSqrt, std::sqrt(x), "sqrt(")
+CL_EXPR_UNARY_OP(OpExp, std::exp(x), "exp(")
+#undef CL_EXPR_UNARY_OP
+
+template <typename Op, typename L, typename R>
+struct BinaryExpr : ExprBase<BinaryExpr<Op, L, R> > {
+  L l;
+  R r;
+  BinaryExpr(const L& l_, const R& r_) : l(l_), r(r_) {
+    if (l.size() && r.size() && l.size() != r.size()) throw std::invalid_argument("expression size mismatch");
+  }
+
+  size_t size() const { return l.size() ? l.size() : r.size(); }
+  void bind_host() {
+    l.bind_host();
+    r.bind_host();
+  }
+  float eval(size_t i) const { return Op::apply(l.eval(i), r.eval(i)); }
+  void emit(std::string& code, ExprArgs& args) const {
+    code += Op::prefix();
+    l.emit(code, args);
+    code += Op::infix();
+    r.emit(code, args);
+    code += Op::suffix();
+  }
+};
+
+template <typename Op, typename E>
+struct UnaryExpr : ExprBase<UnaryExpr<Op, E> > {
+  E e;
+  explicit UnaryExpr(const E& e_) : e(e_) {}
+
+  size_t size() const { return e.size(); }
+  void bind_host() { e.bind_host(); }
+  float eval(size_t i) const { return Op::apply(e.eval(i)); }
+  void emit(std::string& code, ExprArgs& args) const {
+    code += Op::prefix();
+    e.emit(code, args);
+    code += ")";
+  }
+};
+
+// ClArray / 表达式 / 标量 统一转成表达式节点
+template <typename T, typename Enable = void>
+struct ExprOperand;
+
+template <>
+struct ExprOperand<ClArray> {
+  typedef ArrayExpr type;
+  static type make(const ClArray& a) { return ArrayExpr(a); }
+};
+
+template <typename E>
+struct ExprOperand<E, typename std::enable_if<std::is_base_of<ExprBase<E>, E>::value>::type> {
+  typedef E type;
+  static const E& make(const E& e) { return e; }
+};
+
+template <typename T>
+struct ExprOperand<T, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+  typedef ScalarExpr type;
+  static type make(T v) { return ScalarExpr((float)v); }
+};
+
+// 至少一边是数组或表达式才参与重载，避免劫持普通的 float 运算
+template <typename T>
+struct is_expr_like
+    : std::integral_constant<bool, std::is_same<T, ClArray>::value || std::is_base_of<ExprBase<T>, T>::value> {};
+
+template <typename L, typename R>
+struct enable_binary
+    : std::enable_if<(is_expr_like<L>::value || is_expr_like<R>::value) &&
+                         (is_expr_like<L>::value || std::is_arithmetic<L>::value) &&
+                         (is_expr_like<R>::value || std::is_arithmetic<R>::value)> {};
+
+#define CL_EXPR_DEFINE_BINARY(FUNC, OP)                                                                   \
+  template <typename L, typename R, typename = typename enable_binary<L, R>::type>                       \
+  BinaryExpr<OP, typename ExprOperand<L>::type, typename ExprOperand<R>::type> FUNC(const L& l,           \
+                                                                                    const R& r) {         \
+    return BinaryExpr<OP, typename ExprOperand<L>::type, typename ExprOperand<R>::type>(                  \
+        ExprOperand<L>::make(l), ExprOperand<R>::make(r));                                                \
+  }
+
+CL_EXPR_DEFINE_BINARY(operator+, OpAdd)
+CL_EXPR_DEFINE_BINARY(operator-, OpSub)
+CL_EXPR_DEFINE_BINARY(operator*, OpMul)
+CL_EXPR_DEFINE_BINARY(operator/, OpDiv)
+CL_EXPR_DEFINE_BINARY(min, OpMin)
+CL_EXPR_DEFINE_BINARY(max, OpMax)
+#undef CL_EXPR_DEFINE_BINARY
+
+#define CL_EXPR_DEFINE_UNARY(FUNC, OP)                                                            \
+  template <typename E, typename = typename std::enable_if<is_expr_like<E>::value>::type>         \
+  UnaryExpr<OP, typename ExprOperand<E>::type> FUNC(const E& e) {                                 \
+    return UnaryExpr<OP, typename ExprOperand<E>::type>(ExprOperand<E>::make(e));                 \
+  }
+
+CL_EXPR_DEFINE_UNARY(operator-, OpNeg)
+CL_EXPR_DEFINE_UNARY(abs, OpAbs)
+CL_EXPR_DEFINE_UNARY(sqrt, OpSqrt)
+CL_EXPR_DEFINE_UNARY(exp, OpExp)
+#undef CL_EXPR_DEFINE_UNARY
+
+// 把表达式生成 kernel 源码，返回的 body 同时作为缓存签名
+template <typename E>
+std::string generate_expr_kernel(const E& e, ExprArgs& args, std::string& body) {
+  body.clear();
+  e.emit(body, args);
+  std::string src = "__kernel void expr_kernel(__global float *out";
+  for (size_t k = 0; k < args.arrays.size(); k++) src += ", __global const float *a" + std::to_string(k);
+  for (size_t k = 0; k < args.scalars.size(); k++) src += ", const float s" + std::to_string(k);
+  // 下标和元素数都用 64 位，2^31 个元素以上的数组也不截断
+  src += ", const ulong n) {\n"
+         "    size_t i = get_global_id(0);\n"
+         "    if (i >= n) return;\n"
+         "    out[i] = " + body + ";\n"
+         "}\n";
+  return src;
+}
+
+template <typename E>
+void ClArray::assign(const E& e) {
+  size_t n = e.size();
+  if (n == 0) throw std::invalid_argument("expression has no array operand");
+  ClExprContext& ctx = expr_context();
+
+  if (!ctx.use_device || expr_force_cpu()) {
+    // CPU：先把所有叶子读回 host 并拿到指针，再逐元素求值。
+    // 输出和输入是同一个数组时，每个 i 先读后写，逐元素运算不会互相影响
+    E expr = e;
+    expr.bind_host();
+    resize(n);
+    sync_host();
+    float* out = host_.data();
+    ptrdiff_t count = (ptrdiff_t)n;
+#pragma omp parallel for simd schedule(static)
+    for (ptrdiff_t i = 0; i < count; i++) out[i] = expr.eval((size_t)i);
+    dev_valid_ = false;
+    return;
+  }
+
+  ExprArgs args;
+  std::string body;
+  std::string source = generate_expr_kernel(e, args, body);
+  cl_kernel kernel = ctx.cache->get(body, source, "expr_kernel");
+
+  // 先上传输入，再准备输出 buffer（输出同时是输入时也已经是最新数据）
+  std::vector<cl_mem> mems(args.arrays.size());
+  for (size_t k = 0; k < args.arrays.size(); k++) mems[k] = args.arrays[k]->device_buffer();
+  resize(n);
+  alloc_device();
+
+  cl_uint arg = 0;
+  clSetKernelArg(kernel, arg++, sizeof(cl_mem), &dev_);
+  for (size_t k = 0; k < mems.size(); k++) clSetKernelArg(kernel, arg++, sizeof(cl_mem), &mems[k]);
+  for (size_t k = 0; k < args.scalars.size(); k++) clSetKernelArg(kernel, arg++, sizeof(float), &args.scalars[k]);
+  cl_ulong count = (cl_ulong)n;
+  clSetKernelArg(kernel, arg++, sizeof(cl_ulong), &count);
+
+  size_t gsize = (n + 63) / 64 * 64;
+  cl_int err = clEnqueueNDRangeKernel(ctx.queue, kernel, 1, NULL, &gsize, NULL, 0, NULL, NULL);
+  CHECK_ERROR(err, "clEnqueueNDRangeKernel expr");
+  dev_valid_ = true;
+  host_valid_ = false;
+}
+
+#endif //COMPUTERVISION_CL_EXPR_H
@@ -0,0 +1,89 @@
+//
+// Created by zixhu on 2026/10/19.
+//
+
+#ifndef COMPUTERVISION_EXPRMAIN_H
+#define COMPUTERVISION_EXPRMAIN_H
+
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+#include "cl_expr.h"
+
+static double expr_now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// r = a*b + c*d - e：融合成一个 kernel vs 每步一个 kernel（带临时数组）vs CPU
+int exprMain() {
+    const size_t n = 1 << 24;
+    ClArray a(n), b(n), c(n), d(n), e(n);
+    float *pa = a.data(), *pb = b.data(), *pc = c.data(), *pd = d.data(), *pe = e.data();
+    for (size_t i = 0; i < n; i++) {
+        pa[i] = (float)(i % 1000) * 0.001f;
+        pb[i] = 2.0f;
+        pc[i] = (float)(i % 7);
+        pd[i] = 0.5f;
+        pe[i] = 1.0f;
+    }
+
+    ClExprContext& ctx = expr_context();
+    printf("backend: %s\n", ctx.use_device ? "OpenCL" : "CPU (no OpenCL device)");
+
+    ClArray r(n), t1(n), t2(n), t3(n);
+    // 第一次会编译 kernel，不计时
+    r = a * b + c * d - e;
+    t1 = a * b;
+    r.host();
+
+    const int iters = 20;
+    double t0 = expr_now_ms();
+    for (int it = 0; it < iters; it++) {
+        r = a * b + c * d - e;
+    }
+    r.host();
+    double fused_ms = (expr_now_ms() - t0) / iters;
+
+    t0 = expr_now_ms();
+    for (int it = 0; it < iters; it++) {
+        t1 = a * b;
+        t2 = c * d;
+        t3 = t1 + t2;
+        r = t3 - e;
+    }
+    r.host();
+    double unfused_ms = (expr_now_ms() - t0) / iters;
+
+    expr_force_cpu() = true;
+    ClArray r_cpu(n);
+    t0 = expr_now_ms();
+    for (int it = 0; it < iters; it++) {
+        r_cpu = a * b + c * d - e;
+    }
+    double cpu_ms = (expr_now_ms() - t0) / iters;
+    expr_force_cpu() = false;
+
+    bool pass = true;
+    const std::vector<float>& out = r.host();
+    const std::vector<float>& ref = r_cpu.host();
+    for (size_t i = 0; i < n; i++) {
+        if (std::fabs(out[i] - ref[i]) > 1e-5f) {
+            printf("Mismatch at %zu: %f vs %f\n", i, out[i], ref[i]);
+            pass = false;
+            break;
+        }
+    }
+
+    double gb = 6.0 * n * sizeof(float) / 1e9;
+    printf("fused     : %8.3f ms  %6.2f GB/s\n", fused_ms, gb / (fused_ms * 1e-3));
+    printf("unfused   : %8.3f ms  (4 kernels + 3 temporaries)\n", unfused_ms);
+    printf("cpu       : %8.3f ms  %6.2f GB/s\n", cpu_ms, gb / (cpu_ms * 1e-3));
+    if (ctx.use_device) {
+        printf("kernel cache: %zu entries, %zu hits, %zu misses\n", ctx.cache->size(), ctx.cache->hits(),
+               ctx.cache->misses());
+    }
+    printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+    return pass ? 0 : -1;
+}
+
+#endif //COMPUTERVISION_EXPRMAIN_H
@@ -0,0 +1,75 @@
+//
+// Created by zixhu on 2026/10/19.
+//
+
+#ifndef COMPUTERVISION_MULTIDEVICEMAIN_H
+#define COMPUTERVISION_MULTIDEVICEMAIN_H
+
+#include <vector>
+#include <stdio.h>
+#include <opencv2/opencv.hpp>
+#include "multi_device.h"
+
+// CPU 参考实现，和 box_filter_3x3 的 clamp 边界一致
+static void box_filter_3x3_ref(const uchar *src, uchar *dst, int width, int height) {
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int sum = 0;
+            for (int dy = -1; dy <= 1; dy++) {
+                int yy = std::min(std::max(y + dy, 0), height - 1);
+                for (int dx = -1; dx <= 1; dx++) {
+                    int xx = std::min(std::max(x + dx, 0), width - 1);
+                    sum += src[yy * width + xx];
+                }
+            }
+            dst[y * width + x] = sum / 9;
+        }
+    }
+}
+
+int multiDeviceMain() {
+    cv::Mat image = cv::imread("../src/opencl/sources/img.png", cv::IMREAD_GRAYSCALE);
+    if (image.empty()) {
+        printf("Image load failed!\n");
+        return -1;
+    }
+    int width = image.cols;
+    int height = image.rows;
+
+    // 所有 platform 的所有设备，CPU 设备按 NUMA 拆分
+    std::vector<std::string> kernel_names = {"vector_add", "box_filter_3x3_band"};
+    MultiDeviceObjects md = init_multi_device("multi_device.cl", kernel_names, CL_DEVICE_TYPE_ALL, true);
+
+    // vector_add：前几轮用来校准吞吐，之后的划分就稳定了
+    const size_t n = 1 << 24;
+    std::vector<float> A(n), B(n), C(n);
+    for (size_t i = 0; i < n; i++) {
+        A[i] = (float)i;
+        B[i] = (float)(i * 2);
+    }
+    for (int iter = 0; iter < 5; iter++) {
+        multi_vector_add(&md, A.data(), B.data(), C.data(), n);
+    }
+    print_multi_device(md, "vector_add");
+    for (size_t i = 0; i < n; i++) {
+        if (C[i] != A[i] + B[i]) {
+            printf("vector_add mismatch at %zu\n", i);
+            break;
+        }
+    }
+
+    std::vector<uchar> result((size_t)width * height), golden((size_t)width * height);
+    for (int iter = 0; iter < 5; iter++) {
+        multi_box_filter(&md, image.data, result.data(), width, height);
+    }
+    print_multi_device(md, "box_filter_3x3_band");
+
+    box_filter_3x3_ref(image.data, golden.data(), width, height);
+    bool pass = result == golden;
+    printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+
+    release_multi_device(&md);
+    return pass ? 0 : -1;
+}
+
+#endif //COMPUTERVISION_MULTIDEVICEMAIN_H
@@ -0,0 +1,35 @@
+
+// 按行分块的 3x3 均值滤波，src_band 上下各带 halo_top / halo_bottom 行 halo
+// 图像真实边界处没有 halo，clamp 的行为和 box_filter_3x3 一致
+__kernel void box_filter_3x3_band(
+    __global const uchar* src_band,
+    __global uchar* dst_band,
+    const int width,
+    const int band_rows,
+    const int halo_top,
+    const int halo_bottom
+) {
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+
+    if (x >= width || y >= band_rows) return;
+
+    int src_rows = halo_top + band_rows + halo_bottom;
+    int sum = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+        int yy = clamp(y + halo_top + dy, 0, src_rows - 1);
+        for (int dx = -1; dx <= 1; dx++) {
+            int xx = clamp(x + dx, 0, width - 1);
+            sum += src_band[yy * width + xx];
+        }
+    }
+
+    dst_band[y * width + x] = sum / 9;
+}
+
+__kernel void vector_add(__global const float* A,
+                         __global const float* B,
+                         __global float* C) {
+    int id = get_global_id(0);
+    C[id] = A[id] + B[id];
+}
@@ -0,0 +1,314 @@
+//
+// Created by zixhu on 2026/10/19.
+//
+
+#ifndef COMPUTERVISION_MULTI_DEVICE_H
+#define COMPUTERVISION_MULTI_DEVICE_H
+
+#include <stdio.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../boxFilter/opencl_helper.h"
+#include "../profiling/cl_profiler.h"
+
+// 一个参与计算的设备（或 NUMA 子设备）
+typedef struct {
+    cl_platform_id platform;
+    cl_device_id device;
+    int is_sub_device;
+    cl_context context;
+    cl_command_queue queue;     // 带 CL_QUEUE_PROFILING_ENABLE，用于测每块的耗时
+    cl_program program;
+    char name[128];
+    cl_uint compute_units;
+} ClDeviceSlot;
+
+// 一个 kernel 在各个 slot 上的实例和划分权重，不同 kernel 的吞吐比例不同，分开记录
+typedef struct {
+    std::vector<cl_kernel> kernels;
+    std::vector<double> weights;    // 相对吞吐（元素 / ns），划分时按它的比例分配
+    std::vector<int> calibrated;    // weight 是否已经是实测值
+} KernelSplit;
+
+typedef struct {
+    std::vector<ClDeviceSlot> slots;
+    OrderedMapVec<std::string, KernelSplit> kernels;
+} MultiDeviceObjects;
+
+// 一块 NDRange：[offset, offset + count)
+typedef std::pair<size_t, size_t> RangePart;
+
+// 枚举所有 platform 上 type 类型的设备，split_numa 时把 CPU 设备按 NUMA 节点拆成子设备
+std::vector<ClDeviceSlot> enumerate_devices(cl_device_type type, bool split_numa) {
+    std::vector<ClDeviceSlot> slots;
+    cl_int err;
+
+    cl_uint num_platforms = 0;
+    err = clGetPlatformIDs(0, NULL, &num_platforms);
+    CHECK_ERROR(err, "clGetPlatformIDs");
+    std::vector<cl_platform_id> platforms(num_platforms);
+    clGetPlatformIDs(num_platforms, platforms.data(), NULL);
+
+    for (cl_uint p = 0; p < num_platforms; p++) {
+        cl_uint num_devices = 0;
+        // 某个 platform 没有这类设备时跳过
+        if (clGetDeviceIDs(platforms[p], type, 0, NULL, &num_devices) != CL_SUCCESS || num_devices == 0) continue;
+        std::vector<cl_device_id> devices(num_devices);
+        clGetDeviceIDs(platforms[p], type, num_devices, devices.data(), NULL);
+
+        for (cl_uint d = 0; d < num_devices; d++) {
+            cl_device_type dev_type = 0;
+            clGetDeviceInfo(devices[d], CL_DEVICE_TYPE, sizeof(dev_type), &dev_type, NULL);
+
+            std::vector<cl_device_id> parts;
+            if (split_numa && (dev_type & CL_DEVICE_TYPE_CPU)) {
+                cl_device_partition_property props[] = {
+                    CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, CL_DEVICE_AFFINITY_DOMAIN_NUMA, 0};
+                cl_uint num_sub = 0;
+                if (clCreateSubDevices(devices[d], props, 0, NULL, &num_sub) == CL_SUCCESS && num_sub > 1) {
+                    parts.resize(num_sub);
+                    clCreateSubDevices(devices[d], props, num_sub, parts.data(), NULL);
+                }
+            }
+
+            if (parts.empty()) {
+                ClDeviceSlot slot = {};
+                slot.platform = platforms[p];
+                slot.device = devices[d];
+                clGetDeviceInfo(devices[d], CL_DEVICE_NAME, sizeof(slot.name), slot.name, NULL);
+                slots.push_back(slot);
+                continue;
+            }
+            for (size_t s = 0; s < parts.size(); s++) {
+                ClDeviceSlot slot = {};
+                slot.platform = platforms[p];
+                slot.device = parts[s];
+                slot.is_sub_device = 1;
+                char dev_name[100] = {0};
+                clGetDeviceInfo(devices[d], CL_DEVICE_NAME, sizeof(dev_name), dev_name, NULL);
+                snprintf(slot.name, sizeof(slot.name), "%s [numa %zu]", dev_name, s);
+                slots.push_back(slot);
+            }
+        }
+    }
+    return slots;
+}
+
+// 每个 slot 一个 context / queue / program，kernel_names 里的 kernel 全部预先创建
+MultiDeviceObjects init_multi_device(const char *source_file, const std::vector<std::string>& kernel_names,
+                                     cl_device_type type, bool split_numa) {
+    MultiDeviceObjects md;
+    md.slots = enumerate_devices(type, split_numa);
+    if (md.slots.empty()) {
+        fprintf(stderr, "No OpenCL device found\n");
+        exit(1);
+    }
+
+    char *source = read_source(source_file);
+    cl_int err;
+    for (size_t i = 0; i < md.slots.size(); i++) {
+        ClDeviceSlot& slot = md.slots[i];
+        slot.context = clCreateContext(NULL, 1, &slot.device, NULL, NULL, &err);
+        CHECK_ERROR(err, "clCreateContext");
+        slot.queue = clCreateCommandQueue(slot.context, slot.device, CL_QUEUE_PROFILING_ENABLE, &err);
+        CHECK_ERROR(err, "clCreateCommandQueue");
+        slot.program = build_program_from_source(slot.context, slot.device, source, NULL);
+        slot.compute_units = 1;
+        clGetDeviceInfo(slot.device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &slot.compute_units, NULL);
+    }
+    free(source);
+
+    for (size_t k = 0; k < kernel_names.size(); k++) {
+        KernelSplit& split = md.kernels[kernel_names[k]];
+        for (size_t i = 0; i < md.slots.size(); i++) {
+            split.kernels.push_back(clCreateKernel(md.slots[i].program, kernel_names[k].c_str(), &err));
+            CHECK_ERROR(err, "clCreateKernel");
+            // 还没测过吞吐，先用计算单元数做初始权重
+            split.weights.push_back((double)md.slots[i].compute_units);
+            split.calibrated.push_back(0);
+        }
+    }
+    return md;
+}
+
+void release_multi_device(MultiDeviceObjects *md) {
+    for (auto it = md->kernels.begin(); it != md->kernels.end(); ++it) {
+        for (size_t i = 0; i < it->second.kernels.size(); i++) clReleaseKernel(it->second.kernels[i]);
+    }
+    md->kernels.clear();
+    for (size_t i = 0; i < md->slots.size(); i++) {
+        ClDeviceSlot& slot = md->slots[i];
+        clReleaseProgram(slot.program);
+        clReleaseCommandQueue(slot.queue);
+        clReleaseContext(slot.context);
+        if (slot.is_sub_device) clReleaseDevice(slot.device);
+    }
+    md->slots.clear();
+}
+
+// 按权重比例划分 [0, total)，除最后一块外都对齐到 align 个元素
+std::vector<RangePart> partition_range(const std::vector<double>& weights, size_t total, size_t align) {
+    double weight_sum = 0.0;
+    for (size_t i = 0; i < weights.size(); i++) weight_sum += weights[i];
+
+    std::vector<RangePart> parts(weights.size());
+    size_t offset = 0;
+    double acc = 0.0;
+    for (size_t i = 0; i < weights.size(); i++) {
+        acc += weights[i];
+        size_t end = (i + 1 == weights.size()) ? total : (size_t)(total * (acc / weight_sum));
+        end = end / align * align;
+        if (end < offset) end = offset;
+        if (end > total) end = total;
+        parts[i] = RangePart(offset, end - offset);
+        offset = end;
+    }
+    return parts;
+}
+
+// 用这次每块的元素数和 kernel 耗时更新吞吐权重，做一点平滑避免抖动
+void update_weights(KernelSplit& split, const std::vector<RangePart>& parts, const std::vector<cl_ulong>& exec_ns) {
+    for (size_t i = 0; i < split.weights.size(); i++) {
+        if (parts[i].second == 0 || exec_ns[i] == 0) continue;
+        double throughput = (double)parts[i].second / (double)exec_ns[i];
+        split.weights[i] = split.calibrated[i] ? 0.5 * split.weights[i] + 0.5 * throughput : throughput;
+        split.calibrated[i] = 1;
+    }
+}
+
+// C = A + B，按设备吞吐切分
+// 每块的输入输出都用 CL_MEM_USE_HOST_PTR 直接指向 host 数组的切片，结果 map 回来，不需要再拼接
+void multi_vector_add(MultiDeviceObjects *md, const float *A, const float *B, float *C, size_t n) {
+    std::vector<ClDeviceSlot>& slots = md->slots;
+    KernelSplit& split = md->kernels.at("vector_add");
+    const std::vector<cl_kernel>& kernels = split.kernels;
+    // 4KB 对齐的切片在 CPU 设备上可以真正零拷贝
+    std::vector<RangePart> parts = partition_range(split.weights, n, 4096 / sizeof(float));
+
+    cl_int err;
+    std::vector<cl_mem> mems;
+    std::vector<cl_event> kernel_events(slots.size(), NULL);
+    std::vector<cl_event> map_events(slots.size(), NULL);
+    std::vector<void *> mapped(slots.size(), NULL);
+    std::vector<cl_mem> out_mems(slots.size(), NULL);
+
+    for (size_t i = 0; i < slots.size(); i++) {
+        size_t offset = parts[i].first, count = parts[i].second;
+        if (count == 0) continue;
+        size_t bytes = count * sizeof(float);
+        cl_mem a = clCreateBuffer(slots[i].context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, bytes,
+                                  (void *)(A + offset), &err);
+        CHECK_ERROR(err, "clCreateBuffer A");
+        cl_mem b = clCreateBuffer(slots[i].context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, bytes,
+                                  (void *)(B + offset), &err);
+        CHECK_ERROR(err, "clCreateBuffer B");
+        cl_mem c = clCreateBuffer(slots[i].context, CL_MEM_WRITE_ONLY | CL_MEM_USE_HOST_PTR, bytes,
+                                  C + offset, &err);
+        CHECK_ERROR(err, "clCreateBuffer C");
+        mems.push_back(a);
+        mems.push_back(b);
+        out_mems[i] = c;
+
+        clSetKernelArg(kernels[i], 0, sizeof(cl_mem), &a);
+        clSetKernelArg(kernels[i], 1, sizeof(cl_mem), &b);
+        clSetKernelArg(kernels[i], 2, sizeof(cl_mem), &c);
+        err = clEnqueueNDRangeKernel(slots[i].queue, kernels[i], 1, NULL, &count, NULL, 0, NULL,
+                                     &kernel_events[i]);
+        CHECK_ERROR(err, "clEnqueueNDRangeKernel");
+        mapped[i] = clEnqueueMapBuffer(slots[i].queue, c, CL_FALSE, CL_MAP_READ, 0, bytes, 1,
+                                       &kernel_events[i], &map_events[i], &err);
+        CHECK_ERROR(err, "clEnqueueMapBuffer");
+        clFlush(slots[i].queue);
+    }
+
+    std::vector<cl_ulong> exec_ns(slots.size(), 0);
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (parts[i].second == 0) continue;
+        clWaitForEvents(1, &map_events[i]);
+        exec_ns[i] = event_exec_ns(kernel_events[i]);
+        clEnqueueUnmapMemObject(slots[i].queue, out_mems[i], mapped[i], 0, NULL, NULL);
+        clFinish(slots[i].queue);
+        clReleaseEvent(kernel_events[i]);
+        clReleaseEvent(map_events[i]);
+        clReleaseMemObject(out_mems[i]);
+    }
+    for (size_t i = 0; i < mems.size(); i++) clReleaseMemObject(mems[i]);
+
+    update_weights(split, parts, exec_ns);
+}
+
+// 3x3 均值滤波，按行带切分；每块输入多带上下各 1 行 halo，输出直接写进 dst 的对应行
+void multi_box_filter(MultiDeviceObjects *md, const unsigned char *src, unsigned char *dst, int width,
+                      int height) {
+    std::vector<ClDeviceSlot>& slots = md->slots;
+    KernelSplit& split = md->kernels.at("box_filter_3x3_band");
+    const std::vector<cl_kernel>& kernels = split.kernels;
+    std::vector<RangePart> parts = partition_range(split.weights, (size_t)height, 1);
+
+    cl_int err;
+    std::vector<cl_mem> in_mems(slots.size(), NULL);
+    std::vector<cl_mem> out_mems(slots.size(), NULL);
+    std::vector<cl_event> kernel_events(slots.size(), NULL);
+    std::vector<cl_event> map_events(slots.size(), NULL);
+    std::vector<void *> mapped(slots.size(), NULL);
+
+    for (size_t i = 0; i < slots.size(); i++) {
+        int row0 = (int)parts[i].first, rows = (int)parts[i].second;
+        if (rows == 0) continue;
+        int halo_top = row0 > 0 ? 1 : 0;
+        int halo_bottom = row0 + rows < height ? 1 : 0;
+        size_t in_bytes = (size_t)(halo_top + rows + halo_bottom) * width;
+        size_t out_bytes = (size_t)rows * width;
+
+        in_mems[i] = clCreateBuffer(slots[i].context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, in_bytes,
+                                    (void *)(src + (size_t)(row0 - halo_top) * width), &err);
+        CHECK_ERROR(err, "clCreateBuffer input band");
+        out_mems[i] = clCreateBuffer(slots[i].context, CL_MEM_WRITE_ONLY | CL_MEM_USE_HOST_PTR, out_bytes,
+                                     dst + (size_t)row0 * width, &err);
+        CHECK_ERROR(err, "clCreateBuffer output band");
+
+        clSetKernelArg(kernels[i], 0, sizeof(cl_mem), &in_mems[i]);
+        clSetKernelArg(kernels[i], 1, sizeof(cl_mem), &out_mems[i]);
+        clSetKernelArg(kernels[i], 2, sizeof(int), &width);
+        clSetKernelArg(kernels[i], 3, sizeof(int), &rows);
+        clSetKernelArg(kernels[i], 4, sizeof(int), &halo_top);
+        clSetKernelArg(kernels[i], 5, sizeof(int), &halo_bottom);
+
+        size_t gsize[2] = {(size_t)width, (size_t)rows};
+        err = clEnqueueNDRangeKernel(slots[i].queue, kernels[i], 2, NULL, gsize, NULL, 0, NULL,
+                                     &kernel_events[i]);
+        CHECK_ERROR(err, "clEnqueueNDRangeKernel");
+        mapped[i] = clEnqueueMapBuffer(slots[i].queue, out_mems[i], CL_FALSE, CL_MAP_READ, 0, out_bytes, 1,
+                                       &kernel_events[i], &map_events[i], &err);
+        CHECK_ERROR(err, "clEnqueueMapBuffer");
+        clFlush(slots[i].queue);
+    }
+
+    std::vector<cl_ulong> exec_ns(slots.size(), 0);
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (parts[i].second == 0) continue;
+        clWaitForEvents(1, &map_events[i]);
+        exec_ns[i] = event_exec_ns(kernel_events[i]);
+        clEnqueueUnmapMemObject(slots[i].queue, out_mems[i], mapped[i], 0, NULL, NULL);
+        clFinish(slots[i].queue);
+        clReleaseEvent(kernel_events[i]);
+        clReleaseEvent(map_events[i]);
+        clReleaseMemObject(in_mems[i]);
+        clReleaseMemObject(out_mems[i]);
+    }
+
+    update_weights(split, parts, exec_ns);
+}
+
+void print_multi_device(const MultiDeviceObjects& md, const std::string& kernel_name) {
+    const KernelSplit& split = md.kernels.at(kernel_name);
+    double weight_sum = 0.0;
+    for (size_t i = 0; i < split.weights.size(); i++) weight_sum += split.weights[i];
+    printf("%s split:\n", kernel_name.c_str());
+    for (size_t i = 0; i < md.slots.size(); i++) {
+        printf("[%zu] %-48s share %.1f%%\n", i, md.slots[i].name, 100.0 * split.weights[i] / weight_sum);
+    }
+}
+
+#endif //COMPUTERVISION_MULTI_DEVICE_H
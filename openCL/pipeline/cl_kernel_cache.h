@@ -0,0 +1,80 @@
+//
+// Created by zixhu on 2026/10/19.
+//
+
+#ifndef COMPUTERVISION_CL_KERNEL_CACHE_H
+#define COMPUTERVISION_CL_KERNEL_CACHE_H
+
+#include <sstream>
+#include <string>
+#include "../boxFilter/opencl_helper.h"
+#include "../../CPP/OrderedMapVec.hpp"
+
+// 运行时生成的 kernel 按签名缓存，同一个签名只编译一次
+class ClKernelCache {
+ public:
+  ClKernelCache(cl_context context, cl_device_id device) : context_(context), device_(device) {}
+
+  ~ClKernelCache() { clear(); }
+
+  ClKernelCache(const ClKernelCache&) = delete;
+  ClKernelCache& operator=(const ClKernelCache&) = delete;
+
+  // 命中返回缓存的 kernel，否则返回 NULL
+  cl_kernel find(const std::string& signature) {
+    auto it = entries_.find(signature);
+    if (it == entries_.end()) return NULL;
+    hits_++;
+    return it->second.kernel;
+  }
+
+  // 编译 source 并按 signature 缓存
+  cl_kernel build(const std::string& signature, const std::string& source, const char* kernel_name,
+                  const char* options = NULL) {
+    misses_++;
+    Entry entry;
+    entry.program = build_program_from_source(context_, device_, source.c_str(), options);
+    cl_int err;
+    entry.kernel = clCreateKernel(entry.program, kernel_name, &err);
+    CHECK_ERROR(err, "clCreateKernel");
+    entries_.insert_or_assign(signature, entry);
+    return entry.kernel;
+  }
+
+  // source 只在第一次遇到 signature 时编译
+  cl_kernel get(const std::string& signature, const std::string& source, const char* kernel_name,
+                const char* options = NULL) {
+    cl_kernel kernel = find(signature);
+    return kernel ? kernel : build(signature, source, kernel_name, options);
+  }
+
+  bool contains(const std::string& signature) const { return entries_.contains(signature); }
+
+  void clear() {
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      clReleaseKernel(it->second.kernel);
+      clReleaseProgram(it->second.program);
+    }
+    entries_.clear();
+  }
+
+  size_t size() const { return entries_.size(); }
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+  cl_context context() const { return context_; }
+  cl_device_id device() const { return device_; }
+
+ private:
+  struct Entry {
+    cl_program program;
+    cl_kernel kernel;
+  };
+
+  cl_context context_;
+  cl_device_id device_;
+  OrderedMapVec<std::string, Entry> entries_;
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+};
+
+#endif //COMPUTERVISION_CL_KERNEL_CACHE_H
@@ -0,0 +1,305 @@
+//
+// Created by zixhu on 2026/10/19.
+//
+
+#ifndef COMPUTERVISION_IMAGE_PIPELINE_H
+#define COMPUTERVISION_IMAGE_PIPELINE_H
+
+#include <algorithm>
+#include <stdio.h>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "cl_kernel_cache.h"
+#include "../profiling/cl_profiler.h"
+
+// 融合后每个 work-group 负责 PIPELINE_TILE x PIPELINE_TILE 个输出像素
+#define PIPELINE_TILE 16
+// 一个融合 kernel 内所有邻域操作半径之和的上限，超过就拆成下一个 kernel（控制 __local 用量）
+#define PIPELINE_MAX_APRON 8
+
+enum StageKind {
+    STAGE_POINT,            // 逐像素：code 是关于 v 的表达式
+    STAGE_NEIGHBOURHOOD     // 邻域：code 是语句块，用 P(dx, dy) 读邻域，结果写到 r
+};
+
+typedef struct {
+    StageKind kind;
+    std::string name;
+    int radius;
+    std::string code;
+} PipelineStage;
+
+PipelineStage stage_point(const std::string& name, const std::string& expr) {
+    PipelineStage s = {STAGE_POINT, name, 0, expr};
+    return s;
+}
+
+PipelineStage stage_neighbourhood(const std::string& name, int radius, const std::string& body) {
+    PipelineStage s = {STAGE_NEIGHBOURHOOD, name, radius, body};
+    return s;
+}
+
+static std::string float_literal(float value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9gf", value);
+    std::string lit = buf;
+    // 没有小数点的整数要补 .0，否则 "255f" 不是合法的 OpenCL 常量
+    if (lit.find_first_of(".eEn") == std::string::npos) lit.insert(lit.size() - 1, ".0");
+    return lit;
+}
+
+// 均值滤波，和 box_filter_3x3 一样向下取整
+PipelineStage stage_box_blur(int radius) {
+    int n = (2 * radius + 1) * (2 * radius + 1);
+    std::ostringstream os;
+    os << "float s = 0.0f;\n"
+       << "for (int dy = -" << radius << "; dy <= " << radius << "; dy++)\n"
+       << "    for (int dx = -" << radius << "; dx <= " << radius << "; dx++)\n"
+       << "        s += P(dx, dy);\n"
+       << "r = floor(s / " << n << ".0f);";
+    return stage_neighbourhood("box_blur_r" + std::to_string(radius), radius, os.str());
+}
+
+PipelineStage stage_threshold(float thresh, float max_value) {
+    return stage_point("threshold",
+                       "v > " + float_literal(thresh) + " ? " + float_literal(max_value) + " : 0.0f");
+}
+
+PipelineStage stage_gain(float alpha, float beta) {
+    return stage_point("gain", "v * " + float_literal(alpha) + " + " + float_literal(beta));
+}
+
+// Sobel 梯度 L1 幅值
+PipelineStage stage_gradient() {
+    return stage_neighbourhood(
+        "sobel", 1,
+        "float gx = P(1, -1) + 2.0f * P(1, 0) + P(1, 1) - P(-1, -1) - 2.0f * P(-1, 0) - P(-1, 1);\n"
+        "float gy = P(-1, 1) + 2.0f * P(0, 1) + P(1, 1) - P(-1, -1) - 2.0f * P(0, -1) - P(1, -1);\n"
+        "r = fmin(fabs(gx) + fabs(gy), 255.0f);");
+}
+
+// 把一段可以融合的 stage 生成一个 kernel
+// 所有中间结果都是 float：点操作留在寄存器里，邻域操作的输入放在 __local tile（带 apron）
+// 中间层越界的位置取 clamp 后坐标上的值，所以和逐个 kernel 执行的结果完全一致
+std::string generate_pipeline_kernel(const std::vector<PipelineStage>& stages, const char *in_type,
+                                     const char *out_type, const std::string& kernel_name) {
+    std::ostringstream os;
+    std::string store = std::string(out_type) == "uchar" ? "convert_uchar_sat(v)" : "v";
+
+    // 按邻域操作切段：pre 是第一个邻域操作之前的点操作，posts[j] 跟在第 j 个邻域操作之后
+    std::vector<std::string> pre;
+    std::vector<const PipelineStage*> neigh;
+    std::vector<std::vector<std::string> > posts;
+    for (size_t i = 0; i < stages.size(); i++) {
+        if (stages[i].kind == STAGE_NEIGHBOURHOOD) {
+            neigh.push_back(&stages[i]);
+            posts.push_back(std::vector<std::string>());
+        } else if (neigh.empty()) {
+            pre.push_back(stages[i].code);
+        } else {
+            posts.back().push_back(stages[i].code);
+        }
+    }
+
+    os << "#define TS " << PIPELINE_TILE << "\n\n";
+
+    // 纯点操作，不需要 tile
+    if (neigh.empty()) {
+        os << "__kernel void " << kernel_name << "(__global const " << in_type << " *src, __global "
+           << out_type << " *dst, const int width, const int height) {\n"
+           << "    int x = get_global_id(0);\n"
+           << "    int y = get_global_id(1);\n"
+           << "    if (x >= width || y >= height) return;\n"
+           << "    float v = src[y * width + x];\n";
+        for (size_t i = 0; i < pre.size(); i++) os << "    v = " << pre[i] << ";\n";
+        os << "    dst[y * width + x] = " << store << ";\n}\n";
+        return os.str();
+    }
+
+    // apron[j]：第 j 层 tile 四周需要多出的像素数，apron[0] 是所有半径之和，最后一层是 0
+    std::vector<int> apron(neigh.size() + 1, 0);
+    for (int j = (int)neigh.size() - 1; j >= 0; j--) apron[j] = apron[j + 1] + neigh[j]->radius;
+    int w0 = PIPELINE_TILE + 2 * apron[0];
+
+    os << "__kernel __attribute__((reqd_work_group_size(TS, TS, 1)))\n"
+       << "void " << kernel_name << "(__global const " << in_type << " *src, __global " << out_type
+       << " *dst, const int width, const int height) {\n"
+       << "    __local float buf0[" << w0 * w0 << "];\n";
+    if (neigh.size() > 1) os << "    __local float buf1[" << w0 * w0 << "];\n";
+    os << "    const int lx = get_local_id(0);\n"
+       << "    const int ly = get_local_id(1);\n"
+       << "    const int lid = ly * TS + lx;\n"
+       << "    const int gx0 = get_group_id(0) * TS;\n"
+       << "    const int gy0 = get_group_id(1) * TS;\n\n";
+
+    // 第 0 层：从 global 读入，越界 clamp，顺带做前置点操作
+    os << "    for (int i = lid; i < " << w0 * w0 << "; i += TS * TS) {\n"
+       << "        int x = clamp(gx0 - " << apron[0] << " + i % " << w0 << ", 0, width - 1);\n"
+       << "        int y = clamp(gy0 - " << apron[0] << " + i / " << w0 << ", 0, height - 1);\n"
+       << "        float v = src[y * width + x];\n";
+    for (size_t i = 0; i < pre.size(); i++) os << "        v = " << pre[i] << ";\n";
+    os << "        buf0[i] = v;\n"
+       << "    }\n"
+       << "    barrier(CLK_LOCAL_MEM_FENCE);\n";
+
+    for (size_t j = 0; j < neigh.size(); j++) {
+        const char *in_buf = (j % 2 == 0) ? "buf0" : "buf1";
+        const char *out_buf = (j % 2 == 0) ? "buf1" : "buf0";
+        int w_in = PIPELINE_TILE + 2 * apron[j];
+        int w_out = PIPELINE_TILE + 2 * apron[j + 1];
+        bool last = j + 1 == neigh.size();
+
+        os << "\n    // " << neigh[j]->name << "\n";
+        os << "#define P(dx, dy) " << in_buf << "[(cy + (dy)) * " << w_in << " + cx + (dx)]\n";
+        if (!last) {
+            os << "    for (int i = lid; i < " << w_out * w_out << "; i += TS * TS) {\n"
+               << "        int cx = clamp(gx0 - " << apron[j + 1] << " + i % " << w_out << ", 0, width - 1) - (gx0 - "
+               << apron[j] << ");\n"
+               << "        int cy = clamp(gy0 - " << apron[j + 1] << " + i / " << w_out << ", 0, height - 1) - (gy0 - "
+               << apron[j] << ");\n"
+               << "        float r;\n"
+               << "        {\n" << neigh[j]->code << "\n        }\n"
+               << "        float v = r;\n";
+            for (size_t k = 0; k < posts[j].size(); k++) os << "        v = " << posts[j][k] << ";\n";
+            os << "        " << out_buf << "[i] = v;\n"
+               << "    }\n"
+               << "#undef P\n"
+               << "    barrier(CLK_LOCAL_MEM_FENCE);\n";
+        } else {
+            os << "    int x = gx0 + lx;\n"
+               << "    int y = gy0 + ly;\n"
+               << "    if (x < width && y < height) {\n"
+               << "        int cx = lx + " << apron[j] << ";\n"
+               << "        int cy = ly + " << apron[j] << ";\n"
+               << "        float r;\n"
+               << "        {\n" << neigh[j]->code << "\n        }\n"
+               << "        float v = r;\n";
+            for (size_t k = 0; k < posts[j].size(); k++) os << "        v = " << posts[j][k] << ";\n";
+            os << "        dst[y * width + x] = " << store << ";\n"
+               << "    }\n"
+               << "#undef P\n";
+        }
+    }
+    os << "}\n";
+    return os.str();
+}
+
+// 声明式的滤波链：add() 依次加 stage，run() 时把相邻可融合的 stage 合成一个 kernel
+// 融合后的 kernel 按 pipeline 签名缓存在 ClKernelCache 里
+class ImagePipeline {
+ public:
+  explicit ImagePipeline(ClKernelCache* cache) : cache_(cache) {}
+
+  ~ImagePipeline() { release_temps(); }
+
+  ImagePipeline& add(const PipelineStage& stage) {
+    stages_.push_back(stage);
+    return *this;
+  }
+
+  const std::vector<PipelineStage>& stages() const { return stages_; }
+
+  // 融合分组：半径之和不超过 PIPELINE_MAX_APRON 的连续 stage 放进同一个 kernel
+  // fuse 为 false 时每个 stage 单独一组，用来对比
+  std::vector<std::vector<PipelineStage> > groups(bool fuse) const {
+    std::vector<std::vector<PipelineStage> > result;
+    int apron = 0;
+    for (size_t i = 0; i < stages_.size(); i++) {
+      const PipelineStage& s = stages_[i];
+      bool new_group = result.empty() || !fuse || (s.kind == STAGE_NEIGHBOURHOOD && apron + s.radius > PIPELINE_MAX_APRON);
+      if (new_group) {
+        result.push_back(std::vector<PipelineStage>());
+        apron = 0;
+      }
+      result.back().push_back(s);
+      if (s.kind == STAGE_NEIGHBOURHOOD) apron += s.radius;
+    }
+    return result;
+  }
+
+  static std::string signature(const std::vector<PipelineStage>& stages, const char* in_type,
+                               const char* out_type) {
+    std::ostringstream os;
+    os << in_type << "->" << out_type;
+    for (size_t i = 0; i < stages.size(); i++) {
+      os << "|" << (stages[i].kind == STAGE_POINT ? "P" : "N") << stages[i].radius << ":" << stages[i].code;
+    }
+    return os.str();
+  }
+
+  // src / dst 都是 width * height 的 uchar buffer；中间结果在 float 临时 buffer 里
+  // profiler 不为空时所有 launch 经过它计时
+  void run(cl_command_queue queue, cl_mem src, cl_mem dst, int width, int height, bool fuse = true,
+           ClProfiler* profiler = NULL) {
+    std::vector<std::vector<PipelineStage> > gs = groups(fuse);
+    // 没有 stage 时输出就是输入
+    if (gs.empty()) {
+      cl_int err = clEnqueueCopyBuffer(queue, src, dst, 0, 0, (size_t)width * height, 0, NULL, NULL);
+      CHECK_ERROR(err, "clEnqueueCopyBuffer pipeline");
+      return;
+    }
+    ensure_temps(width, height, std::min<size_t>(2, gs.size() - 1));
+
+    cl_mem in = src;
+    for (size_t g = 0; g < gs.size(); g++) {
+      bool first = g == 0, last = g + 1 == gs.size();
+      const char* in_type = first ? "uchar" : "float";
+      const char* out_type = last ? "uchar" : "float";
+      cl_mem out = last ? dst : temps_[g % 2];
+
+      std::string sig = signature(gs[g], in_type, out_type);
+      // 命中缓存时不再生成源码
+      cl_kernel kernel = cache_->find(sig);
+      if (kernel == NULL) {
+        kernel = cache_->build(sig, generate_pipeline_kernel(gs[g], in_type, out_type, "pipeline_fused"),
+                               "pipeline_fused");
+      }
+
+      clSetKernelArg(kernel, 0, sizeof(cl_mem), &in);
+      clSetKernelArg(kernel, 1, sizeof(cl_mem), &out);
+      clSetKernelArg(kernel, 2, sizeof(int), &width);
+      clSetKernelArg(kernel, 3, sizeof(int), &height);
+
+      size_t lsize[2] = {PIPELINE_TILE, PIPELINE_TILE};
+      size_t gsize[2] = {(size_t)(width + PIPELINE_TILE - 1) / PIPELINE_TILE * PIPELINE_TILE,
+                         (size_t)(height + PIPELINE_TILE - 1) / PIPELINE_TILE * PIPELINE_TILE};
+      double bytes = (double)width * height * ((first ? 1 : 4) + (last ? 1 : 4));
+      cl_int err;
+      if (profiler) {
+        std::string name = fuse ? "fused[" + std::to_string(g) + "]" : gs[g][0].name;
+        err = profiler->enqueue_kernel(kernel, 2, NULL, gsize, lsize, bytes, 0.0, name.c_str());
+      } else {
+        err = clEnqueueNDRangeKernel(queue, kernel, 2, NULL, gsize, lsize, 0, NULL, NULL);
+      }
+      CHECK_ERROR(err, "clEnqueueNDRangeKernel pipeline");
+      in = out;
+    }
+  }
+
+ private:
+  void ensure_temps(int width, int height, size_t count) {
+    size_t bytes = (size_t)width * height * sizeof(float);
+    if (temp_bytes_ >= bytes && temps_.size() >= count) return;
+    release_temps();
+    cl_int err;
+    for (size_t i = 0; i < count; i++) {
+      temps_.push_back(clCreateBuffer(cache_->context(), CL_MEM_READ_WRITE, bytes, NULL, &err));
+      CHECK_ERROR(err, "clCreateBuffer pipeline temp");
+    }
+    temp_bytes_ = bytes;
+  }
+
+  void release_temps() {
+    for (size_t i = 0; i < temps_.size(); i++) clReleaseMemObject(temps_[i]);
+    temps_.clear();
+    temp_bytes_ = 0;
+  }
+
+  ClKernelCache* cache_;
+  std::vector<PipelineStage> stages_;
+  std::vector<cl_mem> temps_;
+  size_t temp_bytes_ = 0;
+};
+
+#endif //COMPUTERVISION_IMAGE_PIPELINE_H
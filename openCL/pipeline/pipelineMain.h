@@ -0,0 +1,81 @@
+//
+// Created by zixhu on 2026/10/19.
+//
+
+#ifndef COMPUTERVISION_PIPELINEMAIN_H
+#define COMPUTERVISION_PIPELINEMAIN_H
+
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <opencv2/opencv.hpp>
+#include "image_pipeline.h"
+
+// box blur -> threshold -> gradient -> box blur，融合前后结果必须一致
+int pipelineMain() {
+    cv::Mat image = cv::imread("../src/opencl/sources/img.png", cv::IMREAD_GRAYSCALE);
+    if (image.empty()) {
+        printf("Image load failed!\n");
+        return -1;
+    }
+    int width = image.cols;
+    int height = image.rows;
+    size_t imgSize = (size_t)width * height;
+
+    OpenCLObjects ocl = init_opencl_with_props("../boxFilter/box_filter.cl", "box_filter_3x3",
+                                               CL_QUEUE_PROFILING_ENABLE);
+    ClKernelCache cache(ocl.context, ocl.device);
+
+    cl_int err;
+    cl_mem buf_input = clCreateBuffer(ocl.context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, imgSize,
+                                      image.data, &err);
+    CHECK_ERROR(err, "clCreateBuffer input");
+    cl_mem buf_output = clCreateBuffer(ocl.context, CL_MEM_WRITE_ONLY, imgSize, NULL, &err);
+    CHECK_ERROR(err, "clCreateBuffer output");
+
+    ImagePipeline pipeline(&cache);
+    pipeline.add(stage_box_blur(1))
+            .add(stage_threshold(100.0f, 255.0f))
+            .add(stage_gradient())
+            .add(stage_box_blur(2));
+
+    ClProfiler prof(ocl.queue);
+    std::vector<uchar> fused(imgSize), unfused(imgSize);
+
+    for (int iter = 0; iter < 10; iter++) {
+        pipeline.run(ocl.queue, buf_input, buf_output, width, height, false, &prof);
+    }
+    clEnqueueReadBuffer(ocl.queue, buf_output, CL_TRUE, 0, imgSize, unfused.data(), 0, NULL, NULL);
+
+    for (int iter = 0; iter < 10; iter++) {
+        pipeline.run(ocl.queue, buf_input, buf_output, width, height, true, &prof);
+    }
+    clEnqueueReadBuffer(ocl.queue, buf_output, CL_TRUE, 0, imgSize, fused.data(), 0, NULL, NULL);
+
+    prof.print_table();
+    printf("kernels: unfused %zu, fused %zu, cache entries %zu (hits %zu, misses %zu)\n",
+           pipeline.groups(false).size(), pipeline.groups(true).size(), cache.size(), cache.hits(),
+           cache.misses());
+
+    // 没有 stage 的 pipeline 把输入原样拷到输出
+    ImagePipeline empty(&cache);
+    std::vector<uchar> copied(imgSize);
+    empty.run(ocl.queue, buf_input, buf_output, width, height);
+    clEnqueueReadBuffer(ocl.queue, buf_output, CL_TRUE, 0, imgSize, copied.data(), 0, NULL, NULL);
+
+    bool pass = fused == unfused && memcmp(copied.data(), image.data, imgSize) == 0;
+    printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+
+    cv::Mat output(height, width, CV_8UC1, fused.data());
+    cv::imshow("Original", image);
+    cv::imshow("Fused pipeline", output);
+    cv::waitKey(0);
+
+    clReleaseMemObject(buf_input);
+    clReleaseMemObject(buf_output);
+    cache.clear();
+    release_opencl(&ocl);
+    return pass ? 0 : -1;
+}
+
+#endif //COMPUTERVISION_PIPELINEMAIN_H
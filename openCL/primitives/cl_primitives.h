@@ -0,0 +1,195 @@
+//
+// Created by zixhu on 2026/10/19.
+//
+
+#ifndef COMPUTERVISION_CL_PRIMITIVES_H
+#define COMPUTERVISION_CL_PRIMITIVES_H
+
+#include <stdio.h>
+#include <vector>
+#include "../boxFilter/opencl_helper.h"
+
+// primitives.cl 的 host 端封装：reduce / scan / histogram256 / integral image
+// 所有接口都是异步 enqueue，结果需要时再读回；reduce_sum 例外，直接返回标量
+// 中间 buffer（部分和、每层块和）作为成员保留，按用过的最大尺寸增长，不在每次调用里 clCreateBuffer；
+// 复用依赖 queue 按顺序执行（没有 CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE）
+class ClPrimitives {
+ public:
+  ClPrimitives(cl_context context, cl_device_id device, cl_command_queue queue, const char* source_file)
+      : context_(context), device_(device), queue_(queue) {
+    size_t max_wg = 256;
+    clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(max_wg), &max_wg, NULL);
+    wg_ = 256;
+    while (wg_ > max_wg) wg_ >>= 1;
+    cl_uint cu = 1;
+    clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cu), &cu, NULL);
+    compute_units_ = cu;
+
+    char options[64];
+    snprintf(options, sizeof(options), "-DWG=%zu", wg_);
+    char* source = read_source(source_file);
+    program_ = build_program_from_source(context, device, source, options);
+    free(source);
+
+    cl_int err;
+    k_reduce_ = clCreateKernel(program_, "reduce_sum", &err);
+    CHECK_ERROR(err, "clCreateKernel reduce_sum");
+    k_scan_ = clCreateKernel(program_, "scan_blocks", &err);
+    CHECK_ERROR(err, "clCreateKernel scan_blocks");
+    k_add_ = clCreateKernel(program_, "scan_add_offsets", &err);
+    CHECK_ERROR(err, "clCreateKernel scan_add_offsets");
+    k_hist_ = clCreateKernel(program_, "histogram256", &err);
+    CHECK_ERROR(err, "clCreateKernel histogram256");
+    k_rows_ = clCreateKernel(program_, "integral_rows", &err);
+    CHECK_ERROR(err, "clCreateKernel integral_rows");
+    k_cols_ = clCreateKernel(program_, "integral_cols", &err);
+    CHECK_ERROR(err, "clCreateKernel integral_cols");
+  }
+
+  ~ClPrimitives() {
+    release(partial_);
+    release(result_);
+    for (size_t i = 0; i < scan_sums_.size(); i++) release(scan_sums_[i]);
+    clReleaseKernel(k_reduce_);
+    clReleaseKernel(k_scan_);
+    clReleaseKernel(k_add_);
+    clReleaseKernel(k_hist_);
+    clReleaseKernel(k_rows_);
+    clReleaseKernel(k_cols_);
+    clReleaseProgram(program_);
+  }
+
+  size_t work_group_size() const { return wg_; }
+
+  // 两趟：第一趟每个 work-group 出一个部分和，第二趟用一个 work-group 归约部分和
+  float reduce_sum(cl_mem in, cl_uint n) {
+    size_t groups = persistent_groups(n);
+    cl_mem partial = grow(partial_, groups * sizeof(float), "clCreateBuffer reduce partial");
+    cl_mem result = grow(result_, sizeof(float), "clCreateBuffer reduce result");
+
+    launch_reduce(in, partial, n, groups);
+    launch_reduce(partial, result, (cl_uint)groups, 1);
+
+    float sum = 0.0f;
+    cl_int err = clEnqueueReadBuffer(queue_, result, CL_TRUE, 0, sizeof(float), &sum, 0, NULL, NULL);
+    CHECK_ERROR(err, "clEnqueueReadBuffer reduce");
+    return sum;
+  }
+
+  // uint 前缀和，in 和 out 可以相同
+  void scan(cl_mem in, cl_mem out, cl_uint n, bool inclusive) { scan_level(in, out, n, inclusive, 0); }
+
+  // hist 是 256 个 cl_uint，函数内先清零
+  void histogram256(cl_mem src, cl_uint n, cl_mem hist) {
+    static const cl_uint zeros[256] = {0};
+    cl_int err = clEnqueueWriteBuffer(queue_, hist, CL_FALSE, 0, sizeof(zeros), zeros, 0, NULL, NULL);
+    CHECK_ERROR(err, "clEnqueueWriteBuffer hist");
+
+    size_t groups = persistent_groups(n / 4 + 1);
+    clSetKernelArg(k_hist_, 0, sizeof(cl_mem), &src);
+    clSetKernelArg(k_hist_, 1, sizeof(cl_uint), &n);
+    clSetKernelArg(k_hist_, 2, sizeof(cl_mem), &hist);
+    size_t gsize = groups * wg_;
+    err = clEnqueueNDRangeKernel(queue_, k_hist_, 1, NULL, &gsize, &wg_, 0, NULL, NULL);
+    CHECK_ERROR(err, "clEnqueueNDRangeKernel histogram256");
+    // 保证 zeros 在函数返回前已经拷走
+    clFinish(queue_);
+  }
+
+  // dst[y][x] = src[0..y][0..x] 之和（含当前像素），uchar -> uint
+  void integral_image(cl_mem src, cl_mem dst, int width, int height) {
+    clSetKernelArg(k_rows_, 0, sizeof(cl_mem), &src);
+    clSetKernelArg(k_rows_, 1, sizeof(cl_mem), &dst);
+    clSetKernelArg(k_rows_, 2, sizeof(int), &width);
+    size_t gsize = (size_t)height * wg_;
+    cl_int err = clEnqueueNDRangeKernel(queue_, k_rows_, 1, NULL, &gsize, &wg_, 0, NULL, NULL);
+    CHECK_ERROR(err, "clEnqueueNDRangeKernel integral_rows");
+
+    clSetKernelArg(k_cols_, 0, sizeof(cl_mem), &dst);
+    clSetKernelArg(k_cols_, 1, sizeof(int), &width);
+    clSetKernelArg(k_cols_, 2, sizeof(int), &height);
+    gsize = ((size_t)width + wg_ - 1) / wg_ * wg_;
+    err = clEnqueueNDRangeKernel(queue_, k_cols_, 1, NULL, &gsize, &wg_, 0, NULL, NULL);
+    CHECK_ERROR(err, "clEnqueueNDRangeKernel integral_cols");
+  }
+
+ private:
+  struct Scratch {
+    cl_mem mem = NULL;
+    size_t bytes = 0;
+  };
+
+  static void release(Scratch& s) {
+    if (s.mem) clReleaseMemObject(s.mem);
+    s = Scratch();
+  }
+
+  // 至少 bytes 大小的 buffer，不够时换一个更大的；已经 enqueue 的命令持有旧 buffer 的引用，可以直接 release
+  cl_mem grow(Scratch& s, size_t bytes, const char* what) {
+    if (s.bytes >= bytes) return s.mem;
+    release(s);
+    cl_int err;
+    s.mem = clCreateBuffer(context_, CL_MEM_READ_WRITE, bytes, NULL, &err);
+    CHECK_ERROR(err, what);
+    s.bytes = bytes;
+    return s.mem;
+  }
+
+  // 块和递归做 scan，第 level 层的块和在 scan_sums_[level]
+  void scan_level(cl_mem in, cl_mem out, cl_uint n, bool inclusive, size_t level) {
+    size_t block = 2 * wg_;
+    size_t blocks = (n + block - 1) / block;
+    if (scan_sums_.size() <= level) scan_sums_.resize(level + 1);
+    cl_mem sums = grow(scan_sums_[level], blocks * sizeof(cl_uint), "clCreateBuffer scan sums");
+
+    int incl = inclusive ? 1 : 0;
+    clSetKernelArg(k_scan_, 0, sizeof(cl_mem), &in);
+    clSetKernelArg(k_scan_, 1, sizeof(cl_mem), &out);
+    clSetKernelArg(k_scan_, 2, sizeof(cl_mem), &sums);
+    clSetKernelArg(k_scan_, 3, sizeof(cl_uint), &n);
+    clSetKernelArg(k_scan_, 4, sizeof(int), &incl);
+    size_t gsize = blocks * wg_;
+    cl_int err = clEnqueueNDRangeKernel(queue_, k_scan_, 1, NULL, &gsize, &wg_, 0, NULL, NULL);
+    CHECK_ERROR(err, "clEnqueueNDRangeKernel scan_blocks");
+
+    // 块和递归做 exclusive scan，再加回每个块
+    if (blocks > 1) {
+      scan_level(sums, sums, (cl_uint)blocks, false, level + 1);
+      clSetKernelArg(k_add_, 0, sizeof(cl_mem), &out);
+      clSetKernelArg(k_add_, 1, sizeof(cl_mem), &sums);
+      clSetKernelArg(k_add_, 2, sizeof(cl_uint), &n);
+      gsize = (n + wg_ - 1) / wg_ * wg_;
+      err = clEnqueueNDRangeKernel(queue_, k_add_, 1, NULL, &gsize, &wg_, 0, NULL, NULL);
+      CHECK_ERROR(err, "clEnqueueNDRangeKernel scan_add_offsets");
+    }
+  }
+
+  // grid-stride kernel 的 work-group 数：够填满设备即可，不超过数据量
+  size_t persistent_groups(size_t n) const {
+    size_t groups = (n + wg_ - 1) / wg_;
+    size_t cap = (size_t)compute_units_ * 8;
+    if (groups > cap) groups = cap;
+    return groups ? groups : 1;
+  }
+
+  void launch_reduce(cl_mem in, cl_mem out, cl_uint n, size_t groups) {
+    clSetKernelArg(k_reduce_, 0, sizeof(cl_mem), &in);
+    clSetKernelArg(k_reduce_, 1, sizeof(cl_mem), &out);
+    clSetKernelArg(k_reduce_, 2, sizeof(cl_uint), &n);
+    size_t gsize = groups * wg_;
+    cl_int err = clEnqueueNDRangeKernel(queue_, k_reduce_, 1, NULL, &gsize, &wg_, 0, NULL, NULL);
+    CHECK_ERROR(err, "clEnqueueNDRangeKernel reduce_sum");
+  }
+
+  cl_context context_;
+  cl_device_id device_;
+  cl_command_queue queue_;
+  cl_program program_;
+  cl_kernel k_reduce_, k_scan_, k_add_, k_hist_, k_rows_, k_cols_;
+  size_t wg_;
+  cl_uint compute_units_;
+  Scratch partial_, result_;
+  std::vector<Scratch> scan_sums_;
+};
+
+#endif //COMPUTERVISION_CL_PRIMITIVES_H
@@ -0,0 +1,207 @@
+
+// 并行原语：reduce / scan / histogram / integral image
+// WG（work-group 大小，2 的幂）由 host 通过 -DWG=... 传入
+
+#ifndef WG
+#define WG 256
+#endif
+
+#if defined(cl_khr_subgroups)
+#pragma OPENCL EXTENSION cl_khr_subgroups : enable
+#define HAS_SUBGROUPS 1
+#elif defined(cl_intel_subgroups)
+#pragma OPENCL EXTENSION cl_intel_subgroups : enable
+#define HAS_SUBGROUPS 1
+#else
+#define HAS_SUBGROUPS 0
+#endif
+
+// scan 用的 local memory 每 32 个元素补一个空位，避免 bank conflict
+#define LOG_NUM_BANKS 5
+#define CONFLICT_FREE_OFFSET(n) ((n) >> LOG_NUM_BANKS)
+#define SCAN_BLOCK (2 * WG)
+#define SCAN_LOCAL_SIZE (SCAN_BLOCK + (SCAN_BLOCK >> LOG_NUM_BANKS))
+
+#define HIST_BINS 256
+#define HIST_COPIES 4
+
+// ---------------------------------------------------------------- reduce
+
+// 每个 work-item 先按 grid-stride 累加，再在 work-group 内归约，结果写到 partial[group]
+// 支持 sub-group 时先做 sub_group_reduce_add，只剩每个 sub-group 一个值需要经过 local memory
+__kernel void reduce_sum(__global const float *in, __global float *partial, const uint n) {
+    __local float scratch[WG];
+    int lid = get_local_id(0);
+
+    float acc = 0.0f;
+    for (uint i = get_global_id(0); i < n; i += get_global_size(0)) {
+        acc += in[i];
+    }
+
+#if HAS_SUBGROUPS
+    acc = sub_group_reduce_add(acc);
+    if (get_sub_group_local_id() == 0) scratch[get_sub_group_id()] = acc;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    if (lid == 0) {
+        float sum = 0.0f;
+        for (uint s = 0; s < get_num_sub_groups(); s++) sum += scratch[s];
+        partial[get_group_id(0)] = sum;
+    }
+#else
+    scratch[lid] = acc;
+    for (int s = WG / 2; s > 0; s >>= 1) {
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if (lid < s) scratch[lid] += scratch[lid + s];
+    }
+    if (lid == 0) partial[get_group_id(0)] = scratch[0];
+#endif
+}
+
+// ---------------------------------------------------------------- scan
+
+// Blelloch 工作高效的 exclusive scan，作用在 temp 里的 SCAN_BLOCK 个元素上
+// 返回前把整块的和写到 *total，所有 work-item 在 barrier 之后都能读到
+void block_exclusive_scan(__local uint *temp, __local uint *total, int lid) {
+    int offset = 1;
+    // up-sweep
+    for (int d = WG; d > 0; d >>= 1) {
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if (lid < d) {
+            int i = offset * (2 * lid + 1) - 1;
+            int j = offset * (2 * lid + 2) - 1;
+            i += CONFLICT_FREE_OFFSET(i);
+            j += CONFLICT_FREE_OFFSET(j);
+            temp[j] += temp[i];
+        }
+        offset <<= 1;
+    }
+    if (lid == 0) {
+        int last = SCAN_BLOCK - 1 + CONFLICT_FREE_OFFSET(SCAN_BLOCK - 1);
+        *total = temp[last];
+        temp[last] = 0;
+    }
+    // down-sweep
+    for (int d = 1; d < SCAN_BLOCK; d <<= 1) {
+        offset >>= 1;
+        barrier(CLK_LOCAL_MEM_FENCE);
+        if (lid < d) {
+            int i = offset * (2 * lid + 1) - 1;
+            int j = offset * (2 * lid + 2) - 1;
+            i += CONFLICT_FREE_OFFSET(i);
+            j += CONFLICT_FREE_OFFSET(j);
+            uint t = temp[i];
+            temp[i] = temp[j];
+            temp[j] += t;
+        }
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+// 每个 work-group 扫描 SCAN_BLOCK 个元素，块内总和写到 block_sums[group]
+// in 和 out 可以是同一个 buffer
+__kernel void scan_blocks(__global const uint *in, __global uint *out, __global uint *block_sums,
+                          const uint n, const int inclusive) {
+    __local uint temp[SCAN_LOCAL_SIZE];
+    __local uint total;
+    int lid = get_local_id(0);
+    uint base = get_group_id(0) * SCAN_BLOCK;
+    int ai = lid;
+    int bi = lid + WG;
+
+    uint va = base + ai < n ? in[base + ai] : 0;
+    uint vb = base + bi < n ? in[base + bi] : 0;
+    temp[ai + CONFLICT_FREE_OFFSET(ai)] = va;
+    temp[bi + CONFLICT_FREE_OFFSET(bi)] = vb;
+
+    block_exclusive_scan(temp, &total, lid);
+
+    uint ea = temp[ai + CONFLICT_FREE_OFFSET(ai)];
+    uint eb = temp[bi + CONFLICT_FREE_OFFSET(bi)];
+    if (inclusive) {
+        ea += va;
+        eb += vb;
+    }
+    if (base + ai < n) out[base + ai] = ea;
+    if (base + bi < n) out[base + bi] = eb;
+    if (lid == 0) block_sums[get_group_id(0)] = total;
+}
+
+// 把已经 exclusive scan 过的块和加回每个块
+__kernel void scan_add_offsets(__global uint *out, __global const uint *block_offsets, const uint n) {
+    uint i = get_global_id(0);
+    if (i >= n) return;
+    out[i] += block_offsets[i / SCAN_BLOCK];
+}
+
+// ---------------------------------------------------------------- histogram
+
+// 256 bin 直方图：每个 work-group 在 local memory 里有 HIST_COPIES 份私有直方图，
+// 相邻 work-item 落在不同副本上减少原子冲突，最后合并后再原子加到 global
+__kernel void histogram256(__global const uchar *src, const uint n, __global uint *hist) {
+    __local uint local_hist[HIST_COPIES * HIST_BINS];
+    int lid = get_local_id(0);
+
+    for (int i = lid; i < HIST_COPIES * HIST_BINS; i += WG) local_hist[i] = 0;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    __local uint *my_hist = local_hist + (lid % HIST_COPIES) * HIST_BINS;
+    uint n4 = n / 4;
+    for (uint i = get_global_id(0); i < n4; i += get_global_size(0)) {
+        uchar4 p = vload4(i, src);
+        atomic_inc(&my_hist[p.x]);
+        atomic_inc(&my_hist[p.y]);
+        atomic_inc(&my_hist[p.z]);
+        atomic_inc(&my_hist[p.w]);
+    }
+    // 不足 4 个的尾巴
+    uint tail = n4 * 4 + get_global_id(0);
+    if (tail < n) atomic_inc(&my_hist[src[tail]]);
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int b = lid; b < HIST_BINS; b += WG) {
+        uint sum = 0;
+        for (int c = 0; c < HIST_COPIES; c++) sum += local_hist[c * HIST_BINS + b];
+        if (sum) atomic_add(&hist[b], sum);
+    }
+}
+
+// ---------------------------------------------------------------- integral image
+
+// 第一步：每个 work-group 负责一行，按 SCAN_BLOCK 分段做 inclusive scan，段与段之间带 carry
+__kernel void integral_rows(__global const uchar *src, __global uint *dst, const int width) {
+    __local uint temp[SCAN_LOCAL_SIZE];
+    __local uint total;
+    int lid = get_local_id(0);
+    int y = get_group_id(0);
+    __global const uchar *row_src = src + (size_t)y * width;
+    __global uint *row_dst = dst + (size_t)y * width;
+    int ai = lid;
+    int bi = lid + WG;
+
+    uint carry = 0;
+    for (int x0 = 0; x0 < width; x0 += SCAN_BLOCK) {
+        uint va = x0 + ai < width ? row_src[x0 + ai] : 0;
+        uint vb = x0 + bi < width ? row_src[x0 + bi] : 0;
+        temp[ai + CONFLICT_FREE_OFFSET(ai)] = va;
+        temp[bi + CONFLICT_FREE_OFFSET(bi)] = vb;
+
+        block_exclusive_scan(temp, &total, lid);
+
+        if (x0 + ai < width) row_dst[x0 + ai] = carry + temp[ai + CONFLICT_FREE_OFFSET(ai)] + va;
+        if (x0 + bi < width) row_dst[x0 + bi] = carry + temp[bi + CONFLICT_FREE_OFFSET(bi)] + vb;
+        carry += total;
+        // 下一段会覆盖 temp 和 total
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+}
+
+// 第二步：每个 work-item 负责一列往下累加，相邻 work-item 访问相邻地址，读写是合并的
+__kernel void integral_cols(__global uint *dst, const int width, const int height) {
+    int x = get_global_id(0);
+    if (x >= width) return;
+    uint acc = 0;
+    for (int y = 0; y < height; y++) {
+        acc += dst[(size_t)y * width + x];
+        dst[(size_t)y * width + x] = acc;
+    }
+}
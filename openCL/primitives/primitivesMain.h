@@ -0,0 +1,204 @@
+//
+// Created by zixhu on 2026/10/19.
+//
+
+#ifndef COMPUTERVISION_PRIMITIVESMAIN_H
+#define COMPUTERVISION_PRIMITIVESMAIN_H
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <stdio.h>
+#include "cl_primitives.h"
+
+static double prim_now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static cl_mem prim_buffer(cl_context context, size_t bytes, const void* host) {
+    cl_int err;
+    cl_mem buf = clCreateBuffer(context, CL_MEM_READ_WRITE | (host ? CL_MEM_COPY_HOST_PTR : 0), bytes,
+                                (void*)host, &err);
+    CHECK_ERROR(err, "clCreateBuffer");
+    return buf;
+}
+
+// 用奇数大小覆盖尾巴、多级递归 scan 和只有一个 work-group 的情况
+static bool prim_check(ClPrimitives& prim, cl_context context, cl_command_queue queue) {
+    bool pass = true;
+    const cl_uint sizes[] = {1, 255, 1000, 4097, 1000003};
+    for (cl_uint n : sizes) {
+        std::vector<float> f(n);
+        std::vector<cl_uint> u(n), out(n), ref(n);
+        std::vector<cl_uchar> b(n);
+        double fref = 0.0;
+        for (cl_uint i = 0; i < n; i++) {
+            f[i] = (float)(i % 17) * 0.25f;
+            fref += f[i];
+            u[i] = (i * 2654435761u) >> 28;
+            b[i] = (cl_uchar)((i * 131u) ^ (i >> 3));
+        }
+
+        cl_mem buf_f = prim_buffer(context, n * sizeof(float), f.data());
+        float sum = prim.reduce_sum(buf_f, n);
+        if (std::fabs(sum - fref) > 1e-4 * fref + 1e-3) {
+            printf("reduce n=%u: %f vs %f\n", n, sum, fref);
+            pass = false;
+        }
+
+        cl_mem buf_u = prim_buffer(context, n * sizeof(cl_uint), u.data());
+        cl_mem buf_o = prim_buffer(context, n * sizeof(cl_uint), NULL);
+        for (int inclusive = 0; inclusive < 2; inclusive++) {
+            prim.scan(buf_u, buf_o, n, inclusive);
+            clEnqueueReadBuffer(queue, buf_o, CL_TRUE, 0, n * sizeof(cl_uint), out.data(), 0, NULL, NULL);
+            cl_uint acc = 0;
+            for (cl_uint i = 0; i < n; i++) {
+                if (inclusive) acc += u[i];
+                ref[i] = acc;
+                if (!inclusive) acc += u[i];
+            }
+            if (out != ref) {
+                printf("%s scan n=%u mismatch\n", inclusive ? "inclusive" : "exclusive", n);
+                pass = false;
+            }
+        }
+
+        cl_mem buf_b = prim_buffer(context, n, b.data());
+        cl_mem buf_h = prim_buffer(context, 256 * sizeof(cl_uint), NULL);
+        prim.histogram256(buf_b, n, buf_h);
+        std::vector<cl_uint> hist(256), href(256, 0);
+        clEnqueueReadBuffer(queue, buf_h, CL_TRUE, 0, 256 * sizeof(cl_uint), hist.data(), 0, NULL, NULL);
+        for (cl_uint i = 0; i < n; i++) href[b[i]]++;
+        if (hist != href) {
+            printf("histogram n=%u mismatch\n", n);
+            pass = false;
+        }
+
+        clReleaseMemObject(buf_f);
+        clReleaseMemObject(buf_u);
+        clReleaseMemObject(buf_o);
+        clReleaseMemObject(buf_b);
+        clReleaseMemObject(buf_h);
+    }
+
+    // 积分图：宽度跨多个 SCAN_BLOCK 段
+    const int width = 1283, height = 77;
+    std::vector<cl_uchar> img((size_t)width * height);
+    for (size_t i = 0; i < img.size(); i++) img[i] = (cl_uchar)(i * 7 + (i >> 5));
+    std::vector<cl_uint> integral(img.size()), iref(img.size());
+    for (int y = 0; y < height; y++) {
+        cl_uint row = 0;
+        for (int x = 0; x < width; x++) {
+            row += img[(size_t)y * width + x];
+            iref[(size_t)y * width + x] = row + (y ? iref[(size_t)(y - 1) * width + x] : 0);
+        }
+    }
+    cl_mem buf_img = prim_buffer(context, img.size(), img.data());
+    cl_mem buf_int = prim_buffer(context, img.size() * sizeof(cl_uint), NULL);
+    prim.integral_image(buf_img, buf_int, width, height);
+    clEnqueueReadBuffer(queue, buf_int, CL_TRUE, 0, img.size() * sizeof(cl_uint), integral.data(), 0, NULL,
+                        NULL);
+    if (integral != iref) {
+        printf("integral image %dx%d mismatch\n", width, height);
+        pass = false;
+    }
+    clReleaseMemObject(buf_img);
+    clReleaseMemObject(buf_int);
+    return pass;
+}
+
+// 1K 到 1G 元素，每档 x4；超过 CL_DEVICE_MAX_MEM_ALLOC_SIZE 的跳过
+// 积分图另外在 1080p 和 4K 上测
+static void prim_bench(ClPrimitives& prim, cl_context context, cl_command_queue queue, cl_device_id device) {
+    cl_ulong max_alloc = 0;
+    clGetDeviceInfo(device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(max_alloc), &max_alloc, NULL);
+
+    printf("%12s %22s %22s %22s\n", "elements", "reduce GB/s Gelem/s", "scan GB/s Gelem/s", "hist GB/s Gelem/s");
+    for (size_t n = 1 << 10; n <= ((size_t)1 << 30); n <<= 2) {
+        if (n * sizeof(cl_uint) > max_alloc) {
+            printf("%12zu skipped (max alloc %llu bytes)\n", n, (unsigned long long)max_alloc);
+            continue;
+        }
+        cl_mem buf = prim_buffer(context, n * sizeof(cl_uint), NULL);
+        cl_mem buf_out = prim_buffer(context, n * sizeof(cl_uint), NULL);
+        cl_mem buf_h = prim_buffer(context, 256 * sizeof(cl_uint), NULL);
+        cl_uint zero = 0;
+        clEnqueueFillBuffer(queue, buf, &zero, sizeof(zero), 0, n * sizeof(cl_uint), 0, NULL, NULL);
+        clFinish(queue);
+
+        int iters = n < (1 << 20) ? 100 : 5;
+        // 先各跑一次热身
+        prim.reduce_sum(buf, (cl_uint)n);
+        double t0 = prim_now_ms();
+        for (int it = 0; it < iters; it++) prim.reduce_sum(buf, (cl_uint)n);
+        double reduce_ms = (prim_now_ms() - t0) / iters;
+
+        prim.scan(buf, buf_out, (cl_uint)n, false);
+        clFinish(queue);
+        t0 = prim_now_ms();
+        for (int it = 0; it < iters; it++) prim.scan(buf, buf_out, (cl_uint)n, false);
+        clFinish(queue);
+        double scan_ms = (prim_now_ms() - t0) / iters;
+
+        // histogram 把同一块内存的前 n 个字节当作 uchar 输入
+        prim.histogram256(buf, (cl_uint)n, buf_h);
+        t0 = prim_now_ms();
+        for (int it = 0; it < iters; it++) prim.histogram256(buf, (cl_uint)n, buf_h);
+        double hist_ms = (prim_now_ms() - t0) / iters;
+
+        double bytes = (double)n * sizeof(cl_uint);
+        // reduce 读一遍，scan 读两遍写两遍（scan_blocks + scan_add_offsets），histogram 读一遍
+        printf("%12zu %10.2f %10.3f  %10.2f %10.3f  %10.2f %10.3f\n", n,
+               bytes / (reduce_ms * 1e6), n / (reduce_ms * 1e6),
+               4 * bytes / (scan_ms * 1e6), n / (scan_ms * 1e6),
+               n / (hist_ms * 1e6), n / (hist_ms * 1e6));
+
+        clReleaseMemObject(buf);
+        clReleaseMemObject(buf_out);
+        clReleaseMemObject(buf_h);
+    }
+
+    // 积分图按图像尺寸测：行 pass 读 uchar 写 uint，列 pass 读写 uint，每像素 13 字节
+    const int dims[][2] = {{1920, 1080}, {3840, 2160}};
+    printf("\n%12s %22s\n", "image", "integral GB/s Gpix/s");
+    for (const int* d : dims) {
+        const int width = d[0], height = d[1];
+        size_t n = (size_t)width * height;
+        cl_mem buf_img = prim_buffer(context, n, NULL);
+        cl_mem buf_int = prim_buffer(context, n * sizeof(cl_uint), NULL);
+        cl_uchar zero = 0;
+        clEnqueueFillBuffer(queue, buf_img, &zero, sizeof(zero), 0, n, 0, NULL, NULL);
+
+        const int iters = 20;
+        prim.integral_image(buf_img, buf_int, width, height);
+        clFinish(queue);
+        double t0 = prim_now_ms();
+        for (int it = 0; it < iters; it++) prim.integral_image(buf_img, buf_int, width, height);
+        clFinish(queue);
+        double integral_ms = (prim_now_ms() - t0) / iters;
+
+        char label[16];
+        snprintf(label, sizeof(label), "%dx%d", width, height);
+        printf("%12s %10.2f %10.3f\n", label, 13.0 * n / (integral_ms * 1e6), n / (integral_ms * 1e6));
+
+        clReleaseMemObject(buf_img);
+        clReleaseMemObject(buf_int);
+    }
+}
+
+int primitivesMain() {
+    OpenCLObjects ocl = init_opencl("primitives.cl", "reduce_sum");
+    // init_opencl 按默认 WG 编译，这里按设备的 work-group 上限带 -DWG 重新编译一份
+    ClPrimitives prim(ocl.context, ocl.device, ocl.queue, "primitives.cl");
+    printf("work-group size: %zu\n", prim.work_group_size());
+
+    bool pass = prim_check(prim, ocl.context, ocl.queue);
+    printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+
+    prim_bench(prim, ocl.context, ocl.queue, ocl.device);
+
+    release_opencl(&ocl);
+    return pass ? 0 : -1;
+}
+
+#endif //COMPUTERVISION_PRIMITIVESMAIN_H
@@ -0,0 +1,342 @@
+//
+// Created by zixhu on 2026/10/19.
+//
+
+#ifndef COMPUTERVISION_CL_PROFILER_H
+#define COMPUTERVISION_CL_PROFILER_H
+
+#include <stdio.h>
+#include <float.h>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../boxFilter/opencl_helper.h"
+#include "../../CPP/OrderedMapVec.hpp"
+
+// 每个名字（kernel 名 / write / read）的累计统计，时间单位 ns
+typedef struct {
+    std::string kind;       // "kernel" / "write" / "read"
+    int count;
+    double queued_ns;       // SUBMIT - QUEUED，在 host 队列里等待的时间
+    double submit_ns;       // START - SUBMIT，提交到设备后到开始执行的时间
+    double exec_ns;         // END - START，真正执行时间
+    double min_exec_ns;
+    double max_exec_ns;
+    double bytes;           // 调用方声明的访存字节数
+    double ops;             // 调用方声明的运算次数
+} ClCommandStats;
+
+// 设备峰值，由内置的 stream / fma 微基准测得
+typedef struct {
+    double bandwidth_gbs;
+    double gops;
+} ClDevicePeak;
+
+static const char *kClPeakSource =
+    "__kernel void peak_stream_triad(__global const float4 *a,\n"
+    "                                __global const float4 *b,\n"
+    "                                __global float4 *c,\n"
+    "                                const float s) {\n"
+    "    int i = get_global_id(0);\n"
+    "    c[i] = a[i] + s * b[i];\n"
+    "}\n"
+    "\n"
+    "__kernel void peak_fma(__global float4 *out, const float y, const int iters) {\n"
+    "    float4 x0 = (float4)(get_global_id(0));\n"
+    "    float4 x1 = x0 + 1.0f, x2 = x0 + 2.0f, x3 = x0 + 3.0f;\n"
+    "    float4 x4 = x0 + 4.0f, x5 = x0 + 5.0f, x6 = x0 + 6.0f, x7 = x0 + 7.0f;\n"
+    "    for (int i = 0; i < iters; i++) {\n"
+    "        x0 = mad(x0, y, y); x1 = mad(x1, y, y); x2 = mad(x2, y, y); x3 = mad(x3, y, y);\n"
+    "        x4 = mad(x4, y, y); x5 = mad(x5, y, y); x6 = mad(x6, y, y); x7 = mad(x7, y, y);\n"
+    "    }\n"
+    "    out[get_global_id(0)] = x0 + x1 + x2 + x3 + x4 + x5 + x6 + x7;\n"
+    "}\n";
+
+// 一个 event 的 END - START，单位 ns
+cl_ulong event_exec_ns(cl_event ev) {
+    cl_ulong start = 0, end = 0;
+    clGetEventProfilingInfo(ev, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+    clGetEventProfilingInfo(ev, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+    return end - start;
+}
+
+// 测量设备峰值：stream triad 带宽 + 8 路独立 mad 链的算力，各取 5 次里最好的一次
+ClDevicePeak measure_device_peak(cl_context context, cl_device_id device) {
+    ClDevicePeak peak = {0.0, 0.0};
+    cl_int err;
+
+    cl_command_queue queue = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &err);
+    CHECK_ERROR(err, "clCreateCommandQueue peak");
+    cl_program program = build_program_from_source(context, device, kClPeakSource, NULL);
+
+    // stream：每个数组 64MB，超过单次分配上限就缩小
+    cl_ulong max_alloc = 0;
+    clGetDeviceInfo(device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(max_alloc), &max_alloc, NULL);
+    size_t bytes = 64u << 20;
+    while (bytes > max_alloc && bytes > (1u << 20)) bytes >>= 1;
+    size_t n4 = bytes / (4 * sizeof(float));
+
+    cl_mem a = clCreateBuffer(context, CL_MEM_READ_ONLY, bytes, NULL, &err);
+    CHECK_ERROR(err, "clCreateBuffer peak a");
+    cl_mem b = clCreateBuffer(context, CL_MEM_READ_ONLY, bytes, NULL, &err);
+    CHECK_ERROR(err, "clCreateBuffer peak b");
+    cl_mem c = clCreateBuffer(context, CL_MEM_WRITE_ONLY, bytes, NULL, &err);
+    CHECK_ERROR(err, "clCreateBuffer peak c");
+
+    cl_kernel triad = clCreateKernel(program, "peak_stream_triad", &err);
+    CHECK_ERROR(err, "clCreateKernel peak_stream_triad");
+    float s = 3.0f;
+    clSetKernelArg(triad, 0, sizeof(cl_mem), &a);
+    clSetKernelArg(triad, 1, sizeof(cl_mem), &b);
+    clSetKernelArg(triad, 2, sizeof(cl_mem), &c);
+    clSetKernelArg(triad, 3, sizeof(float), &s);
+
+    // 第一次是 warm up，不计入
+    cl_ulong best = (cl_ulong)-1;
+    for (int run = 0; run < 6; run++) {
+        cl_event ev;
+        err = clEnqueueNDRangeKernel(queue, triad, 1, NULL, &n4, NULL, 0, NULL, &ev);
+        CHECK_ERROR(err, "clEnqueueNDRangeKernel peak_stream_triad");
+        clWaitForEvents(1, &ev);
+        cl_ulong t = event_exec_ns(ev);
+        if (run > 0 && t < best) best = t;
+        clReleaseEvent(ev);
+    }
+    peak.bandwidth_gbs = 3.0 * bytes / (double)best;
+
+    // fma：每个 work-item 8 条 float4 链，每次迭代 8 * 4 * 2 次浮点运算
+    cl_kernel fma = clCreateKernel(program, "peak_fma", &err);
+    CHECK_ERROR(err, "clCreateKernel peak_fma");
+    size_t items = n4 < (1u << 20) ? n4 : (1u << 20);
+    float y = 0.999f;
+    int iters = 256;
+    clSetKernelArg(fma, 0, sizeof(cl_mem), &c);
+    clSetKernelArg(fma, 1, sizeof(float), &y);
+    clSetKernelArg(fma, 2, sizeof(int), &iters);
+
+    best = (cl_ulong)-1;
+    for (int run = 0; run < 6; run++) {
+        cl_event ev;
+        err = clEnqueueNDRangeKernel(queue, fma, 1, NULL, &items, NULL, 0, NULL, &ev);
+        CHECK_ERROR(err, "clEnqueueNDRangeKernel peak_fma");
+        clWaitForEvents(1, &ev);
+        cl_ulong t = event_exec_ns(ev);
+        if (run > 0 && t < best) best = t;
+        clReleaseEvent(ev);
+    }
+    peak.gops = (double)items * iters * 64.0 / (double)best;
+
+    clReleaseKernel(triad);
+    clReleaseKernel(fma);
+    clReleaseMemObject(a);
+    clReleaseMemObject(b);
+    clReleaseMemObject(c);
+    clReleaseProgram(program);
+    clReleaseCommandQueue(queue);
+    return peak;
+}
+
+// 包装所有 enqueue，记录 event，collect() 时按名字聚合
+// queue 必须带 CL_QUEUE_PROFILING_ENABLE（见 init_opencl_with_props）
+class ClProfiler {
+ public:
+  explicit ClProfiler(cl_command_queue queue) : queue_(queue) { peak_.bandwidth_gbs = peak_.gops = 0.0; }
+  ~ClProfiler() { collect(); }
+
+  void set_peak(const ClDevicePeak& peak) { peak_ = peak; }
+  const ClDevicePeak& peak() const { return peak_; }
+
+  cl_int enqueue_write(cl_mem buffer, cl_bool blocking, size_t offset, size_t size, const void* ptr,
+                       const char* name = "write", cl_uint num_wait = 0, const cl_event* wait_list = NULL,
+                       cl_event* out_event = NULL) {
+    cl_event ev;
+    cl_int err = clEnqueueWriteBuffer(queue_, buffer, blocking, offset, size, ptr, num_wait, wait_list, &ev);
+    if (err == CL_SUCCESS) track(name, "write", ev, (double)size, 0.0, out_event);
+    return err;
+  }
+
+  cl_int enqueue_read(cl_mem buffer, cl_bool blocking, size_t offset, size_t size, void* ptr,
+                      const char* name = "read", cl_uint num_wait = 0, const cl_event* wait_list = NULL,
+                      cl_event* out_event = NULL) {
+    cl_event ev;
+    cl_int err = clEnqueueReadBuffer(queue_, buffer, blocking, offset, size, ptr, num_wait, wait_list, &ev);
+    if (err == CL_SUCCESS) track(name, "read", ev, (double)size, 0.0, out_event);
+    return err;
+  }
+
+  // bytes / ops 是这次 launch 的理论访存量和运算量，用于算 GB/s、GOP/s；不关心可以传 0
+  // name 为 NULL 时用 kernel 的函数名
+  cl_int enqueue_kernel(cl_kernel kernel, cl_uint work_dim, const size_t* global_offset,
+                        const size_t* global_size, const size_t* local_size, double bytes, double ops,
+                        const char* name = NULL, cl_uint num_wait = 0, const cl_event* wait_list = NULL,
+                        cl_event* out_event = NULL) {
+    char func_name[128];
+    if (name == NULL) {
+      func_name[0] = '\0';
+      clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, sizeof(func_name), func_name, NULL);
+      name = func_name;
+    }
+    cl_event ev;
+    cl_int err = clEnqueueNDRangeKernel(queue_, kernel, work_dim, global_offset, global_size, local_size,
+                                        num_wait, wait_list, &ev);
+    if (err == CL_SUCCESS) track(name, "kernel", ev, bytes, ops, out_event);
+    return err;
+  }
+
+  // 等待队列完成，把未处理的 event 折算进统计
+  void collect() {
+    if (pending_.empty()) return;
+    clFinish(queue_);
+    for (size_t i = 0; i < pending_.size(); i++) {
+      Pending& p = pending_[i];
+      cl_ulong queued = 0, submit = 0, start = 0, end = 0;
+      clGetEventProfilingInfo(p.ev, CL_PROFILING_COMMAND_QUEUED, sizeof(cl_ulong), &queued, NULL);
+      clGetEventProfilingInfo(p.ev, CL_PROFILING_COMMAND_SUBMIT, sizeof(cl_ulong), &submit, NULL);
+      clGetEventProfilingInfo(p.ev, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+      clGetEventProfilingInfo(p.ev, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+      clReleaseEvent(p.ev);
+
+      auto it = stats_.try_emplace(p.name).first;
+      ClCommandStats& s = it->second;
+      if (s.count == 0) {
+        s.kind = p.kind;
+        s.min_exec_ns = DBL_MAX;
+      }
+      double exec = (double)(end - start);
+      s.count++;
+      s.queued_ns += (double)(submit - queued);
+      s.submit_ns += (double)(start - submit);
+      s.exec_ns += exec;
+      if (exec < s.min_exec_ns) s.min_exec_ns = exec;
+      if (exec > s.max_exec_ns) s.max_exec_ns = exec;
+      s.bytes += p.bytes;
+      s.ops += p.ops;
+    }
+    pending_.clear();
+  }
+
+  void reset() {
+    collect();
+    stats_.clear();
+  }
+
+  const OrderedMapVec<std::string, ClCommandStats>& stats() {
+    collect();
+    return stats_;
+  }
+
+  // 表格输出，设置了 peak 时附带 roofline 分析
+  void print_table(FILE* fp = stdout) {
+    collect();
+    bool has_peak = peak_.bandwidth_gbs > 0.0 && peak_.gops > 0.0;
+    if (has_peak) {
+      fprintf(fp, "device peak: %.2f GB/s, %.2f GOP/s, ridge point %.2f op/byte\n", peak_.bandwidth_gbs,
+              peak_.gops, peak_.gops / peak_.bandwidth_gbs);
+    }
+    fprintf(fp, "%-24s %-6s %6s %10s %9s %9s %9s %9s %9s %8s %8s %8s %8s %6s\n", "name", "kind", "calls",
+            "total(ms)", "avg(us)", "min(us)", "max(us)", "queue(us)", "submit(us)", "GB/s", "%bw", "GOP/s",
+            "%ops", "bound");
+    for (auto it = stats_.begin(); it != stats_.end(); ++it) {
+      const ClCommandStats& s = it->second;
+      double gbs = s.exec_ns > 0.0 ? s.bytes / s.exec_ns : 0.0;
+      double gops = s.exec_ns > 0.0 ? s.ops / s.exec_ns : 0.0;
+      fprintf(fp, "%-24s %-6s %6d %10.3f %9.2f %9.2f %9.2f %9.2f %9.2f %8.2f %8s %8.2f %8s %6s\n",
+              it->first.c_str(), s.kind.c_str(), s.count, s.exec_ns * 1e-6, s.exec_ns / s.count * 1e-3,
+              s.min_exec_ns * 1e-3, s.max_exec_ns * 1e-3, s.queued_ns / s.count * 1e-3,
+              s.submit_ns / s.count * 1e-3, gbs, percent(gbs, peak_.bandwidth_gbs).c_str(), gops,
+              percent(gops, peak_.gops).c_str(), bound(s));
+    }
+  }
+
+  std::string to_json() {
+    collect();
+    std::ostringstream os;
+    os << "{\n  \"peak\": {\"bandwidth_gbs\": " << peak_.bandwidth_gbs << ", \"gops\": " << peak_.gops << "},\n";
+    os << "  \"commands\": [";
+    bool first = true;
+    for (auto it = stats_.begin(); it != stats_.end(); ++it) {
+      const ClCommandStats& s = it->second;
+      os << (first ? "\n" : ",\n");
+      first = false;
+      os << "    {\"name\": " << json_string(it->first) << ", \"kind\": " << json_string(s.kind)
+         << ", \"calls\": " << s.count << ", \"queued_ns\": " << s.queued_ns << ", \"submit_ns\": " << s.submit_ns
+         << ", \"exec_ns\": " << s.exec_ns << ", \"min_exec_ns\": " << s.min_exec_ns
+         << ", \"max_exec_ns\": " << s.max_exec_ns << ", \"bytes\": " << s.bytes << ", \"ops\": " << s.ops
+         << ", \"gbs\": " << (s.exec_ns > 0.0 ? s.bytes / s.exec_ns : 0.0)
+         << ", \"gops\": " << (s.exec_ns > 0.0 ? s.ops / s.exec_ns : 0.0) << ", \"bound\": \"" << bound(s)
+         << "\"}";
+    }
+    os << "\n  ]\n}\n";
+    return os.str();
+  }
+
+  bool write_json(const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+      perror("Failed to open json file");
+      return false;
+    }
+    std::string json = to_json();
+    fwrite(json.data(), 1, json.size(), fp);
+    fclose(fp);
+    return true;
+  }
+
+ private:
+  struct Pending {
+    std::string name;
+    const char* kind;
+    cl_event ev;
+    double bytes;
+    double ops;
+  };
+
+  void track(const char* name, const char* kind, cl_event ev, double bytes, double ops, cl_event* out_event) {
+    if (out_event) {
+      clRetainEvent(ev);
+      *out_event = ev;
+    }
+    Pending p = {name, kind, ev, bytes, ops};
+    pending_.push_back(p);
+  }
+
+  static std::string percent(double value, double peak) {
+    if (peak <= 0.0) return "-";
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.1f", 100.0 * value / peak);
+    return buf;
+  }
+
+  // JSON 字符串字面量：名字来自调用方（enqueue_* 的 name），引号、反斜杠和控制字符要转义
+  static std::string json_string(const std::string& str) {
+    std::string out = "\"";
+    for (size_t i = 0; i < str.size(); i++) {
+      const unsigned char c = (unsigned char)str[i];
+      if (c == '"' || c == '\\') {
+        out += '\\';
+        out += (char)c;
+      } else if (c < 0x20) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\u%04x", c);
+        out += buf;
+      } else {
+        out += (char)c;
+      }
+    }
+    return out + "\"";
+  }
+
+  // 按算术强度和 ridge point 判断是访存瓶颈还是计算瓶颈
+  const char* bound(const ClCommandStats& s) const {
+    if (s.kind != "kernel" || s.bytes <= 0.0 || peak_.bandwidth_gbs <= 0.0 || peak_.gops <= 0.0) return "-";
+    double intensity = s.ops / s.bytes;
+    return intensity < peak_.gops / peak_.bandwidth_gbs ? "memory" : "compute";
+  }
+
+  cl_command_queue queue_;
+  ClDevicePeak peak_;
+  std::vector<Pending> pending_;
+  OrderedMapVec<std::string, ClCommandStats> stats_;
+};
+
+#endif //COMPUTERVISION_CL_PROFILER_H
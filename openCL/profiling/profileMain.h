@@ -0,0 +1,71 @@
+//
+// Created by zixhu on 2026/10/19.
+//
+
+#ifndef COMPUTERVISION_PROFILEMAIN_H
+#define COMPUTERVISION_PROFILEMAIN_H
+
+#include <vector>
+#include <stdio.h>
+#include "cl_profiler.h"
+
+// 对 vector_add 做一次完整的 write -> kernel -> read 计时，并输出 roofline 报告
+int profileMain() {
+    const int n = 1 << 22;
+    const size_t bytes = sizeof(float) * n;
+
+    std::vector<float> A(n), B(n), C(n);
+    for (int i = 0; i < n; i++) {
+        A[i] = (float)i;
+        B[i] = (float)(i * 2);
+    }
+
+    // 打开 profiling 的队列
+    OpenCLObjects ocl = init_opencl_with_props("../addDemo/add.cl", "vector_add", CL_QUEUE_PROFILING_ENABLE);
+
+    cl_int err;
+    cl_mem buf_a = clCreateBuffer(ocl.context, CL_MEM_READ_ONLY, bytes, NULL, &err);
+    CHECK_ERROR(err, "clCreateBuffer A");
+    cl_mem buf_b = clCreateBuffer(ocl.context, CL_MEM_READ_ONLY, bytes, NULL, &err);
+    CHECK_ERROR(err, "clCreateBuffer B");
+    cl_mem buf_c = clCreateBuffer(ocl.context, CL_MEM_WRITE_ONLY, bytes, NULL, &err);
+    CHECK_ERROR(err, "clCreateBuffer C");
+
+    ClProfiler prof(ocl.queue);
+    prof.set_peak(measure_device_peak(ocl.context, ocl.device));
+
+    clSetKernelArg(ocl.kernel, 0, sizeof(cl_mem), &buf_a);
+    clSetKernelArg(ocl.kernel, 1, sizeof(cl_mem), &buf_b);
+    clSetKernelArg(ocl.kernel, 2, sizeof(cl_mem), &buf_c);
+
+    size_t gsize = n;
+    for (int iter = 0; iter < 10; iter++) {
+        err = prof.enqueue_write(buf_a, CL_FALSE, 0, bytes, A.data(), "write A");
+        CHECK_ERROR(err, "clEnqueueWriteBuffer A");
+        err = prof.enqueue_write(buf_b, CL_FALSE, 0, bytes, B.data(), "write B");
+        CHECK_ERROR(err, "clEnqueueWriteBuffer B");
+        // 每个元素读 2 个 float 写 1 个 float，做 1 次加法
+        err = prof.enqueue_kernel(ocl.kernel, 1, NULL, &gsize, NULL, 3.0 * bytes, (double)n);
+        CHECK_ERROR(err, "clEnqueueNDRangeKernel");
+        err = prof.enqueue_read(buf_c, CL_TRUE, 0, bytes, C.data(), "read C");
+        CHECK_ERROR(err, "clEnqueueReadBuffer");
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (C[i] != A[i] + B[i]) {
+            printf("Mismatch at %d: %f\n", i, C[i]);
+            break;
+        }
+    }
+
+    prof.print_table();
+    prof.write_json("vector_add_profile.json");
+
+    clReleaseMemObject(buf_a);
+    clReleaseMemObject(buf_b);
+    clReleaseMemObject(buf_c);
+    release_opencl(&ocl);
+    return 0;
+}
+
+#endif //COMPUTERVISION_PROFILEMAIN_H
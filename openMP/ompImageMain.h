@@ -0,0 +1,232 @@
+#pragma once
+
+// Checks the OpenMP backend against the scalar references (box_filter_ref,
+// the SIMD to_gray, pyr_down_ref, warp_perspective_ref) over odd sizes,
+// every schedule and odd tile shapes, then prints a scaling report on a 4K
+// frame: ms per operation from 1 thread up to every core, for static, dynamic
+// and guided scheduling, plus the cost of skipping first touch.
+//
+// On a dual-socket box run it with the threads spread over both sockets and
+// pinned, otherwise first touch has nothing to work with:
+//   OMP_PROC_BIND=spread OMP_PLACES=cores ./omp_demo
+//
+// The kernels are plain loops vectorized by the compiler, so build for the
+// target ISA:
+// g++ -O3 -march=native -fopenmp -std=c++17 main.cpp -o omp_demo
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "../simd/boxFilter/box_filter_simd.h"
+#include "../simd/color/color.h"
+#include "omp_image.h"
+
+namespace xr {
+namespace omp {
+
+inline std::vector<uint8_t> omp_random(size_t n, uint32_t seed) {
+  std::vector<uint8_t> v(n);
+  for (auto& x : v) {
+    seed = seed * 1664525u + 1013904223u;
+    x = (uint8_t)(seed >> 24);
+  }
+  return v;
+}
+
+// rotation by deg about the centre plus a mild perspective term, mapping
+// destination pixels to source pixels
+inline void omp_test_homography(int w, int h, float deg, float persp, float m[9]) {
+  const float c = std::cos(deg * 3.14159265f / 180.0f), s = std::sin(deg * 3.14159265f / 180.0f);
+  const float cx = 0.5f * w, cy = 0.5f * h;
+  m[0] = c;
+  m[1] = -s;
+  m[2] = cx - c * cx + s * cy;
+  m[3] = s;
+  m[4] = c;
+  m[5] = cy - s * cx - c * cy;
+  m[6] = persp / w;
+  m[7] = 0.0f;
+  m[8] = 1.0f;
+}
+
+// largest |a - b| over width bytes of each row
+inline int omp_max_diff(const uint8_t* a, int a_step, const uint8_t* b, int b_step, int width, int height) {
+  int worst = 0;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) worst = std::max(worst, std::abs(a[(size_t)y * a_step + x] - b[(size_t)y * b_step + x]));
+  }
+  return worst;
+}
+
+// one width x height case of every operation under cfg; returns false on a
+// mismatch (warps may differ by 1)
+inline bool omp_check(int width, int height, const OmpConfig& cfg) {
+  bool ok = true;
+  const int pad = 3, step = width + pad;
+  std::vector<uint8_t> dense = omp_random((size_t)width * height, width * 13 + height);
+  std::vector<uint8_t> src((size_t)step * height), ref((size_t)width * height), out((size_t)step * height);
+  for (int y = 0; y < height; y++) std::memcpy(&src[(size_t)y * step], &dense[(size_t)y * width], width);
+
+  for (int r : {0, 1, 2, 5}) {
+    xr::box::box_filter_ref(dense.data(), ref.data(), width, height, r);
+    ok &= box_filter(src.data(), step, out.data(), step, width, height, r, cfg);
+    ok &= omp_max_diff(out.data(), step, ref.data(), width, width, height) == 0;
+  }
+
+  const int dw = (width + 1) / 2, dh = (height + 1) / 2;
+  std::vector<uint8_t> pyr_ref((size_t)dw * dh), pyr((size_t)(dw + pad) * dh);
+  pyr_down_ref(src.data(), step, width, height, pyr_ref.data(), dw);
+  ok &= pyr_down(src.data(), step, width, height, pyr.data(), dw + pad, cfg);
+  ok &= omp_max_diff(pyr.data(), dw + pad, pyr_ref.data(), dw, dw, dh) == 0;
+
+  float m[9];
+  omp_test_homography(width, height, 17.0f, 0.1f, m);
+  std::vector<uint8_t> warp_ref((size_t)step * height);
+  warp_perspective_ref(src.data(), step, width, height, warp_ref.data(), step, width, height, m, 7);
+  ok &= warp_perspective(src.data(), step, width, height, out.data(), step, width, height, m, 7, cfg);
+  ok &= omp_max_diff(out.data(), step, warp_ref.data(), step, width, height) <= 1;
+
+  for (int channels = 3; channels <= 4; channels++) {
+    const int cstep = width * channels + pad;
+    std::vector<uint8_t> color = omp_random((size_t)cstep * height, width + channels);
+    const ColorOrder order = channels == 3 ? ColorOrder::kBGR : ColorOrder::kRGBA;
+    const xr::color::ColorOrder simd_order = channels == 3 ? xr::color::ColorOrder::kBGR : xr::color::ColorOrder::kRGBA;
+    xr::color::to_gray(color.data(), cstep, simd_order, ref.data(), width, width, height);
+    ok &= to_gray(color.data(), cstep, order, out.data(), step, width, height, cfg);
+    ok &= omp_max_diff(out.data(), step, ref.data(), width, width, height) == 0;
+
+    std::vector<float> f((size_t)width * channels * height);
+    ok &= convert_u8_f32(color.data(), cstep, f.data(), width * channels * (int)sizeof(float), width, height, channels,
+                         1.0f / 255.0f, -0.5f, cfg);
+    for (int y = 0; y < height; y++) {
+      for (int i = 0; i < width * channels; i++) {
+        ok &= f[(size_t)y * width * channels + i] == (float)color[(size_t)y * cstep + i] * (1.0f / 255.0f) - 0.5f;
+      }
+    }
+  }
+  return ok;
+}
+
+inline double omp_now_ms() {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F>
+inline double omp_time_ms(F&& f) {
+  f();
+  int runs = 0;
+  double t0 = omp_now_ms();
+  do {
+    f();
+    runs++;
+  } while (omp_now_ms() - t0 < 100.0);
+  return (omp_now_ms() - t0) / runs;
+}
+
+}  // namespace omp
+}  // namespace xr
+
+inline int ompImageMain() {
+  using namespace xr::omp;
+
+  const Schedule schedules[] = {Schedule::kStatic, Schedule::kDynamic, Schedule::kGuided};
+  bool pass = true;
+  {
+    const int sizes[][2] = {{1, 1}, {2, 3}, {17, 9}, {64, 64}, {300, 201}, {513, 130}};
+    const int tiles[][2] = {{256, 64}, {37, 5}, {1, 1}};
+    for (Schedule s : schedules) {
+      bool ok = true;
+      for (const auto& t : tiles) {
+        OmpConfig cfg;
+        cfg.schedule = s;
+        cfg.tile_width = t[0];
+        cfg.tile_height = t[1];
+        cfg.chunk = t[0] == 1 ? 7 : 0;
+        for (const auto& sz : sizes) ok &= omp_check(sz[0], sz[1], cfg);
+      }
+      pass &= ok;
+      printf("%-8s %s\n", schedule_name(s), ok ? "ok" : "FAILED");
+    }
+  }
+
+#ifdef _OPENMP
+  const int max_threads = omp_get_max_threads();
+  printf("\n%d OpenMP threads, %d procs\n", max_threads, omp_get_num_procs());
+#else
+  const int max_threads = 1;
+  printf("\nbuilt without OpenMP\n");
+#endif
+  std::vector<int> counts;
+  for (int t = 1; t < max_threads; t *= 2) counts.push_back(t);
+  counts.push_back(max_threads);
+
+  const int w = 3840, h = 2160;
+  OmpConfig touch;
+  OmpImage<uint8_t> src(w, h, 1, touch), dst(w, h, 1, touch), bgr(w, h, 3, touch);
+  OmpImage<float> f(w, h, 1, touch);
+  std::vector<uint8_t> noise = omp_random((size_t)w * h * 3, 1);
+  for (int y = 0; y < h; y++) {
+    std::memcpy(src.row(y), &noise[(size_t)y * w], w);
+    std::memcpy(bgr.row(y), &noise[(size_t)y * w * 3], (size_t)w * 3);
+  }
+  float m[9];
+  omp_test_homography(w, h, 15.0f, 0.0f, m);
+
+  struct Op {
+    const char* name;
+    std::function<void(const OmpConfig&)> run;
+  };
+  const Op ops[] = {
+      {"box r=3", [&](const OmpConfig& c) { box_filter(src.data(), src.step(), dst.data(), dst.step(), w, h, 3, c); }},
+      {"warp 15deg",
+       [&](const OmpConfig& c) {
+         warp_perspective(src.data(), src.step(), w, h, dst.data(), dst.step(), w, h, m, 0, c);
+       }},
+      {"pyramid x5", [&](const OmpConfig& c) { build_pyramid(src.data(), src.step(), w, h, 5, c); }},
+      {"bgr -> gray",
+       [&](const OmpConfig& c) { to_gray(bgr.data(), bgr.step(), ColorOrder::kBGR, dst.data(), dst.step(), w, h, c); }},
+      {"u8 -> f32",
+       [&](const OmpConfig& c) {
+         convert_u8_f32(src.data(), src.step(), f.data(), f.step(), w, h, 1, 1.0f / 255.0f, 0.0f, c);
+       }},
+  };
+
+  printf("%dx%d, ms (speedup over 1 thread)\n%-12s %-8s", w, h, "", "");
+  for (int t : counts) printf(" %9d thr", t);
+  printf("\n");
+  for (const Op& op : ops) {
+    for (Schedule s : schedules) {
+      printf("%-12s %-8s", op.name, schedule_name(s));
+      double base = 0.0;
+      for (int t : counts) {
+        OmpConfig cfg;
+        cfg.threads = t;
+        cfg.schedule = s;
+        double ms = omp_time_ms([&] { op.run(cfg); });
+        if (t == 1) base = ms;
+        printf(" %7.2f (%4.1fx)", ms, base / ms);
+      }
+      printf("\n");
+    }
+  }
+
+  // the same box filter on buffers the main thread zeroed: on NUMA every page
+  // sits on the first socket and the other socket's threads read remotely
+  {
+    OmpConfig cfg;
+    std::vector<uint8_t> a((size_t)w * h), b((size_t)w * h);
+    std::memcpy(a.data(), noise.data(), a.size());
+    double serial = omp_time_ms([&] { box_filter(a.data(), w, b.data(), w, w, h, 3, cfg); });
+    double first = omp_time_ms([&] { box_filter(src.data(), src.step(), dst.data(), dst.step(), w, h, 3, cfg); });
+    double simd = omp_time_ms([&] { xr::box::box_filter_simd(a.data(), b.data(), w, h, 3); });
+    printf("\nbox r=3, %d threads: first touch %.2f ms, main-thread touch %.2f ms, SIMD backend %.2f ms\n",
+           max_threads, first, serial, simd);
+  }
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
@@ -0,0 +1,435 @@
+#pragma once
+
+// OpenMP scheduling / affinity sweep over four kernels of this repository:
+//
+//   vector_add   C = A + B on 8M floats, openCL/addDemo on the CPU, memory
+//                bound
+//   sgemm        1024^3 in 64 x 128 blocks of C, one single-threaded
+//                xr::gemm::sgemm per block, compute bound
+//   box r=3      xr::omp::box_filter_tile over 256 x 64 tiles of a 4K frame,
+//                a stencil
+//   skewed       per-point iterative refinement where clustered points take
+//                60x more iterations than the rest (see CPP/workStealingMain.h)
+//
+// Each kernel is one `omp for schedule(runtime)` loop, run for every schedule
+// kind (static, dynamic, guided, auto) x chunk size x thread count. Reported
+// per run:
+//
+//   rate   throughput in the kernel's unit (GB/s, GFLOP/s, Mpix/s, Mpts/s)
+//   imb    load imbalance, max / mean of the per-thread busy time
+//   wait   mean time a thread sits in the closing barrier, in us
+//
+// plus the bare cost of a barrier and of a parallel region per thread count,
+// and the best setting of every kernel. OMP_PROC_BIND and OMP_PLACES are read
+// once at start-up, so on Linux the demo starts its own executable once per
+// binding policy below, with XR_OMP_SCHED_CHILD set, and relays its output.
+// For that, main() must hand over to ompSchedChild() before anything else:
+//
+//   int main() {
+//     if (std::getenv("XR_OMP_SCHED_CHILD")) return ompSchedChild();
+//     return ompSchedMain();
+//   }
+//
+// A child that does not answer with ompSchedChild's first line is stopped,
+// and the demo measures only the binding it was started with, as it does
+// outside Linux. Whatever wins maps directly onto OMP_SCHEDULE="kind,chunk"
+// for schedule(runtime) loops.
+//
+// g++ -O3 -march=native -fopenmp -std=c++17 main.cpp -o sched_demo
+
+#ifndef _OPENMP
+#error "ompSchedMain.h measures OpenMP scheduling, build with -fopenmp"
+#endif
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+#include "../simd/gemm/gemm.h"
+#include "omp_image.h"
+
+namespace xr {
+namespace omp {
+
+struct LoopStats {
+  double ms = 0.0;         // wall time per run
+  double imbalance = 0.0;  // max / mean busy time
+  double wait_us = 0.0;    // mean time in the closing barrier
+};
+
+// Runs body(i) for i in [0, n) as one schedule(runtime) loop under (kind,
+// chunk) on threads threads, repeated until at least min_ms have passed.
+template <typename F>
+inline LoopStats sched_run(int n, int threads, omp_sched_t kind, int chunk, double min_ms, F&& body) {
+  omp_sched_t saved_kind;
+  int saved_chunk;
+  omp_get_schedule(&saved_kind, &saved_chunk);
+  omp_set_schedule(kind, chunk);
+
+  std::vector<double> busy(threads), done(threads);
+  LoopStats sum;
+  int runs = 0;
+  const double start = omp_get_wtime();
+  do {
+    int team = threads;
+    const double t0 = omp_get_wtime();
+#pragma omp parallel num_threads(threads)
+    {
+      const int t = omp_get_thread_num();
+      if (t == 0) team = omp_get_num_threads();
+      const double s = omp_get_wtime();
+#pragma omp for schedule(runtime) nowait
+      for (int i = 0; i < n; i++) body(i);
+      const double e = omp_get_wtime();
+      busy[t] = e - s;
+      done[t] = e;
+    }
+    const double t1 = omp_get_wtime();
+    double mean = 0.0, peak = 0.0, last = 0.0, wait = 0.0;
+    for (int t = 0; t < team; t++) {
+      mean += busy[t] / team;
+      peak = std::max(peak, busy[t]);
+      last = std::max(last, done[t]);
+    }
+    for (int t = 0; t < team; t++) wait += (last - done[t]) / team;
+    sum.ms += (t1 - t0) * 1e3;
+    sum.imbalance += mean > 0.0 ? peak / mean : 1.0;
+    sum.wait_us += wait * 1e6;
+    runs++;
+  } while ((omp_get_wtime() - start) * 1e3 < min_ms || runs < 3);
+
+  omp_set_schedule(saved_kind, saved_chunk);
+  sum.ms /= runs;
+  sum.imbalance /= runs;
+  sum.wait_us /= runs;
+  return sum;
+}
+
+// EPCC syncbench style: microseconds per `omp barrier` and per empty
+// `omp parallel` on threads threads
+inline void sched_sync_cost(int threads, double* barrier_us, double* region_us) {
+  constexpr int kReps = 2000;
+#pragma omp parallel num_threads(threads)
+  {
+#pragma omp barrier
+  }
+  double t0 = omp_get_wtime();
+#pragma omp parallel num_threads(threads)
+  {
+    for (int r = 0; r < kReps; r++) {
+#pragma omp barrier
+    }
+  }
+  *barrier_us = (omp_get_wtime() - t0) * 1e6 / kReps;
+  t0 = omp_get_wtime();
+  for (int r = 0; r < kReps; r++) {
+#pragma omp parallel num_threads(threads)
+    {
+    }
+  }
+  *region_us = (omp_get_wtime() - t0) * 1e6 / kReps;
+}
+
+inline const char* sched_kind_name(omp_sched_t kind) {
+  switch (kind & ~omp_sched_monotonic) {
+    case omp_sched_static:
+      return "static";
+    case omp_sched_dynamic:
+      return "dynamic";
+    case omp_sched_guided:
+      return "guided";
+    default:
+      return "auto";
+  }
+}
+
+// refinement of point i: iterations until convergence, clustered like
+// occlusion boundaries in optical flow
+inline int sched_skew_iters(int i) {
+  const uint32_t h = (uint32_t)i * 2654435761u;
+  return i % 2000 < 120 ? 300 : 3 + (int)(h >> 30);
+}
+
+inline float sched_refine(int i) {
+  float x = (float)(i & 1023);
+  for (int it = sched_skew_iters(i); it > 0; it--) x = x * 0.999f + std::sqrt(x + 1.0f);
+  return x;
+}
+
+// one kernel of the sweep: n loop iterations, body(i) does one of them and
+// work is what a run moves, in the unit rate_unit is per second
+struct SchedKernel {
+  const char* name;
+  const char* rate_unit;
+  double work;
+  int n;
+  std::function<void(int)> body;
+};
+
+struct SchedBest {
+  double rate = 0.0;
+  std::string setting;
+};
+
+// Sweeps every kernel on the binding this process was started with and
+// prints one line per (kernel, threads, kind, chunk).
+inline void sched_sweep(std::vector<SchedKernel>& kernels, double min_ms) {
+  const char* bind = std::getenv("OMP_PROC_BIND");
+  const char* places = std::getenv("OMP_PLACES");
+  const int max_threads = omp_get_max_threads();
+  std::vector<int> counts;
+  for (int t = 1; t < max_threads; t *= 2) counts.push_back(t);
+  counts.push_back(max_threads);
+
+  printf("\n== OMP_PROC_BIND=%s OMP_PLACES=%s, %d places, %d threads\n", bind ? bind : "(unset)",
+         places ? places : "(unset)", omp_get_num_places(), max_threads);
+  printf("%8s %12s %12s\n", "threads", "barrier us", "region us");
+  for (int t : counts) {
+    double barrier = 0.0, region = 0.0;
+    sched_sync_cost(t, &barrier, &region);
+    printf("%8d %12.2f %12.2f\n", t, barrier, region);
+  }
+
+  const omp_sched_t kinds[] = {omp_sched_static, omp_sched_dynamic, omp_sched_guided, omp_sched_auto};
+  const int chunks[] = {0, 1, 8, 64};
+  for (SchedKernel& k : kernels) {
+    // first touch of the outputs happens here, not in the first measurement
+    sched_run(k.n, max_threads, omp_sched_static, 0, 0.0, k.body);
+    SchedBest best;
+    printf("\n%-10s %7s %-8s %5s %10s %6s %10s\n", k.name, "threads", "kind", "chunk", k.rate_unit, "imb", "wait us");
+    for (int t : counts) {
+      for (omp_sched_t kind : kinds) {
+        for (int chunk : chunks) {
+          if (kind == omp_sched_auto && chunk != 0) continue;
+          LoopStats s = sched_run(k.n, t, kind, chunk, min_ms, k.body);
+          const double rate = k.work / (s.ms * 1e-3);
+          printf("%-10s %7d %-8s %5d %10.2f %6.2f %10.1f\n", "", t, sched_kind_name(kind), chunk, rate, s.imbalance,
+                 s.wait_us);
+          if (t == max_threads && rate > best.rate) {
+            best.rate = rate;
+            best.setting = std::string(sched_kind_name(kind)) + "," + std::to_string(chunk);
+          }
+        }
+      }
+    }
+    printf("best %s at %d threads: OMP_SCHEDULE=%s, %.2f %s\n", k.name, max_threads, best.setting.c_str(), best.rate,
+           k.rate_unit);
+  }
+}
+
+// first line of a child's output, so the parent knows main() handed over to
+// ompSchedChild and did not start its other demos
+constexpr const char* kSchedChildHello = "xr-omp-sched-child";
+
+// Starts this executable once per binding policy, with XR_OMP_SCHED_CHILD set
+// and OMP_PROC_BIND / OMP_PLACES replaced in a copy of the environment, and
+// relays its output. Returns false when that is not possible here, including
+// when the child does not run ompSchedChild.
+inline bool sched_sweep_bindings() {
+#ifdef __linux__
+  char exe[4096];
+  const ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+  if (len <= 0) return false;
+  exe[len] = 0;
+  const char* const bindings[][2] = {
+      {"false", nullptr},   {"close", "cores"},   {"spread", "cores"},
+      {"close", "threads"}, {"spread", "sockets"}, {"primary", "cores"},
+  };
+  for (const auto& b : bindings) {
+    std::vector<std::string> env_strings;
+    for (char** e = environ; *e; e++) {
+      if (std::strncmp(*e, "OMP_PROC_BIND=", 14) && std::strncmp(*e, "OMP_PLACES=", 11) &&
+          std::strncmp(*e, "XR_OMP_SCHED_CHILD=", 19)) {
+        env_strings.push_back(*e);
+      }
+    }
+    env_strings.push_back("XR_OMP_SCHED_CHILD=1");
+    env_strings.push_back("OMP_PROC_BIND=" + std::string(b[0]));
+    if (b[1]) env_strings.push_back("OMP_PLACES=" + std::string(b[1]));
+    std::vector<char*> envp;
+    for (std::string& e : env_strings) envp.push_back(&e[0]);
+    envp.push_back(nullptr);
+    char* argv[] = {exe, nullptr};
+
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+    pid_t pid;
+    std::fflush(stdout);
+    const int rc = posix_spawn(&pid, exe, &actions, nullptr, argv, envp.data());
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (rc != 0) {
+      close(fds[0]);
+      return false;
+    }
+
+    FILE* child = fdopen(fds[0], "r");
+    char line[256];
+    const bool hello = child && std::fgets(line, sizeof(line), child) &&
+                       std::strncmp(line, kSchedChildHello, std::strlen(kSchedChildHello)) == 0;
+    if (hello) {
+      while (std::fgets(line, sizeof(line), child)) std::fputs(line, stdout);
+      std::fflush(stdout);
+    } else {
+      kill(pid, SIGTERM);
+    }
+    if (child) {
+      std::fclose(child);
+    } else {
+      close(fds[0]);
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    if (!hello || !WIFEXITED(status) || WEXITSTATUS(status) != 0) return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Inputs and outputs of the four kernels; kernels() refers to them, so the
+// workload must outlive the returned bodies.
+struct SchedWorkload {
+  // vector_add
+  static constexpr int add_n = 1 << 23, add_block = 4096;
+  std::vector<float> a, b, c;
+  // sgemm, 64 x 128 blocks of C
+  static constexpr int gm = 1024, gn = 1024, gk = 1024, bm = 64, bn = 128;
+  std::vector<float> ga, gb, gc;
+  // box filter on 256 x 64 tiles of a 4K frame
+  static constexpr int w = 3840, h = 2160, tw = 256, th = 64, radius = 3;
+  std::vector<uint8_t> img, box;
+  // skewed loop
+  static constexpr int pts = 20000;
+  std::vector<float> refined;
+
+  SchedWorkload()
+      : a(add_n), b(add_n), c(add_n), ga((size_t)gm * gk), gb((size_t)gk * gn), gc((size_t)gm * gn),
+        img((size_t)w * h), box((size_t)w * h), refined(pts) {
+    for (int i = 0; i < add_n; i++) {
+      a[i] = (float)(i % 1000);
+      b[i] = (float)(i % 77) * 0.5f;
+    }
+    for (size_t i = 0; i < ga.size(); i++) ga[i] = (float)((i * 7) % 13) / 13.0f - 0.5f;
+    for (size_t i = 0; i < gb.size(); i++) gb[i] = (float)((i * 5) % 11) / 11.0f - 0.5f;
+    for (size_t i = 0; i < img.size(); i++) img[i] = (uint8_t)(i * 2654435761u >> 24);
+  }
+  SchedWorkload(const SchedWorkload&) = delete;
+  SchedWorkload& operator=(const SchedWorkload&) = delete;
+
+  std::vector<SchedKernel> kernels() {
+    const int blocks_n = gn / bn;
+    const int tiles_x = (w + tw - 1) / tw, tiles_y = (h + th - 1) / th;
+    return {
+        {"vector_add", "GB/s", 3.0 * sizeof(float) * add_n * 1e-9, add_n / add_block,
+         [this](int blk) {
+           const int i0 = blk * add_block;
+           const float* pa = a.data() + i0;
+           const float* pb = b.data() + i0;
+           float* pc = c.data() + i0;
+#pragma omp simd
+           for (int i = 0; i < add_block; i++) pc[i] = pa[i] + pb[i];
+         }},
+        {"sgemm", "GFLOP/s", 2.0 * gm * gn * gk * 1e-9, (gm / bm) * blocks_n,
+         [this, blocks_n](int blk) {
+           const int i0 = blk / blocks_n * bm, j0 = blk % blocks_n * bn;
+           xr::gemm::sgemm(false, false, bm, bn, gk, 1.0f, ga.data() + (size_t)i0 * gk, gk, gb.data() + j0, gn,
+                           0.0f, gc.data() + (size_t)i0 * gn + j0, gn, 1);
+         }},
+        {"box r=3", "Mpix/s", (double)w * h * 1e-6, tiles_x * tiles_y,
+         [this, tiles_x](int t) {
+           const int x0 = t % tiles_x * tw, y0 = t / tiles_x * th;
+           box_filter_tile(img.data(), w, box.data(), w, w, h, radius, x0, y0, std::min(w, x0 + tw),
+                           std::min(h, y0 + th));
+         }},
+        {"skewed", "Mpts/s", pts * 1e-6, pts, [this](int i) { refined[i] = sched_refine(i); }},
+    };
+  }
+};
+
+}  // namespace omp
+}  // namespace xr
+
+// Entry point of the per-binding runs started by ompSchedMain: sweeps the
+// binding given in the environment and nothing else.
+inline int ompSchedChild() {
+  using namespace xr::omp;
+  printf("%s\n", kSchedChildHello);
+  std::fflush(stdout);
+  SchedWorkload wl;
+  std::vector<SchedKernel> kernels = wl.kernels();
+  sched_sweep(kernels, 50.0);
+  return 0;
+}
+
+inline int ompSchedMain() {
+  using namespace xr::omp;
+  // a main() that runs this demo first needs no dispatch of its own
+  if (std::getenv("XR_OMP_SCHED_CHILD")) return ompSchedChild();
+
+  SchedWorkload wl;
+  std::vector<SchedKernel> kernels = wl.kernels();
+  const int gm = SchedWorkload::gm, gn = SchedWorkload::gn, gk = SchedWorkload::gk;
+  const int w = SchedWorkload::w, h = SchedWorkload::h, radius = SchedWorkload::radius;
+  const int add_n = SchedWorkload::add_n, pts = SchedWorkload::pts;
+  const std::vector<float>& a = wl.a;
+  const std::vector<float>& b = wl.b;
+  std::vector<float>& c = wl.c;
+  std::vector<float>& gc = wl.gc;
+  std::vector<float>& refined = wl.refined;
+  std::vector<uint8_t>& box = wl.box;
+  std::vector<float> gref((size_t)gm * gn);
+  std::vector<uint8_t> box_ref((size_t)w * h);
+
+  // every schedule must give the serial result
+  xr::gemm::sgemm(gm, gn, gk, wl.ga.data(), wl.gb.data(), gref.data(), 1);
+  OmpConfig serial;
+  serial.threads = 1;
+  box_filter(wl.img.data(), w, box_ref.data(), w, w, h, radius, serial);
+  bool pass = true;
+  for (omp_sched_t kind : {omp_sched_static, omp_sched_dynamic, omp_sched_guided, omp_sched_auto}) {
+    std::fill(c.begin(), c.end(), 0.0f);
+    std::fill(gc.begin(), gc.end(), 0.0f);
+    std::fill(box.begin(), box.end(), 0);
+    std::fill(refined.begin(), refined.end(), 0.0f);
+    for (SchedKernel& k : kernels) sched_run(k.n, omp_get_max_threads(), kind, 3, 0.0, k.body);
+    bool ok = box == box_ref;
+    for (int i = 0; i < add_n; i++) ok &= c[i] == a[i] + b[i];
+    for (size_t i = 0; i < gc.size(); i++) ok &= std::fabs(gc[i] - gref[i]) <= 1e-4f * (1.0f + std::fabs(gref[i]));
+    for (int i = 0; i < pts; i++) ok &= refined[i] == sched_refine(i);
+    pass &= ok;
+    printf("%-8s %s\n", sched_kind_name(kind), ok ? "ok" : "FAILED");
+  }
+
+  if (!sched_sweep_bindings()) {
+    printf("\ncannot re-run per binding here, measuring the current one only\n");
+    sched_sweep(kernels, 50.0);
+  }
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
@@ -0,0 +1,500 @@
+#pragma once
+
+// OpenMP backend for the image operations of this repository: box filter,
+// perspective / affine warp, Gaussian pyramid and conversions, in plain C++
+// with no intrinsics.
+//
+//   - the output is cut into 2D tiles (OmpConfig::tile_width x tile_height)
+//     so the source rows a tile reads stay in L1/L2 while it is processed
+//   - tiles go through one schedule(runtime) loop; OmpConfig picks static,
+//     dynamic or guided and the chunk size per call
+//   - inner loops over x are `omp simd`, written without calls or
+//     data-dependent branches so the compiler can vectorize them
+//   - OmpImage buffers are first touched by the same static tiling, so on a
+//     NUMA machine every page is placed on the node of the thread that later
+//     works on it. That only holds for static scheduling; dynamic and guided
+//     move tiles between threads and keep locality only approximately.
+//
+// Results are bit-exact with the references (box_filter_ref in
+// simd/boxFilter, xr::color::to_gray, pyr_down_ref below); warps match
+// warp_perspective_ref up to floating-point contraction, i.e. within 1.
+// Every step argument is in bytes. Without -fopenmp everything runs on one
+// thread. Functions return false for arguments they do not support.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace xr {
+namespace omp {
+
+enum class Schedule { kStatic, kDynamic, kGuided };
+
+struct OmpConfig {
+  int threads = 0;  // <= 0 uses every OpenMP thread
+  Schedule schedule = Schedule::kStatic;
+  int chunk = 0;  // tiles per grab, 0 for the runtime default
+  int tile_width = 256;
+  int tile_height = 64;
+};
+
+inline int omp_threads(int threads) {
+#ifdef _OPENMP
+  return threads <= 0 ? omp_get_max_threads() : threads;
+#else
+  (void)threads;
+  return 1;
+#endif
+}
+
+inline const char* schedule_name(Schedule s) {
+  return s == Schedule::kStatic ? "static" : s == Schedule::kDynamic ? "dynamic" : "guided";
+}
+
+// fn(x0, y0, x1, y1) for every tile of a width x height grid. Tiles are
+// numbered row-major, so static scheduling gives each thread a contiguous
+// band of tile rows. The caller's run-sched-var is restored afterwards.
+template <typename F>
+inline void for_each_tile(int width, int height, const OmpConfig& cfg, F&& fn) {
+  const int tw = std::max(1, cfg.tile_width), th = std::max(1, cfg.tile_height);
+  const int tiles_x = (width + tw - 1) / tw, tiles_y = (height + th - 1) / th;
+  const int tiles = tiles_x * tiles_y;
+#ifdef _OPENMP
+  omp_sched_t saved_kind;
+  int saved_chunk;
+  omp_get_schedule(&saved_kind, &saved_chunk);
+  const omp_sched_t kind = cfg.schedule == Schedule::kDynamic  ? omp_sched_dynamic
+                           : cfg.schedule == Schedule::kGuided ? omp_sched_guided
+                                                               : omp_sched_static;
+  omp_set_schedule(kind, cfg.chunk);
+#endif
+#pragma omp parallel for schedule(runtime) num_threads(omp_threads(cfg.threads)) if (tiles > 1)
+  for (int t = 0; t < tiles; t++) {
+    const int x0 = t % tiles_x * tw, y0 = t / tiles_x * th;
+    fn(x0, y0, std::min(width, x0 + tw), std::min(height, y0 + th));
+  }
+#ifdef _OPENMP
+  omp_set_schedule(saved_kind, saved_chunk);
+#endif
+}
+
+// Per-thread scratch of at least n elements, reused across tiles and calls.
+template <typename T>
+inline T* tile_scratch(size_t n) {
+  static thread_local std::vector<T> buf;
+  if (buf.size() < n) buf.resize(n);
+  return buf.data();
+}
+
+// Row-padded width x height image of T with channels interleaved values per
+// pixel. Rows start on 64-byte boundaries. The constructor does not write the
+// memory itself: the zero fill runs through for_each_tile with the given
+// tiling and static scheduling, which is what places the pages on NUMA nodes.
+template <typename T>
+class OmpImage {
+ public:
+  OmpImage() = default;
+  OmpImage(int width, int height, int channels, const OmpConfig& cfg = OmpConfig()) {
+    if (width <= 0 || height <= 0 || channels <= 0) return;
+    width_ = width;
+    height_ = height;
+    channels_ = channels;
+    step_ = ((size_t)width * channels * sizeof(T) + 63) / 64 * 64;
+#if defined(_MSC_VER)
+    data_ = (uint8_t*)_aligned_malloc(step_ * height, 64);
+#else
+    void* p = nullptr;
+    data_ = posix_memalign(&p, 64, step_ * height) == 0 ? (uint8_t*)p : nullptr;
+#endif
+    if (!data_) {
+      width_ = height_ = 0;
+      return;
+    }
+    OmpConfig touch = cfg;
+    touch.schedule = Schedule::kStatic;
+    touch.chunk = 0;
+    const size_t px = (size_t)channels * sizeof(T);
+    for_each_tile(width, height, touch, [&](int x0, int y0, int x1, int y1) {
+      // the tile ending the row also owns the padding
+      const size_t end = x1 == width ? step_ : x1 * px;
+      for (int y = y0; y < y1; y++) std::memset(data_ + y * step_ + x0 * px, 0, end - x0 * px);
+    });
+  }
+  ~OmpImage() { release(); }
+  OmpImage(const OmpImage&) = delete;
+  OmpImage& operator=(const OmpImage&) = delete;
+  OmpImage(OmpImage&& o) noexcept { *this = std::move(o); }
+  OmpImage& operator=(OmpImage&& o) noexcept {
+    if (this != &o) {
+      release();
+      data_ = std::exchange(o.data_, nullptr);
+      width_ = std::exchange(o.width_, 0);
+      height_ = std::exchange(o.height_, 0);
+      channels_ = o.channels_;
+      step_ = std::exchange(o.step_, 0);
+    }
+    return *this;
+  }
+
+  T* data() { return (T*)data_; }
+  const T* data() const { return (const T*)data_; }
+  T* row(int y) { return (T*)(data_ + y * step_); }
+  const T* row(int y) const { return (const T*)(data_ + y * step_); }
+  int width() const { return width_; }
+  int height() const { return height_; }
+  int channels() const { return channels_; }
+  int step() const { return (int)step_; }  // bytes
+  bool empty() const { return data_ == nullptr; }
+
+ private:
+  void release() {
+#if defined(_MSC_VER)
+    _aligned_free(data_);
+#else
+    free(data_);
+#endif
+    data_ = nullptr;
+  }
+
+  uint8_t* data_ = nullptr;
+  int width_ = 0, height_ = 0, channels_ = 1;
+  size_t step_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Box filter
+
+constexpr int kMaxBoxRadius = 127;
+// up to this window width the horizontal sum uses shifted vector adds
+constexpr int kMaxShiftedTaps = 15;
+
+// Mean of the (2r+1)^2 window with clamped borders and floor division, the
+// same result as box_filter_3x3 / box_filter_nxn in openCL/boxFilter.
+//
+// Per tile: colsum holds the vertical window sum of every column the tile
+// needs, r extra on each side; clamped columns are replicated into that
+// margin. It slides down one row at a time, and each output row sums 2r + 1
+// neighbouring entries of colsum.
+inline void box_filter_tile(const uint8_t* src, int src_step, uint8_t* dst, int dst_step, int width, int height,
+                            int radius, int x0, int y0, int x1, int y1) {
+  const int area = (2 * radius + 1) * (2 * radius + 1), taps = 2 * radius + 1;
+  const float inv_area = 1.0f / (float)area;
+  const int n = x1 - x0, len = n + 2 * radius;
+  int32_t* colsum = tile_scratch<int32_t>((size_t)len + n);
+  int32_t* sums = colsum + len;
+  // colsum[e] is column c0 + e; [e0, e1) are the columns inside the image
+  const int c0 = x0 - radius;
+  const int e0 = std::max(0, -c0), e1 = std::min(len, width - c0);
+  auto src_row = [=](int y) { return src + (ptrdiff_t)std::min(std::max(y, 0), height - 1) * src_step + c0; };
+
+  std::fill(colsum + e0, colsum + e1, 0);
+  for (int dy = -radius; dy <= radius; dy++) {
+    const uint8_t* s = src_row(y0 + dy);
+#pragma omp simd
+    for (int e = e0; e < e1; e++) colsum[e] += s[e];
+  }
+  for (int y = y0; y < y1; y++) {
+    if (y > y0) {
+      const uint8_t* add_row = src_row(y + radius);
+      const uint8_t* sub_row = src_row(y - radius - 1);
+#pragma omp simd
+      for (int e = e0; e < e1; e++) colsum[e] += add_row[e] - sub_row[e];
+    }
+    for (int e = 0; e < e0; e++) colsum[e] = colsum[e0];
+    for (int e = e1; e < len; e++) colsum[e] = colsum[e1 - 1];
+
+    // window sums along the row: shifted adds vectorize for small radii, a
+    // serial prefix sum does not depend on the radius at all
+    if (taps <= kMaxShiftedTaps) {
+#pragma omp simd
+      for (int i = 0; i < n; i++) sums[i] = colsum[i];
+      for (int d = 1; d < taps; d++) {
+#pragma omp simd
+        for (int i = 0; i < n; i++) sums[i] += colsum[i + d];
+      }
+    } else {
+      int32_t acc = 0;
+      for (int e = 0; e < taps - 1; e++) acc += colsum[e];
+      for (int i = 0; i < n; i++) {
+        acc += colsum[i + taps - 1];
+        sums[i] = acc;
+        acc -= colsum[i];
+      }
+    }
+
+    uint8_t* out = dst + (ptrdiff_t)y * dst_step + x0;
+#pragma omp simd
+    for (int i = 0; i < n; i++) {
+      const int32_t sum = sums[i];
+      // sum < 2^24 is exact in float; the estimate is off by at most one
+      int32_t q = (int32_t)((float)sum * inv_area);
+      q -= q * area > sum;
+      q += (q + 1) * area <= sum;
+      out[i] = (uint8_t)q;
+    }
+  }
+}
+
+inline bool box_filter(const uint8_t* src, int src_step, uint8_t* dst, int dst_step, int width, int height,
+                       int radius, const OmpConfig& cfg = OmpConfig()) {
+  if (radius < 0 || radius > kMaxBoxRadius || width <= 0 || height <= 0) return false;
+  for_each_tile(width, height, cfg, [=](int x0, int y0, int x1, int y1) {
+    box_filter_tile(src, src_step, dst, dst_step, width, height, radius, x0, y0, x1, y1);
+  });
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Warp
+
+constexpr float kInf = std::numeric_limits<float>::infinity();
+
+// Bilinear sample of the source at the point m maps (x, y) to, written as
+// the plain loop the tiled version must reproduce. m is row-major 3x3 from
+// destination pixel coordinates to source pixel coordinates; samples outside
+// the source read as border.
+inline void warp_perspective_ref(const uint8_t* src, int src_step, int src_w, int src_h, uint8_t* dst, int dst_step,
+                                 int dst_w, int dst_h, const float m[9], uint8_t border) {
+  for (int y = 0; y < dst_h; y++) {
+    for (int x = 0; x < dst_w; x++) {
+      const float w = m[6] * x + m[7] * y + m[8];
+      const float iw = 1.0f / (w != 0.0f ? w : kInf);
+      const float sx = std::min(std::max((m[0] * x + m[1] * y + m[2]) * iw, -2.0f), (float)src_w + 1.0f);
+      const float sy = std::min(std::max((m[3] * x + m[4] * y + m[5]) * iw, -2.0f), (float)src_h + 1.0f);
+      const int ix = (int)std::floor(sx), iy = (int)std::floor(sy);
+      const float fx = sx - ix, fy = sy - iy;
+      float p[4];
+      for (int k = 0; k < 4; k++) {
+        const int xx = ix + (k & 1), yy = iy + (k >> 1);
+        const bool inside = xx >= 0 && xx < src_w && yy >= 0 && yy < src_h;
+        p[k] = inside ? src[(ptrdiff_t)yy * src_step + xx] : border;
+      }
+      const float v = (1.0f - fy) * ((1.0f - fx) * p[0] + fx * p[1]) + fy * ((1.0f - fx) * p[2] + fx * p[3]);
+      dst[(ptrdiff_t)y * dst_step + x] = (uint8_t)(v + 0.5f);
+    }
+  }
+}
+
+// Two passes per row, like a remap: the coordinate math runs as one `omp
+// simd` loop with no memory access but the stores of its results, then a
+// second loop does the four loads and the blend. Fused, the loop has
+// data-dependent byte gathers that compilers refuse to vectorize, and the
+// arithmetic would go scalar along with them.
+inline void warp_perspective_tile(const uint8_t* src, int src_step, int src_w, int src_h, uint8_t* dst,
+                                  int dst_step, const float* m, uint8_t border, int x0, int y0, int x1, int y1) {
+  const int n = x1 - x0;
+  // per pixel: offset of the clamped top-left tap, offsets of the right and
+  // lower taps relative to it, which taps are inside, and the weights
+  int32_t* off = tile_scratch<int32_t>(4 * (size_t)n);
+  int32_t *right = off + n, *down = off + 2 * n, *inside = off + 3 * n;
+  float* fxs = tile_scratch<float>(2 * (size_t)n);
+  float* fys = fxs + n;
+  const float m0 = m[0], m3 = m[3], m6 = m[6];
+  const float max_x = (float)src_w + 1.0f, max_y = (float)src_h + 1.0f;
+  const float b = border;
+  for (int y = y0; y < y1; y++) {
+    const float bx = m[1] * y + m[2] + m0 * x0, by = m[4] * y + m[5] + m3 * x0, bw = m[7] * y + m[8] + m6 * x0;
+#pragma omp simd
+    for (int i = 0; i < n; i++) {
+      const float w = m6 * i + bw;
+      const float iw = 1.0f / (w != 0.0f ? w : kInf);  // unconditional divide, 0 at infinity
+      // clamping keeps far-away points in int range; they read border anyway
+      const float sx = std::min(std::max((m0 * i + bx) * iw, -2.0f), max_x);
+      const float sy = std::min(std::max((m3 * i + by) * iw, -2.0f), max_y);
+      // floor without a libm call
+      int ix = (int)sx, iy = (int)sy;
+      ix -= sx < (float)ix;
+      iy -= sy < (float)iy;
+      fxs[i] = sx - ix;
+      fys[i] = sy - iy;
+      const int cx0 = std::min(std::max(ix, 0), src_w - 1), cx1 = std::min(std::max(ix + 1, 0), src_w - 1);
+      const int cy0 = std::min(std::max(iy, 0), src_h - 1), cy1 = std::min(std::max(iy + 1, 0), src_h - 1);
+      off[i] = cy0 * src_step + cx0;
+      right[i] = cx1 - cx0;
+      down[i] = (cy1 - cy0) * src_step;
+      inside[i] = (ix >= 0 && ix < src_w) | (ix + 1 >= 0 && ix + 1 < src_w) << 1 | (iy >= 0 && iy < src_h) << 2 |
+                  (iy + 1 >= 0 && iy + 1 < src_h) << 3;
+    }
+    uint8_t* out = dst + (ptrdiff_t)y * dst_step + x0;
+    for (int i = 0; i < n; i++) {
+      const uint8_t* p = src + off[i];
+      const int in = inside[i];
+      float p00 = p[0], p01 = p[right[i]], p10 = p[down[i]], p11 = p[down[i] + right[i]];
+      if (in != 15) {
+        // clamped taps stand in for samples outside the source
+        p00 = (in & 5) == 5 ? p00 : b;
+        p01 = (in & 6) == 6 ? p01 : b;
+        p10 = (in & 9) == 9 ? p10 : b;
+        p11 = (in & 10) == 10 ? p11 : b;
+      }
+      const float fx = fxs[i], fy = fys[i];
+      const float v = (1.0f - fy) * ((1.0f - fx) * p00 + fx * p01) + fy * ((1.0f - fx) * p10 + fx * p11);
+      out[i] = (uint8_t)(v + 0.5f);
+    }
+  }
+}
+
+// Tiled version of warp_perspective_ref. 2D tiles matter here: a rotated
+// output row walks diagonally through the source, and a square-ish tile keeps
+// the source rows it touches in cache.
+inline bool warp_perspective(const uint8_t* src, int src_step, int src_w, int src_h, uint8_t* dst, int dst_step,
+                             int dst_w, int dst_h, const float m[9], uint8_t border,
+                             const OmpConfig& cfg = OmpConfig()) {
+  if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) return false;
+  for_each_tile(dst_w, dst_h, cfg, [=](int x0, int y0, int x1, int y1) {
+    warp_perspective_tile(src, src_step, src_w, src_h, dst, dst_step, m, border, x0, y0, x1, y1);
+  });
+  return true;
+}
+
+// m is the 2x3 affine matrix from destination to source coordinates.
+inline bool warp_affine(const uint8_t* src, int src_step, int src_w, int src_h, uint8_t* dst, int dst_step,
+                        int dst_w, int dst_h, const float m[6], uint8_t border, const OmpConfig& cfg = OmpConfig()) {
+  const float full[9] = {m[0], m[1], m[2], m[3], m[4], m[5], 0.0f, 0.0f, 1.0f};
+  return warp_perspective(src, src_step, src_w, src_h, dst, dst_step, dst_w, dst_h, full, border, cfg);
+}
+
+// ---------------------------------------------------------------------------
+// Gaussian pyramid
+
+// reflect-101 border: -1 -> 1, n -> n - 2
+inline int reflect101(int p, int n) {
+  if (n == 1) return 0;
+  while (p < 0 || p >= n) p = p < 0 ? -p : 2 * n - 2 - p;
+  return p;
+}
+
+// 5x5 Gaussian [1 4 6 4 1]^T [1 4 6 4 1] / 256 at every second pixel, rounded
+// to nearest; output is (w + 1) / 2 x (h + 1) / 2 (OpenCV pyrDown).
+inline void pyr_down_ref(const uint8_t* src, int src_step, int width, int height, uint8_t* dst, int dst_step) {
+  static const int k[5] = {1, 4, 6, 4, 1};
+  for (int y = 0; y < (height + 1) / 2; y++) {
+    for (int x = 0; x < (width + 1) / 2; x++) {
+      int sum = 0;
+      for (int i = 0; i < 5; i++) {
+        const uint8_t* row = src + (ptrdiff_t)reflect101(2 * y + i - 2, height) * src_step;
+        for (int j = 0; j < 5; j++) sum += k[i] * k[j] * row[reflect101(2 * x + j - 2, width)];
+      }
+      dst[(ptrdiff_t)y * dst_step + x] = (uint8_t)((sum + 128) >> 8);
+    }
+  }
+}
+
+inline void pyr_down_tile(const uint8_t* src, int src_step, int width, int height, uint8_t* dst, int dst_step,
+                          int x0, int y0, int x1, int y1) {
+  const int len = 2 * (x1 - x0) + 3;
+  int32_t* colsum = tile_scratch<int32_t>(len);
+  // colsum[e] is source column c0 + e
+  const int c0 = 2 * x0 - 2;
+  const int e0 = std::max(0, -c0), e1 = std::min(len, width - c0);
+  for (int y = y0; y < y1; y++) {
+    const uint8_t* r[5];
+    for (int i = 0; i < 5; i++) r[i] = src + (ptrdiff_t)reflect101(2 * y + i - 2, height) * src_step + c0;
+    const uint8_t *r0 = r[0], *r1 = r[1], *r2 = r[2], *r3 = r[3], *r4 = r[4];
+#pragma omp simd
+    for (int e = e0; e < e1; e++) colsum[e] = r0[e] + 4 * (r1[e] + r3[e]) + 6 * r2[e] + r4[e];
+    for (int e = 0; e < e0; e++) colsum[e] = colsum[reflect101(c0 + e, width) - c0];
+    for (int e = e1; e < len; e++) colsum[e] = colsum[reflect101(c0 + e, width) - c0];
+
+    uint8_t* out = dst + (ptrdiff_t)y * dst_step + x0;
+#pragma omp simd
+    for (int i = 0; i < x1 - x0; i++) {
+      const int32_t* c = colsum + 2 * i;
+      out[i] = (uint8_t)((c[0] + 4 * (c[1] + c[3]) + 6 * c[2] + c[4] + 128) >> 8);
+    }
+  }
+}
+
+// Tiled over the output: per row, the five source rows are summed vertically
+// into colsum (every column the tile needs plus two of margin, reflected at
+// the image edge), then the horizontal taps read colsum at stride 2.
+inline bool pyr_down(const uint8_t* src, int src_step, int width, int height, uint8_t* dst, int dst_step,
+                     const OmpConfig& cfg = OmpConfig()) {
+  if (width <= 0 || height <= 0) return false;
+  for_each_tile((width + 1) / 2, (height + 1) / 2, cfg, [=](int x0, int y0, int x1, int y1) {
+    pyr_down_tile(src, src_step, width, height, dst, dst_step, x0, y0, x1, y1);
+  });
+  return true;
+}
+
+// Level 0 is a copy of src, level i + 1 is pyr_down of level i. Stops early
+// once a level is 1 x 1. Every level is first-touched with cfg's tiling.
+inline std::vector<OmpImage<uint8_t>> build_pyramid(const uint8_t* src, int src_step, int width, int height,
+                                                    int levels, const OmpConfig& cfg = OmpConfig()) {
+  std::vector<OmpImage<uint8_t>> pyr;
+  if (width <= 0 || height <= 0 || levels <= 0) return pyr;
+  pyr.emplace_back(width, height, 1, cfg);
+  for_each_tile(width, height, cfg, [&](int x0, int y0, int x1, int y1) {
+    for (int y = y0; y < y1; y++) std::memcpy(pyr[0].row(y) + x0, src + (ptrdiff_t)y * src_step + x0, x1 - x0);
+  });
+  while ((int)pyr.size() < levels && (pyr.back().width() > 1 || pyr.back().height() > 1)) {
+    const OmpImage<uint8_t>& prev = pyr.back();
+    OmpImage<uint8_t> next((prev.width() + 1) / 2, (prev.height() + 1) / 2, 1, cfg);
+    pyr_down(prev.data(), prev.step(), prev.width(), prev.height(), next.data(), next.step(), cfg);
+    pyr.push_back(std::move(next));
+  }
+  return pyr;
+}
+
+// ---------------------------------------------------------------------------
+// Conversions
+
+enum class ColorOrder { kRGB, kBGR, kRGBA, kBGRA };
+
+// channels as a template argument turns the loads into fixed-stride ones the
+// compiler can deinterleave
+template <int C>
+inline void gray_tile(const uint8_t* src, int src_step, int r_index, uint8_t* gray, int gray_step, int x0, int y0,
+                      int x1, int y1) {
+  for (int y = y0; y < y1; y++) {
+    const uint8_t* r = src + (ptrdiff_t)y * src_step + r_index;
+    const uint8_t* g = src + (ptrdiff_t)y * src_step + 1;
+    const uint8_t* b = src + (ptrdiff_t)y * src_step + 2 - r_index;
+    uint8_t* out = gray + (ptrdiff_t)y * gray_step;
+#pragma omp simd
+    for (int x = x0; x < x1; x++) out[x] = (uint8_t)((77 * r[C * x] + 150 * g[C * x] + 29 * b[C * x] + 128) >> 8);
+  }
+}
+
+// (77 R + 150 G + 29 B + 128) >> 8, the same weights as xr::color::to_gray
+inline bool to_gray(const uint8_t* src, int src_step, ColorOrder order, uint8_t* gray, int gray_step, int width,
+                    int height, const OmpConfig& cfg = OmpConfig()) {
+  if (width <= 0 || height <= 0) return false;
+  const bool four = order == ColorOrder::kRGBA || order == ColorOrder::kBGRA;
+  const int ri = order == ColorOrder::kRGB || order == ColorOrder::kRGBA ? 0 : 2;
+  for_each_tile(width, height, cfg, [=](int x0, int y0, int x1, int y1) {
+    if (four) {
+      gray_tile<4>(src, src_step, ri, gray, gray_step, x0, y0, x1, y1);
+    } else {
+      gray_tile<3>(src, src_step, ri, gray, gray_step, x0, y0, x1, y1);
+    }
+  });
+  return true;
+}
+
+// dst = src * scale + offset, u8 -> f32 per channel value (network input)
+inline bool convert_u8_f32(const uint8_t* src, int src_step, float* dst, int dst_step, int width, int height,
+                           int channels, float scale, float offset, const OmpConfig& cfg = OmpConfig()) {
+  if (width <= 0 || height <= 0 || channels <= 0) return false;
+  for_each_tile(width, height, cfg, [=](int x0, int y0, int x1, int y1) {
+    for (int y = y0; y < y1; y++) {
+      const uint8_t* s = src + (ptrdiff_t)y * src_step;
+      float* out = (float*)((uint8_t*)dst + (ptrdiff_t)y * dst_step);
+#pragma omp simd
+      for (int i = x0 * channels; i < x1 * channels; i++) out[i] = (float)s[i] * scale + offset;
+    }
+  });
+  return true;
+}
+
+}  // namespace omp
+}  // namespace xr
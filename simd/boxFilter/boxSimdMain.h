@@ -0,0 +1,168 @@
+#pragma once
+
+// Checks box_filter_simd against the reference on every backend this CPU can
+// run, then times it against box_filter_nxn from openCL/boxFilter/box_filter.cl
+// on the same image. Without an OpenCL device only the CPU side runs.
+//
+// g++ -O2 -fopenmp -std=c++17 main.cpp -framework OpenCL `pkg-config --cflags --libs opencv4`
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <OpenCL/opencl.h>
+#include <opencv2/opencv.hpp>
+
+#include "box_filter_simd.h"
+
+namespace xr {
+namespace box {
+
+// Runs box_filter_nxn on the first default device. Returns false (without
+// exiting, unlike init_opencl) when there is no device or the kernel file is
+// missing; ms receives the average kernel time over iters runs.
+inline bool box_filter_opencl(const char* source_file, const uint8_t* src, uint8_t* dst, int width, int height,
+                              int radius, int iters, double* ms) {
+  FILE* fp = fopen(source_file, "rb");
+  if (!fp) return false;
+  std::string source;
+  char buf[4096];
+  size_t got;
+  while ((got = fread(buf, 1, sizeof(buf), fp)) > 0) source.append(buf, got);
+  fclose(fp);
+
+  cl_platform_id platform;
+  cl_device_id device;
+  if (clGetPlatformIDs(1, &platform, NULL) != CL_SUCCESS) return false;
+  if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_DEFAULT, 1, &device, NULL) != CL_SUCCESS) return false;
+  cl_int err;
+  cl_context context = clCreateContext(NULL, 1, &device, NULL, NULL, &err);
+  if (err != CL_SUCCESS) return false;
+  cl_command_queue queue = clCreateCommandQueue(context, device, 0, &err);
+  if (err != CL_SUCCESS) {
+    clReleaseContext(context);
+    return false;
+  }
+  const char* text = source.c_str();
+  cl_program program = clCreateProgramWithSource(context, 1, &text, NULL, &err);
+  bool ok = clBuildProgram(program, 1, &device, NULL, NULL, NULL) == CL_SUCCESS;
+  cl_kernel kernel = ok ? clCreateKernel(program, "box_filter_nxn", &err) : NULL;
+  ok = ok && err == CL_SUCCESS;
+
+  size_t bytes = (size_t)width * height;
+  cl_mem in = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, (void*)src, &err);
+  cl_mem out = clCreateBuffer(context, CL_MEM_WRITE_ONLY, bytes, NULL, &err);
+  if (ok) {
+    clSetKernelArg(kernel, 0, sizeof(cl_mem), &in);
+    clSetKernelArg(kernel, 1, sizeof(cl_mem), &out);
+    clSetKernelArg(kernel, 2, sizeof(int), &width);
+    clSetKernelArg(kernel, 3, sizeof(int), &height);
+    clSetKernelArg(kernel, 4, sizeof(int), &radius);
+    size_t gsize[2] = {(size_t)width, (size_t)height};
+    // the first launch includes the device-side JIT, so it is not timed
+    ok = clEnqueueNDRangeKernel(queue, kernel, 2, NULL, gsize, NULL, 0, NULL, NULL) == CL_SUCCESS;
+    clFinish(queue);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int it = 0; ok && it < iters; it++) {
+      clEnqueueNDRangeKernel(queue, kernel, 2, NULL, gsize, NULL, 0, NULL, NULL);
+    }
+    clFinish(queue);
+    *ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / iters;
+    ok = ok && clEnqueueReadBuffer(queue, out, CL_TRUE, 0, bytes, dst, 0, NULL, NULL) == CL_SUCCESS;
+  }
+
+  clReleaseMemObject(in);
+  clReleaseMemObject(out);
+  if (kernel) clReleaseKernel(kernel);
+  clReleaseProgram(program);
+  clReleaseCommandQueue(queue);
+  clReleaseContext(context);
+  return ok;
+}
+
+}  // namespace box
+}  // namespace xr
+
+inline int boxSimdMain() {
+  using namespace xr::simd;
+
+  cv::Mat image = cv::imread("../src/opencl/sources/img.png", cv::IMREAD_GRAYSCALE);
+  int width = 1920, height = 1080;
+  std::vector<uint8_t> src;
+  if (!image.empty() && image.isContinuous()) {
+    width = image.cols;
+    height = image.rows;
+    src.assign(image.data, image.data + (size_t)width * height);
+  } else {
+    // no image: a fixed pseudo-random frame of the same size as a 1080p camera
+    printf("Image load failed, using a synthetic %dx%d frame\n", width, height);
+    src.resize((size_t)width * height);
+    uint32_t seed = 12345;
+    for (auto& p : src) {
+      seed = seed * 1664525u + 1013904223u;
+      p = (uint8_t)(seed >> 24);
+    }
+  }
+  const size_t bytes = (size_t)width * height;
+  std::vector<uint8_t> ref(bytes), out(bytes), cl_out(bytes);
+
+  const Isa all[] = {Isa::kScalar, Isa::kSSE42, Isa::kAVX2, Isa::kAVX512, Isa::kNEON};
+  const Isa initial = current_isa();
+  // 1..7 take the 16-bit multiply-shift path, 8 and up the 32-bit one
+  const int radii[] = {1, 2, 7, 8, 20};
+  bool pass = true;
+
+  // odd sizes and images thinner than the window exercise the tails and clamping
+  const int shapes[][2] = {{1, 1}, {3, 50}, {67, 5}, {129, 33}};
+  for (auto& s : shapes) {
+    std::vector<uint8_t> a((size_t)s[0] * s[1]), r(a.size()), o(a.size());
+    for (size_t i = 0; i < a.size(); i++) a[i] = (uint8_t)(i * 37 + (i >> 3));
+    for (int radius : radii) {
+      xr::box::box_filter_ref(a.data(), r.data(), s[0], s[1], radius);
+      for (Isa isa : all) {
+        if (!set_isa(isa)) continue;
+        xr::box::box_filter_simd(a.data(), o.data(), s[0], s[1], radius, 3);
+        if (o != r) {
+          printf("%s %dx%d r=%d mismatch\n", isa_name(isa), s[0], s[1], radius);
+          pass = false;
+        }
+      }
+    }
+  }
+
+  const int iters = 20;
+  for (int radius : radii) {
+    xr::box::box_filter_ref(src.data(), ref.data(), width, height, radius);
+    for (Isa isa : all) {
+      if (!set_isa(isa)) continue;
+      xr::box::box_filter_simd(src.data(), out.data(), width, height, radius);
+      bool ok = out == ref;
+      pass &= ok;
+      auto t0 = std::chrono::steady_clock::now();
+      for (int it = 0; it < iters; it++) {
+        xr::box::box_filter_simd(src.data(), out.data(), width, height, radius);
+      }
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / iters;
+      printf("r=%-2d %-7s %s %8.3f ms  %7.1f MPix/s\n", radius, isa_name(isa), ok ? "ok    " : "FAILED", ms,
+             bytes / (ms * 1e3));
+    }
+    set_isa(initial);
+
+    double cl_ms = 0;
+    if (xr::box::box_filter_opencl("../openCL/boxFilter/box_filter.cl", src.data(), cl_out.data(), width, height,
+                                   radius, iters, &cl_ms)) {
+      bool ok = cl_out == ref;
+      pass &= ok;
+      printf("r=%-2d %-7s %s %8.3f ms  %7.1f MPix/s\n", radius, "opencl", ok ? "ok    " : "FAILED", cl_ms,
+             bytes / (cl_ms * 1e3));
+    } else if (radius == radii[0]) {
+      printf("no OpenCL device, CPU only\n");
+    }
+  }
+  set_isa(initial);
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
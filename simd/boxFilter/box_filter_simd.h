@@ -0,0 +1,126 @@
+#pragma once
+
+// CPU mean filter, bit-exact with box_filter_3x3 in openCL/boxFilter/box_filter.cl
+// (and box_filter_nxn for other radii): clamped borders, integer sum, floor
+// division by (2r+1)^2.
+//
+// Sliding column sums make the cost per pixel independent of the radius in the
+// vertical direction; the divide is replaced by a fixed-point multiply-shift
+// whose constants are verified by brute force over every reachable sum.
+// Rows are split into one band per OpenMP thread (build with -fopenmp).
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../xr_simd.h"
+
+namespace xr {
+namespace box {
+
+#define XR_SIMD_KERNELS "boxFilter/box_filter_simd.inl"
+#include "../xr_simd_foreach.h"
+
+// floor(x / divisor) == ((x * mul) >> 16) >> shift for all 0 <= x <= max_value
+struct DivMagic16 {
+  uint16_t mul = 0;
+  int shift = 0;
+};
+
+// Smallest shift whose rounded-up reciprocal is exact over the whole range,
+// checked against every value rather than trusting the error bound.
+inline bool find_div_magic16(uint32_t divisor, uint32_t max_value, DivMagic16* magic) {
+  if (divisor < 2 || max_value > 0xFFFF) return false;
+  for (int shift = 0; shift < 16; shift++) {
+    uint64_t m = ((1ull << (16 + shift)) + divisor - 1) / divisor;
+    if (m > 0xFFFF) break;
+    bool exact = true;
+    for (uint32_t x = 0; x <= max_value && exact; x++) {
+      exact = ((x * (uint32_t)m) >> (16 + shift)) == x / divisor;
+    }
+    if (exact) {
+      magic->mul = (uint16_t)m;
+      magic->shift = shift;
+      return true;
+    }
+  }
+  return false;
+}
+
+constexpr int kMaxBoxRadius = 127;
+
+// Straight port of the OpenCL kernel, used as the reference.
+inline void box_filter_ref(const uint8_t* src, uint8_t* dst, int width, int height, int radius = 1) {
+  const int area = (2 * radius + 1) * (2 * radius + 1);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      int sum = 0;
+      for (int dy = -radius; dy <= radius; dy++) {
+        int yy = std::min(std::max(y + dy, 0), height - 1);
+        for (int dx = -radius; dx <= radius; dx++) {
+          int xx = std::min(std::max(x + dx, 0), width - 1);
+          sum += src[yy * width + xx];
+        }
+      }
+      dst[y * width + x] = (uint8_t)(sum / area);
+    }
+  }
+}
+
+// threads <= 0 uses every OpenMP thread. Returns false for an unsupported
+// radius (0 < radius <= kMaxBoxRadius is required; radius 0 is a copy).
+inline bool box_filter_simd(const uint8_t* src, uint8_t* dst, int width, int height, int radius = 1,
+                            int threads = 0) {
+  if (radius < 0 || radius > kMaxBoxRadius || width <= 0 || height <= 0) return false;
+  if (radius == 0) {
+    std::memcpy(dst, src, (size_t)width * height);
+    return true;
+  }
+#ifdef _OPENMP
+  if (threads <= 0) threads = omp_get_max_threads();
+#else
+  threads = 1;
+#endif
+  int bands = std::max(1, std::min(threads, height));
+
+  // 16-bit sums cover radius <= 7; the magic numbers for those are found once
+  struct MagicTable {
+    DivMagic16 magic[8];
+    bool valid[8] = {false};
+  };
+  static const MagicTable table = [] {
+    MagicTable t;
+    for (int r = 1; r < 8; r++) {
+      uint32_t area = (uint32_t)(2 * r + 1) * (2 * r + 1);
+      t.valid[r] = area * 255 <= 0xFFFF && find_div_magic16(area, area * 255, &t.magic[r]);
+    }
+    return t;
+  }();
+  const bool use_u16 = radius < 8 && table.valid[radius];
+  const DivMagic16 magic = use_u16 ? table.magic[radius] : DivMagic16();
+
+  auto band_u16 = XR_SIMD_DISPATCH(box_band_u16);
+  auto band_i32 = XR_SIMD_DISPATCH(box_band_i32);
+  const size_t padded = (size_t)width + 2 * radius;
+
+#pragma omp parallel for schedule(static) num_threads(bands)
+  for (int b = 0; b < bands; b++) {
+    int y0 = (int)((int64_t)height * b / bands);
+    int y1 = (int)((int64_t)height * (b + 1) / bands);
+    if (use_u16) {
+      std::vector<uint16_t> colsum(padded);
+      band_u16(src, dst, width, height, radius, y0, y1, magic.mul, magic.shift, colsum.data());
+    } else {
+      std::vector<int32_t> colsum(padded), prefix(padded + 1);
+      band_i32(src, dst, width, height, radius, y0, y1, colsum.data(), prefix.data());
+    }
+  }
+  return true;
+}
+
+}  // namespace box
+}  // namespace xr
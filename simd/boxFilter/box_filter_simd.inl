@@ -0,0 +1,158 @@
+// Box filter kernels, expanded per backend by xr_simd_foreach.h from
+// box_filter_simd.h. Each call filters the output rows [y0, y1) of one band.
+//
+// Vertical pass: colsum[x] holds the sum of the 2r+1 source rows around the
+// current output row and slides down one row at a time (add the row entering
+// the window, subtract the one leaving). Rows outside the image are clamped,
+// exactly like clamp() in box_filter.cl.
+// Horizontal pass: colsum is stored with r replicated entries on each side,
+// which is the same as clamping x, so the row sum needs no edge branches.
+
+// colsum + r (the unpadded part) must already hold the vertical sums; copy the
+// edge columns into the padding
+template <typename T>
+inline void pad_edges(T* colsum, int width, int radius) {
+  for (int k = 0; k < radius; k++) {
+    colsum[k] = colsum[radius];
+    colsum[radius + width + k] = colsum[radius + width - 1];
+  }
+}
+
+// sums never exceed 65535 on this path, so u16 wrap-around cancels out
+inline void slide_rows_u16(uint16_t* sum, const uint8_t* add_row, const uint8_t* sub_row, int width) {
+  int x = 0;
+  for (; x + vu8::N <= width; x += vu8::N) {
+    vu8 a = loadu(add_row + x);
+    vu8 s = loadu(sub_row + x);
+    vu16 lo = loadu(sum + x);
+    vu16 hi = loadu(sum + x + vu16::N);
+    lo = sub(add(lo, widen_lo(a)), widen_lo(s));
+    hi = sub(add(hi, widen_hi(a)), widen_hi(s));
+    storeu(sum + x, lo);
+    storeu(sum + x + vu16::N, hi);
+  }
+  for (; x < width; x++) sum[x] = (uint16_t)(sum[x] + add_row[x] - sub_row[x]);
+}
+
+inline void add_row_u16(uint16_t* sum, const uint8_t* row, int width) {
+  int x = 0;
+  for (; x + vu8::N <= width; x += vu8::N) {
+    vu8 a = loadu(row + x);
+    storeu(sum + x, add(loadu(sum + x), widen_lo(a)));
+    storeu(sum + x + vu16::N, add(loadu(sum + x + vu16::N), widen_hi(a)));
+  }
+  for (; x < width; x++) sum[x] = (uint16_t)(sum[x] + row[x]);
+}
+
+// Window sums fit in 16 bits: (2r+1)^2 * 255 <= 65535, i.e. radius <= 7.
+// floor(sum / (2r+1)^2) == mulhi(sum, mul) >> shift for every possible sum.
+// colsum needs width + 2 * radius entries.
+inline void box_band_u16(const uint8_t* src, uint8_t* dst, int width, int height, int radius, int y0, int y1,
+                         uint16_t mul, int shift, uint16_t* colsum) {
+  uint16_t* sum = colsum + radius;
+  std::memset(sum, 0, sizeof(uint16_t) * width);
+  for (int dy = -radius; dy <= radius; dy++) {
+    int yy = std::min(std::max(y0 + dy, 0), height - 1);
+    add_row_u16(sum, src + (size_t)yy * width, width);
+  }
+
+  const vu16 vmul = set1_u16(mul);
+  const int taps = 2 * radius + 1;
+  for (int y = y0; y < y1; y++) {
+    if (y > y0) {
+      int y_add = std::min(y + radius, height - 1);
+      int y_sub = std::max(y - radius - 1, 0);
+      slide_rows_u16(sum, src + (size_t)y_add * width, src + (size_t)y_sub * width, width);
+    }
+    pad_edges(colsum, width, radius);
+
+    uint8_t* out = dst + (size_t)y * width;
+    int x = 0;
+    for (; x + vu8::N <= width; x += vu8::N) {
+      vu16 lo = loadu(colsum + x);
+      vu16 hi = loadu(colsum + x + vu16::N);
+      for (int k = 1; k < taps; k++) {
+        lo = add(lo, loadu(colsum + x + k));
+        hi = add(hi, loadu(colsum + x + k + vu16::N));
+      }
+      lo = shr(mulhi(lo, vmul), shift);
+      hi = shr(mulhi(hi, vmul), shift);
+      storeu(out + x, narrow_sat_u8(lo, hi));
+    }
+    for (; x < width; x++) {
+      uint32_t s = 0;
+      for (int k = 0; k < taps; k++) s += colsum[x + k];
+      out[x] = (uint8_t)(((s * mul) >> 16) >> shift);
+    }
+  }
+}
+
+inline void slide_rows_i32(int32_t* sum, const uint8_t* add_row, const uint8_t* sub_row, int width) {
+  int x = 0;
+  for (; x + vu8::N <= width; x += vu8::N) {
+    // u8 -> u16 difference in two's complement, then sign-extend to i32
+    vu8 a = loadu(add_row + x);
+    vu8 s = loadu(sub_row + x);
+    vi16 d_lo = as_i16(sub(widen_lo(a), widen_lo(s)));
+    vi16 d_hi = as_i16(sub(widen_hi(a), widen_hi(s)));
+    int32_t* p = sum + x;
+    storeu(p, add(loadu(p), widen_lo(d_lo)));
+    storeu(p + vi32::N, add(loadu(p + vi32::N), widen_hi(d_lo)));
+    storeu(p + 2 * vi32::N, add(loadu(p + 2 * vi32::N), widen_lo(d_hi)));
+    storeu(p + 3 * vi32::N, add(loadu(p + 3 * vi32::N), widen_hi(d_hi)));
+  }
+  for (; x < width; x++) sum[x] += add_row[x] - sub_row[x];
+}
+
+// Any radius with (2r+1)^2 * 255 < 2^24. The horizontal sum uses a prefix sum
+// so the cost does not grow with the radius, and the division is a float
+// reciprocal estimate corrected to the exact floor with one remainder check.
+// colsum needs width + 2 * radius entries, prefix width + 2 * radius + 1.
+inline void box_band_i32(const uint8_t* src, uint8_t* dst, int width, int height, int radius, int y0, int y1,
+                         int32_t* colsum, int32_t* prefix) {
+  int32_t* sum = colsum + radius;
+  std::memset(sum, 0, sizeof(int32_t) * width);
+  for (int dy = -radius; dy <= radius; dy++) {
+    int yy = std::min(std::max(y0 + dy, 0), height - 1);
+    const uint8_t* row = src + (size_t)yy * width;
+    for (int x = 0; x < width; x++) sum[x] += row[x];
+  }
+
+  const int taps = 2 * radius + 1;
+  const int32_t area = taps * taps;
+  const vf32 inv_area = set1_f32(1.0f / (float)area);
+  const vi32 varea = set1_i32(area);
+  const vi32 area_minus1 = set1_i32(area - 1);
+  const vi32 zero = zero_i32();
+  const int padded = width + 2 * radius;
+  for (int y = y0; y < y1; y++) {
+    if (y > y0) {
+      int y_add = std::min(y + radius, height - 1);
+      int y_sub = std::max(y - radius - 1, 0);
+      slide_rows_i32(sum, src + (size_t)y_add * width, src + (size_t)y_sub * width, width);
+    }
+    pad_edges(colsum, width, radius);
+    prefix[0] = 0;
+    for (int i = 0; i < padded; i++) prefix[i + 1] = prefix[i] + colsum[i];
+
+    uint8_t* out = dst + (size_t)y * width;
+    int x = 0;
+    for (; x + vu8::N <= width; x += vu8::N) {
+      vi32 q[4];
+      for (int j = 0; j < 4; j++) {
+        const int32_t* p = prefix + x + j * vi32::N;
+        vi32 s = sub(loadu(p + taps), loadu(p));
+        vi32 e = cvtt_i32(mul(cvt_f32(s), inv_area));
+        vi32 rem = sub(s, mul(e, varea));
+        // masks are -1 where the estimate is one too small / too large
+        e = sub(e, cmpgt(rem, area_minus1));
+        e = add(e, cmplt(rem, zero));
+        q[j] = e;
+      }
+      vu16 lo = narrow_sat_u16(q[0], q[1]);
+      vu16 hi = narrow_sat_u16(q[2], q[3]);
+      storeu(out + x, narrow_sat_u8(lo, hi));
+    }
+    for (; x < width; x++) out[x] = (uint8_t)((prefix[x + taps] - prefix[x]) / area);
+  }
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+// Pixel layout conversions for 8-bit camera frames, so colour input can feed
+// the single-channel kernels (box filter, conv, ...):
+//   - interleaved (AoS) RGB / BGR / RGBA <-> planar (SoA), like NEON vld3 /
+//     vst3; x86 gets the same through load3 / store3 in the SIMD layer
+//   - RGB / BGR / RGBA / BGRA -> gray
+//   - NV12 (NV21) and YUYV -> planar Y, U, V and -> gray
+//
+// Every step argument is in bytes. Rows are split into one band per OpenMP
+// thread (build with -fopenmp); small images stay on one thread. Functions
+// return false for arguments they do not support.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../xr_simd.h"
+
+namespace xr {
+namespace color {
+
+// BT.601 luma weights in 8-bit fixed point, summing to 256
+constexpr int kGrayR = 77;
+constexpr int kGrayG = 150;
+constexpr int kGrayB = 29;
+
+#define XR_SIMD_KERNELS "color/color_kernels.inl"
+#include "../xr_simd_foreach.h"
+
+enum class ColorOrder { kRGB, kBGR, kRGBA, kBGRA };
+
+inline int order_channels(ColorOrder order) { return order == ColorOrder::kRGB || order == ColorOrder::kBGR ? 3 : 4; }
+
+// below this many pixels per thread the fork costs more than the copy
+constexpr int64_t kMinBandPixels = 1 << 16;
+
+// fn(y0, y1) on [0, height) split into bands, one per thread
+template <typename F>
+inline void for_each_band(int width, int height, int threads, F&& fn) {
+#ifdef _OPENMP
+  if (threads <= 0) threads = omp_get_max_threads();
+#else
+  threads = 1;
+#endif
+  int64_t by_size = std::max<int64_t>(1, (int64_t)width * height / kMinBandPixels);
+  int bands = (int)std::max<int64_t>(1, std::min<int64_t>({(int64_t)threads, (int64_t)height, by_size}));
+#pragma omp parallel for schedule(static) num_threads(bands) if (bands > 1)
+  for (int b = 0; b < bands; b++) {
+    int y0 = (int)((int64_t)height * b / bands);
+    int y1 = (int)((int64_t)height * (b + 1) / bands);
+    fn(y0, y1);
+  }
+}
+
+// channels is 3 or 4; planes[3] may be null to drop the fourth channel. The
+// plane order follows the source, so BGR input gives B, G, R planes.
+inline bool deinterleave(const uint8_t* src, int src_step, int channels, uint8_t* const planes[], int plane_step,
+                         int width, int height, int threads = 0) {
+  if ((channels != 3 && channels != 4) || width <= 0 || height <= 0) return false;
+  auto row3 = XR_SIMD_DISPATCH(deinterleave3_row);
+  auto row4 = XR_SIMD_DISPATCH(deinterleave4_row);
+  for_each_band(width, height, threads, [&](int y0, int y1) {
+    for (int y = y0; y < y1; y++) {
+      const uint8_t* s = src + (ptrdiff_t)y * src_step;
+      const ptrdiff_t o = (ptrdiff_t)y * plane_step;
+      if (channels == 3) {
+        row3(s, planes[0] + o, planes[1] + o, planes[2] + o, width);
+      } else {
+        row4(s, planes[0] + o, planes[1] + o, planes[2] + o, planes[3] ? planes[3] + o : nullptr, width);
+      }
+    }
+  });
+  return true;
+}
+
+// inverse of deinterleave; planes[3] may be null for an opaque alpha of 255
+inline bool interleave(const uint8_t* const planes[], int plane_step, int channels, uint8_t* dst, int dst_step,
+                       int width, int height, int threads = 0) {
+  if ((channels != 3 && channels != 4) || width <= 0 || height <= 0) return false;
+  auto row3 = XR_SIMD_DISPATCH(interleave3_row);
+  auto row4 = XR_SIMD_DISPATCH(interleave4_row);
+  for_each_band(width, height, threads, [&](int y0, int y1) {
+    for (int y = y0; y < y1; y++) {
+      uint8_t* d = dst + (ptrdiff_t)y * dst_step;
+      const ptrdiff_t o = (ptrdiff_t)y * plane_step;
+      if (channels == 3) {
+        row3(planes[0] + o, planes[1] + o, planes[2] + o, d, width);
+      } else {
+        row4(planes[0] + o, planes[1] + o, planes[2] + o, planes[3] ? planes[3] + o : nullptr, d, width);
+      }
+    }
+  });
+  return true;
+}
+
+// (77 R + 150 G + 29 B + 128) >> 8; alpha is ignored
+inline bool to_gray(const uint8_t* src, int src_step, ColorOrder order, uint8_t* gray, int gray_step, int width,
+                    int height, int threads = 0) {
+  if (width <= 0 || height <= 0) return false;
+  const int channels = order_channels(order);
+  const int r_index = order == ColorOrder::kRGB || order == ColorOrder::kRGBA ? 0 : 2;
+  auto row = XR_SIMD_DISPATCH(gray_row);
+  for_each_band(width, height, threads, [&](int y0, int y1) {
+    for (int y = y0; y < y1; y++) {
+      row(src + (ptrdiff_t)y * src_step, channels, r_index, gray + (ptrdiff_t)y * gray_step, width);
+    }
+  });
+  return true;
+}
+
+// NV12: full-size Y plane plus a half-size plane of interleaved U V pairs.
+// Output is I420 (U and V planes of width / 2 x height / 2); swap dst_u and
+// dst_v for NV21. width and height must be even.
+inline bool nv12_to_planar(const uint8_t* y, int y_step, const uint8_t* uv, int uv_step, uint8_t* dst_y,
+                           int dst_y_step, uint8_t* dst_u, uint8_t* dst_v, int dst_uv_step, int width, int height,
+                           int threads = 0) {
+  if (width <= 0 || height <= 0 || width % 2 || height % 2) return false;
+  auto row = XR_SIMD_DISPATCH(uv_row);
+  // bands over chroma rows, each taking its two luma rows along
+  for_each_band(width, height / 2, threads, [&](int r0, int r1) {
+    for (int r = r0; r < r1; r++) {
+      for (int k = 2 * r; k < 2 * r + 2; k++) {
+        std::memcpy(dst_y + (ptrdiff_t)k * dst_y_step, y + (ptrdiff_t)k * y_step, width);
+      }
+      const ptrdiff_t o = (ptrdiff_t)r * dst_uv_step;
+      row(uv + (ptrdiff_t)r * uv_step, dst_u + o, dst_v + o, width / 2);
+    }
+  });
+  return true;
+}
+
+// the Y plane already is the gray image; this only drops the row padding
+inline bool nv12_to_gray(const uint8_t* y, int y_step, uint8_t* gray, int gray_step, int width, int height,
+                         int threads = 0) {
+  if (width <= 0 || height <= 0) return false;
+  for_each_band(width, height, threads, [&](int y0, int y1) {
+    for (int r = y0; r < y1; r++) std::memcpy(gray + (ptrdiff_t)r * gray_step, y + (ptrdiff_t)r * y_step, width);
+  });
+  return true;
+}
+
+// YUYV (YUY2) 4:2:2 -> Y plane and width / 2 x height U and V planes. width
+// must be even.
+inline bool yuyv_to_planar(const uint8_t* src, int src_step, uint8_t* dst_y, int dst_y_step, uint8_t* dst_u,
+                           uint8_t* dst_v, int dst_uv_step, int width, int height, int threads = 0) {
+  if (width <= 0 || height <= 0 || width % 2 || !dst_u || !dst_v) return false;
+  auto row = XR_SIMD_DISPATCH(yuyv_row);
+  for_each_band(width, height, threads, [&](int y0, int y1) {
+    for (int r = y0; r < y1; r++) {
+      const ptrdiff_t o = (ptrdiff_t)r * dst_uv_step;
+      row(src + (ptrdiff_t)r * src_step, dst_y + (ptrdiff_t)r * dst_y_step, dst_u + o, dst_v + o, width);
+    }
+  });
+  return true;
+}
+
+inline bool yuyv_to_gray(const uint8_t* src, int src_step, uint8_t* gray, int gray_step, int width, int height,
+                         int threads = 0) {
+  if (width <= 0 || height <= 0 || width % 2) return false;
+  auto row = XR_SIMD_DISPATCH(yuyv_row);
+  for_each_band(width, height, threads, [&](int y0, int y1) {
+    for (int r = y0; r < y1; r++) {
+      row(src + (ptrdiff_t)r * src_step, gray + (ptrdiff_t)r * gray_step, nullptr, nullptr, width);
+    }
+  });
+  return true;
+}
+
+}  // namespace color
+}  // namespace xr
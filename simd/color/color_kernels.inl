@@ -0,0 +1,137 @@
+// Pixel layout kernels, expanded per backend by xr_simd_foreach.h from
+// color.h. Every function converts one row; the scalar tails produce the same
+// bytes as the vector body, so results do not depend on the width or the ISA.
+
+// RGB RGB ... -> R R ..., G G ..., B B ...
+inline void deinterleave3_row(const uint8_t* src, uint8_t* d0, uint8_t* d1, uint8_t* d2, int width) {
+  int x = 0;
+  for (; x + vu8::N <= width; x += vu8::N) {
+    vu8x3 p = load3(src + 3 * x);
+    storeu(d0 + x, p.v[0]);
+    storeu(d1 + x, p.v[1]);
+    storeu(d2 + x, p.v[2]);
+  }
+  for (; x < width; x++) {
+    d0[x] = src[3 * x];
+    d1[x] = src[3 * x + 1];
+    d2[x] = src[3 * x + 2];
+  }
+}
+
+// d3 may be null to drop the fourth channel
+inline void deinterleave4_row(const uint8_t* src, uint8_t* d0, uint8_t* d1, uint8_t* d2, uint8_t* d3, int width) {
+  int x = 0;
+  for (; x + vu8::N <= width; x += vu8::N) {
+    vu8x4 p = load4(src + 4 * x);
+    storeu(d0 + x, p.v[0]);
+    storeu(d1 + x, p.v[1]);
+    storeu(d2 + x, p.v[2]);
+    if (d3) storeu(d3 + x, p.v[3]);
+  }
+  for (; x < width; x++) {
+    d0[x] = src[4 * x];
+    d1[x] = src[4 * x + 1];
+    d2[x] = src[4 * x + 2];
+    if (d3) d3[x] = src[4 * x + 3];
+  }
+}
+
+inline void interleave3_row(const uint8_t* s0, const uint8_t* s1, const uint8_t* s2, uint8_t* dst, int width) {
+  int x = 0;
+  for (; x + vu8::N <= width; x += vu8::N) store3(dst + 3 * x, {{loadu(s0 + x), loadu(s1 + x), loadu(s2 + x)}});
+  for (; x < width; x++) {
+    dst[3 * x] = s0[x];
+    dst[3 * x + 1] = s1[x];
+    dst[3 * x + 2] = s2[x];
+  }
+}
+
+// s3 may be null for an opaque (255) fourth channel
+inline void interleave4_row(const uint8_t* s0, const uint8_t* s1, const uint8_t* s2, const uint8_t* s3, uint8_t* dst,
+                            int width) {
+  const vu8 opaque = set1_u8(255);
+  int x = 0;
+  for (; x + vu8::N <= width; x += vu8::N) {
+    store4(dst + 4 * x, {{loadu(s0 + x), loadu(s1 + x), loadu(s2 + x), s3 ? loadu(s3 + x) : opaque}});
+  }
+  for (; x < width; x++) {
+    dst[4 * x] = s0[x];
+    dst[4 * x + 1] = s1[x];
+    dst[4 * x + 2] = s2[x];
+    dst[4 * x + 3] = s3 ? s3[x] : 255;
+  }
+}
+
+// (wr * r + wg * g + wb * b + 128) >> 8 with weights summing to 256, so the
+// 16-bit lanes cannot overflow
+inline vu16 gray_u16(vu16 r, vu16 g, vu16 b, vu16 wr, vu16 wg, vu16 wb) {
+  vu16 sum = add(add(mul(r, wr), mul(g, wg)), add(mul(b, wb), set1_u16(128)));
+  return shr(sum, 8);
+}
+
+// channels is 3 or 4; r_index is 0 for RGB(A) and 2 for BGR(A)
+inline void gray_row(const uint8_t* src, int channels, int r_index, uint8_t* gray, int width) {
+  const vu16 wr = set1_u16(kGrayR), wg = set1_u16(kGrayG), wb = set1_u16(kGrayB);
+  const int b_index = 2 - r_index;
+  int x = 0;
+  for (; x + vu8::N <= width; x += vu8::N) {
+    vu8 r, g, b;
+    if (channels == 3) {
+      vu8x3 p = load3(src + 3 * x);
+      r = p.v[r_index];
+      g = p.v[1];
+      b = p.v[b_index];
+    } else {
+      vu8x4 p = load4(src + 4 * x);
+      r = p.v[r_index];
+      g = p.v[1];
+      b = p.v[b_index];
+    }
+    vu16 lo = gray_u16(widen_lo(r), widen_lo(g), widen_lo(b), wr, wg, wb);
+    vu16 hi = gray_u16(widen_hi(r), widen_hi(g), widen_hi(b), wr, wg, wb);
+    storeu(gray + x, narrow_sat_u8(lo, hi));
+  }
+  for (; x < width; x++) {
+    const uint8_t* p = src + channels * x;
+    gray[x] = (uint8_t)((kGrayR * p[r_index] + kGrayG * p[1] + kGrayB * p[b_index] + 128) >> 8);
+  }
+}
+
+// NV12 chroma row U V U V ... -> U U ..., V V ...
+inline void uv_row(const uint8_t* uv, uint8_t* u, uint8_t* v, int pairs) {
+  int x = 0;
+  for (; x + vu8::N <= pairs; x += vu8::N) {
+    vu8 a = loadu(uv + 2 * x), b = loadu(uv + 2 * x + vu8::N);
+    storeu(u + x, unzip_even(a, b));
+    storeu(v + x, unzip_odd(a, b));
+  }
+  for (; x < pairs; x++) {
+    u[x] = uv[2 * x];
+    v[x] = uv[2 * x + 1];
+  }
+}
+
+// Y0 U Y1 V ... -> Y plane at full width, U and V at half width. u and v may
+// both be null to extract luma (gray) only. width is even.
+inline void yuyv_row(const uint8_t* src, uint8_t* y, uint8_t* u, uint8_t* v, int width) {
+  int x = 0;
+  for (; x + 2 * vu8::N <= width; x += 2 * vu8::N) {
+    const uint8_t* p = src + 2 * x;
+    vu8 l0 = loadu(p), l1 = loadu(p + vu8::N), l2 = loadu(p + 2 * vu8::N), l3 = loadu(p + 3 * vu8::N);
+    storeu(y + x, unzip_even(l0, l1));
+    storeu(y + x + vu8::N, unzip_even(l2, l3));
+    if (u) {
+      vu8 c0 = unzip_odd(l0, l1), c1 = unzip_odd(l2, l3);
+      storeu(u + x / 2, unzip_even(c0, c1));
+      storeu(v + x / 2, unzip_odd(c0, c1));
+    }
+  }
+  for (; x < width; x += 2) {
+    y[x] = src[2 * x];
+    y[x + 1] = src[2 * x + 2];
+    if (u) {
+      u[x / 2] = src[2 * x + 1];
+      v[x / 2] = src[2 * x + 3];
+    }
+  }
+}
@@ -0,0 +1,359 @@
+#pragma once
+
+// conv2d for CNN inference on NCHWc activations (16 channels innermost,
+// channel count padded up to a multiple of 16 with zeros).
+//
+// Three algorithms, all producing the same NCHWc output:
+//   kDirect    register-blocked direct convolution, kOW output pixels x 16
+//              output channels per tile; depthwise layers always use it
+//   kIm2col    im2col of a chunk of output pixels, then sgemm (gemm/gemm.h)
+//   kWinograd  F(2x2, 3x3): 16 sgemms on transformed tiles instead of 36
+//              multiplies per 2x2 outputs (2.25x fewer), 3x3 stride 1 only
+// choose_algo() picks one per layer shape; forward() can also be told which.
+//
+// Supported: groups == 1, or depthwise (groups == in_c == out_c).
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../gemm/gemm.h"
+#include "../xr_simd.h"
+
+namespace xr {
+namespace conv {
+
+constexpr int kConvBlock = 16;
+
+#define XR_SIMD_KERNELS "conv/conv_kernels.inl"
+#include "../xr_simd_foreach.h"
+
+inline int conv_blocks(int channels) { return (channels + kConvBlock - 1) / kConvBlock; }
+
+// floats in an NCHWc tensor
+inline size_t nchwc_size(int n, int c, int h, int w) { return (size_t)n * conv_blocks(c) * h * w * kConvBlock; }
+
+inline void nchw_to_nchwc(const float* src, float* dst, int n, int c, int h, int w) {
+  const int cb = conv_blocks(c);
+  const size_t plane = (size_t)h * w;
+  for (int i = 0; i < n; i++) {
+    for (int b = 0; b < cb; b++) {
+      float* out = dst + ((size_t)i * cb + b) * plane * kConvBlock;
+      for (size_t p = 0; p < plane; p++) {
+        for (int l = 0; l < kConvBlock; l++) {
+          int ch = b * kConvBlock + l;
+          out[p * kConvBlock + l] = ch < c ? src[((size_t)i * c + ch) * plane + p] : 0.0f;
+        }
+      }
+    }
+  }
+}
+
+inline void nchwc_to_nchw(const float* src, float* dst, int n, int c, int h, int w) {
+  const int cb = conv_blocks(c);
+  const size_t plane = (size_t)h * w;
+  for (int i = 0; i < n; i++) {
+    for (int ch = 0; ch < c; ch++) {
+      const float* in = src + ((size_t)i * cb + ch / kConvBlock) * plane * kConvBlock + ch % kConvBlock;
+      float* out = dst + ((size_t)i * c + ch) * plane;
+      for (size_t p = 0; p < plane; p++) out[p] = in[p * kConvBlock];
+    }
+  }
+}
+
+struct ConvShape {
+  int batch = 1;
+  int in_c = 0, in_h = 0, in_w = 0;
+  int out_c = 0;
+  int kernel_h = 3, kernel_w = 3;
+  int stride = 1, pad = 0;
+  int groups = 1;
+
+  int out_h() const { return (in_h + 2 * pad - kernel_h) / stride + 1; }
+  int out_w() const { return (in_w + 2 * pad - kernel_w) / stride + 1; }
+  bool depthwise() const { return groups > 1 && groups == in_c && groups == out_c; }
+  double flops() const {
+    return 2.0 * batch * out_c * out_h() * out_w() * (in_c / groups) * kernel_h * kernel_w;
+  }
+};
+
+enum class ConvAlgo { kAuto, kDirect, kIm2col, kWinograd };
+
+inline const char* algo_name(ConvAlgo a) {
+  switch (a) {
+    case ConvAlgo::kDirect: return "direct";
+    case ConvAlgo::kIm2col: return "im2col";
+    case ConvAlgo::kWinograd: return "winograd";
+    default: return "auto";
+  }
+}
+
+inline bool conv_supported(const ConvShape& s) {
+  return s.batch > 0 && s.in_c > 0 && s.out_c > 0 && s.stride > 0 && s.pad >= 0 && s.kernel_h > 0 &&
+         s.kernel_w > 0 && s.out_h() > 0 && s.out_w() > 0 && (s.groups == 1 || s.depthwise());
+}
+
+inline bool algo_applicable(const ConvShape& s, ConvAlgo a) {
+  switch (a) {
+    case ConvAlgo::kDirect: return true;
+    case ConvAlgo::kIm2col: return !s.depthwise();
+    case ConvAlgo::kWinograd: return !s.depthwise() && s.kernel_h == 3 && s.kernel_w == 3 && s.stride == 1;
+    default: return true;
+  }
+}
+
+// Measured with convMain.h: Winograd wins on 3x3 stride 1 once there are
+// enough channels for its GEMMs to be compute bound and enough tiles (14x14
+// and up) to amortize the transforms. Otherwise im2col + GEMM needs a long
+// reduction and many output channels to beat the direct kernel, which also
+// skips the zero channels of a 3-channel stem.
+inline ConvAlgo choose_algo(const ConvShape& s) {
+  if (s.depthwise()) return ConvAlgo::kDirect;
+  if (algo_applicable(s, ConvAlgo::kWinograd) && s.in_c >= 32 && s.out_c >= 32 && s.out_h() * s.out_w() >= 100) {
+    return ConvAlgo::kWinograd;
+  }
+  const int k = conv_blocks(s.in_c) * kConvBlock * s.kernel_h * s.kernel_w;
+  return k >= 384 && s.out_c >= 128 ? ConvAlgo::kIm2col : ConvAlgo::kDirect;
+}
+
+// Weights are packed for every applicable algorithm up front, so forward() is
+// const and can run on several threads at once.
+class Conv2d {
+ public:
+  // weights are OIHW (depthwise: C x 1 x KH x KW); bias may be null
+  Conv2d(const ConvShape& shape, const float* weights, const float* bias) : s_(shape) {
+    in_cb_ = conv_blocks(s_.in_c);
+    out_cb_ = conv_blocks(s_.out_c);
+    bias_.assign((size_t)out_cb_ * kConvBlock, 0.0f);
+    if (bias) std::copy(bias, bias + s_.out_c, bias_.begin());
+    if (!conv_supported(s_)) return;
+    pack_direct(weights);
+    if (algo_applicable(s_, ConvAlgo::kIm2col)) pack_im2col(weights);
+    if (algo_applicable(s_, ConvAlgo::kWinograd)) pack_winograd(weights);
+  }
+
+  const ConvShape& shape() const { return s_; }
+
+  // in and out are NCHWc. Returns false when the shape or the algorithm is not
+  // supported. threads <= 0 uses every OpenMP thread.
+  bool forward(const float* in, float* out, ConvAlgo algo = ConvAlgo::kAuto, int threads = 0) const {
+    if (!conv_supported(s_)) return false;
+    if (algo == ConvAlgo::kAuto) algo = choose_algo(s_);
+    if (!algo_applicable(s_, algo)) return false;
+#ifdef _OPENMP
+    if (threads <= 0) threads = omp_get_max_threads();
+#else
+    threads = 1;
+#endif
+
+    const int oh = s_.out_h(), ow = s_.out_w();
+    int ph = s_.in_h + 2 * s_.pad, pw = s_.in_w + 2 * s_.pad;
+    if (algo == ConvAlgo::kWinograd) {
+      // whole 4x4 input patches for the last, possibly partial, 2x2 tiles
+      ph = std::max(ph, (oh + 1) / 2 * 2 + 2);
+      pw = std::max(pw, (ow + 1) / 2 * 2 + 2);
+    }
+    std::vector<float> padded;
+    pad_input(in, ph, pw, &padded, threads);
+
+    for (int n = 0; n < s_.batch; n++) {
+      const float* img = padded.data() + (size_t)n * in_cb_ * ph * pw * kConvBlock;
+      float* dst = out + (size_t)n * out_cb_ * oh * ow * kConvBlock;
+      if (algo == ConvAlgo::kDirect) {
+        run_direct(img, ph, pw, dst, threads);
+      } else if (algo == ConvAlgo::kIm2col) {
+        run_im2col(img, ph, pw, dst, threads);
+      } else {
+        run_winograd(img, ph, pw, dst, threads);
+      }
+    }
+    return true;
+  }
+
+ private:
+  // copy into [n][in_cb][ph][pw][16] with zero borders
+  void pad_input(const float* in, int ph, int pw, std::vector<float>* padded, int threads) const {
+    const int ih = s_.in_h, iw = s_.in_w, p = s_.pad;
+    padded->assign((size_t)s_.batch * in_cb_ * ph * pw * kConvBlock, 0.0f);
+    const int planes = s_.batch * in_cb_;
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (int b = 0; b < planes; b++) {
+      for (int y = 0; y < ih; y++) {
+        const float* src = in + ((size_t)b * ih + y) * iw * kConvBlock;
+        float* dst = padded->data() + (((size_t)b * ph + y + p) * pw + p) * kConvBlock;
+        std::memcpy(dst, src, sizeof(float) * iw * kConvBlock);
+      }
+    }
+  }
+
+  float weight(const float* w, int oc, int ic, int r, int c) const {
+    return w[(((size_t)oc * (s_.in_c / s_.groups) + ic) * s_.kernel_h + r) * s_.kernel_w + c];
+  }
+
+  // [out_cb][in_cb][kh][kw][16 ic][16 oc]; depthwise [cb][kh][kw][16]
+  void pack_direct(const float* w) {
+    const int kh = s_.kernel_h, kw = s_.kernel_w;
+    if (s_.depthwise()) {
+      direct_w_.assign((size_t)out_cb_ * kh * kw * kConvBlock, 0.0f);
+      for (int c = 0; c < s_.out_c; c++) {
+        for (int r = 0; r < kh; r++) {
+          for (int q = 0; q < kw; q++) {
+            direct_w_[(((size_t)(c / kConvBlock) * kh + r) * kw + q) * kConvBlock + c % kConvBlock] =
+                weight(w, c, 0, r, q);
+          }
+        }
+      }
+      return;
+    }
+    direct_w_.assign((size_t)out_cb_ * in_cb_ * kh * kw * kConvBlock * kConvBlock, 0.0f);
+    for (int oc = 0; oc < s_.out_c; oc++) {
+      for (int ic = 0; ic < s_.in_c; ic++) {
+        for (int r = 0; r < kh; r++) {
+          for (int q = 0; q < kw; q++) {
+            size_t tap = (((size_t)(oc / kConvBlock) * in_cb_ + ic / kConvBlock) * kh + r) * kw + q;
+            direct_w_[(tap * kConvBlock + ic % kConvBlock) * kConvBlock + oc % kConvBlock] = weight(w, oc, ic, r, q);
+          }
+        }
+      }
+    }
+  }
+
+  // K x OCp with K ordered (icb, r, s, 16 ic) to match conv_im2col_rows
+  void pack_im2col(const float* w) {
+    const int kh = s_.kernel_h, kw = s_.kernel_w, ocp = out_cb_ * kConvBlock;
+    im2col_w_.assign((size_t)in_cb_ * kh * kw * kConvBlock * ocp, 0.0f);
+    for (int oc = 0; oc < s_.out_c; oc++) {
+      for (int ic = 0; ic < s_.in_c; ic++) {
+        for (int r = 0; r < kh; r++) {
+          for (int q = 0; q < kw; q++) {
+            size_t k = (((size_t)(ic / kConvBlock) * kh + r) * kw + q) * kConvBlock + ic % kConvBlock;
+            im2col_w_[k * ocp + oc] = weight(w, oc, ic, r, q);
+          }
+        }
+      }
+    }
+  }
+
+  // U = G g G^T per (oc, ic), stored as 16 matrices [xi][ICp][OCp]
+  void pack_winograd(const float* w) {
+    static const float G[4][3] = {{1.0f, 0.0f, 0.0f}, {0.5f, 0.5f, 0.5f}, {0.5f, -0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}};
+    const int icp = in_cb_ * kConvBlock, ocp = out_cb_ * kConvBlock;
+    wino_w_.assign((size_t)16 * icp * ocp, 0.0f);
+    for (int oc = 0; oc < s_.out_c; oc++) {
+      for (int ic = 0; ic < s_.in_c; ic++) {
+        float gg[4][3];
+        for (int i = 0; i < 4; i++) {
+          for (int j = 0; j < 3; j++) {
+            gg[i][j] = G[i][0] * weight(w, oc, ic, 0, j) + G[i][1] * weight(w, oc, ic, 1, j) +
+                       G[i][2] * weight(w, oc, ic, 2, j);
+          }
+        }
+        for (int i = 0; i < 4; i++) {
+          for (int j = 0; j < 4; j++) {
+            float u = gg[i][0] * G[j][0] + gg[i][1] * G[j][1] + gg[i][2] * G[j][2];
+            wino_w_[((size_t)(i * 4 + j) * icp + ic) * ocp + oc] = u;
+          }
+        }
+      }
+    }
+  }
+
+  void run_direct(const float* img, int ph, int pw, float* dst, int threads) const {
+    const int oh = s_.out_h(), ow = s_.out_w(), kh = s_.kernel_h, kw = s_.kernel_w, st = s_.stride;
+    const ptrdiff_t in_plane = (ptrdiff_t)ph * pw * kConvBlock;
+    const ptrdiff_t out_plane = (ptrdiff_t)oh * ow * kConvBlock;
+    const int rows = out_cb_ * oh;
+    if (s_.depthwise()) {
+      auto row_fn = XR_SIMD_DISPATCH(conv_depthwise_row);
+#pragma omp parallel for schedule(static) num_threads(threads)
+      for (int i = 0; i < rows; i++) {
+        const int cb = i / oh, y = i % oh;
+        row_fn(img + cb * in_plane + (ptrdiff_t)y * st * pw * kConvBlock, pw,
+               direct_w_.data() + (size_t)cb * kh * kw * kConvBlock, kh, kw, st,
+               dst + cb * out_plane + (ptrdiff_t)y * ow * kConvBlock, ow, bias_.data() + cb * kConvBlock);
+      }
+      return;
+    }
+    auto row_fn = XR_SIMD_DISPATCH(conv_direct_row);
+    const size_t w_block = (size_t)in_cb_ * kh * kw * kConvBlock * kConvBlock;
+    const int last_ic = s_.in_c - (in_cb_ - 1) * kConvBlock;
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (int i = 0; i < rows; i++) {
+      const int ocb = i / oh, y = i % oh;
+      row_fn(img + (ptrdiff_t)y * st * pw * kConvBlock, in_cb_, last_ic, in_plane, pw, direct_w_.data() + ocb * w_block,
+             kh, kw, st, dst + ocb * out_plane + (ptrdiff_t)y * ow * kConvBlock, ow, bias_.data() + ocb * kConvBlock);
+    }
+  }
+
+  void run_im2col(const float* img, int ph, int pw, float* dst, int threads) const {
+    const int oh = s_.out_h(), ow = s_.out_w(), pixels = oh * ow;
+    const int k = in_cb_ * s_.kernel_h * s_.kernel_w * kConvBlock, ocp = out_cb_ * kConvBlock;
+    const ptrdiff_t in_plane = (ptrdiff_t)ph * pw * kConvBlock;
+    // bound the column buffer to ~4 MB
+    const int chunk = std::max(64, std::min(pixels, (1 << 20) / k));
+    std::vector<float> col((size_t)chunk * k), m((size_t)chunk * ocp);
+    auto im2col = XR_SIMD_DISPATCH(conv_im2col_rows);
+    auto scatter = XR_SIMD_DISPATCH(conv_scatter_rows);
+    for (int p0 = 0; p0 < pixels; p0 += chunk) {
+      const int p1 = std::min(pixels, p0 + chunk), rows = p1 - p0;
+      const int parts = std::max(1, std::min(threads, rows / 16));
+#pragma omp parallel for schedule(static) num_threads(threads)
+      for (int t = 0; t < parts; t++) {
+        int a = p0 + rows * t / parts, b = p0 + rows * (t + 1) / parts;
+        im2col(img, in_cb_, in_plane, pw, s_.kernel_h, s_.kernel_w, s_.stride, ow, a, b, col.data() + (size_t)(a - p0) * k);
+      }
+      xr::gemm::sgemm(false, false, rows, ocp, k, 1.0f, col.data(), k, im2col_w_.data(), ocp, 0.0f, m.data(), ocp,
+                      threads);
+#pragma omp parallel for schedule(static) num_threads(threads)
+      for (int t = 0; t < parts; t++) {
+        int a = p0 + rows * t / parts, b = p0 + rows * (t + 1) / parts;
+        scatter(m.data() + (size_t)(a - p0) * ocp, a, b, out_cb_, (ptrdiff_t)pixels * kConvBlock, dst, bias_.data());
+      }
+    }
+  }
+
+  void run_winograd(const float* img, int ph, int pw, float* dst, int threads) const {
+    const int oh = s_.out_h(), ow = s_.out_w();
+    const int tiles_w = (ow + 1) / 2, tiles = (oh + 1) / 2 * tiles_w;
+    const int icp = in_cb_ * kConvBlock, ocp = out_cb_ * kConvBlock;
+    const ptrdiff_t in_plane = (ptrdiff_t)ph * pw * kConvBlock;
+    // V and M for one chunk of tiles kept around 2 MB
+    const int chunk = std::max(16, std::min(tiles, (1 << 19) / (16 * (icp + ocp))));
+    std::vector<float> v((size_t)16 * chunk * icp), m((size_t)16 * chunk * ocp);
+    auto input = XR_SIMD_DISPATCH(wino_input_tiles);
+    auto output = XR_SIMD_DISPATCH(wino_output_tiles);
+    for (int t0 = 0; t0 < tiles; t0 += chunk) {
+      const int t1 = std::min(tiles, t0 + chunk), count = t1 - t0;
+      const int parts = std::max(1, std::min(threads, count / 4));
+      const ptrdiff_t v_stride = (ptrdiff_t)count * icp, m_stride = (ptrdiff_t)count * ocp;
+#pragma omp parallel for schedule(static) num_threads(threads)
+      for (int t = 0; t < parts; t++) {
+        int a = t0 + count * t / parts, b = t0 + count * (t + 1) / parts;
+        input(img, in_cb_, in_plane, pw, tiles_w, a, b, v.data() + (ptrdiff_t)(a - t0) * icp, v_stride);
+      }
+      for (int xi = 0; xi < 16; xi++) {
+        xr::gemm::sgemm(false, false, count, ocp, icp, 1.0f, v.data() + xi * v_stride, icp,
+                        wino_w_.data() + (size_t)xi * icp * ocp, ocp, 0.0f, m.data() + xi * m_stride, ocp, threads);
+      }
+#pragma omp parallel for schedule(static) num_threads(threads)
+      for (int t = 0; t < parts; t++) {
+        int a = t0 + count * t / parts, b = t0 + count * (t + 1) / parts;
+        output(m.data() + (ptrdiff_t)(a - t0) * ocp, m_stride, out_cb_, tiles_w, a, b, dst,
+               (ptrdiff_t)oh * ow * kConvBlock, oh, ow, bias_.data());
+      }
+    }
+  }
+
+  ConvShape s_;
+  int in_cb_ = 0, out_cb_ = 0;
+  std::vector<float> bias_;
+  std::vector<float> direct_w_, im2col_w_, wino_w_;
+};
+
+}  // namespace conv
+}  // namespace xr
@@ -0,0 +1,178 @@
+#pragma once
+
+// Checks every conv2d algorithm against a plain NCHW loop on every backend
+// this CPU can run, then times them on ResNet / MobileNet layer shapes and
+// marks the one choose_algo() picks.
+//
+// g++ -O3 -fopenmp -std=c++17 main.cpp -o conv_demo
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "conv2d.h"
+
+namespace xr {
+namespace conv {
+
+// NCHW in, OIHW weights, NCHW out, double accumulation
+inline void conv_ref(const ConvShape& s, const float* in, const float* w, const float* bias, float* out) {
+  const int oh = s.out_h(), ow = s.out_w(), icg = s.in_c / s.groups, ocg = s.out_c / s.groups;
+  for (int n = 0; n < s.batch; n++) {
+    for (int oc = 0; oc < s.out_c; oc++) {
+      const int g = oc / ocg;
+      for (int y = 0; y < oh; y++) {
+        for (int x = 0; x < ow; x++) {
+          double sum = bias[oc];
+          for (int ic = 0; ic < icg; ic++) {
+            for (int r = 0; r < s.kernel_h; r++) {
+              int iy = y * s.stride + r - s.pad;
+              if (iy < 0 || iy >= s.in_h) continue;
+              for (int q = 0; q < s.kernel_w; q++) {
+                int ix = x * s.stride + q - s.pad;
+                if (ix < 0 || ix >= s.in_w) continue;
+                sum += (double)in[(((size_t)n * s.in_c + g * icg + ic) * s.in_h + iy) * s.in_w + ix] *
+                       w[(((size_t)oc * icg + ic) * s.kernel_h + r) * s.kernel_w + q];
+              }
+            }
+          }
+          out[(((size_t)n * s.out_c + oc) * oh + y) * ow + x] = (float)sum;
+        }
+      }
+    }
+  }
+}
+
+inline ConvShape make_conv(int c, int h, int w, int oc, int k, int stride, int pad, int groups = 1, int batch = 1) {
+  ConvShape s;
+  s.batch = batch;
+  s.in_c = c;
+  s.in_h = h;
+  s.in_w = w;
+  s.out_c = oc;
+  s.kernel_h = s.kernel_w = k;
+  s.stride = stride;
+  s.pad = pad;
+  s.groups = groups;
+  return s;
+}
+
+struct ConvData {
+  std::vector<float> in_nchw, weights, bias, in;
+  explicit ConvData(const ConvShape& s) {
+    uint32_t seed = 99;
+    auto next = [&seed]() {
+      seed = seed * 1664525u + 1013904223u;
+      return (float)((int)(seed >> 20) - 2048) / 2048.0f;
+    };
+    in_nchw.resize((size_t)s.batch * s.in_c * s.in_h * s.in_w);
+    weights.resize((size_t)s.out_c * (s.in_c / s.groups) * s.kernel_h * s.kernel_w);
+    bias.resize(s.out_c);
+    for (auto& x : in_nchw) x = next();
+    for (auto& x : weights) x = next();
+    for (auto& x : bias) x = next();
+    in.resize(nchwc_size(s.batch, s.in_c, s.in_h, s.in_w));
+    nchw_to_nchwc(in_nchw.data(), in.data(), s.batch, s.in_c, s.in_h, s.in_w);
+  }
+};
+
+inline double conv_now_ms() {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace conv
+}  // namespace xr
+
+inline int convMain() {
+  using namespace xr::simd;
+  using namespace xr::conv;
+
+  const Isa all[] = {Isa::kScalar, Isa::kSSE42, Isa::kAVX2, Isa::kAVX512, Isa::kNEON};
+  const ConvAlgo algos[] = {ConvAlgo::kDirect, ConvAlgo::kIm2col, ConvAlgo::kWinograd};
+  const Isa initial = current_isa();
+  bool pass = true;
+
+  // odd sizes, channel counts that are not multiples of 16, padding, stride,
+  // batch > 1 and an odd output size for the partial Winograd tiles
+  const ConvShape checks[] = {make_conv(3, 11, 13, 5, 3, 1, 1),     make_conv(20, 9, 7, 33, 3, 1, 0, 1, 2),
+                              make_conv(17, 15, 15, 18, 3, 2, 1),   make_conv(40, 6, 10, 24, 1, 1, 0),
+                              make_conv(8, 12, 12, 8, 5, 1, 2),     make_conv(24, 13, 9, 24, 3, 1, 1, 24),
+                              make_conv(19, 10, 10, 19, 3, 2, 1, 19), make_conv(3, 23, 23, 16, 7, 2, 3)};
+  for (Isa isa : all) {
+    if (!set_isa(isa)) continue;
+    double worst = 0.0;
+    for (const ConvShape& s : checks) {
+      ConvData d(s);
+      Conv2d conv(s, d.weights.data(), d.bias.data());
+      const int oh = s.out_h(), ow = s.out_w();
+      std::vector<float> ref((size_t)s.batch * s.out_c * oh * ow), got(ref.size());
+      std::vector<float> out(nchwc_size(s.batch, s.out_c, oh, ow));
+      conv_ref(s, d.in_nchw.data(), d.weights.data(), d.bias.data(), ref.data());
+      for (ConvAlgo a : algos) {
+        if (!algo_applicable(s, a)) continue;
+        if (!conv.forward(d.in.data(), out.data(), a)) {
+          printf("  %s forward failed\n", algo_name(a));
+          worst = 1.0;
+          continue;
+        }
+        nchwc_to_nchw(out.data(), got.data(), s.batch, s.out_c, oh, ow);
+        // errors relative to the magnitude of the reduction
+        const double scale = std::sqrt((double)(s.in_c / s.groups) * s.kernel_h * s.kernel_w);
+        for (size_t i = 0; i < ref.size(); i++) worst = std::max(worst, std::fabs(got[i] - ref[i]) / scale);
+      }
+    }
+    bool ok = worst < 1e-5;
+    pass &= ok;
+    printf("%-7s max err %.2e %s\n", isa_name(isa), worst, ok ? "ok" : "FAILED");
+  }
+  set_isa(initial);
+
+  struct Layer {
+    const char* name;
+    ConvShape s;
+  };
+  const Layer layers[] = {
+      {"resnet conv1 7x7/2", make_conv(3, 224, 224, 64, 7, 2, 3)},
+      {"resnet 3x3 64", make_conv(64, 56, 56, 64, 3, 1, 1)},
+      {"resnet 3x3 128", make_conv(128, 28, 28, 128, 3, 1, 1)},
+      {"resnet 3x3 256", make_conv(256, 14, 14, 256, 3, 1, 1)},
+      {"resnet 3x3 512", make_conv(512, 7, 7, 512, 3, 1, 1)},
+      {"resnet 3x3/2 128", make_conv(128, 28, 28, 256, 3, 2, 1)},
+      {"resnet 1x1 256-64", make_conv(256, 56, 56, 64, 1, 1, 0)},
+      {"resnet 1x1 64-256", make_conv(64, 56, 56, 256, 1, 1, 0)},
+      {"mobilenet dw 32", make_conv(32, 112, 112, 32, 3, 1, 1, 32)},
+      {"mobilenet pw 32-64", make_conv(32, 112, 112, 64, 1, 1, 0)},
+      {"mobilenet dw/2 128", make_conv(128, 56, 56, 128, 3, 2, 1, 128)},
+      {"mobilenet pw 512", make_conv(512, 14, 14, 512, 1, 1, 0)},
+      {"mobilenet dw 1024", make_conv(1024, 7, 7, 1024, 3, 1, 1, 1024)},
+  };
+  printf("\nms per layer, batch 1 (%s, * = choose_algo)\n", isa_name(current_isa()));
+  printf("%-20s %10s %10s %10s %8s\n", "layer", "direct", "im2col", "winograd", "GFLOP/s");
+  for (const Layer& l : layers) {
+    ConvData d(l.s);
+    Conv2d conv(l.s, d.weights.data(), d.bias.data());
+    std::vector<float> out(nchwc_size(l.s.batch, l.s.out_c, l.s.out_h(), l.s.out_w()));
+    const ConvAlgo pick = choose_algo(l.s);
+    char cells[3][16];
+    double picked_ms = 0.0;
+    for (int i = 0; i < 3; i++) {
+      snprintf(cells[i], sizeof(cells[i]), "-");
+      if (!algo_applicable(l.s, algos[i])) continue;
+      conv.forward(d.in.data(), out.data(), algos[i]);
+      int runs = 0;
+      double t0 = conv_now_ms();
+      do {
+        conv.forward(d.in.data(), out.data(), algos[i]);
+        runs++;
+      } while (conv_now_ms() - t0 < 100.0);
+      double ms = (conv_now_ms() - t0) / runs;
+      if (algos[i] == pick) picked_ms = ms;
+      snprintf(cells[i], sizeof(cells[i]), "%.3f%s", ms, algos[i] == pick ? "*" : " ");
+    }
+    printf("%-20s %10s %10s %10s %8.1f\n", l.name, cells[0], cells[1], cells[2], l.s.flops() * 1e-6 / picked_ms);
+  }
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
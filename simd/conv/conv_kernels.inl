@@ -0,0 +1,253 @@
+// conv2d kernels, expanded per backend by xr_simd_foreach.h from conv2d.h.
+//
+// Activations are NCHWc with c = kConvBlock (16) channels innermost, so one
+// channel block of one pixel is kConvBlock / vf32::N vectors: 1 zmm, 2 ymm or
+// 4 xmm / q registers. Inputs arrive already zero padded, so none of these
+// loops test borders.
+
+#if defined(__clang__)
+#define XR_CONV_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define XR_CONV_UNROLL _Pragma("GCC unroll 16")
+#else
+#define XR_CONV_UNROLL
+#endif
+
+constexpr int kV = kConvBlock / vf32::N;
+
+// output pixels per register tile of the direct kernel: kOW * kV accumulators
+// plus kV weight vectors and one broadcast
+#if XR_SIMD_TARGET == XR_SIMD_TARGET_AVX512
+constexpr int kOW = 14;
+#elif XR_SIMD_TARGET == XR_SIMD_TARGET_AVX2
+constexpr int kOW = 6;
+#elif XR_SIMD_TARGET == XR_SIMD_TARGET_NEON
+constexpr int kOW = 6;
+#else
+constexpr int kOW = 3;
+#endif
+
+// T output pixels x one output channel block, summed over every input block.
+// in: padded input at (row oh * stride, col ow0 * stride) of input block 0.
+// w: [in_cb][kh][kw][16 ic][16 oc] for this output block. Only last_ic
+// channels of the last input block are real (the zero padding is skipped,
+// which matters for 3-channel stems).
+template <int T>
+inline void conv_direct_tile(const float* in, int in_cb, int last_ic, ptrdiff_t in_plane, int pw, const float* w,
+                             int kh, int kw, int stride, float* out, const float* bias) {
+  vf32 acc[T][kV];
+  XR_CONV_UNROLL
+  for (int v = 0; v < kV; v++) {
+    vf32 b = bias ? loadu(bias + v * vf32::N) : zero_f32();
+    XR_CONV_UNROLL
+    for (int t = 0; t < T; t++) acc[t][v] = b;
+  }
+  const ptrdiff_t step = (ptrdiff_t)stride * kConvBlock;
+  for (int icb = 0; icb < in_cb; icb++) {
+    const int ics = icb + 1 == in_cb ? last_ic : kConvBlock;
+    for (int r = 0; r < kh; r++) {
+      const float* irow = in + icb * in_plane + (ptrdiff_t)r * pw * kConvBlock;
+      for (int s = 0; s < kw; s++) {
+        const float* ip = irow + s * kConvBlock;
+        const float* wp = w + ((ptrdiff_t)(icb * kh + r) * kw + s) * kConvBlock * kConvBlock;
+        for (int ic = 0; ic < ics; ic++) {
+          vf32 wv[kV];
+          XR_CONV_UNROLL
+          for (int v = 0; v < kV; v++) wv[v] = loadu(wp + ic * kConvBlock + v * vf32::N);
+          XR_CONV_UNROLL
+          for (int t = 0; t < T; t++) {
+            vf32 x = set1_f32(ip[t * step + ic]);
+            XR_CONV_UNROLL
+            for (int v = 0; v < kV; v++) acc[t][v] = fma(x, wv[v], acc[t][v]);
+          }
+        }
+      }
+    }
+  }
+  XR_CONV_UNROLL
+  for (int t = 0; t < T; t++) {
+    XR_CONV_UNROLL
+    for (int v = 0; v < kV; v++) storeu(out + t * kConvBlock + v * vf32::N, acc[t][v]);
+  }
+}
+
+// One output row of one output channel block. in points at the padded input
+// row oh * stride of block 0; out at the output row ([ow][16]). The tail uses
+// halved tiles so short rows (7 pixels at the end of ResNet) stay blocked.
+inline void conv_direct_row(const float* in, int in_cb, int last_ic, ptrdiff_t in_plane, int pw, const float* w,
+                            int kh, int kw, int stride, float* out, int ow, const float* bias) {
+  const ptrdiff_t step = (ptrdiff_t)stride * kConvBlock;
+  int x = 0;
+  for (; x + kOW <= ow; x += kOW) {
+    conv_direct_tile<kOW>(in + x * step, in_cb, last_ic, in_plane, pw, w, kh, kw, stride, out + x * kConvBlock, bias);
+  }
+  if (kOW / 2 > 1 && x + kOW / 2 <= ow) {
+    conv_direct_tile<kOW / 2>(in + x * step, in_cb, last_ic, in_plane, pw, w, kh, kw, stride, out + x * kConvBlock,
+                              bias);
+    x += kOW / 2;
+  }
+  if (kOW / 4 > 1 && x + kOW / 4 <= ow) {
+    conv_direct_tile<kOW / 4>(in + x * step, in_cb, last_ic, in_plane, pw, w, kh, kw, stride, out + x * kConvBlock,
+                              bias);
+    x += kOW / 4;
+  }
+  for (; x < ow; x++) {
+    conv_direct_tile<1>(in + x * step, in_cb, last_ic, in_plane, pw, w, kh, kw, stride, out + x * kConvBlock, bias);
+  }
+}
+
+// Depthwise: each lane is its own channel, so a block is a plain vector
+// multiply-add per tap. w: [kh][kw][16] for this block.
+inline void conv_depthwise_row(const float* in, int pw, const float* w, int kh, int kw, int stride, float* out,
+                               int ow, const float* bias) {
+  constexpr int T = 4;
+  const ptrdiff_t step = (ptrdiff_t)stride * kConvBlock;
+  int x = 0;
+  for (; x < ow; x += T) {
+    const int n = std::min(T, ow - x);
+    vf32 acc[T][kV];
+    for (int t = 0; t < T; t++) {
+      XR_CONV_UNROLL
+      for (int v = 0; v < kV; v++) acc[t][v] = bias ? loadu(bias + v * vf32::N) : zero_f32();
+    }
+    for (int r = 0; r < kh; r++) {
+      const float* irow = in + (ptrdiff_t)r * pw * kConvBlock + x * step;
+      for (int s = 0; s < kw; s++) {
+        const float* wp = w + (r * kw + s) * kConvBlock;
+        XR_CONV_UNROLL
+        for (int v = 0; v < kV; v++) {
+          vf32 wv = loadu(wp + v * vf32::N);
+          XR_CONV_UNROLL
+          for (int t = 0; t < T; t++) {
+            if (t < n) acc[t][v] = fma(loadu(irow + t * step + s * kConvBlock + v * vf32::N), wv, acc[t][v]);
+          }
+        }
+      }
+    }
+    for (int t = 0; t < n; t++) {
+      XR_CONV_UNROLL
+      for (int v = 0; v < kV; v++) storeu(out + (x + t) * kConvBlock + v * vf32::N, acc[t][v]);
+    }
+  }
+}
+
+// im2col rows [p0, p1) of one image into col[p - p0][K] with K ordered
+// (icb, r, s, 16 ic), i.e. 16 contiguous floats per tap.
+inline void conv_im2col_rows(const float* in, int in_cb, ptrdiff_t in_plane, int pw, int kh, int kw, int stride,
+                             int ow, int p0, int p1, float* col) {
+  const int k = in_cb * kh * kw * kConvBlock;
+  for (int p = p0; p < p1; p++) {
+    const int y = p / ow, x = p % ow;
+    float* dst = col + (ptrdiff_t)(p - p0) * k;
+    for (int icb = 0; icb < in_cb; icb++) {
+      for (int r = 0; r < kh; r++) {
+        const float* src = in + icb * in_plane + ((ptrdiff_t)(y * stride + r) * pw + x * stride) * kConvBlock;
+        for (int s = 0; s < kw; s++) {
+          XR_CONV_UNROLL
+          for (int v = 0; v < kV; v++) storeu(dst + v * vf32::N, loadu(src + s * kConvBlock + v * vf32::N));
+          dst += kConvBlock;
+        }
+      }
+    }
+  }
+}
+
+// GEMM result rows m[p - p0][out_cb * 16] back into NCHWc, adding the bias.
+inline void conv_scatter_rows(const float* m, int p0, int p1, int out_cb, ptrdiff_t out_plane, float* out,
+                              const float* bias) {
+  const int ocp = out_cb * kConvBlock;
+  for (int p = p0; p < p1; p++) {
+    const float* src = m + (ptrdiff_t)(p - p0) * ocp;
+    for (int ocb = 0; ocb < out_cb; ocb++) {
+      float* dst = out + ocb * out_plane + (ptrdiff_t)p * kConvBlock;
+      XR_CONV_UNROLL
+      for (int v = 0; v < kV; v++) {
+        vf32 r = loadu(src + ocb * kConvBlock + v * vf32::N);
+        storeu(dst + v * vf32::N, add(r, loadu(bias + ocb * kConvBlock + v * vf32::N)));
+      }
+    }
+  }
+}
+
+// Winograd F(2x2, 3x3) input transform V = B^T d B for tiles [t0, t1) of one
+// image, d being the 4x4 padded input patch at (2 * ty, 2 * tx).
+// Writes v[xi * xi_stride + (t - t0) * in_cb * 16 + c] for the 16 positions xi.
+inline void wino_input_tiles(const float* in, int in_cb, ptrdiff_t in_plane, int pw, int tiles_w, int t0, int t1,
+                             float* v_out, ptrdiff_t xi_stride) {
+  const int icp = in_cb * kConvBlock;
+  for (int t = t0; t < t1; t++) {
+    const int ty = t / tiles_w, tx = t % tiles_w;
+    for (int icb = 0; icb < in_cb; icb++) {
+      const float* base = in + icb * in_plane + ((ptrdiff_t)2 * ty * pw + 2 * tx) * kConvBlock;
+      float* dst = v_out + (ptrdiff_t)(t - t0) * icp + icb * kConvBlock;
+      XR_CONV_UNROLL
+      for (int v = 0; v < kV; v++) {
+        vf32 d[4][4], u[4][4];
+        XR_CONV_UNROLL
+        for (int i = 0; i < 4; i++) {
+          XR_CONV_UNROLL
+          for (int j = 0; j < 4; j++) d[i][j] = loadu(base + ((ptrdiff_t)i * pw + j) * kConvBlock + v * vf32::N);
+        }
+        XR_CONV_UNROLL
+        for (int j = 0; j < 4; j++) {
+          vf32 a = sub(d[0][j], d[2][j]), b = add(d[1][j], d[2][j]);
+          vf32 c = sub(d[2][j], d[1][j]), e = sub(d[1][j], d[3][j]);
+          d[0][j] = a;
+          d[1][j] = b;
+          d[2][j] = c;
+          d[3][j] = e;
+        }
+        XR_CONV_UNROLL
+        for (int i = 0; i < 4; i++) {
+          u[i][0] = sub(d[i][0], d[i][2]);
+          u[i][1] = add(d[i][1], d[i][2]);
+          u[i][2] = sub(d[i][2], d[i][1]);
+          u[i][3] = sub(d[i][1], d[i][3]);
+        }
+        XR_CONV_UNROLL
+        for (int i = 0; i < 4; i++) {
+          XR_CONV_UNROLL
+          for (int j = 0; j < 4; j++) storeu(dst + (i * 4 + j) * xi_stride + v * vf32::N, u[i][j]);
+        }
+      }
+    }
+  }
+}
+
+// Output transform Y = A^T M A plus bias for tiles [t0, t1): reads
+// m[xi * xi_stride + (t - t0) * out_cb * 16 + c] and writes the valid part of
+// each 2x2 output tile into NCHWc out.
+inline void wino_output_tiles(const float* m, ptrdiff_t xi_stride, int out_cb, int tiles_w, int t0, int t1,
+                              float* out, ptrdiff_t out_plane, int oh, int ow, const float* bias) {
+  const int ocp = out_cb * kConvBlock;
+  for (int t = t0; t < t1; t++) {
+    const int ty = t / tiles_w, tx = t % tiles_w;
+    const int rows = std::min(2, oh - 2 * ty), cols = std::min(2, ow - 2 * tx);
+    for (int ocb = 0; ocb < out_cb; ocb++) {
+      const float* src = m + (ptrdiff_t)(t - t0) * ocp + ocb * kConvBlock;
+      float* dst = out + ocb * out_plane + ((ptrdiff_t)2 * ty * ow + 2 * tx) * kConvBlock;
+      XR_CONV_UNROLL
+      for (int v = 0; v < kV; v++) {
+        vf32 s[2][4];
+        XR_CONV_UNROLL
+        for (int j = 0; j < 4; j++) {
+          vf32 m0 = loadu(src + (0 * 4 + j) * xi_stride + v * vf32::N);
+          vf32 m1 = loadu(src + (1 * 4 + j) * xi_stride + v * vf32::N);
+          vf32 m2 = loadu(src + (2 * 4 + j) * xi_stride + v * vf32::N);
+          vf32 m3 = loadu(src + (3 * 4 + j) * xi_stride + v * vf32::N);
+          s[0][j] = add(add(m0, m1), m2);
+          s[1][j] = sub(sub(m1, m2), m3);
+        }
+        const vf32 b = loadu(bias + ocb * kConvBlock + v * vf32::N);
+        for (int i = 0; i < rows; i++) {
+          vf32 y0 = add(add(add(s[i][0], s[i][1]), s[i][2]), b);
+          vf32 y1 = add(sub(sub(s[i][1], s[i][2]), s[i][3]), b);
+          storeu(dst + (ptrdiff_t)i * ow * kConvBlock + v * vf32::N, y0);
+          if (cols > 1) storeu(dst + ((ptrdiff_t)i * ow + 1) * kConvBlock + v * vf32::N, y1);
+        }
+      }
+    }
+  }
+}
+
+#undef XR_CONV_UNROLL
@@ -0,0 +1,399 @@
+#pragma once
+
+// FFTs for signals and images: complex 1D, real 1D (r2c / c2r), complex 2D and
+// real 2D. Transforms are unnormalized in both directions (ifft(fft(x)) is
+// n * x), with forward sign -1, and data is interleaved std::complex<float>.
+//
+// A size-n plan is built once per (n, vector width) and cached. When the
+// vector width V divides n and n / V factors into 2, 3 and 5, the transform is
+// a four-step FFT whose passes are all Stockham stages over full vectors
+// (fft_kernels.inl). Any other n runs a scalar Stockham FFT with radices 4, 2,
+// 3, 5 and plain DFT butterflies for larger prime factors.
+//
+// 2D transforms do the rows, a cache-blocked transpose, the rows again and a
+// transpose back, with rows spread over OpenMP threads.
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../xr_simd.h"
+
+namespace xr {
+namespace fft {
+
+using cfloat = std::complex<float>;
+
+// One Stockham pass of the given radix after sub-transforms of size ns are
+// done. tw[(k * (radix - 1) + q - 1) * 2 + {0, 1}] = W_(ns * radix)^(q * k).
+struct FftStage {
+  int radix = 0, ns = 0;
+  std::vector<float> tw;
+  std::vector<cfloat> roots;  // W_radix^t, used by the scalar path for radices above 5
+};
+
+struct FftSimdPlan {
+  int n = 0, lanes = 0, n1 = 0;
+  std::vector<FftStage> rows;  // length n1, down the rows
+  std::vector<FftStage> lane;  // length lanes, across them
+  std::vector<float> tw_re, tw_im;  // [k1][j2] = W_n^(j2 * k1)
+  std::vector<float> lane_roots;    // W_lanes^e, interleaved
+};
+
+#define XR_SIMD_KERNELS "fft/fft_kernels.inl"
+#include "../xr_simd_foreach.h"
+
+// Radices in the order the stages run, 4s first. Empty if n has a prime factor
+// above 5 and only 2, 3, 5 are allowed.
+inline std::vector<int> fft_factor(int n, bool smooth_only) {
+  std::vector<int> radices;
+  while (n % 4 == 0) {
+    radices.push_back(4);
+    n /= 4;
+  }
+  for (int r : {2, 3, 5}) {
+    while (n % r == 0) {
+      radices.push_back(r);
+      n /= r;
+    }
+  }
+  for (int r = 7; n > 1; r += 2) {
+    if (smooth_only) return {};
+    while (n % r == 0) {
+      radices.push_back(r);
+      n /= r;
+    }
+    if ((int64_t)r * r > n && n > 1) {
+      radices.push_back(n);
+      n = 1;
+    }
+  }
+  return radices;
+}
+
+inline std::vector<FftStage> fft_stages(const std::vector<int>& radices) {
+  std::vector<FftStage> stages;
+  const double pi = 3.14159265358979323846;
+  int ns = 1;
+  for (int r : radices) {
+    FftStage s;
+    s.radix = r;
+    s.ns = ns;
+    s.tw.resize((size_t)ns * (r - 1) * 2);
+    for (int k = 0; k < ns; k++) {
+      for (int q = 1; q < r; q++) {
+        double a = -2.0 * pi * q * k / ((double)ns * r);
+        s.tw[((size_t)k * (r - 1) + q - 1) * 2] = (float)std::cos(a);
+        s.tw[((size_t)k * (r - 1) + q - 1) * 2 + 1] = (float)std::sin(a);
+      }
+    }
+    if (r > 5) {
+      for (int t = 0; t < r; t++) s.roots.emplace_back((float)std::cos(-2.0 * pi * t / r), (float)std::sin(-2.0 * pi * t / r));
+    }
+    stages.push_back(std::move(s));
+    ns *= r;
+  }
+  return stages;
+}
+
+// std::complex operator* checks for inf / nan through a libgcc call; the
+// transforms never need that
+inline cfloat cmul(cfloat a, cfloat b) {
+  return cfloat(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+// 64-byte aligned per-thread buffers, grown on demand; two slots so the real
+// transforms can hold a temporary while the complex plan uses its own
+inline float* fft_scratch(int slot, size_t floats) {
+  struct Scratch {
+    float* p[2] = {nullptr, nullptr};
+    size_t cap[2] = {0, 0};
+    ~Scratch() {
+      xr::simd::aligned_free(p[0]);
+      xr::simd::aligned_free(p[1]);
+    }
+  };
+  thread_local Scratch s;
+  if (floats > s.cap[slot]) {
+    xr::simd::aligned_free(s.p[slot]);
+    s.p[slot] = (float*)xr::simd::aligned_malloc(sizeof(float) * floats);
+    s.cap[slot] = floats;
+  }
+  return s.p[slot];
+}
+
+class FftPlan {
+ public:
+  FftPlan(int n, int lanes) : n_(n) {
+    stages_ = fft_stages(fft_factor(n, false));
+    // below lanes * lanes every row would take the direct V-point DFT
+    if (n % lanes != 0 || n < lanes * lanes) return;
+    std::vector<int> rows = fft_factor(n / lanes, true), lane = fft_factor(lanes, true);
+    if (rows.empty() && n != lanes) return;
+    const double pi = 3.14159265358979323846;
+    simd_.n = n;
+    simd_.lanes = lanes;
+    simd_.n1 = n / lanes;
+    simd_.rows = fft_stages(rows);
+    simd_.lane = fft_stages(lane);
+    simd_.tw_re.resize(n);
+    simd_.tw_im.resize(n);
+    for (int k1 = 0; k1 < simd_.n1; k1++) {
+      for (int j2 = 0; j2 < lanes; j2++) {
+        double a = -2.0 * pi * ((double)j2 * k1) / n;
+        simd_.tw_re[(size_t)k1 * lanes + j2] = (float)std::cos(a);
+        simd_.tw_im[(size_t)k1 * lanes + j2] = (float)std::sin(a);
+      }
+    }
+    for (int e = 0; e < lanes; e++) {
+      simd_.lane_roots.push_back((float)std::cos(-2.0 * pi * e / lanes));
+      simd_.lane_roots.push_back((float)std::sin(-2.0 * pi * e / lanes));
+    }
+  }
+
+  int size() const { return n_; }
+  bool vectorized() const { return simd_.n != 0; }
+
+  // in and out may be the same array
+  void execute(const cfloat* in, cfloat* out, bool inverse = false) const {
+    if (vectorized() && XR_SIMD_DISPATCH(fft_lanes)() == simd_.lanes) {
+      XR_SIMD_DISPATCH(fft_four_step)(simd_, (const float*)in, (float*)out, inverse, fft_scratch(0, 4 * (size_t)n_));
+      return;
+    }
+    execute_scalar(in, out, inverse);
+  }
+
+ private:
+  void execute_scalar(const cfloat* in, cfloat* out, bool inverse) const {
+    cfloat* x = (cfloat*)fft_scratch(0, 4 * (size_t)n_);
+    cfloat* y = x + n_;
+    // ifft(x) = conj(fft(conj(x)))
+    for (int i = 0; i < n_; i++) x[i] = inverse ? std::conj(in[i]) : in[i];
+    std::vector<cfloat> a, v;
+    for (const FftStage& s : stages_) {
+      const int r = s.radix, ns = s.ns, m = n_ / r, blocks = m / ns;
+      a.resize(r);
+      v.resize(r);
+      for (int k = 0; k < ns; k++) {
+        const cfloat* tw = (const cfloat*)s.tw.data() + (size_t)k * (r - 1);
+        for (int b = 0; b < blocks; b++) {
+          const int j = b * ns + k;
+          a[0] = x[j];
+          for (int q = 1; q < r; q++) a[q] = k ? cmul(x[j + q * m], tw[q - 1]) : x[j + q * m];
+          butterfly(s, a.data(), v.data());
+          cfloat* dst = y + (size_t)b * ns * r + k;
+          for (int q = 0; q < r; q++) dst[q * ns] = v[q];
+        }
+      }
+      std::swap(x, y);
+    }
+    for (int i = 0; i < n_; i++) out[i] = inverse ? std::conj(x[i]) : x[i];
+  }
+
+  static void butterfly(const FftStage& s, const cfloat* a, cfloat* v) {
+    const int r = s.radix;
+    if (r == 2) {
+      v[0] = a[0] + a[1];
+      v[1] = a[0] - a[1];
+    } else if (r == 4) {
+      cfloat t0 = a[0] + a[2], t1 = a[0] - a[2], t2 = a[1] + a[3], d = a[1] - a[3];
+      cfloat t3(d.imag(), -d.real());
+      v[0] = t0 + t2;
+      v[1] = t1 + t3;
+      v[2] = t0 - t2;
+      v[3] = t1 - t3;
+    } else if (r == 3) {
+      cfloat sum = a[1] + a[2], d = (a[1] - a[2]) * 0.86602540378443865f;
+      cfloat m = a[0] - sum * 0.5f, rot(d.imag(), -d.real());
+      v[0] = a[0] + sum;
+      v[1] = m + rot;
+      v[2] = m - rot;
+    } else if (r == 5) {
+      const float c1 = 0.30901699437494742f, c2 = -0.80901699437494742f;
+      const float s1 = 0.95105651629515357f, s2 = 0.58778525229247313f;
+      cfloat b1 = a[1] + a[4], b2 = a[2] + a[3], d1 = a[1] - a[4], d2 = a[2] - a[3];
+      cfloat t1 = a[0] + c1 * b1 + c2 * b2, t2 = a[0] + c2 * b1 + c1 * b2;
+      cfloat e1 = s1 * d1 + s2 * d2, e2 = s2 * d1 - s1 * d2;
+      cfloat u1(e1.imag(), -e1.real()), u2(e2.imag(), -e2.real());
+      v[0] = a[0] + b1 + b2;
+      v[1] = t1 + u1;
+      v[4] = t1 - u1;
+      v[2] = t2 + u2;
+      v[3] = t2 - u2;
+    } else {
+      for (int q = 0; q < r; q++) {
+        cfloat sum = 0.0f;
+        for (int p = 0, e = 0; p < r; p++, e = e + q >= r ? e + q - r : e + q) sum += cmul(a[p], s.roots[e]);
+        v[q] = sum;
+      }
+    }
+  }
+
+  int n_;
+  std::vector<FftStage> stages_;
+  FftSimdPlan simd_;
+};
+
+// Cached plan for the vector width of the current ISA. Plans are immutable, so
+// the reference can be used from any thread.
+inline const FftPlan& fft_plan(int n) {
+  static std::mutex mu;
+  static std::map<std::pair<int, int>, std::unique_ptr<FftPlan>> cache;
+  const int lanes = XR_SIMD_DISPATCH(fft_lanes)();
+  std::lock_guard<std::mutex> lock(mu);
+  std::unique_ptr<FftPlan>& p = cache[{n, lanes}];
+  if (!p) p.reset(new FftPlan(n, lanes));
+  return *p;
+}
+
+inline void fft(const cfloat* in, cfloat* out, int n, bool inverse = false) {
+  if (n > 0) fft_plan(n).execute(in, out, inverse);
+}
+
+// W_n^k for k <= n / 2, cached per n
+inline const std::vector<cfloat>& rfft_twiddles(int n) {
+  static std::mutex mu;
+  static std::map<int, std::vector<cfloat>> cache;
+  std::lock_guard<std::mutex> lock(mu);
+  std::vector<cfloat>& w = cache[n];
+  if (w.empty()) {
+    const double pi = 3.14159265358979323846;
+    for (int k = 0; k <= n / 2; k++) w.emplace_back((float)std::cos(-2.0 * pi * k / n), (float)std::sin(-2.0 * pi * k / n));
+  }
+  return w;
+}
+
+// n real samples -> n / 2 + 1 complex bins. Even n packs the samples into an
+// n / 2 complex transform (z[m] = x[2m] + i x[2m+1]) and untangles the result;
+// in and out must not overlap.
+inline void rfft(const float* in, cfloat* out, int n) {
+  if (n <= 0) return;
+  if (n % 2) {
+    cfloat* tmp = (cfloat*)fft_scratch(1, 2 * (size_t)n);
+    for (int i = 0; i < n; i++) tmp[i] = in[i];
+    fft(tmp, tmp, n);
+    std::copy(tmp, tmp + n / 2 + 1, out);
+    return;
+  }
+  const int m = n / 2;
+  fft(reinterpret_cast<const cfloat*>(in), out, m);
+  const std::vector<cfloat>& w = rfft_twiddles(n);
+  // X[k] = E[k] + W^k O[k] with E = (Z[k] + conj Z[m-k]) / 2, O = (Z[k] - conj Z[m-k]) / 2i
+  for (int k = 0; k <= m / 2; k++) {
+    const int j = m - k;
+    const cfloat zk = out[k], zj = out[j % m];
+    const cfloat dk = zk - std::conj(zj), dj = zj - std::conj(zk);
+    const cfloat ek = 0.5f * (zk + std::conj(zj)), ok(0.5f * dk.imag(), -0.5f * dk.real());
+    const cfloat ej = 0.5f * (zj + std::conj(zk)), oj(0.5f * dj.imag(), -0.5f * dj.real());
+    out[k] = ek + cmul(w[k], ok);
+    out[j] = ej + cmul(w[j], oj);
+  }
+}
+
+// n / 2 + 1 complex bins -> n real samples, scaled by n like ifft
+inline void irfft(const cfloat* in, float* out, int n) {
+  if (n <= 0) return;
+  if (n % 2) {
+    cfloat* tmp = (cfloat*)fft_scratch(1, 2 * (size_t)n);
+    for (int k = 0; k <= n / 2; k++) tmp[k] = in[k];
+    for (int k = n / 2 + 1; k < n; k++) tmp[k] = std::conj(in[n - k]);
+    fft(tmp, tmp, n, true);
+    for (int i = 0; i < n; i++) out[i] = tmp[i].real();
+    return;
+  }
+  const int m = n / 2;
+  cfloat* z = (cfloat*)fft_scratch(1, 2 * (size_t)m);
+  const std::vector<cfloat>& w = rfft_twiddles(n);
+  // inverse of the untangling above, times 2 so the result comes out scaled by n
+  for (int k = 0; k < m; k++) {
+    const cfloat xk = in[k], xj = std::conj(in[m - k]);
+    const cfloat o = cmul(xk - xj, std::conj(w[k]));
+    z[k] = (xk + xj) + cfloat(-o.imag(), o.real());
+  }
+  fft(z, reinterpret_cast<cfloat*>(out), m, true);
+}
+
+// 32 x 32 tiles keep both the rows read and the rows written in L1
+template <typename T>
+inline void transpose_blocked(const T* src, T* dst, int rows, int cols, int threads) {
+  constexpr int B = 32;
+  const int rb = (rows + B - 1) / B, cb = (cols + B - 1) / B;
+#pragma omp parallel for schedule(static) num_threads(threads)
+  for (int t = 0; t < rb * cb; t++) {
+    const int i0 = t / cb * B, j0 = t % cb * B;
+    const int i1 = std::min(rows, i0 + B), j1 = std::min(cols, j0 + B);
+    for (int i = i0; i < i1; i++) {
+      for (int j = j0; j < j1; j++) dst[(size_t)j * rows + i] = src[(size_t)i * cols + j];
+    }
+  }
+}
+
+inline int fft_threads(int threads) {
+#ifdef _OPENMP
+  return threads > 0 ? threads : omp_get_max_threads();
+#else
+  (void)threads;
+  return 1;
+#endif
+}
+
+// the same transform on each of count rows of length n, stride n
+inline void fft_rows_batch(const cfloat* in, cfloat* out, int count, int n, bool inverse, int threads) {
+  const FftPlan& plan = fft_plan(n);
+#pragma omp parallel for schedule(static) num_threads(threads)
+  for (int i = 0; i < count; i++) plan.execute(in + (size_t)i * n, out + (size_t)i * n, inverse);
+}
+
+// h x w complex image, row-major; in and out may be the same array
+inline void fft2d(const cfloat* in, cfloat* out, int h, int w, bool inverse = false, int threads = 0) {
+  if (h <= 0 || w <= 0) return;
+  threads = fft_threads(threads);
+  std::vector<cfloat> t((size_t)h * w);
+  fft_rows_batch(in, out, h, w, inverse, threads);
+  transpose_blocked(out, t.data(), h, w, threads);
+  fft_rows_batch(t.data(), t.data(), w, h, inverse, threads);
+  transpose_blocked(t.data(), out, w, h, threads);
+}
+
+// h x w real image -> h x (w / 2 + 1) complex spectrum
+inline void rfft2d(const float* in, cfloat* out, int h, int w, int threads = 0) {
+  if (h <= 0 || w <= 0) return;
+  threads = fft_threads(threads);
+  const int wc = w / 2 + 1;
+  (void)rfft_twiddles(w);  // build shared state before the threads need it
+  (void)fft_plan(w % 2 ? w : w / 2);
+#pragma omp parallel for schedule(static) num_threads(threads)
+  for (int y = 0; y < h; y++) rfft(in + (size_t)y * w, out + (size_t)y * wc, w);
+  std::vector<cfloat> t((size_t)wc * h);
+  transpose_blocked(out, t.data(), h, wc, threads);
+  fft_rows_batch(t.data(), t.data(), wc, h, false, threads);
+  transpose_blocked(t.data(), out, wc, h, threads);
+}
+
+// h x (w / 2 + 1) spectrum -> h x w real image, scaled by h * w
+inline void irfft2d(const cfloat* in, float* out, int h, int w, int threads = 0) {
+  if (h <= 0 || w <= 0) return;
+  threads = fft_threads(threads);
+  const int wc = w / 2 + 1;
+  std::vector<cfloat> t((size_t)wc * h), rows((size_t)h * wc);
+  transpose_blocked(in, t.data(), h, wc, threads);
+  fft_rows_batch(t.data(), t.data(), wc, h, true, threads);
+  transpose_blocked(t.data(), rows.data(), wc, h, threads);
+  (void)rfft_twiddles(w);
+  (void)fft_plan(w % 2 ? w : w / 2);
+#pragma omp parallel for schedule(static) num_threads(threads)
+  for (int y = 0; y < h; y++) irfft(rows.data() + (size_t)y * wc, out + (size_t)y * w, w);
+}
+
+}  // namespace fft
+}  // namespace xr
@@ -0,0 +1,191 @@
+#pragma once
+
+// Checks the complex, real and 2D FFTs against a naive double DFT on every
+// backend this CPU can run (power-of-two, mixed-radix and prime sizes, plus
+// inverse round trips), then reports GFLOP/s as 5 n log2(n) / t.
+//
+// g++ -O3 -fopenmp -std=c++17 main.cpp -o fft_demo
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "fft.h"
+
+namespace xr {
+namespace fft {
+
+using cdouble = std::complex<double>;
+
+inline std::vector<cdouble> dft_ref(const std::vector<cdouble>& x) {
+  const int n = (int)x.size();
+  const double pi = 3.14159265358979323846;
+  std::vector<cdouble> y(n);
+  for (int k = 0; k < n; k++) {
+    cdouble sum = 0.0;
+    for (int j = 0; j < n; j++) sum += x[j] * std::polar(1.0, -2.0 * pi * (double)((int64_t)j * k % n) / n);
+    y[k] = sum;
+  }
+  return y;
+}
+
+// relative L2 error of got against ref
+template <typename T>
+inline double fft_rel_err(const T* got, const std::vector<cdouble>& ref) {
+  double num = 0.0, den = 0.0;
+  for (size_t i = 0; i < ref.size(); i++) {
+    num += std::norm(cdouble(got[i]) - ref[i]);
+    den += std::norm(ref[i]);
+  }
+  return den > 0.0 ? std::sqrt(num / den) : std::sqrt(num);
+}
+
+inline std::vector<cfloat> fft_random(size_t n, uint32_t seed) {
+  std::vector<cfloat> x(n);
+  for (auto& v : x) {
+    seed = seed * 1664525u + 1013904223u;
+    float re = (float)((int)(seed >> 20) - 2048) / 2048.0f;
+    seed = seed * 1664525u + 1013904223u;
+    v = cfloat(re, (float)((int)(seed >> 20) - 2048) / 2048.0f);
+  }
+  return x;
+}
+
+// worst error over 1D complex, real, and 2D checks on the current backend
+inline double fft_check_all() {
+  double worst = 0.0;
+  const int sizes[] = {1, 2, 3, 4, 5, 7, 8, 12, 15, 16, 64, 100, 125, 128, 176, 243, 256, 360, 1000, 1024, 1536, 4096};
+  for (int n : sizes) {
+    std::vector<cfloat> x = fft_random(n, n), y(n);
+    std::vector<cdouble> xd(x.begin(), x.end());
+    fft(x.data(), y.data(), n);
+    worst = std::max(worst, fft_rel_err(y.data(), dft_ref(xd)));
+    // in place inverse, scaled back by n
+    fft(y.data(), y.data(), n, true);
+    for (auto& v : y) v /= (float)n;
+    worst = std::max(worst, fft_rel_err(y.data(), xd));
+  }
+
+  for (int n : {2, 6, 9, 16, 30, 64, 250, 1000, 2048, 4095}) {
+    std::vector<cfloat> c = fft_random(n, 7 * n);
+    std::vector<float> x(n), back(n);
+    std::vector<cdouble> xd(n);
+    for (int i = 0; i < n; i++) {
+      x[i] = c[i].real();
+      xd[i] = x[i];
+    }
+    std::vector<cdouble> ref = dft_ref(xd);
+    ref.resize(n / 2 + 1);
+    std::vector<cfloat> y(n / 2 + 1);
+    rfft(x.data(), y.data(), n);
+    worst = std::max(worst, fft_rel_err(y.data(), ref));
+    irfft(y.data(), back.data(), n);
+    for (auto& v : back) v /= (float)n;
+    worst = std::max(worst, fft_rel_err(back.data(), xd));
+  }
+
+  const int shapes[][2] = {{8, 8}, {12, 20}, {33, 16}, {64, 48}, {5, 7}};
+  for (const auto& s : shapes) {
+    const int h = s[0], w = s[1];
+    std::vector<cfloat> x = fft_random((size_t)h * w, h * 31 + w), y(x.size());
+    // naive 2D DFT: rows, then columns
+    std::vector<cdouble> ref(x.begin(), x.end());
+    for (int r = 0; r < h; r++) {
+      std::vector<cdouble> row(ref.begin() + (size_t)r * w, ref.begin() + (size_t)(r + 1) * w);
+      row = dft_ref(row);
+      std::copy(row.begin(), row.end(), ref.begin() + (size_t)r * w);
+    }
+    for (int c = 0; c < w; c++) {
+      std::vector<cdouble> col(h);
+      for (int r = 0; r < h; r++) col[r] = ref[(size_t)r * w + c];
+      col = dft_ref(col);
+      for (int r = 0; r < h; r++) ref[(size_t)r * w + c] = col[r];
+    }
+    fft2d(x.data(), y.data(), h, w);
+    worst = std::max(worst, fft_rel_err(y.data(), ref));
+
+    // real input: the left w / 2 + 1 columns of the same transform
+    const int wc = w / 2 + 1;
+    std::vector<float> xr((size_t)h * w), back(xr.size());
+    std::vector<cdouble> xrd(xr.size());
+    for (size_t i = 0; i < xr.size(); i++) {
+      xr[i] = x[i].real();
+      xrd[i] = xr[i];
+    }
+    std::vector<cfloat> full(xr.begin(), xr.end()), spec((size_t)h * wc);
+    fft2d(full.data(), full.data(), h, w);
+    rfft2d(xr.data(), spec.data(), h, w);
+    std::vector<cdouble> half((size_t)h * wc);
+    for (int r = 0; r < h; r++) {
+      for (int c = 0; c < wc; c++) half[(size_t)r * wc + c] = cdouble(full[(size_t)r * w + c]);
+    }
+    worst = std::max(worst, fft_rel_err(spec.data(), half));
+    irfft2d(spec.data(), back.data(), h, w);
+    for (auto& v : back) v /= (float)(h * w);
+    worst = std::max(worst, fft_rel_err(back.data(), xrd));
+  }
+  return worst;
+}
+
+inline double fft_now_ms() {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F>
+inline double fft_time_ms(F&& f) {
+  f();
+  int runs = 0;
+  double t0 = fft_now_ms();
+  do {
+    f();
+    runs++;
+  } while (fft_now_ms() - t0 < 100.0);
+  return (fft_now_ms() - t0) / runs;
+}
+
+}  // namespace fft
+}  // namespace xr
+
+inline int fftMain() {
+  using namespace xr::simd;
+  using namespace xr::fft;
+
+  const Isa all[] = {Isa::kScalar, Isa::kSSE42, Isa::kAVX2, Isa::kAVX512, Isa::kNEON};
+  const Isa initial = current_isa();
+  bool pass = true;
+  for (Isa isa : all) {
+    if (!set_isa(isa)) continue;
+    double worst = fft_check_all();
+    bool ok = worst < 1e-5;
+    pass &= ok;
+    printf("%-7s rel err %.2e %s\n", isa_name(isa), worst, ok ? "ok" : "FAILED");
+  }
+  set_isa(initial);
+
+  // real transforms count as half the work of a complex one of the same size
+  printf("\nGFLOP/s, 5 n log2(n) / t (%s, %d lanes)\n", isa_name(current_isa()), XR_SIMD_DISPATCH_IN(xr::fft, fft_lanes)());
+  printf("%-8s %6s %10s %10s %10s\n", "n", "simd", "complex", "real", "us");
+  const int bench[] = {64, 256, 1024, 4096, 16384, 65536, 1 << 20, 360, 1000, 1536, 3000, 6000, 100000, 1009};
+  for (int n : bench) {
+    std::vector<cfloat> x = fft_random(n, n), y(n), spec(n / 2 + 1);
+    std::vector<float> xr(n);
+    for (int i = 0; i < n; i++) xr[i] = x[i].real();
+    const double flops = 5.0 * n * std::log2((double)n);
+    double c_ms = fft_time_ms([&] { fft(x.data(), y.data(), n); });
+    double r_ms = fft_time_ms([&] { rfft(xr.data(), spec.data(), n); });
+    printf("%-8d %6s %10.2f %10.2f %10.1f\n", n, fft_plan(n).vectorized() ? "yes" : "no", flops * 1e-6 / c_ms,
+           0.5 * flops * 1e-6 / r_ms, c_ms * 1e3);
+  }
+
+  const int h = 1024, w = 1024;
+  std::vector<float> img((size_t)h * w);
+  for (size_t i = 0; i < img.size(); i++) img[i] = (float)(i * 2654435761u % 1000) / 1000.0f;
+  std::vector<cfloat> spec((size_t)h * (w / 2 + 1));
+  double ms = fft_time_ms([&] { rfft2d(img.data(), spec.data(), h, w); });
+  const double flops = 2.5 * h * w * std::log2((double)h * w);
+  printf("rfft2d %dx%d: %.2f ms, %.2f GFLOP/s\n", h, w, ms, flops * 1e-6 / ms);
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
@@ -0,0 +1,203 @@
+// FFT kernels, expanded per backend by xr_simd_foreach.h from fft.h.
+//
+// Complex data is split into a real and an imaginary array whose "rows" are
+// one vector of V = vf32::N lanes each. fft_rows runs the same Stockham
+// transform down the rows of all V lanes at once, so every butterfly is fully
+// vectorized and the twiddles are broadcasts. fft_four_step builds a size-n
+// transform out of that (n = n1 * V):
+//   1. V interleaved transforms of length n1 (lane j2 holds x[j1 * V + j2])
+//   2. multiply row k1, lane j2 by the twiddle W_n^(j2 * k1)
+//   3. length-V transforms across the lanes: transpose V x V blocks so lanes
+//      become rows, run fft_rows again, and store X[k1 + n1 * k2]
+
+inline int fft_lanes() { return vf32::N; }
+
+struct FftVec {
+  vf32 re, im;
+};
+
+inline FftVec fft_add(FftVec a, FftVec b) { return {add(a.re, b.re), add(a.im, b.im)}; }
+inline FftVec fft_sub(FftVec a, FftVec b) { return {sub(a.re, b.re), sub(a.im, b.im)}; }
+inline FftVec fft_scale(FftVec a, vf32 s) { return {mul(a.re, s), mul(a.im, s)}; }
+inline FftVec fft_cmul(FftVec a, vf32 wr, vf32 wi) {
+  return {sub(mul(a.re, wr), mul(a.im, wi)), fma(a.re, wi, mul(a.im, wr))};
+}
+// -i * a
+inline FftVec fft_mul_neg_i(FftVec a) { return {a.im, sub(zero_f32(), a.re)}; }
+
+// forward butterflies (sign -1), in place on a[0..r)
+inline void fft_butterfly2(FftVec* a) {
+  FftVec t = a[0];
+  a[0] = fft_add(t, a[1]);
+  a[1] = fft_sub(t, a[1]);
+}
+
+inline void fft_butterfly3(FftVec* a) {
+  const vf32 half = set1_f32(0.5f), s3 = set1_f32(0.86602540378443865f);
+  FftVec s = fft_add(a[1], a[2]);
+  FftVec d = fft_mul_neg_i(fft_scale(fft_sub(a[1], a[2]), s3));
+  FftVec m = fft_sub(a[0], fft_scale(s, half));
+  a[0] = fft_add(a[0], s);
+  a[1] = fft_add(m, d);
+  a[2] = fft_sub(m, d);
+}
+
+inline void fft_butterfly4(FftVec* a) {
+  FftVec t0 = fft_add(a[0], a[2]), t1 = fft_sub(a[0], a[2]);
+  FftVec t2 = fft_add(a[1], a[3]), t3 = fft_mul_neg_i(fft_sub(a[1], a[3]));
+  a[0] = fft_add(t0, t2);
+  a[1] = fft_add(t1, t3);
+  a[2] = fft_sub(t0, t2);
+  a[3] = fft_sub(t1, t3);
+}
+
+inline void fft_butterfly5(FftVec* a) {
+  const vf32 c1 = set1_f32(0.30901699437494742f), c2 = set1_f32(-0.80901699437494742f);
+  const vf32 s1 = set1_f32(0.95105651629515357f), s2 = set1_f32(0.58778525229247313f);
+  FftVec b1 = fft_add(a[1], a[4]), b2 = fft_add(a[2], a[3]);
+  FftVec d1 = fft_sub(a[1], a[4]), d2 = fft_sub(a[2], a[3]);
+  FftVec t1 = {fma(b2.re, c2, fma(b1.re, c1, a[0].re)), fma(b2.im, c2, fma(b1.im, c1, a[0].im))};
+  FftVec t2 = {fma(b2.re, c1, fma(b1.re, c2, a[0].re)), fma(b2.im, c1, fma(b1.im, c2, a[0].im))};
+  FftVec u1 = fft_mul_neg_i({fma(d2.re, s2, mul(d1.re, s1)), fma(d2.im, s2, mul(d1.im, s1))});
+  FftVec u2 = fft_mul_neg_i({sub(mul(d1.re, s2), mul(d2.re, s1)), sub(mul(d1.im, s2), mul(d2.im, s1))});
+  a[0] = fft_add(a[0], fft_add(b1, b2));
+  a[1] = fft_add(t1, u1);
+  a[4] = fft_sub(t1, u1);
+  a[2] = fft_add(t2, u2);
+  a[3] = fft_sub(t2, u2);
+}
+
+// Stockham autosort over len rows: each stage reads row j + q * len / r and
+// writes row (j / ns) * ns * r + j % ns + q * ns, so no bit reversal is
+// needed. Buffers are 64-byte aligned. Returns 1 when the result ended up in
+// (re2, im2), 0 for (re, im).
+inline int fft_rows(const FftStage* stages, int count, int len, float* re, float* im, float* re2, float* im2) {
+  constexpr int V = vf32::N;
+  float *xr = re, *xi = im, *yr = re2, *yi = im2;
+  for (int s = 0; s < count; s++) {
+    const int r = stages[s].radix, ns = stages[s].ns;
+    const int m = len / r, blocks = m / ns;
+    const float* tw = stages[s].tw.data();
+    for (int k = 0; k < ns; k++) {
+      vf32 wr[4], wi[4];
+      for (int q = 1; q < r; q++) {
+        wr[q - 1] = set1_f32(tw[(k * (r - 1) + q - 1) * 2]);
+        wi[q - 1] = set1_f32(tw[(k * (r - 1) + q - 1) * 2 + 1]);
+      }
+      for (int b = 0; b < blocks; b++) {
+        const int j = b * ns + k;
+        FftVec a[5];
+        for (int q = 0; q < r; q++) {
+          const ptrdiff_t row = (ptrdiff_t)(j + q * m) * V;
+          a[q] = {load(xr + row), load(xi + row)};
+          if (q > 0 && k > 0) a[q] = fft_cmul(a[q], wr[q - 1], wi[q - 1]);
+        }
+        switch (r) {
+          case 2: fft_butterfly2(a); break;
+          case 3: fft_butterfly3(a); break;
+          case 4: fft_butterfly4(a); break;
+          default: fft_butterfly5(a); break;
+        }
+        const int out = b * ns * r + k;
+        for (int q = 0; q < r; q++) {
+          const ptrdiff_t row = (ptrdiff_t)(out + q * ns) * V;
+          store(yr + row, a[q].re);
+          store(yi + row, a[q].im);
+        }
+      }
+    }
+    std::swap(xr, yr);
+    std::swap(xi, yi);
+  }
+  return count % 2;
+}
+
+// V x V transpose of rows by log2(V) rounds of perfect shuffles
+inline void fft_transpose(vf32* rows) {
+  constexpr int V = vf32::N;
+  vf32 t[V];
+  for (int round = V; round > 1; round /= 2) {
+    for (int i = 0; i < V / 2; i++) {
+      t[2 * i] = zip_lo(rows[i], rows[i + V / 2]);
+      t[2 * i + 1] = zip_hi(rows[i], rows[i + V / 2]);
+    }
+    for (int i = 0; i < V; i++) rows[i] = t[i];
+  }
+}
+
+// in and out are interleaved complex (may alias). work holds 4 * n floats,
+// 64-byte aligned. The inverse transform swaps real and imaginary parts on the
+// way in and out: ifft(x) = swap(fft(swap(x))), unnormalized.
+inline void fft_four_step(const FftSimdPlan& p, const float* in, float* out, bool inverse, float* work) {
+  constexpr int V = vf32::N;
+  const int n = p.n, n1 = p.n1;
+  float* ar = work;
+  float* ai = work + n;
+  float* br = work + 2 * n;
+  float* bi = work + 3 * n;
+  for (int j1 = 0; j1 < n1; j1++) {
+    vf32 lo = loadu(in + (ptrdiff_t)j1 * 2 * V), hi = loadu(in + (ptrdiff_t)j1 * 2 * V + V);
+    store(ar + (ptrdiff_t)j1 * V, unzip_even(lo, hi));
+    store(ai + (ptrdiff_t)j1 * V, unzip_odd(lo, hi));
+  }
+  if (inverse) {
+    std::swap(ar, ai);
+    std::swap(br, bi);
+  }
+
+  // 1. length-n1 transforms, one per lane
+  if (fft_rows(p.rows.data(), (int)p.rows.size(), n1, ar, ai, br, bi)) {
+    std::swap(ar, br);
+    std::swap(ai, bi);
+  }
+
+  // 2 + 3, V rows at a time; the result goes straight to out
+  alignas(64) float tr[V * V], ti[V * V], tr2[V * V], ti2[V * V];
+  const int full = n1 / V * V;
+  for (int k0 = 0; k0 < full; k0 += V) {
+    vf32 rr[V], ri[V];
+    for (int t = 0; t < V; t++) {
+      const ptrdiff_t row = (ptrdiff_t)(k0 + t) * V;
+      FftVec c = fft_cmul({load(ar + row), load(ai + row)}, loadu(p.tw_re.data() + row), loadu(p.tw_im.data() + row));
+      rr[t] = c.re;
+      ri[t] = c.im;
+    }
+    fft_transpose(rr);
+    fft_transpose(ri);
+    for (int t = 0; t < V; t++) {
+      store(tr + t * V, rr[t]);
+      store(ti + t * V, ri[t]);
+    }
+    const bool second = fft_rows(p.lane.data(), (int)p.lane.size(), V, tr, ti, tr2, ti2);
+    const float* xr = second ? tr2 : tr;
+    const float* xi = second ? ti2 : ti;
+    for (int k2 = 0; k2 < V; k2++) {
+      vf32 re = load(xr + k2 * V), im = load(xi + k2 * V);
+      if (inverse) std::swap(re, im);
+      float* dst = out + ((ptrdiff_t)k0 + (ptrdiff_t)n1 * k2) * 2;
+      storeu(dst, zip_lo(re, im));
+      storeu(dst + V, zip_hi(re, im));
+    }
+  }
+  // rows left over when V does not divide n1: twiddle, then a direct V-point
+  // DFT across the lanes
+  for (int k1 = full; k1 < n1; k1++) {
+    alignas(64) float cr[V], ci[V];
+    const ptrdiff_t row = (ptrdiff_t)k1 * V;
+    FftVec c = fft_cmul({load(ar + row), load(ai + row)}, loadu(p.tw_re.data() + row), loadu(p.tw_im.data() + row));
+    store(cr, c.re);
+    store(ci, c.im);
+    for (int k2 = 0; k2 < V; k2++) {
+      float sr = 0.0f, si = 0.0f;
+      for (int j2 = 0; j2 < V; j2++) {
+        const int e = (j2 * k2) % V;
+        const float wr = p.lane_roots[2 * e], wi = p.lane_roots[2 * e + 1];
+        sr += cr[j2] * wr - ci[j2] * wi;
+        si += cr[j2] * wi + ci[j2] * wr;
+      }
+      float* dst = out + ((ptrdiff_t)k1 + (ptrdiff_t)n1 * k2) * 2;
+      dst[0] = inverse ? si : sr;
+      dst[1] = inverse ? sr : si;
+    }
+  }
+}
@@ -0,0 +1,559 @@
+#pragma once
+
+// Sparse pyramidal Lucas-Kanade optical flow on the host, with the parameters
+// and status semantics of the device call in DSP/MTK
+// (mtkapi_calcopticalflowpyrlk_u8f32_with_search_range): window size,
+// max_level, criteria_cnt iterations and criteria_eps, status 1 for a tracked
+// point and 0 for a lost one. The per-point math follows OpenCV's
+// LKTrackerInvoker, so results can be compared with cv::calcOpticalFlowPyrLK.
+//
+//   - FlowPyramid keeps every level padded on all sides (reflect101 for the
+//     image, zeros for the derivatives), so the window loops read without
+//     bounds checks even for points on or just outside the frame
+//   - Scharr derivatives of the previous frame are computed once per level
+//     and reused by every point and every iteration
+//   - patches are sampled bilinearly with 14-bit fixed-point weights on whole
+//     vector rows of int32 (flow_kernels.inl); the image patch carries 5
+//     fractional bits, the gradients none
+//   - points are spread over OpenMP threads; every point walks all levels
+//     on its own, so there is no barrier between levels
+//
+// calc_optical_flow_pyr_lk_ref is a plain scalar version of the same math
+// with explicit border handling, used to check the vector kernels. Point
+// coordinates are interleaved (x, y) floats. Every step argument is in bytes.
+// Functions return false for arguments they do not support.
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../../openMP/omp_image.h"
+#include "../xr_simd.h"
+
+namespace xr {
+namespace flow {
+
+struct LkParams {
+  int win_width = 21;
+  int win_height = 21;
+  int max_level = 3;  // 0 tracks on the full-resolution frame only
+  int criteria_cnt = 20;
+  float criteria_eps = 0.01f;        // stop once the update is shorter than this, in pixels
+  float min_eig_threshold = 1e-4f;   // smallest eigenvalue of the normalized 2x2 gradient matrix
+  bool use_initial_flow = false;     // next_pts holds the starting guesses
+};
+
+// One pyramid level as the kernels see it: pointers to pixel (0, 0) of padded
+// buffers (FlowPyramid::border_x / border_y readable on every side).
+struct LkLevel {
+  const uint8_t* img;
+  const int16_t* dx;  // null for a level without derivatives
+  const int16_t* dy;
+  ptrdiff_t step;   // bytes between image rows
+  ptrdiff_t dstep;  // elements between derivative rows
+  int width, height;
+};
+
+struct LkCriteria {
+  int win_width, win_height;
+  int max_count;
+  float eps2;  // criteria_eps squared
+  float min_eig;
+};
+
+// widest vector of any backend, in int32 lanes; the patch rows are rounded up
+// to it
+constexpr int kLkMaxLanes = 16;
+
+#define XR_SIMD_KERNELS "flow/flow_kernels.inl"
+#include "../xr_simd_foreach.h"
+
+// Number of pyramid levels above the base actually used: max_level, cut where
+// a level would be no larger than the window.
+inline int flow_levels(int width, int height, const LkParams& p) {
+  int levels = 0;
+  while (levels < p.max_level) {
+    width = (width + 1) / 2;
+    height = (height + 1) / 2;
+    if (width <= p.win_width || height <= p.win_height) break;
+    levels++;
+  }
+  return levels;
+}
+
+// Level padding for params' window. Left / top: a window starting win pixels
+// out; right / bottom: the window, one bilinear neighbour and the kernels'
+// whole-vector over-read.
+inline int flow_border_x(const LkParams& params) { return params.win_width + kLkMaxLanes * 4 + kLkMaxLanes + 1; }
+inline int flow_border_y(const LkParams& params) { return params.win_height + 1; }
+
+// Bytes of the levels of a width x height frame's pyramid, with or without
+// derivatives, and of the half-size image each level is staged in while
+// building: the scratch the caller-memory build_flow_pyramid needs, and the
+// sizes for xr::scratch plans.
+inline size_t flow_pyramid_bytes(int width, int height, const LkParams& params, bool derivs) {
+  const int bx = flow_border_x(params), by = flow_border_y(params);
+  const int levels = flow_levels(width, height, params) + 1;
+  size_t bytes = 0;
+  for (int i = 0; i < levels; i++) {
+    if (i > 0) {
+      width = (width + 1) / 2;
+      height = (height + 1) / 2;
+    }
+    const size_t size = (size_t)(width + 2 * bx) * (height + 2 * by);
+    bytes += derivs ? size * (1 + 2 * sizeof(int16_t)) : size;
+  }
+  return bytes;
+}
+
+inline size_t flow_pyramid_staging_bytes(int width, int height, const LkParams& params) {
+  return flow_levels(width, height, params) > 0 ? (size_t)((width + 1) / 2) * ((height + 1) / 2) : 0;
+}
+
+// One frame's pyramid, padded for a given window. Build it once per frame;
+// only the frame points are tracked from needs derivatives. The levels point
+// into storage, or into the caller's scratch when it was built there.
+struct FlowPyramid {
+  struct Level {
+    int width = 0, height = 0;
+    ptrdiff_t step = 0;  // bytes for img, elements for dx / dy
+    uint8_t* img = nullptr;
+    int16_t *dx = nullptr, *dy = nullptr;  // null without derivatives
+  };
+
+  int win_width = 0, win_height = 0;
+  int border_x = 0, border_y = 0;
+  std::vector<Level> levels;
+  std::vector<uint8_t> storage;
+
+  FlowPyramid() = default;
+  FlowPyramid(const FlowPyramid&) = delete;
+  FlowPyramid& operator=(const FlowPyramid&) = delete;
+
+  bool has_derivs() const { return !levels.empty() && levels[0].dx != nullptr; }
+
+  LkLevel view(int level) const {
+    const Level& l = levels[level];
+    const ptrdiff_t origin = border_y * l.step + border_x;
+    LkLevel v;
+    v.img = l.img + origin;
+    v.dx = l.dx ? l.dx + origin : nullptr;
+    v.dy = l.dy ? l.dy + origin : nullptr;
+    v.step = l.step;
+    v.dstep = l.step;
+    v.width = l.width;
+    v.height = l.height;
+    return v;
+  }
+};
+
+// Copies a width x height image into the middle of a padded level and fills
+// the border with reflect101, the border the derivatives assume.
+inline void flow_pad_level(const uint8_t* src, ptrdiff_t src_step, FlowPyramid::Level& l, int bx, int by) {
+  uint8_t* base = l.img;
+  const int w = l.width, h = l.height;
+  for (int y = -by; y < h + by; y++) {
+    const uint8_t* s = src + xr::omp::reflect101(y, h) * src_step;
+    uint8_t* d = base + (y + by) * l.step + bx;
+    std::memcpy(d, s, w);
+    for (int x = 1; x <= bx; x++) {
+      d[-x] = s[xr::omp::reflect101(-x, w)];
+      d[w - 1 + x] = s[xr::omp::reflect101(w - 1 + x, w)];
+    }
+  }
+}
+
+// Builds the pyramid of one frame for params' window and level count, with
+// Scharr derivatives of every level when derivs is set, in caller memory: the
+// levels in scratch (flow_pyramid_bytes, aligned for int16_t), which pyr
+// points into afterwards, and the half-size staging image in staging
+// (flow_pyramid_staging_bytes, only used during the call). threads <= 0 uses
+// every OpenMP thread.
+inline bool build_flow_pyramid(const uint8_t* img, int step, int width, int height, const LkParams& params,
+                               bool derivs, FlowPyramid& pyr, void* scratch, size_t scratch_bytes, void* staging,
+                               size_t staging_bytes, int threads = 0) {
+  if (!img || width < 1 || height < 1 || step < width) return false;
+  if (params.win_width < 3 || params.win_height < 3 || params.max_level < 0) return false;
+  if (!scratch || (uintptr_t)scratch % alignof(int16_t) != 0) return false;
+  if (scratch_bytes < flow_pyramid_bytes(width, height, params, derivs)) return false;
+  const size_t half_bytes = flow_pyramid_staging_bytes(width, height, params);
+  if (staging_bytes < half_bytes || (half_bytes > 0 && !staging)) return false;
+#ifdef _OPENMP
+  if (threads <= 0) threads = omp_get_max_threads();
+#else
+  threads = 1;
+#endif
+
+  const int bx = flow_border_x(params), by = flow_border_y(params);
+  pyr.win_width = params.win_width;
+  pyr.win_height = params.win_height;
+  pyr.border_x = bx;
+  pyr.border_y = by;
+  const int levels = flow_levels(width, height, params) + 1;
+  pyr.levels.resize(levels);
+
+  // every level's derivatives first, so they stay aligned whatever the image
+  // sizes, then the images
+  uint8_t* mem = static_cast<uint8_t*>(scratch);
+  for (int i = 0; i < levels; i++) {
+    FlowPyramid::Level& l = pyr.levels[i];
+    l.width = i > 0 ? (pyr.levels[i - 1].width + 1) / 2 : width;
+    l.height = i > 0 ? (pyr.levels[i - 1].height + 1) / 2 : height;
+    l.step = l.width + 2 * bx;
+    const size_t size = (size_t)l.step * (l.height + 2 * by);
+    l.dx = l.dy = nullptr;
+    if (derivs) {
+      l.dx = reinterpret_cast<int16_t*>(mem);
+      l.dy = l.dx + size;
+      mem += 2 * size * sizeof(int16_t);
+    }
+  }
+  for (FlowPyramid::Level& l : pyr.levels) {
+    l.img = mem;
+    mem += (size_t)l.step * (l.height + 2 * by);
+  }
+
+  xr::omp::OmpConfig cfg;
+  cfg.threads = threads;
+  uint8_t* half = static_cast<uint8_t*>(staging);
+  const uint8_t* src = img;
+  ptrdiff_t src_step = step;
+  auto scharr = XR_SIMD_DISPATCH(scharr_rows);
+  for (int i = 0; i < levels; i++) {
+    FlowPyramid::Level& l = pyr.levels[i];
+    if (i > 0) {
+      const FlowPyramid::Level& up = pyr.levels[i - 1];
+      xr::omp::pyr_down(up.img + by * up.step + bx, (int)up.step, up.width, up.height, half, l.width, cfg);
+      src = half;
+      src_step = l.width;
+    }
+    flow_pad_level(src, src_step, l, bx, by);
+    if (!derivs) continue;
+
+    const size_t size = (size_t)l.step * (l.height + 2 * by);
+    std::memset(l.dx, 0, size * sizeof(int16_t));
+    std::memset(l.dy, 0, size * sizeof(int16_t));
+    const ptrdiff_t origin = by * l.step + bx;
+    const int bands = std::max(1, std::min(threads * 4, l.height / 16));
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (int b = 0; b < bands; b++) {
+      const int y0 = (int)((int64_t)l.height * b / bands), y1 = (int)((int64_t)l.height * (b + 1) / bands);
+      scharr(l.img + origin, l.step, l.dx + origin, l.dy + origin, l.step, l.width, y0, y1);
+    }
+  }
+  return true;
+}
+
+// The same with the levels in pyr.storage, which is kept across calls.
+inline bool build_flow_pyramid(const uint8_t* img, int step, int width, int height, const LkParams& params,
+                               bool derivs, FlowPyramid& pyr, int threads = 0) {
+  if (!img || width < 1 || height < 1 || step < width) return false;
+  if (params.win_width < 3 || params.win_height < 3 || params.max_level < 0) return false;
+  pyr.storage.resize(flow_pyramid_bytes(width, height, params, derivs));
+  // reused across calls, so a stream of frames does not fault in a fresh
+  // half-size image every time
+  thread_local std::vector<uint8_t> half;
+  half.resize(flow_pyramid_staging_bytes(width, height, params));
+  return build_flow_pyramid(img, step, width, height, params, derivs, pyr, pyr.storage.data(), pyr.storage.size(),
+                            half.data(), half.size(), threads);
+}
+
+// bytes of one thread's patch buffers for params' window (image, dx, dy; rows
+// rounded up to kLkMaxLanes)
+inline size_t flow_patch_bytes(const LkParams& params) {
+  return (size_t)3 * params.win_height * (params.win_width + kLkMaxLanes) * sizeof(int32_t);
+}
+
+// per-thread int32 patch buffers for one window (image, dx, dy)
+inline int32_t* flow_scratch(size_t n) {
+  thread_local std::vector<int32_t> buf;
+  if (buf.size() < n) buf.resize(n);
+  return buf.data();
+}
+
+// Body of both calc_optical_flow_pyr_lk on pyramids: thread t's patch buffers
+// are patches + t * flow_patch_bytes, or its flow_scratch when patches is null.
+inline bool flow_track_points(const FlowPyramid& prev, const FlowPyramid& next, const float* prev_pts, int count,
+                              float* next_pts, uint8_t* status, const LkParams& params, int threads,
+                              int32_t* patches) {
+  if (count < 0 || (count > 0 && (!prev_pts || !next_pts || !status))) return false;
+  if (!prev.has_derivs() || prev.levels.size() != next.levels.size()) return false;
+  if (prev.win_width != params.win_width || prev.win_height != params.win_height) return false;
+  if (next.win_width != params.win_width || next.win_height != params.win_height) return false;
+  if (prev.levels[0].width != next.levels[0].width || prev.levels[0].height != next.levels[0].height) return false;
+  if (params.criteria_cnt < 1) return false;
+#ifdef _OPENMP
+  if (threads <= 0) threads = omp_get_max_threads();
+#else
+  (void)threads;
+#endif
+
+  LkCriteria c;
+  c.win_width = params.win_width;
+  c.win_height = params.win_height;
+  c.max_count = params.criteria_cnt;
+  c.eps2 = params.criteria_eps * params.criteria_eps;
+  c.min_eig = params.min_eig_threshold;
+  const int levels = (int)prev.levels.size();
+  const size_t patch = flow_patch_bytes(params) / sizeof(int32_t);
+  auto refine = XR_SIMD_DISPATCH(lk_refine);
+
+  // a few points per grab: the cost per point varies a lot (lost points stop
+  // at once, slow ones run every iteration on every level)
+#pragma omp parallel for schedule(dynamic, 8) num_threads(threads)
+  for (int i = 0; i < count; i++) {
+#ifdef _OPENMP
+    int32_t* scratch = patches ? patches + (size_t)omp_get_thread_num() * patch : flow_scratch(patch);
+#else
+    int32_t* scratch = patches ? patches : flow_scratch(patch);
+#endif
+    const float scale = 1.0f / (float)(1 << (levels - 1));
+    float nx, ny;
+    if (params.use_initial_flow) {
+      nx = next_pts[2 * i] * scale;
+      ny = next_pts[2 * i + 1] * scale;
+    } else {
+      nx = prev_pts[2 * i] * scale;
+      ny = prev_pts[2 * i + 1] * scale;
+    }
+    uint8_t st = 1;
+    for (int level = levels - 1; level >= 0; level--) {
+      const float s = 1.0f / (float)(1 << level);
+      if (!refine(prev.view(level), next.view(level), c, prev_pts[2 * i] * s, prev_pts[2 * i + 1] * s, &nx, &ny,
+                  scratch) &&
+          level == 0) {
+        st = 0;
+      }
+      if (level > 0) {
+        nx *= 2.0f;
+        ny *= 2.0f;
+      }
+    }
+    next_pts[2 * i] = nx;
+    next_pts[2 * i + 1] = ny;
+    status[i] = st;
+  }
+  return true;
+}
+
+// Tracks count points from prev to next. prev must have derivatives, and both
+// pyramids must have been built for params' window with the same level count.
+// status[i] is 1 when point i was tracked and 0 when it was lost: its window
+// left the frame, or the gradient matrix was too flat to solve (min_eig).
+inline bool calc_optical_flow_pyr_lk(const FlowPyramid& prev, const FlowPyramid& next, const float* prev_pts,
+                                     int count, float* next_pts, uint8_t* status, const LkParams& params,
+                                     int threads = 0) {
+  return flow_track_points(prev, next, prev_pts, count, next_pts, status, params, threads, nullptr);
+}
+
+// The same with the patch buffers in caller memory: scratch holds threads *
+// flow_patch_bytes, aligned for int32_t (threads <= 0: every OpenMP thread).
+inline bool calc_optical_flow_pyr_lk(const FlowPyramid& prev, const FlowPyramid& next, const float* prev_pts,
+                                     int count, float* next_pts, uint8_t* status, const LkParams& params,
+                                     void* scratch, size_t scratch_bytes, int threads = 0) {
+#ifdef _OPENMP
+  if (threads <= 0) threads = omp_get_max_threads();
+#else
+  threads = 1;
+#endif
+  if (!scratch || (uintptr_t)scratch % alignof(int32_t) != 0) return false;
+  if (scratch_bytes < (size_t)threads * flow_patch_bytes(params)) return false;
+  return flow_track_points(prev, next, prev_pts, count, next_pts, status, params, threads,
+                           static_cast<int32_t*>(scratch));
+}
+
+// One-shot form on two frames of the same size: builds both pyramids and
+// tracks. The pyramids are kept per calling thread, so repeated calls reuse
+// their buffers instead of page-faulting new ones (about 10 ms at 1080p). A
+// stream should keep its own pyramids instead: the next frame's becomes the
+// previous one, built with derivatives.
+inline bool calc_optical_flow_pyr_lk(const uint8_t* prev_img, const uint8_t* next_img, int step, int width,
+                                     int height, const float* prev_pts, int count, float* next_pts, uint8_t* status,
+                                     const LkParams& params, int threads = 0) {
+  thread_local FlowPyramid prev, next;
+  if (!build_flow_pyramid(prev_img, step, width, height, params, true, prev, threads)) return false;
+  if (!build_flow_pyramid(next_img, step, width, height, params, false, next, threads)) return false;
+  return calc_optical_flow_pyr_lk(prev, next, prev_pts, count, next_pts, status, params, threads);
+}
+
+// ---------------------------------------------------------------------------
+// Scalar reference
+
+struct FlowRefLevel {
+  int width, height;
+  std::vector<uint8_t> img;    // width x height, no padding
+  std::vector<int16_t> dx, dy;
+
+  // image outside the frame is reflect101, derivatives outside are 0
+  int pixel(int x, int y) const {
+    return img[(size_t)xr::omp::reflect101(y, height) * width + xr::omp::reflect101(x, width)];
+  }
+  int deriv(const std::vector<int16_t>& d, int x, int y) const {
+    return x < 0 || y < 0 || x >= width || y >= height ? 0 : d[(size_t)y * width + x];
+  }
+};
+
+inline void scharr_ref(FlowRefLevel& l) {
+  l.dx.resize((size_t)l.width * l.height);
+  l.dy.resize(l.dx.size());
+  for (int y = 0; y < l.height; y++) {
+    for (int x = 0; x < l.width; x++) {
+      const int gx = 3 * (l.pixel(x + 1, y - 1) - l.pixel(x - 1, y - 1) + l.pixel(x + 1, y + 1) - l.pixel(x - 1, y + 1)) +
+                     10 * (l.pixel(x + 1, y) - l.pixel(x - 1, y));
+      const int gy = 3 * (l.pixel(x - 1, y + 1) - l.pixel(x - 1, y - 1) + l.pixel(x + 1, y + 1) - l.pixel(x + 1, y - 1)) +
+                     10 * (l.pixel(x, y + 1) - l.pixel(x, y - 1));
+      l.dx[(size_t)y * l.width + x] = (int16_t)gx;
+      l.dy[(size_t)y * l.width + x] = (int16_t)gy;
+    }
+  }
+}
+
+inline std::vector<FlowRefLevel> flow_pyramid_ref(const uint8_t* img, int step, int width, int height,
+                                                  const LkParams& p) {
+  std::vector<FlowRefLevel> pyr(flow_levels(width, height, p) + 1);
+  pyr[0].width = width;
+  pyr[0].height = height;
+  pyr[0].img.resize((size_t)width * height);
+  for (int y = 0; y < height; y++) std::memcpy(&pyr[0].img[(size_t)y * width], img + (size_t)y * step, width);
+  for (size_t i = 1; i < pyr.size(); i++) {
+    const FlowRefLevel& up = pyr[i - 1];
+    pyr[i].width = (up.width + 1) / 2;
+    pyr[i].height = (up.height + 1) / 2;
+    pyr[i].img.resize((size_t)pyr[i].width * pyr[i].height);
+    xr::omp::pyr_down_ref(up.img.data(), up.width, up.width, up.height, pyr[i].img.data(), pyr[i].width);
+  }
+  return pyr;
+}
+
+// one level of one point; false when the point is lost on this level
+inline bool lk_refine_ref(const FlowRefLevel& I, const FlowRefLevel& J, const LkParams& p, float prev_x,
+                          float prev_y, float* next_x, float* next_y) {
+  constexpr int kBits = 14;
+  constexpr float kScale = 1.0f / (1 << 20);
+  const int ww = p.win_width, wh = p.win_height;
+  const float half_w = (ww - 1) * 0.5f, half_h = (wh - 1) * 0.5f;
+  const float px = prev_x - half_w, py = prev_y - half_h;
+  const int ix = (int)std::floor(px), iy = (int)std::floor(py);
+  if (ix < -ww || ix >= I.width || iy < -wh || iy >= I.height) return false;
+
+  auto weights = [](float a, float b, int w[4]) {
+    w[0] = (int)std::nearbyint((1.0f - a) * (1.0f - b) * (1 << kBits));
+    w[1] = (int)std::nearbyint(a * (1.0f - b) * (1 << kBits));
+    w[2] = (int)std::nearbyint((1.0f - a) * b * (1 << kBits));
+    w[3] = (1 << kBits) - w[0] - w[1] - w[2];
+  };
+  int w[4];
+  weights(px - ix, py - iy, w);
+
+  std::vector<int> pi((size_t)ww * wh), pdx(pi.size()), pdy(pi.size());
+  float a11 = 0.0f, a12 = 0.0f, a22 = 0.0f;
+  for (int y = 0; y < wh; y++) {
+    for (int x = 0; x < ww; x++) {
+      const int sx = ix + x, sy = iy + y;
+      const int v = I.pixel(sx, sy) * w[0] + I.pixel(sx + 1, sy) * w[1] + I.pixel(sx, sy + 1) * w[2] +
+                    I.pixel(sx + 1, sy + 1) * w[3];
+      const int gx = I.deriv(I.dx, sx, sy) * w[0] + I.deriv(I.dx, sx + 1, sy) * w[1] +
+                     I.deriv(I.dx, sx, sy + 1) * w[2] + I.deriv(I.dx, sx + 1, sy + 1) * w[3];
+      const int gy = I.deriv(I.dy, sx, sy) * w[0] + I.deriv(I.dy, sx + 1, sy) * w[1] +
+                     I.deriv(I.dy, sx, sy + 1) * w[2] + I.deriv(I.dy, sx + 1, sy + 1) * w[3];
+      const size_t k = (size_t)y * ww + x;
+      pi[k] = (v + (1 << (kBits - 6))) >> (kBits - 5);
+      pdx[k] = (gx + (1 << (kBits - 1))) >> kBits;
+      pdy[k] = (gy + (1 << (kBits - 1))) >> kBits;
+      a11 += (float)(pdx[k] * pdx[k]);
+      a12 += (float)(pdx[k] * pdy[k]);
+      a22 += (float)(pdy[k] * pdy[k]);
+    }
+  }
+  a11 *= kScale;
+  a12 *= kScale;
+  a22 *= kScale;
+  float det = a11 * a22 - a12 * a12;
+  const float min_eig =
+      (a22 + a11 - std::sqrt((a11 - a22) * (a11 - a22) + 4.0f * a12 * a12)) / (float)(2 * ww * wh);
+  if (min_eig < p.min_eig_threshold || det < FLT_EPSILON) return false;
+  det = 1.0f / det;
+
+  float nx = *next_x - half_w, ny = *next_y - half_h;
+  float prev_dx = 0.0f, prev_dy = 0.0f;
+  bool tracked = true;
+  for (int j = 0; j < p.criteria_cnt; j++) {
+    const int jx = (int)std::floor(nx), jy = (int)std::floor(ny);
+    if (jx < -ww || jx >= J.width || jy < -wh || jy >= J.height) {
+      tracked = false;
+      break;
+    }
+    weights(nx - jx, ny - jy, w);
+    float b1 = 0.0f, b2 = 0.0f;
+    for (int y = 0; y < wh; y++) {
+      for (int x = 0; x < ww; x++) {
+        const int sx = jx + x, sy = jy + y;
+        const int v = J.pixel(sx, sy) * w[0] + J.pixel(sx + 1, sy) * w[1] + J.pixel(sx, sy + 1) * w[2] +
+                      J.pixel(sx + 1, sy + 1) * w[3];
+        const size_t k = (size_t)y * ww + x;
+        const int diff = ((v + (1 << (kBits - 6))) >> (kBits - 5)) - pi[k];
+        b1 += (float)(diff * pdx[k]);
+        b2 += (float)(diff * pdy[k]);
+      }
+    }
+    b1 *= kScale;
+    b2 *= kScale;
+    const float dx = (a12 * b2 - a22 * b1) * det, dy = (a12 * b1 - a11 * b2) * det;
+    nx += dx;
+    ny += dy;
+    if (dx * dx + dy * dy <= p.criteria_eps * p.criteria_eps) break;
+    // oscillating between two positions: settle in the middle
+    if (j > 0 && std::fabs(dx + prev_dx) < 0.01f && std::fabs(dy + prev_dy) < 0.01f) {
+      nx -= dx * 0.5f;
+      ny -= dy * 0.5f;
+      break;
+    }
+    prev_dx = dx;
+    prev_dy = dy;
+  }
+  *next_x = nx + half_w;
+  *next_y = ny + half_h;
+  return tracked;
+}
+
+inline bool calc_optical_flow_pyr_lk_ref(const uint8_t* prev_img, const uint8_t* next_img, int step, int width,
+                                         int height, const float* prev_pts, int count, float* next_pts,
+                                         uint8_t* status, const LkParams& params) {
+  if (!prev_img || !next_img || width < 1 || height < 1 || step < width || count < 0) return false;
+  if (params.win_width < 3 || params.win_height < 3 || params.max_level < 0 || params.criteria_cnt < 1) return false;
+  std::vector<FlowRefLevel> prev = flow_pyramid_ref(prev_img, step, width, height, params);
+  std::vector<FlowRefLevel> next = flow_pyramid_ref(next_img, step, width, height, params);
+  for (FlowRefLevel& l : prev) scharr_ref(l);
+  const int levels = (int)prev.size();
+  for (int i = 0; i < count; i++) {
+    const float scale = 1.0f / (float)(1 << (levels - 1));
+    const float* start = params.use_initial_flow ? next_pts : prev_pts;
+    float nx = start[2 * i] * scale, ny = start[2 * i + 1] * scale;
+    uint8_t st = 1;
+    for (int level = levels - 1; level >= 0; level--) {
+      const float s = 1.0f / (float)(1 << level);
+      if (!lk_refine_ref(prev[level], next[level], params, prev_pts[2 * i] * s, prev_pts[2 * i + 1] * s, &nx, &ny) &&
+          level == 0) {
+        st = 0;
+      }
+      if (level > 0) {
+        nx *= 2.0f;
+        ny *= 2.0f;
+      }
+    }
+    next_pts[2 * i] = nx;
+    next_pts[2 * i + 1] = ny;
+    status[i] = st;
+  }
+  return true;
+}
+
+}  // namespace flow
+}  // namespace xr
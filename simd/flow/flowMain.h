@@ -0,0 +1,287 @@
+#pragma once
+
+// Checks the pyramidal LK tracker on every backend this CPU can run against
+// the scalar reference (same status for every point, positions within
+// 0.01 px) and against the true motion of a synthetic pair, then times the
+// device demo's configuration: 1920x1080, 500 points, 21x21 window, max_level 3,
+// 20 iterations, eps 0.01.
+//
+// Run from DSP/MTK/mtk_device_demo to use its data (cve_data/prevImg.bin,
+// nextImg.bin, prevPts.bin, the inputs of the device run); without them the
+// timing runs on a synthetic 1080p pair.
+//
+// g++ -O3 -fopenmp -std=c++17 main.cpp -o flow_demo
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "flow.h"
+
+namespace xr {
+namespace flow {
+
+// smooth random texture: noise box-blurred twice, stretched back to 0..255,
+// with a flat rectangle in the middle that has nothing to track
+inline std::vector<uint8_t> flow_texture(int w, int h, uint32_t seed) {
+  std::vector<float> a((size_t)w * h), b(a.size());
+  for (auto& x : a) {
+    seed = seed * 1664525u + 1013904223u;
+    x = (float)(seed >> 24);
+  }
+  const int r = 2;
+  for (int pass = 0; pass < 2; pass++) {
+    for (int y = 0; y < h; y++) {
+      for (int x = 0; x < w; x++) {
+        float s = 0.0f;
+        for (int k = -r; k <= r; k++) s += a[(size_t)y * w + std::min(w - 1, std::max(0, x + k))];
+        b[(size_t)y * w + x] = s / (2 * r + 1);
+      }
+    }
+    for (int y = 0; y < h; y++) {
+      for (int x = 0; x < w; x++) {
+        float s = 0.0f;
+        for (int k = -r; k <= r; k++) s += b[(size_t)std::min(h - 1, std::max(0, y + k)) * w + x];
+        a[(size_t)y * w + x] = s / (2 * r + 1);
+      }
+    }
+  }
+  std::vector<uint8_t> img(a.size());
+  for (size_t i = 0; i < a.size(); i++) img[i] = (uint8_t)std::min(255.0f, std::max(0.0f, (a[i] - 128.0f) * 4.0f + 128.0f));
+  for (int y = h * 2 / 5; y < h * 3 / 5; y++) {
+    for (int x = w * 2 / 5; x < w * 3 / 5; x++) img[(size_t)y * w + x] = 100;
+  }
+  return img;
+}
+
+// prev -> next motion: rotation by deg and scale about the centre, then a
+// shift; m is the 2x3 affine matrix
+inline void flow_motion(int w, int h, float deg, float scale, float tx, float ty, float m[6]) {
+  const float c = scale * std::cos(deg * 3.14159265f / 180.0f), s = scale * std::sin(deg * 3.14159265f / 180.0f);
+  const float cx = 0.5f * w, cy = 0.5f * h;
+  m[0] = c;
+  m[1] = -s;
+  m[2] = cx - c * cx + s * cy + tx;
+  m[3] = s;
+  m[4] = c;
+  m[5] = cy - s * cx - c * cy + ty;
+}
+
+// next(q) = prev(m^-1 q), bilinear, replicated border
+inline std::vector<uint8_t> flow_warp(const std::vector<uint8_t>& src, int w, int h, const float m[6]) {
+  const float det = m[0] * m[4] - m[1] * m[3];
+  const float i0 = m[4] / det, i1 = -m[1] / det, i3 = -m[3] / det, i4 = m[0] / det;
+  std::vector<uint8_t> dst(src.size());
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      const float u = x - m[2], v = y - m[5];
+      const float sx = i0 * u + i1 * v, sy = i3 * u + i4 * v;
+      const int x0 = (int)std::floor(sx), y0 = (int)std::floor(sy);
+      const float fx = sx - x0, fy = sy - y0;
+      auto at = [&](int xx, int yy) {
+        return (float)src[(size_t)std::min(h - 1, std::max(0, yy)) * w + std::min(w - 1, std::max(0, xx))];
+      };
+      const float p = (1 - fy) * ((1 - fx) * at(x0, y0) + fx * at(x0 + 1, y0)) +
+                      fy * ((1 - fx) * at(x0, y0 + 1) + fx * at(x0 + 1, y0 + 1));
+      dst[(size_t)y * w + x] = (uint8_t)(p + 0.5f);
+    }
+  }
+  return dst;
+}
+
+// count random points, plus a few off the frame and in the flat rectangle
+inline std::vector<float> flow_points(int w, int h, int count, uint32_t seed) {
+  std::vector<float> pts;
+  const float extra[][2] = {{-40.0f, 100.0f}, {w + 35.0f, 50.0f},      {60.0f, h + 50.0f},
+                            {0.0f, 0.0f},     {w - 1.0f, h - 1.0f},    {0.5f * w, 0.5f * h},
+                            {0.5f * w + 3.0f, 0.5f * h - 4.0f}};
+  for (const auto& e : extra) {
+    pts.push_back(e[0]);
+    pts.push_back(e[1]);
+  }
+  for (int i = (int)(pts.size() / 2); i < count; i++) {
+    for (int k = 0; k < 2; k++) {
+      seed = seed * 1664525u + 1013904223u;
+      pts.push_back((seed >> 8) * (1.0f / (1 << 24)) * (k ? h - 1 : w - 1));
+    }
+  }
+  return pts;
+}
+
+struct FlowCompare {
+  int status_diff = 0;
+  float max_diff = 0.0f;
+};
+
+inline FlowCompare flow_compare(const std::vector<float>& a, const std::vector<uint8_t>& sa,
+                                const std::vector<float>& b, const std::vector<uint8_t>& sb) {
+  FlowCompare r;
+  for (size_t i = 0; i < sa.size(); i++) {
+    if (sa[i] != sb[i]) {
+      r.status_diff++;
+    } else if (sa[i]) {
+      r.max_diff = std::max({r.max_diff, std::fabs(a[2 * i] - b[2 * i]), std::fabs(a[2 * i + 1] - b[2 * i + 1])});
+    }
+  }
+  return r;
+}
+
+inline double flow_now_ms() {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F>
+inline double flow_time_ms(F&& f) {
+  f();
+  int runs = 0;
+  double t0 = flow_now_ms();
+  do {
+    f();
+    runs++;
+  } while (flow_now_ms() - t0 < 100.0);
+  return (flow_now_ms() - t0) / runs;
+}
+
+inline bool flow_read(const char* path, void* dst, size_t bytes) {
+  FILE* f = std::fopen(path, "rb");
+  if (!f) return false;
+  const bool ok = std::fread(dst, 1, bytes, f) == bytes;
+  std::fclose(f);
+  return ok;
+}
+
+}  // namespace flow
+}  // namespace xr
+
+inline int flowMain() {
+  using namespace xr::flow;
+  using xr::simd::Isa;
+
+  bool pass = true;
+  const Isa all[] = {Isa::kScalar, Isa::kSSE42, Isa::kAVX2, Isa::kAVX512, Isa::kNEON};
+  const Isa saved = xr::simd::current_isa();
+
+  // synthetic pair with known motion; odd size, windows that do not fill a
+  // vector, and points that must be lost
+  {
+    const int w = 643, h = 481, count = 400;
+    float m[6];
+    flow_motion(w, h, 2.0f, 1.01f, 5.3f, -3.7f, m);
+    const std::vector<uint8_t> prev = flow_texture(w, h, 7), next = flow_warp(prev, w, h, m);
+    const std::vector<float> pts = flow_points(w, h, count, 11);
+
+    for (int win : {21, 9, 15}) {
+      LkParams p;
+      p.win_width = win;
+      p.win_height = win == 15 ? 11 : win;
+      p.max_level = win == 9 ? 5 : 3;
+      std::vector<float> ref(pts.size()), got(pts.size());
+      std::vector<uint8_t> ref_st(count), got_st(count);
+      pass &= calc_optical_flow_pyr_lk_ref(prev.data(), next.data(), w, w, h, pts.data(), count, ref.data(),
+                                           ref_st.data(), p);
+
+      // against the true motion, points away from the border and the flat area
+      int inliers = 0, tracked = 0, interior = 0;
+      for (int i = 0; i < count; i++) {
+        const float x = pts[2 * i], y = pts[2 * i + 1];
+        const float tx = m[0] * x + m[1] * y + m[2], ty = m[3] * x + m[4] * y + m[5];
+        const bool flat = x > w * 0.4f - win && x < w * 0.6f + win && y > h * 0.4f - win && y < h * 0.6f + win;
+        if (flat || x < 2 * win || y < 2 * win || x > w - 2 * win || y > h - 2 * win) continue;
+        if (tx < 2 * win || ty < 2 * win || tx > w - 2 * win || ty > h - 2 * win) continue;
+        interior++;
+        if (!ref_st[i]) continue;
+        tracked++;
+        inliers += std::hypot(ref[2 * i] - tx, ref[2 * i + 1] - ty) < 0.2f;
+      }
+      const bool lost_ok = !ref_st[0] && !ref_st[1] && !ref_st[2] && !ref_st[5];
+      pass &= lost_ok && tracked > interior * 95 / 100 && inliers > tracked * 95 / 100;
+      printf("%dx%d window, %d levels: ref tracks %d / %d interior points, %d within 0.2 px%s\n", p.win_width,
+             p.win_height, flow_levels(w, h, p) + 1, tracked, interior, inliers, lost_ok ? "" : ", LOST POINTS KEPT");
+
+      for (Isa isa : all) {
+        if (!xr::simd::set_isa(isa)) continue;
+        for (int threads : {1, 0}) {
+          pass &= calc_optical_flow_pyr_lk(prev.data(), next.data(), w, w, h, pts.data(), count, got.data(),
+                                           got_st.data(), p, threads);
+          const FlowCompare c = flow_compare(got, got_st, ref, ref_st);
+          const bool ok = c.status_diff == 0 && c.max_diff < 0.01f;
+          pass &= ok;
+          if (threads == 0 || !ok) {
+            printf("  %-7s status diff %d, max diff %.5f px %s\n", xr::simd::isa_name(isa), c.status_diff, c.max_diff,
+                   ok ? "ok" : "FAILED");
+          }
+        }
+      }
+      xr::simd::set_isa(saved);
+    }
+
+    // use_initial_flow from a good guess lands where tracking from scratch does
+    LkParams p;
+    std::vector<float> a(pts.size()), b(pts.size());
+    std::vector<uint8_t> sa(count), sb(count);
+    calc_optical_flow_pyr_lk(prev.data(), next.data(), w, w, h, pts.data(), count, a.data(), sa.data(), p);
+    p.use_initial_flow = true;
+    for (size_t i = 0; i < b.size(); i++) b[i] = a[i] + 1.0f;
+    calc_optical_flow_pyr_lk(prev.data(), next.data(), w, w, h, pts.data(), count, b.data(), sb.data(), p);
+    const FlowCompare c = flow_compare(a, sa, b, sb);
+    pass &= c.max_diff < 0.05f;
+    printf("initial flow off by 1 px: status diff %d, max diff %.4f px\n", c.status_diff, c.max_diff);
+  }
+
+  // the device demo's configuration
+  {
+    const int w = 1920, h = 1080, count = 500;
+    LkParams p;
+    std::vector<uint8_t> prev((size_t)w * h), next(prev.size());
+    std::vector<float> pts((size_t)count * 2);
+    const bool real = flow_read("cve_data/prevImg.bin", prev.data(), prev.size()) &&
+                      flow_read("cve_data/nextImg.bin", next.data(), next.size()) &&
+                      flow_read("cve_data/prevPts.bin", pts.data(), pts.size() * sizeof(float));
+    if (!real) {
+      float m[6];
+      flow_motion(w, h, 1.0f, 1.0f, 12.4f, 6.2f, m);
+      prev = flow_texture(w, h, 3);
+      next = flow_warp(prev, w, h, m);
+      pts = flow_points(w, h, count, 5);
+    }
+    std::vector<float> ref(pts.size()), got(pts.size());
+    std::vector<uint8_t> ref_st(count), got_st(count);
+    pass &= calc_optical_flow_pyr_lk_ref(prev.data(), next.data(), w, w, h, pts.data(), count, ref.data(),
+                                         ref_st.data(), p);
+    int tracked = 0;
+    for (uint8_t s : ref_st) tracked += s;
+    printf("\n%s 1920x1080, %d points, 21x21, %d levels: %d tracked\n", real ? "cve_data" : "synthetic", count,
+           flow_levels(w, h, p) + 1, tracked);
+
+    FlowPyramid pp, pn;
+    double ref_ms = flow_time_ms([&] {
+      calc_optical_flow_pyr_lk_ref(prev.data(), next.data(), w, w, h, pts.data(), count, ref.data(), ref_st.data(), p);
+    });
+    printf("  %-7s %8.2f ms\n", "ref", ref_ms);
+    for (Isa isa : all) {
+      if (!xr::simd::set_isa(isa)) continue;
+      calc_optical_flow_pyr_lk(prev.data(), next.data(), w, w, h, pts.data(), count, got.data(), got_st.data(), p);
+      const FlowCompare c = flow_compare(got, got_st, ref, ref_st);
+      pass &= c.status_diff == 0 && c.max_diff < 0.01f;
+      double one = flow_time_ms([&] {
+        calc_optical_flow_pyr_lk(prev.data(), next.data(), w, w, h, pts.data(), count, got.data(), got_st.data(), p,
+                                 1);
+      });
+      double all_threads = flow_time_ms([&] {
+        calc_optical_flow_pyr_lk(prev.data(), next.data(), w, w, h, pts.data(), count, got.data(), got_st.data(), p);
+      });
+      // pyramids kept from the previous frame, as a stream would: only the
+      // tracking itself
+      build_flow_pyramid(prev.data(), w, w, h, p, true, pp);
+      build_flow_pyramid(next.data(), w, w, h, p, false, pn);
+      double track = flow_time_ms([&] { calc_optical_flow_pyr_lk(pp, pn, pts.data(), count, got.data(), got_st.data(), p); });
+      printf("  %-7s %8.2f ms 1 thread, %8.2f ms all threads, %6.2f ms tracking only (diff %d / %.5f px)\n",
+             xr::simd::isa_name(isa), one, all_threads, track, c.status_diff, c.max_diff);
+    }
+    xr::simd::set_isa(saved);
+  }
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
@@ -0,0 +1,148 @@
+// Lucas-Kanade kernels, expanded per backend by xr_simd_foreach.h from
+// flow.h. Patch rows are processed in whole vi32 vectors, reading past the
+// window into the pyramid padding; the extra lanes are zeroed in the gradient
+// patches, so they drop out of every sum.
+
+inline vi32 lk_load_i32(const uint8_t* p) { return widen_lo(widen_lo(loadu(p))); }
+inline vi32 lk_load_i32(const int16_t* p) { return widen_lo(loadu(p)); }
+
+// bilinear sample of N consecutive pixels, weights summing to 1 << 14,
+// rounded and shifted down by shift
+template <typename T>
+inline vi32 lk_bilinear(const T* p, ptrdiff_t step, vi32 w00, vi32 w01, vi32 w10, vi32 w11, vi32 round, int shift) {
+  vi32 top = add(mul(lk_load_i32(p), w00), mul(lk_load_i32(p + 1), w01));
+  vi32 bottom = add(mul(lk_load_i32(p + step), w10), mul(lk_load_i32(p + step + 1), w11));
+  return shr(add(add(top, bottom), round), shift);
+}
+
+inline void lk_weights(float a, float b, int w[4]) {
+  w[0] = (int)std::nearbyint((1.0f - a) * (1.0f - b) * (1 << 14));
+  w[1] = (int)std::nearbyint(a * (1.0f - b) * (1 << 14));
+  w[2] = (int)std::nearbyint((1.0f - a) * b * (1 << 14));
+  w[3] = (1 << 14) - w[0] - w[1] - w[2];
+}
+
+// Scharr dx / dy of rows [y0, y1); img points at pixel (0, 0) of a padded
+// image, so rows -1 and height and columns -1 and width are readable.
+inline void scharr_rows(const uint8_t* img, ptrdiff_t step, int16_t* dx, int16_t* dy, ptrdiff_t dstep, int width,
+                        int y0, int y1) {
+  const vi16 k3 = set1_i16(3), k10 = set1_i16(10);
+  for (int y = y0; y < y1; y++) {
+    const uint8_t* r0 = img + (y - 1) * step;
+    const uint8_t* r1 = r0 + step;
+    const uint8_t* r2 = r1 + step;
+    int16_t* gx = dx + y * dstep;
+    int16_t* gy = dy + y * dstep;
+    int x = 0;
+    for (; x + vu8::N <= width; x += vu8::N) {
+      const vu8 v[3][3] = {{loadu(r0 + x - 1), loadu(r0 + x), loadu(r0 + x + 1)},
+                           {loadu(r1 + x - 1), loadu(r1 + x), loadu(r1 + x + 1)},
+                           {loadu(r2 + x - 1), loadu(r2 + x), loadu(r2 + x + 1)}};
+      for (int half = 0; half < 2; half++) {
+        vi16 s[3][3];
+        for (int r = 0; r < 3; r++) {
+          for (int c = 0; c < 3; c++) s[r][c] = as_i16(half ? widen_hi(v[r][c]) : widen_lo(v[r][c]));
+        }
+        vi16 ex = add(mul(add(sub(s[0][2], s[0][0]), sub(s[2][2], s[2][0])), k3), mul(sub(s[1][2], s[1][0]), k10));
+        vi16 ey = add(mul(add(sub(s[2][0], s[0][0]), sub(s[2][2], s[0][2])), k3), mul(sub(s[2][1], s[0][1]), k10));
+        storeu(gx + x + half * vi16::N, ex);
+        storeu(gy + x + half * vi16::N, ey);
+      }
+    }
+    for (; x < width; x++) {
+      gx[x] = (int16_t)(3 * (r0[x + 1] - r0[x - 1] + r2[x + 1] - r2[x - 1]) + 10 * (r1[x + 1] - r1[x - 1]));
+      gy[x] = (int16_t)(3 * (r2[x - 1] - r0[x - 1] + r2[x + 1] - r0[x + 1]) + 10 * (r2[x] - r0[x]));
+    }
+  }
+}
+
+// One level of one point: samples the window around prev in I (image and
+// gradients), then iterates the 2x2 solve on J from *next. Returns false when
+// the point is lost on this level. *next is left alone when the point is lost
+// before iterating, as the caller then keeps its current guess.
+inline bool lk_refine(const LkLevel& I, const LkLevel& J, const LkCriteria& c, float prev_x, float prev_y,
+                      float* next_x, float* next_y, int32_t* patch) {
+  constexpr int N = vi32::N;
+  constexpr float kScale = 1.0f / (1 << 20);
+  const int ww = c.win_width, wh = c.win_height;
+  const int wpad = (ww + N - 1) / N * N;
+  const float half_w = (ww - 1) * 0.5f, half_h = (wh - 1) * 0.5f;
+  const float px = prev_x - half_w, py = prev_y - half_h;
+  const int ix = (int)std::floor(px), iy = (int)std::floor(py);
+  if (ix < -ww || ix >= I.width || iy < -wh || iy >= I.height) return false;
+
+  int w[4];
+  lk_weights(px - ix, py - iy, w);
+  vi32 w00 = set1_i32(w[0]), w01 = set1_i32(w[1]), w10 = set1_i32(w[2]), w11 = set1_i32(w[3]);
+  const vi32 round9 = set1_i32(1 << 8), round14 = set1_i32(1 << 13);
+
+  int32_t* pi = patch;
+  int32_t* pdx = pi + (size_t)wh * wpad;
+  int32_t* pdy = pdx + (size_t)wh * wpad;
+  vf32 a11 = zero_f32(), a12 = zero_f32(), a22 = zero_f32();
+  for (int y = 0; y < wh; y++) {
+    const ptrdiff_t src = (ptrdiff_t)(iy + y) * I.step + ix, dsrc = (ptrdiff_t)(iy + y) * I.dstep + ix;
+    int32_t* ri = pi + (size_t)y * wpad;
+    int32_t* rx = pdx + (size_t)y * wpad;
+    int32_t* ry = pdy + (size_t)y * wpad;
+    for (int x = 0; x < wpad; x += N) {
+      storeu(ri + x, lk_bilinear(I.img + src + x, I.step, w00, w01, w10, w11, round9, 9));
+      storeu(rx + x, lk_bilinear(I.dx + dsrc + x, I.dstep, w00, w01, w10, w11, round14, 14));
+      storeu(ry + x, lk_bilinear(I.dy + dsrc + x, I.dstep, w00, w01, w10, w11, round14, 14));
+    }
+    for (int x = ww; x < wpad; x++) rx[x] = ry[x] = 0;
+    for (int x = 0; x < wpad; x += N) {
+      vi32 gx = loadu(rx + x), gy = loadu(ry + x);
+      a11 = add(a11, cvt_f32(mul(gx, gx)));
+      a12 = add(a12, cvt_f32(mul(gx, gy)));
+      a22 = add(a22, cvt_f32(mul(gy, gy)));
+    }
+  }
+
+  const float A11 = reduce_add(a11) * kScale, A12 = reduce_add(a12) * kScale, A22 = reduce_add(a22) * kScale;
+  float det = A11 * A22 - A12 * A12;
+  const float min_eig = (A22 + A11 - std::sqrt((A11 - A22) * (A11 - A22) + 4.0f * A12 * A12)) / (float)(2 * ww * wh);
+  if (min_eig < c.min_eig || det < FLT_EPSILON) return false;
+  det = 1.0f / det;
+
+  float nx = *next_x - half_w, ny = *next_y - half_h;
+  float prev_dx = 0.0f, prev_dy = 0.0f;
+  bool tracked = true;
+  for (int j = 0; j < c.max_count; j++) {
+    const int jx = (int)std::floor(nx), jy = (int)std::floor(ny);
+    if (jx < -ww || jx >= J.width || jy < -wh || jy >= J.height) {
+      tracked = false;
+      break;
+    }
+    lk_weights(nx - jx, ny - jy, w);
+    w00 = set1_i32(w[0]);
+    w01 = set1_i32(w[1]);
+    w10 = set1_i32(w[2]);
+    w11 = set1_i32(w[3]);
+    vf32 b1 = zero_f32(), b2 = zero_f32();
+    for (int y = 0; y < wh; y++) {
+      const uint8_t* row = J.img + (ptrdiff_t)(jy + y) * J.step + jx;
+      const size_t k = (size_t)y * wpad;
+      for (int x = 0; x < wpad; x += N) {
+        vi32 diff = sub(lk_bilinear(row + x, J.step, w00, w01, w10, w11, round9, 9), loadu(pi + k + x));
+        b1 = add(b1, cvt_f32(mul(diff, loadu(pdx + k + x))));
+        b2 = add(b2, cvt_f32(mul(diff, loadu(pdy + k + x))));
+      }
+    }
+    const float B1 = reduce_add(b1) * kScale, B2 = reduce_add(b2) * kScale;
+    const float dx = (A12 * B2 - A22 * B1) * det, dy = (A12 * B1 - A11 * B2) * det;
+    nx += dx;
+    ny += dy;
+    if (dx * dx + dy * dy <= c.eps2) break;
+    if (j > 0 && std::fabs(dx + prev_dx) < 0.01f && std::fabs(dy + prev_dy) < 0.01f) {
+      nx -= dx * 0.5f;
+      ny -= dy * 0.5f;
+      break;
+    }
+    prev_dx = dx;
+    prev_dy = dy;
+  }
+  *next_x = nx + half_w;
+  *next_y = ny + half_h;
+  return tracked;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+// Packed, cache-blocked SGEMM in the BLIS layout:
+//
+//   for jc in N by NC          B block (KC x NC) lives in L3, packed once
+//     for pc in K by KC
+//       pack B[pc, jc] into NR-wide panels              (shared by all threads)
+//       for ic in M by MC      A block (MC x KC) lives in L2, packed per thread
+//         pack A[ic, pc] into MR-high panels
+//         for jr in NC by NR   B panel (KC x NR) lives in L1
+//           for ir in MC by MR
+//             micro-kernel: MR x NR block of C in registers
+//
+// MR/NR/MC/KC/NC come from the backend picked at runtime (gemm_kernels.inl).
+// OpenMP splits the ic loop, and the jr loop too when there are fewer MC
+// blocks than threads, so skinny shapes still use every core. Very short A
+// (m <= kSmallM) skips packing altogether, since packing B would cost as much
+// as the multiply itself.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../xr_simd.h"
+
+namespace xr {
+namespace gemm {
+
+struct GemmBlocking {
+  int mr, nr;      // register tile
+  int mc, kc, nc;  // cache blocks; mc is a multiple of mr
+};
+
+constexpr int kSmallM = 4;
+
+#define XR_SIMD_KERNELS "gemm/gemm_kernels.inl"
+#include "../xr_simd_foreach.h"
+
+// Plain i-j-k triple loop, the slowest baseline. C = A * B, row-major.
+inline void gemm_naive(int m, int n, int k, const float* a, const float* b, float* c) {
+  for (int i = 0; i < m; i++) {
+    for (int j = 0; j < n; j++) {
+      float sum = 0.0f;
+      for (int p = 0; p < k; p++) sum += a[(size_t)i * k + p] * b[(size_t)p * n + j];
+      c[(size_t)i * n + j] = sum;
+    }
+  }
+}
+
+// C = alpha * op(A) * op(B) + beta * C with row-major storage, op(X) = X or
+// X^T. op(A) is m x k, op(B) is k x n. threads <= 0 uses every OpenMP thread.
+inline void sgemm(bool trans_a, bool trans_b, int m, int n, int k, float alpha, const float* a, int lda,
+                  const float* b, int ldb, float beta, float* c, int ldc, int threads = 0) {
+  if (m <= 0 || n <= 0) return;
+  if (k <= 0 || alpha == 0.0f) {
+    for (int i = 0; i < m; i++) {
+      float* row = c + (size_t)i * ldc;
+      for (int j = 0; j < n; j++) row[j] = beta == 0.0f ? 0.0f : beta * row[j];
+    }
+    return;
+  }
+
+#ifdef _OPENMP
+  if (threads <= 0) threads = omp_get_max_threads();
+#else
+  threads = 1;
+#endif
+
+  if (m <= kSmallM && !trans_b) {
+    auto small_m = XR_SIMD_DISPATCH(gemm_small_m);
+    const ptrdiff_t rs = trans_a ? 1 : lda, cs = trans_a ? lda : 1;
+    // column slices of 64 keep every thread's strips whole
+    const int slices = std::max(1, std::min(threads, n / 64));
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (int s = 0; s < slices; s++) {
+      int j0 = (int)((int64_t)n * s / slices) / 64 * 64;
+      int j1 = s + 1 == slices ? n : (int)((int64_t)n * (s + 1) / slices) / 64 * 64;
+      small_m(m, j1 - j0, k, alpha, a, rs, cs, b + j0, ldb, beta, c + j0, ldc);
+    }
+    return;
+  }
+
+  const GemmBlocking blk = XR_SIMD_DISPATCH(gemm_blocking)();
+  auto pack_a = XR_SIMD_DISPATCH(gemm_pack_a);
+  auto pack_b = XR_SIMD_DISPATCH(gemm_pack_b);
+  auto micro = XR_SIMD_DISPATCH(gemm_micro);
+
+  // element (i, p) of op(A) is a[i * a_rs + p * a_cs]; same for B
+  const ptrdiff_t a_rs = trans_a ? 1 : lda, a_cs = trans_a ? lda : 1;
+  const ptrdiff_t b_rs = trans_b ? 1 : ldb, b_cs = trans_b ? ldb : 1;
+
+  const int nc_max = std::min(blk.nc, n);
+  const int kc_max = std::min(blk.kc, k);
+  const int b_panels_max = (nc_max + blk.nr - 1) / blk.nr;
+  float* b_pack = (float*)xr::simd::aligned_malloc(sizeof(float) * kc_max * b_panels_max * blk.nr);
+
+#pragma omp parallel num_threads(threads)
+  {
+    const int mc_max = std::min(blk.mc, (m + blk.mr - 1) / blk.mr * blk.mr);
+    float* a_pack = (float*)xr::simd::aligned_malloc(sizeof(float) * mc_max * kc_max);
+
+    for (int jc = 0; jc < n; jc += blk.nc) {
+      const int nc = std::min(blk.nc, n - jc);
+      const int b_panels = (nc + blk.nr - 1) / blk.nr;
+      for (int pc = 0; pc < k; pc += blk.kc) {
+        const int kc = std::min(blk.kc, k - pc);
+        const float beta_pc = pc == 0 ? beta : 1.0f;
+
+#pragma omp for schedule(static)
+        for (int jp = 0; jp < b_panels; jp++) {
+          int jr = jp * blk.nr;
+          pack_b(b + pc * b_rs + (jc + jr) * b_cs, b_rs, b_cs, kc, std::min(blk.nr, nc - jr),
+                 b_pack + (size_t)jp * kc * blk.nr);
+        }
+
+        // work items are (MC block, slice of the B panels); slices only split
+        // when there are too few MC blocks to go around
+        const int m_blocks = (m + blk.mc - 1) / blk.mc;
+        const int slices = std::max(1, std::min(b_panels, (threads + m_blocks - 1) / m_blocks));
+        int packed_ic = -1;
+#pragma omp for schedule(static)
+        for (int item = 0; item < m_blocks * slices; item++) {
+          const int ic = item / slices * blk.mc;
+          const int mc = std::min(blk.mc, m - ic);
+          if (ic != packed_ic) {
+            pack_a(a + ic * a_rs + pc * a_cs, a_rs, a_cs, mc, kc, a_pack);
+            packed_ic = ic;
+          }
+          const int s = item % slices;
+          const int jp0 = (int)((int64_t)b_panels * s / slices);
+          const int jp1 = (int)((int64_t)b_panels * (s + 1) / slices);
+          for (int jp = jp0; jp < jp1; jp++) {
+            const int jr = jp * blk.nr;
+            const float* bp = b_pack + (size_t)jp * kc * blk.nr;
+            for (int ir = 0; ir < mc; ir += blk.mr) {
+              micro(kc, a_pack + (size_t)ir * kc, bp, c + (size_t)(ic + ir) * ldc + jc + jr, ldc, alpha, beta_pc,
+                    std::min(blk.mr, mc - ir), std::min(blk.nr, nc - jr));
+            }
+          }
+        }
+        // the implicit barrier above keeps b_pack alive until every thread is done
+      }
+    }
+    xr::simd::aligned_free(a_pack);
+  }
+  xr::simd::aligned_free(b_pack);
+}
+
+// C = A * B, all row-major and densely packed.
+inline void sgemm(int m, int n, int k, const float* a, const float* b, float* c, int threads = 0) {
+  sgemm(false, false, m, n, k, 1.0f, a, k, b, n, 0.0f, c, n, threads);
+}
+
+}  // namespace gemm
+}  // namespace xr
@@ -0,0 +1,177 @@
+// SGEMM kernels, expanded per backend by xr_simd_foreach.h from gemm.h.
+//
+// The micro-kernel keeps an MR x NR block of C in registers (MR rows, NR =
+// NV vectors) and walks a packed MR-wide panel of A and NR-wide panel of B
+// one k at a time: NV vector loads of B, MR broadcasts of A, MR * NV FMAs.
+// MR * NV accumulators plus NV + 1 temporaries must fit the register file.
+
+#if defined(__clang__)
+#define XR_GEMM_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define XR_GEMM_UNROLL _Pragma("GCC unroll 16")
+#else
+#define XR_GEMM_UNROLL
+#endif
+
+#if XR_SIMD_TARGET == XR_SIMD_TARGET_AVX512
+// 32 zmm: 28 accumulators, 2 B vectors, 1 broadcast
+constexpr int kMR = 14, kNV = 2, kMC = 112, kKC = 384, kNC = 3072;
+#elif XR_SIMD_TARGET == XR_SIMD_TARGET_AVX2
+// 16 ymm: 12 accumulators, 2 B vectors, 1 broadcast
+constexpr int kMR = 6, kNV = 2, kMC = 120, kKC = 256, kNC = 3072;
+#elif XR_SIMD_TARGET == XR_SIMD_TARGET_SSE42
+constexpr int kMR = 6, kNV = 2, kMC = 96, kKC = 256, kNC = 2048;
+#elif XR_SIMD_TARGET == XR_SIMD_TARGET_NEON
+// 32 q registers: 24 accumulators, 3 B vectors, 1 broadcast
+constexpr int kMR = 8, kNV = 3, kMC = 128, kKC = 256, kNC = 2048;
+#else
+constexpr int kMR = 4, kNV = 2, kMC = 64, kKC = 256, kNC = 2048;
+#endif
+constexpr int kNR = kNV * vf32::N;
+
+inline GemmBlocking gemm_blocking() { return {kMR, kNR, kMC, kKC, kNC}; }
+
+// Packs an mc x kc block of A (element (i, p) at a[i * rs + p * cs]) into
+// MR-row panels, each stored k-major: panel[p * MR + i]. Rows past mc are zero
+// so the micro-kernel never needs a row count.
+inline void gemm_pack_a(const float* a, ptrdiff_t rs, ptrdiff_t cs, int mc, int kc, float* dst) {
+  for (int ir = 0; ir < mc; ir += kMR) {
+    int rows = std::min(kMR, mc - ir);
+    const float* src = a + ir * rs;
+    for (int p = 0; p < kc; p++) {
+      int i = 0;
+      for (; i < rows; i++) dst[i] = src[i * rs + p * cs];
+      for (; i < kMR; i++) dst[i] = 0.0f;
+      dst += kMR;
+    }
+  }
+}
+
+// Packs a kc x nc block of B (element (p, j) at b[p * rs + j * cs]) into
+// NR-column panels, each stored k-major: panel[p * NR + j], zero padded.
+inline void gemm_pack_b(const float* b, ptrdiff_t rs, ptrdiff_t cs, int kc, int nc, float* dst) {
+  for (int jr = 0; jr < nc; jr += kNR) {
+    int cols = std::min(kNR, nc - jr);
+    const float* src = b + jr * cs;
+    if (cs == 1 && cols == kNR) {
+      for (int p = 0; p < kc; p++) {
+        XR_GEMM_UNROLL
+        for (int v = 0; v < kNV; v++) store(dst + v * vf32::N, loadu(src + p * rs + v * vf32::N));
+        dst += kNR;
+      }
+      continue;
+    }
+    for (int p = 0; p < kc; p++) {
+      int j = 0;
+      for (; j < cols; j++) dst[j] = src[p * rs + j * cs];
+      for (; j < kNR; j++) dst[j] = 0.0f;
+      dst += kNR;
+    }
+  }
+}
+
+// C[0:mr, 0:nr] = alpha * Apanel * Bpanel + beta * C. beta == 0 never reads C,
+// so C may start out uninitialized (as in BLAS).
+inline void gemm_micro(int kc, const float* a, const float* b, float* c, ptrdiff_t ldc, float alpha, float beta,
+                       int mr, int nr) {
+  vf32 acc[kMR][kNV];
+  XR_GEMM_UNROLL
+  for (int i = 0; i < kMR; i++) {
+    XR_GEMM_UNROLL
+    for (int v = 0; v < kNV; v++) acc[i][v] = zero_f32();
+  }
+
+  for (int p = 0; p < kc; p++) {
+    vf32 bv[kNV];
+    XR_GEMM_UNROLL
+    for (int v = 0; v < kNV; v++) bv[v] = load(b + v * vf32::N);
+    XR_GEMM_UNROLL
+    for (int i = 0; i < kMR; i++) {
+      vf32 av = set1_f32(a[i]);
+      XR_GEMM_UNROLL
+      for (int v = 0; v < kNV; v++) acc[i][v] = fma(av, bv[v], acc[i][v]);
+    }
+    a += kMR;
+    b += kNR;
+  }
+
+  const vf32 valpha = set1_f32(alpha);
+  if (mr == kMR && nr == kNR) {
+    const vf32 vbeta = set1_f32(beta);
+    XR_GEMM_UNROLL
+    for (int i = 0; i < kMR; i++) {
+      float* row = c + i * ldc;
+      XR_GEMM_UNROLL
+      for (int v = 0; v < kNV; v++) {
+        vf32 r = mul(acc[i][v], valpha);
+        if (beta != 0.0f) r = fma(loadu(row + v * vf32::N), vbeta, r);
+        storeu(row + v * vf32::N, r);
+      }
+    }
+    return;
+  }
+
+  // edge tile: spill the block and copy the valid part
+  alignas(64) float tmp[kMR * kNR];
+  for (int i = 0; i < kMR; i++) {
+    for (int v = 0; v < kNV; v++) store(tmp + i * kNR + v * vf32::N, mul(acc[i][v], valpha));
+  }
+  for (int i = 0; i < mr; i++) {
+    float* row = c + i * ldc;
+    for (int j = 0; j < nr; j++) row[j] = beta != 0.0f ? tmp[i * kNR + j] + beta * row[j] : tmp[i * kNR + j];
+  }
+}
+
+// Rows of C computed straight from unpacked, non-transposed B, for m too small
+// to pay back packing B (a GEMV when m == 1). Columns go in chunks whose m
+// partial rows stay in L2 while k rows of B stream past in order; each B
+// vector is loaded once for all m rows. m must be at most kSmallM.
+inline void gemm_small_m(int m, int n, int k, float alpha, const float* a, ptrdiff_t a_rs, ptrdiff_t a_cs,
+                         const float* b, ptrdiff_t ldb, float beta, float* c, ptrdiff_t ldc) {
+  constexpr int kChunk = 4096;
+  alignas(64) float acc[kSmallM][kChunk];
+  const vf32 valpha = set1_f32(alpha), vbeta = set1_f32(beta);
+  for (int j0 = 0; j0 < n; j0 += kChunk) {
+    const int w = std::min(kChunk, n - j0);
+    const int wv = w / vf32::N * vf32::N;
+    for (int i = 0; i < m; i++) std::fill(acc[i], acc[i] + w, 0.0f);
+    for (int p = 0; p < k; p++) {
+      const float* brow = b + p * ldb + j0;
+      for (int i = 0; i < m; i++) {
+        const float aip = a[i * a_rs + p * a_cs];
+        const vf32 av = set1_f32(aip);
+        float* row = acc[i];
+        int j = 0;
+        for (; j < wv; j += vf32::N) store(row + j, fma(av, loadu(brow + j), load(row + j)));
+        for (; j < w; j++) row[j] += aip * brow[j];
+      }
+    }
+    for (int i = 0; i < m; i++) {
+      float* crow = c + i * ldc + j0;
+      int j = 0;
+      for (; j < wv; j += vf32::N) {
+        vf32 r = mul(load(acc[i] + j), valpha);
+        if (beta != 0.0f) r = fma(loadu(crow + j), vbeta, r);
+        storeu(crow + j, r);
+      }
+      for (; j < w; j++) crow[j] = beta != 0.0f ? alpha * acc[i][j] + beta * crow[j] : alpha * acc[i][j];
+    }
+  }
+}
+
+// Baseline for the benchmark: the i-k-j loop compilers auto-vectorize,
+// compiled here with this backend's target flags. C = A * B, all row-major.
+inline void gemm_autovec(int m, int n, int k, const float* __restrict a, const float* __restrict b,
+                         float* __restrict c) {
+  for (int i = 0; i < m; i++) {
+    float* crow = c + (size_t)i * n;
+    for (int j = 0; j < n; j++) crow[j] = 0.0f;
+    for (int p = 0; p < k; p++) {
+      const float aip = a[(size_t)i * k + p];
+      const float* brow = b + (size_t)p * n;
+      for (int j = 0; j < n; j++) crow[j] += aip * brow[j];
+    }
+  }
+}
+
+#undef XR_GEMM_UNROLL
@@ -0,0 +1,554 @@
+#pragma once
+
+// Robust homography between two point sets, the host version of the device's
+// mtkapi_findhomography_ransac_f32: H maps src points onto dst points,
+// row-major 3x3 with H[8] = 1.
+//
+//   - hypotheses are drawn, solved (4-point exact solve) and scored in
+//     batches of kRansacBatch spread over OpenMP threads; the best model and
+//     the adaptive iteration bound are updated between batches, so a run
+//     stops at most one batch after the bound drops below the hypotheses
+//     already tried
+//   - scoring counts inliers (|H src - dst|^2 <= threshold^2) over SoA copies
+//     of the points, a vector of points at a time (homography_kernels.inl)
+//   - hypothesis i draws its sample from its own generator, seeded from word
+//     i % 64 of the seed table and the round i / 64, and batches are reduced
+//     in hypothesis order with ties going to the lowest index. The result
+//     depends only on the inputs and the seeds, not on the thread count.
+//   - PROSAC (Chum and Matas 2005) samples from the best-ranked points first
+//     and widens the pool on its growth schedule; it only changes the
+//     sampling, termination is the RANSAC bound
+//   - the winner is refined on its inliers: normalized DLT, then
+//     Levenberg-Marquardt on the reprojection error, as cv::findHomography
+//
+// Points are interleaved (x, y) floats. Functions return false for arguments
+// they do not support or when no model is found.
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../xr_simd.h"
+
+namespace xr {
+namespace homography {
+
+// widest vector of any backend, in floats; SoA arrays are padded to it
+constexpr int kHomographyLanes = 16;
+constexpr int kRansacBatch = 64;
+// words in the seed table, the size of the device's random_seed buffer
+constexpr int kRansacSeeds = 64;
+
+enum class Sampling { kUniform, kProsac };
+
+struct RansacParams {
+  float threshold = 1.0f;  // inlier distance in pixels
+  int max_iters = 2000;
+  float confidence = 0.9f;
+  Sampling sampling = Sampling::kUniform;
+  bool refine = true;
+  // kRansacSeeds words; null uses 0, 1, ..., 63 like the device demo
+  const uint32_t* random_seed = nullptr;
+};
+
+struct RansacStats {
+  int iterations = 0;     // hypotheses evaluated
+  int inliers = 0;        // of the RANSAC model
+  int best_iteration = -1;
+};
+
+#define XR_SIMD_KERNELS "homography/homography_kernels.inl"
+#include "../xr_simd_foreach.h"
+
+// Hypotheses needed to draw one all-inlier sample of model_points with the
+// given confidence, for the inlier fraction 1 - outlier_ratio
+// (cv::RANSACUpdateNumIters).
+inline int ransac_update_iters(double confidence, double outlier_ratio, int model_points, int max_iters) {
+  outlier_ratio = std::max(outlier_ratio, 0.0);
+  outlier_ratio = std::min(outlier_ratio, 1.0);
+  double num = std::max(1.0 - confidence, DBL_MIN);
+  double denom = 1.0 - std::pow(1.0 - outlier_ratio, model_points);
+  if (denom < DBL_MIN) return 0;
+  num = std::log(num);
+  denom = std::log(denom);
+  return denom >= 0 || -num >= max_iters * (-denom) ? max_iters : (int)std::lround(num / denom);
+}
+
+inline uint32_t ransac_mix(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7FEB352Du;
+  x ^= x >> 15;
+  x *= 0x846CA68Bu;
+  x ^= x >> 16;
+  return x;
+}
+
+// generator of hypothesis i: xorshift32 from seed word i % 64 and round i / 64
+struct RansacRng {
+  uint32_t s;
+  RansacRng(const uint32_t* seeds, int i) {
+    s = ransac_mix(seeds[i % kRansacSeeds] ^ ransac_mix((uint32_t)(i / kRansacSeeds) + 0x9E3779B9u));
+    if (s == 0) s = 1;
+  }
+  uint32_t next() {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+  }
+  int below(int n) { return (int)(((uint64_t)next() * (uint32_t)n) >> 32); }
+};
+
+// PROSAC growth schedule for hypotheses 0..iters-1: pool[i] is the size of
+// the top-ranked pool hypothesis i samples from, and with_last[i] says the
+// sample must contain pool[i] - 1, the newest point of the pool.
+inline void prosac_schedule(int count, int iters, int* pool, uint8_t* with_last) {
+  constexpr int m = 4;
+  double tn = iters;
+  for (int i = 0; i < m; i++) tn *= (double)(m - i) / (count - i);
+  double tn_prime = 1.0;
+  int n = m;
+  for (int t = 1; t <= iters; t++) {
+    if (t > tn_prime && n < count) {
+      const double tn1 = tn * (n + 1) / (n + 1 - m);
+      tn_prime += std::ceil(tn1 - tn);
+      tn = tn1;
+      n++;
+    }
+    pool[t - 1] = n;
+    with_last[t - 1] = tn_prime >= t;
+  }
+}
+
+// Solves a x = b for the n x n row-major a with partial pivoting, in place;
+// false when a is singular.
+inline bool solve_dense(double* a, double* b, int n) {
+  for (int c = 0; c < n; c++) {
+    int p = c;
+    for (int r = c + 1; r < n; r++) {
+      if (std::fabs(a[r * n + c]) > std::fabs(a[p * n + c])) p = r;
+    }
+    if (std::fabs(a[p * n + c]) < 1e-12) return false;
+    if (p != c) {
+      for (int k = 0; k < n; k++) std::swap(a[c * n + k], a[p * n + k]);
+      std::swap(b[c], b[p]);
+    }
+    for (int r = c + 1; r < n; r++) {
+      const double f = a[r * n + c] / a[c * n + c];
+      for (int k = c; k < n; k++) a[r * n + k] -= f * a[c * n + k];
+      b[r] -= f * b[c];
+    }
+  }
+  for (int c = n - 1; c >= 0; c--) {
+    double s = b[c];
+    for (int k = c + 1; k < n; k++) s -= a[c * n + k] * b[k];
+    b[c] = s / a[c * n + c];
+  }
+  return true;
+}
+
+// Exact homography through 4 correspondences (cv::getPerspectiveTransform).
+inline bool homography_4pt(const float src[8], const float dst[8], float h[9]) {
+  double a[64], b[8];
+  for (int i = 0; i < 4; i++) {
+    const double x = src[2 * i], y = src[2 * i + 1], u = dst[2 * i], v = dst[2 * i + 1];
+    const double r0[8] = {x, y, 1, 0, 0, 0, -x * u, -y * u};
+    const double r1[8] = {0, 0, 0, x, y, 1, -x * v, -y * v};
+    std::memcpy(a + (2 * i) * 8, r0, sizeof(r0));
+    std::memcpy(a + (2 * i + 1) * 8, r1, sizeof(r1));
+    b[2 * i] = u;
+    b[2 * i + 1] = v;
+  }
+  if (!solve_dense(a, b, 8)) return false;
+  for (int i = 0; i < 8; i++) h[i] = (float)b[i];
+  h[8] = 1.0f;
+  for (int i = 0; i < 9; i++) {
+    if (!std::isfinite(h[i])) return false;
+  }
+  return true;
+}
+
+// A sample is usable when every triangle of it keeps its orientation from
+// src to dst and none is degenerate (cv::HomographyEstimatorCallback).
+inline bool homography_sample_ok(const float src[8], const float dst[8]) {
+  static const int tri[4][3] = {{0, 1, 2}, {1, 2, 3}, {0, 2, 3}, {0, 1, 3}};
+  int negative = 0;
+  for (const auto& t : tri) {
+    auto area = [&](const float* p) {
+      return (p[2 * t[1]] - p[2 * t[0]]) * (p[2 * t[2] + 1] - p[2 * t[0] + 1]) -
+             (p[2 * t[1] + 1] - p[2 * t[0] + 1]) * (p[2 * t[2]] - p[2 * t[0]]);
+    };
+    const float a = area(src), b = area(dst);
+    if (std::fabs(a) < 1e-3f || std::fabs(b) < 1e-3f) return false;
+    negative += a * b < 0;
+  }
+  return negative == 0 || negative == 4;
+}
+
+// eigenvector of the smallest eigenvalue of the symmetric 9x9 a (cyclic
+// Jacobi); a is destroyed
+inline void smallest_eigenvector9(double a[81], double v[9]) {
+  double e[81] = {};
+  for (int i = 0; i < 9; i++) e[i * 9 + i] = 1.0;
+  for (int sweep = 0; sweep < 50; sweep++) {
+    double off = 0.0;
+    for (int p = 0; p < 9; p++) {
+      for (int q = p + 1; q < 9; q++) off += a[p * 9 + q] * a[p * 9 + q];
+    }
+    if (off < 1e-30) break;
+    for (int p = 0; p < 9; p++) {
+      for (int q = p + 1; q < 9; q++) {
+        if (std::fabs(a[p * 9 + q]) < 1e-300) continue;
+        const double theta = (a[q * 9 + q] - a[p * 9 + p]) / (2.0 * a[p * 9 + q]);
+        const double t = (theta >= 0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+        const double c = 1.0 / std::sqrt(t * t + 1.0), s = t * c;
+        for (int k = 0; k < 9; k++) {
+          const double akp = a[k * 9 + p], akq = a[k * 9 + q];
+          a[k * 9 + p] = c * akp - s * akq;
+          a[k * 9 + q] = s * akp + c * akq;
+        }
+        for (int k = 0; k < 9; k++) {
+          const double apk = a[p * 9 + k], aqk = a[q * 9 + k];
+          a[p * 9 + k] = c * apk - s * aqk;
+          a[q * 9 + k] = s * apk + c * aqk;
+        }
+        for (int k = 0; k < 9; k++) {
+          const double ekp = e[k * 9 + p], ekq = e[k * 9 + q];
+          e[k * 9 + p] = c * ekp - s * ekq;
+          e[k * 9 + q] = s * ekp + c * ekq;
+        }
+      }
+    }
+  }
+  int best = 0;
+  for (int i = 1; i < 9; i++) {
+    if (a[i * 9 + i] < a[best * 9 + best]) best = i;
+  }
+  for (int i = 0; i < 9; i++) v[i] = e[i * 9 + best];
+}
+
+// Least-squares homography of the listed correspondences: normalized DLT
+// (centroid at the origin, mean distance 1 per axis), then Levenberg-Marquardt
+// on the sum of squared reprojection errors with H[8] fixed to 1.
+inline bool homography_refine(const float* src, const float* dst, const int* idx, int n, float h[9]) {
+  if (n < 4) return false;
+  double cs[2] = {}, cd[2] = {}, ss[2] = {}, sd[2] = {};
+  for (int k = 0; k < n; k++) {
+    const int i = idx[k];
+    cs[0] += src[2 * i];
+    cs[1] += src[2 * i + 1];
+    cd[0] += dst[2 * i];
+    cd[1] += dst[2 * i + 1];
+  }
+  for (int c = 0; c < 2; c++) {
+    cs[c] /= n;
+    cd[c] /= n;
+  }
+  for (int k = 0; k < n; k++) {
+    const int i = idx[k];
+    for (int c = 0; c < 2; c++) {
+      ss[c] += std::fabs(src[2 * i + c] - cs[c]);
+      sd[c] += std::fabs(dst[2 * i + c] - cd[c]);
+    }
+  }
+  for (int c = 0; c < 2; c++) {
+    if (ss[c] < DBL_EPSILON || sd[c] < DBL_EPSILON) return false;
+    ss[c] = n / ss[c];
+    sd[c] = n / sd[c];
+  }
+
+  double ata[81] = {};
+  for (int k = 0; k < n; k++) {
+    const int i = idx[k];
+    const double x = (src[2 * i] - cs[0]) * ss[0], y = (src[2 * i + 1] - cs[1]) * ss[1];
+    const double u = (dst[2 * i] - cd[0]) * sd[0], v = (dst[2 * i + 1] - cd[1]) * sd[1];
+    const double r0[9] = {x, y, 1, 0, 0, 0, -u * x, -u * y, -u};
+    const double r1[9] = {0, 0, 0, x, y, 1, -v * x, -v * y, -v};
+    for (int p = 0; p < 9; p++) {
+      for (int q = p; q < 9; q++) ata[p * 9 + q] += r0[p] * r0[q] + r1[p] * r1[q];
+    }
+  }
+  for (int p = 0; p < 9; p++) {
+    for (int q = 0; q < p; q++) ata[p * 9 + q] = ata[q * 9 + p];
+  }
+  double hn[9];
+  smallest_eigenvector9(ata, hn);
+
+  // H = inv(Td) * Hn * Ts
+  const double ts[9] = {ss[0], 0, -ss[0] * cs[0], 0, ss[1], -ss[1] * cs[1], 0, 0, 1};
+  const double td_inv[9] = {1 / sd[0], 0, cd[0], 0, 1 / sd[1], cd[1], 0, 0, 1};
+  double t[9], hd[9];
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      t[r * 3 + c] = hn[r * 3] * ts[c] + hn[r * 3 + 1] * ts[3 + c] + hn[r * 3 + 2] * ts[6 + c];
+    }
+  }
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      hd[r * 3 + c] = td_inv[r * 3] * t[c] + td_inv[r * 3 + 1] * t[3 + c] + td_inv[r * 3 + 2] * t[6 + c];
+    }
+  }
+  if (std::fabs(hd[8]) < DBL_EPSILON) return false;
+  for (int i = 0; i < 9; i++) hd[i] /= hd[8];
+
+  // Levenberg-Marquardt over h0..h7
+  auto cost = [&](const double* p, double* jtj, double* jtr) {
+    double sum = 0.0;
+    if (jtj) {
+      std::fill(jtj, jtj + 64, 0.0);
+      std::fill(jtr, jtr + 8, 0.0);
+    }
+    for (int k = 0; k < n; k++) {
+      const int i = idx[k];
+      const double x = src[2 * i], y = src[2 * i + 1];
+      const double w = p[6] * x + p[7] * y + 1.0;
+      if (std::fabs(w) < DBL_EPSILON) continue;
+      const double iw = 1.0 / w;
+      const double u = (p[0] * x + p[1] * y + p[2]) * iw, v = (p[3] * x + p[4] * y + p[5]) * iw;
+      const double ru = u - dst[2 * i], rv = v - dst[2 * i + 1];
+      sum += ru * ru + rv * rv;
+      if (!jtj) continue;
+      const double ju[8] = {x * iw, y * iw, iw, 0, 0, 0, -u * x * iw, -u * y * iw};
+      const double jv[8] = {0, 0, 0, x * iw, y * iw, iw, -v * x * iw, -v * y * iw};
+      for (int a = 0; a < 8; a++) {
+        jtr[a] += ju[a] * ru + jv[a] * rv;
+        for (int b = a; b < 8; b++) jtj[a * 8 + b] += ju[a] * ju[b] + jv[a] * jv[b];
+      }
+    }
+    return sum;
+  };
+  double jtj[64], jtr[8], lambda = 1e-3;
+  double err = cost(hd, jtj, jtr);
+  for (int it = 0; it < 10; it++) {
+    double a[64], step[8], trial[9];
+    for (int r = 0; r < 8; r++) {
+      for (int c = 0; c < 8; c++) a[r * 8 + c] = r <= c ? jtj[r * 8 + c] : jtj[c * 8 + r];
+      a[r * 8 + r] *= 1.0 + lambda;
+      step[r] = -jtr[r];
+    }
+    if (!solve_dense(a, step, 8)) break;
+    for (int i = 0; i < 8; i++) trial[i] = hd[i] + step[i];
+    trial[8] = 1.0;
+    const double trial_err = cost(trial, nullptr, nullptr);
+    if (trial_err < err) {
+      std::memcpy(hd, trial, sizeof(hd));
+      const bool converged = err - trial_err < 1e-12 * err;
+      err = cost(hd, jtj, jtr);
+      lambda = std::max(lambda * 0.1, 1e-12);
+      if (converged) break;
+    } else {
+      lambda *= 10.0;
+    }
+  }
+  for (int i = 0; i < 9; i++) h[i] = (float)hd[i];
+  return true;
+}
+
+inline int ransac_padded(int count) { return (count + kHomographyLanes - 1) / kHomographyLanes * kHomographyLanes; }
+
+// SoA copies of both point sets, padded to kHomographyLanes with points
+// whose error is too large to ever count. The four arrays are 4 * padded
+// floats of mem, or of storage when no mem is given.
+struct PointsSoA {
+  float *sx, *sy, *dx, *dy;
+  int padded = 0;
+  std::vector<float> storage;
+
+  PointsSoA(const float* src, const float* dst, int n, float* mem = nullptr) {
+    padded = ransac_padded(n);
+    if (!mem) {
+      storage.resize((size_t)4 * padded);
+      mem = storage.data();
+    }
+    sx = mem;
+    sy = sx + padded;
+    dx = sy + padded;
+    dy = dx + padded;
+    std::fill(sx, dx, 0.0f);
+    std::fill(dx, dy + padded, 1e18f);
+    for (int i = 0; i < n; i++) {
+      sx[i] = src[2 * i];
+      sy[i] = src[2 * i + 1];
+      dx[i] = dst[2 * i];
+      dy[i] = dst[2 * i + 1];
+    }
+  }
+  PointsSoA(const PointsSoA&) = delete;
+  PointsSoA& operator=(const PointsSoA&) = delete;
+};
+
+// Bytes find_homography_ransac needs for count points: the padded SoA copies,
+// the reprojection errors, the inlier list and, for PROSAC, the sampling
+// schedule. The scratch of the caller-memory find_homography_ransac, and a
+// size for xr::scratch plans.
+inline size_t ransac_scratch_bytes(int count, const RansacParams& params) {
+  const size_t padded = ransac_padded(count);
+  size_t bytes = 5 * padded * sizeof(float) + (size_t)count * sizeof(int);
+  if (params.sampling == Sampling::kProsac) bytes += (size_t)params.max_iters * (sizeof(int) + 1);
+  return bytes;
+}
+
+inline bool ransac_args_ok(const float* src, const float* dst, int count, const float* h,
+                           const RansacParams& params) {
+  return src && dst && h && count >= 4 && params.max_iters >= 1 && params.threshold > 0.0f;
+}
+
+// Body of both find_homography_ransac: mem holds ransac_scratch_bytes, laid
+// out as the SoA copies, the errors, the inlier list, the PROSAC pool sizes
+// and the PROSAC with_last flags.
+inline bool ransac_run(const float* src, const float* dst, int count, float h[9], const RansacParams& params,
+                       uint8_t* mask, RansacStats* stats, const int* order, int threads, uint8_t* mem) {
+#ifdef _OPENMP
+  if (threads <= 0) threads = omp_get_max_threads();
+#else
+  (void)threads;
+#endif
+
+  uint32_t default_seeds[kRansacSeeds];
+  for (int i = 0; i < kRansacSeeds; i++) default_seeds[i] = (uint32_t)i;
+  const uint32_t* seeds = params.random_seed ? params.random_seed : default_seeds;
+  const bool prosac = params.sampling == Sampling::kProsac;
+  const PointsSoA pts(src, dst, count, reinterpret_cast<float*>(mem));
+  float* err = pts.dy + pts.padded;
+  int* inliers = reinterpret_cast<int*>(err + pts.padded);
+  int* pool = nullptr;
+  uint8_t* with_last = nullptr;
+  if (prosac) {
+    pool = inliers + count;
+    with_last = reinterpret_cast<uint8_t*>(pool + params.max_iters);
+    prosac_schedule(count, params.max_iters, pool, with_last);
+  }
+
+  const float thr2 = params.threshold * params.threshold;
+  auto count_fn = XR_SIMD_DISPATCH(count_inliers);
+
+  float best_h[9] = {};
+  int best_score = 3, best_iter = -1, bound = params.max_iters, done = 0;
+  int score[kRansacBatch];
+  float model[kRansacBatch][9];
+
+#pragma omp parallel num_threads(threads)
+  for (int b0 = 0; b0 < bound; b0 += kRansacBatch) {
+    const int batch = std::min(kRansacBatch, bound - b0);
+#pragma omp for schedule(static)
+    for (int k = 0; k < batch; k++) {
+      const int it = b0 + k;
+      RansacRng rng(seeds, it);
+      score[k] = 0;
+      // redraw degenerate samples from the same generator, like OpenCV
+      for (int attempt = 0; attempt < 100; attempt++) {
+        int idx[4];
+        int n = count, fixed = 0;
+        if (prosac) {
+          n = pool[it];
+          if (with_last[it]) {
+            idx[0] = n - 1;
+            fixed = 1;
+            n--;
+          }
+        }
+        for (int j = fixed; j < 4; j++) {
+          bool again;
+          do {
+            idx[j] = rng.below(n);
+            again = false;
+            for (int q = 0; q < j; q++) again |= idx[q] == idx[j];
+          } while (again);
+        }
+        float s[8], d[8];
+        for (int j = 0; j < 4; j++) {
+          const int p = prosac && order ? order[idx[j]] : idx[j];
+          s[2 * j] = src[2 * p];
+          s[2 * j + 1] = src[2 * p + 1];
+          d[2 * j] = dst[2 * p];
+          d[2 * j + 1] = dst[2 * p + 1];
+        }
+        if (!homography_sample_ok(s, d) || !homography_4pt(s, d, model[k])) continue;
+        score[k] = count_fn(pts.sx, pts.sy, pts.dx, pts.dy, pts.padded, model[k], thr2);
+        break;
+      }
+    }
+#pragma omp single
+    {
+      for (int k = 0; k < batch; k++) {
+        if (score[k] > best_score) {
+          best_score = score[k];
+          best_iter = b0 + k;
+          std::memcpy(best_h, model[k], sizeof(best_h));
+          bound = std::min(bound, ransac_update_iters(params.confidence, (double)(count - best_score) / count, 4,
+                                                      params.max_iters));
+        }
+      }
+      done = b0 + batch;
+    }
+  }
+
+  if (stats) {
+    stats->iterations = done;
+    stats->inliers = best_iter < 0 ? 0 : best_score;
+    stats->best_iteration = best_iter;
+  }
+  if (best_iter < 0) return false;
+
+  XR_SIMD_DISPATCH(reproj_errors)(pts.sx, pts.sy, pts.dx, pts.dy, pts.padded, best_h, err);
+  int n_in = 0;
+  for (int i = 0; i < count; i++) {
+    const bool in = err[i] <= thr2;
+    if (mask) mask[i] = in;
+    if (in) inliers[n_in++] = i;
+  }
+  std::memcpy(h, best_h, sizeof(best_h));
+  if (params.refine) {
+    float refined[9];
+    if (homography_refine(src, dst, inliers, n_in, refined)) std::memcpy(h, refined, sizeof(refined));
+  }
+  return true;
+}
+
+// Robust homography from count correspondences src[i] -> dst[i] into h (9
+// floats). mask, when given, receives 1 for the inliers of the RANSAC model.
+// For PROSAC, order lists the point indices best first (null when the points
+// are already sorted that way). threads <= 0 uses every OpenMP thread.
+inline bool find_homography_ransac(const float* src, const float* dst, int count, float h[9],
+                                   const RansacParams& params, uint8_t* mask = nullptr, RansacStats* stats = nullptr,
+                                   const int* order = nullptr, int threads = 0) {
+  if (!ransac_args_ok(src, dst, count, h, params)) return false;
+  // floats first, so the float vector keeps every part aligned
+  std::vector<float> mem((ransac_scratch_bytes(count, params) + sizeof(float) - 1) / sizeof(float));
+  return ransac_run(src, dst, count, h, params, mask, stats, order, threads, reinterpret_cast<uint8_t*>(mem.data()));
+}
+
+// The same with its temporaries in caller memory: scratch holds
+// ransac_scratch_bytes(count, params), aligned for float.
+inline bool find_homography_ransac(const float* src, const float* dst, int count, float h[9],
+                                   const RansacParams& params, void* scratch, size_t scratch_bytes,
+                                   uint8_t* mask = nullptr, RansacStats* stats = nullptr, const int* order = nullptr,
+                                   int threads = 0) {
+  if (!ransac_args_ok(src, dst, count, h, params)) return false;
+  if (!scratch || (uintptr_t)scratch % alignof(float) != 0) return false;
+  if (scratch_bytes < ransac_scratch_bytes(count, params)) return false;
+  return ransac_run(src, dst, count, h, params, mask, stats, order, threads, static_cast<uint8_t*>(scratch));
+}
+
+// Scalar inlier count, the reference for count_inliers.
+inline int count_inliers_ref(const float* src, const float* dst, int count, const float h[9], float thr2) {
+  int inliers = 0;
+  for (int i = 0; i < count; i++) {
+    const float x = src[2 * i], y = src[2 * i + 1];
+    const float w = 1.0f / (h[6] * x + h[7] * y + h[8]);
+    const float u = (h[0] * x + h[1] * y + h[2]) * w - dst[2 * i];
+    const float v = (h[3] * x + h[4] * y + h[5]) * w - dst[2 * i + 1];
+    inliers += u * u + v * v <= thr2;
+  }
+  return inliers;
+}
+
+}  // namespace homography
+}  // namespace xr
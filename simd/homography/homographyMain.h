@@ -0,0 +1,242 @@
+#pragma once
+
+// Checks the inlier counting kernel on every backend this CPU can run against
+// the scalar count, then runs RANSAC on synthetic correspondences (a known
+// perspective map, 0.3 px noise, a share of outliers): the model must map the
+// frame within 0.5 px of the truth, and the result must not change with the
+// thread count. Then compares how many hypotheses uniform sampling and PROSAC
+// need as the outlier share grows, and times the device configuration (500
+// points, threshold 1, max_iters 2000, confidence 0.9).
+//
+// Run from DSP/MTK/mtk_device_demo to also check the golden H.bin: the
+// points are tracked from cve_data/prevPts.bin with xr::flow first, as on the
+// device. Without the data that check is skipped.
+//
+// g++ -O3 -fopenmp -std=c++17 main.cpp -o homography_demo
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <vector>
+
+#include "../flow/flow.h"
+#include "homography.h"
+
+namespace xr {
+namespace homography {
+
+struct HomographyCase {
+  std::vector<float> src, dst;
+  std::vector<float> quality;  // higher for inliers, with overlap
+  std::vector<uint8_t> inlier;
+};
+
+inline void apply_h(const float h[9], float x, float y, float* u, float* v) {
+  const float w = h[6] * x + h[7] * y + h[8];
+  *u = (h[0] * x + h[1] * y + h[2]) / w;
+  *v = (h[3] * x + h[4] * y + h[5]) / w;
+}
+
+// count points in a w x h frame mapped by truth, a share outlier_ratio of
+// them replaced by random destinations
+inline HomographyCase homography_case(const float truth[9], int w, int h, int count, float outlier_ratio,
+                                      uint32_t seed) {
+  auto uniform = [&seed]() {
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) * (1.0f / (1 << 24));
+  };
+  HomographyCase c;
+  for (int i = 0; i < count; i++) {
+    const float x = uniform() * w, y = uniform() * h;
+    float u, v;
+    apply_h(truth, x, y, &u, &v);
+    const bool in = uniform() >= outlier_ratio;
+    if (in) {
+      // Box-Muller, sigma 0.3
+      const float r = 0.3f * std::sqrt(-2.0f * std::log(std::max(uniform(), 1e-7f))), t = 6.2831853f * uniform();
+      u += r * std::cos(t);
+      v += r * std::sin(t);
+    } else {
+      u = uniform() * w;
+      v = uniform() * h;
+    }
+    c.src.push_back(x);
+    c.src.push_back(y);
+    c.dst.push_back(u);
+    c.dst.push_back(v);
+    c.inlier.push_back(in);
+    c.quality.push_back(uniform() + (in ? 0.6f : 0.0f));
+  }
+  return c;
+}
+
+// largest distance between the two maps over a grid on the frame
+inline float homography_distance(const float a[9], const float b[9], int w, int h) {
+  float worst = 0.0f;
+  for (int y = 0; y <= 8; y++) {
+    for (int x = 0; x <= 8; x++) {
+      float u0, v0, u1, v1;
+      apply_h(a, x * w / 8.0f, y * h / 8.0f, &u0, &v0);
+      apply_h(b, x * w / 8.0f, y * h / 8.0f, &u1, &v1);
+      worst = std::max(worst, std::hypot(u0 - u1, v0 - v1));
+    }
+  }
+  return worst;
+}
+
+inline std::vector<int> homography_order(const HomographyCase& c) {
+  std::vector<int> order(c.quality.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return c.quality[a] > c.quality[b]; });
+  return order;
+}
+
+inline double homography_now_ms() {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F>
+inline double homography_time_ms(F&& f) {
+  f();
+  int runs = 0;
+  double t0 = homography_now_ms();
+  do {
+    f();
+    runs++;
+  } while (homography_now_ms() - t0 < 100.0);
+  return (homography_now_ms() - t0) / runs;
+}
+
+inline bool homography_read(const char* path, void* dst, size_t bytes) {
+  FILE* f = std::fopen(path, "rb");
+  if (!f) return false;
+  const bool ok = std::fread(dst, 1, bytes, f) == bytes;
+  std::fclose(f);
+  return ok;
+}
+
+}  // namespace homography
+}  // namespace xr
+
+inline int homographyMain() {
+  using namespace xr::homography;
+  using xr::simd::Isa;
+
+  bool pass = true;
+  const int w = 1920, h = 1080;
+  const float truth[9] = {1.02f, 0.03f, -14.0f, -0.025f, 0.99f, 9.5f, 2e-5f, -1e-5f, 1.0f};
+
+  const Isa all[] = {Isa::kScalar, Isa::kSSE42, Isa::kAVX2, Isa::kAVX512, Isa::kNEON};
+  const Isa initial = xr::simd::current_isa();
+  for (Isa isa : all) {
+    if (!xr::simd::set_isa(isa)) continue;
+    bool ok = true;
+    for (int count : {4, 17, 500, 1003}) {
+      const HomographyCase c = homography_case(truth, w, h, count, 0.4f, count);
+      const PointsSoA pts(c.src.data(), c.dst.data(), count);
+      for (float thr : {0.3f, 1.0f, 3.0f}) {
+        const int got = XR_SIMD_DISPATCH(count_inliers)(pts.sx, pts.sy, pts.dx, pts.dy, pts.padded, truth,
+                                                        thr * thr);
+        ok &= std::abs(got - count_inliers_ref(c.src.data(), c.dst.data(), count, truth, thr * thr)) <= 1;
+      }
+    }
+    RansacParams p;
+    const HomographyCase c = homography_case(truth, w, h, 500, 0.3f, 1);
+    float hm[9];
+    RansacStats st;
+    ok &= find_homography_ransac(c.src.data(), c.dst.data(), 500, hm, p, nullptr, &st);
+    const float dist = homography_distance(hm, truth, w, h);
+    ok &= dist < 0.5f;
+    pass &= ok;
+    printf("%-7s count ok, 30%% outliers: %d inliers after %d hypotheses, %.3f px from truth %s\n",
+           xr::simd::isa_name(isa), st.inliers, st.iterations, dist, ok ? "ok" : "FAILED");
+  }
+  xr::simd::set_isa(initial);
+
+  // same seeds, any thread count: the same model bit for bit
+  {
+    const HomographyCase c = homography_case(truth, w, h, 500, 0.5f, 2);
+    RansacParams p;
+    p.confidence = 0.995f;
+    float h1[9], hn[9];
+    RansacStats s1, sn;
+    std::vector<uint8_t> m1(500), mn(500);
+    find_homography_ransac(c.src.data(), c.dst.data(), 500, h1, p, m1.data(), &s1, nullptr, 1);
+    find_homography_ransac(c.src.data(), c.dst.data(), 500, hn, p, mn.data(), &sn, nullptr, 0);
+    const bool same = std::memcmp(h1, hn, sizeof(h1)) == 0 && m1 == mn && s1.iterations == sn.iterations;
+    int found = 0, missed = 0;
+    for (int i = 0; i < 500; i++) {
+      found += m1[i] && c.inlier[i];
+      missed += !m1[i] && c.inlier[i];
+    }
+    pass &= same && homography_distance(h1, truth, w, h) < 0.5f;
+    printf("\n50%% outliers: 1 thread and all threads %s, %d true inliers found, %d missed\n",
+           same ? "identical" : "DIFFER", found, missed);
+  }
+
+  printf("\nhypotheses until stop, confidence 0.99 (ms, all threads)\n");
+  for (float ratio : {0.2f, 0.5f, 0.7f, 0.85f}) {
+    const HomographyCase c = homography_case(truth, w, h, 500, ratio, 3);
+    const std::vector<int> order = homography_order(c);
+    RansacParams p;
+    p.confidence = 0.99f;
+    p.max_iters = 20000;
+    float hu[9], hp[9];
+    RansacStats su, sp;
+    bool ok = find_homography_ransac(c.src.data(), c.dst.data(), 500, hu, p, nullptr, &su);
+    const double tu = homography_time_ms([&] { find_homography_ransac(c.src.data(), c.dst.data(), 500, hu, p); });
+    p.sampling = Sampling::kProsac;
+    ok &= find_homography_ransac(c.src.data(), c.dst.data(), 500, hp, p, nullptr, &sp, order.data());
+    const double tp = homography_time_ms(
+        [&] { find_homography_ransac(c.src.data(), c.dst.data(), 500, hp, p, nullptr, nullptr, order.data()); });
+    const float du = homography_distance(hu, truth, w, h), dp = homography_distance(hp, truth, w, h);
+    ok &= dp < 1.0f && (ratio > 0.8f || du < 1.0f);
+    pass &= ok;
+    printf("  %2.0f%% outliers: uniform %5d (%6.3f ms, %.2f px)  PROSAC %5d (%6.3f ms, %.2f px)%s\n", ratio * 100,
+           su.iterations, tu, du, sp.iterations, tp, dp, ok ? "" : " FAILED");
+  }
+
+  // the device configuration
+  {
+    const HomographyCase c = homography_case(truth, w, h, 500, 0.3f, 4);
+    RansacParams p;
+    float hm[9];
+    const double one = homography_time_ms(
+        [&] { find_homography_ransac(c.src.data(), c.dst.data(), 500, hm, p, nullptr, nullptr, nullptr, 1); });
+    const double any = homography_time_ms([&] { find_homography_ransac(c.src.data(), c.dst.data(), 500, hm, p); });
+    p.refine = false;
+    const double raw = homography_time_ms([&] { find_homography_ransac(c.src.data(), c.dst.data(), 500, hm, p); });
+    printf("\n500 points, 30%% outliers: %.3f ms 1 thread, %.3f ms all threads, %.3f ms without refinement\n", one,
+           any, raw);
+  }
+
+  {
+    const int count = 500;
+    std::vector<uint8_t> prev((size_t)w * h), next(prev.size());
+    std::vector<float> prev_pts(count * 2), next_pts(count * 2);
+    float golden[9];
+    if (homography_read("cve_data/prevImg.bin", prev.data(), prev.size()) &&
+        homography_read("cve_data/nextImg.bin", next.data(), next.size()) &&
+        homography_read("cve_data/prevPts.bin", prev_pts.data(), prev_pts.size() * sizeof(float)) &&
+        homography_read("cve_data/H.bin", golden, sizeof(golden))) {
+      std::vector<uint8_t> status(count);
+      xr::flow::LkParams lk;
+      xr::flow::calc_optical_flow_pyr_lk(prev.data(), next.data(), w, w, h, prev_pts.data(), count, next_pts.data(),
+                                         status.data(), lk);
+      RansacParams p;
+      float hm[9];
+      RansacStats st;
+      pass &= find_homography_ransac(prev_pts.data(), next_pts.data(), count, hm, p, nullptr, &st);
+      float worst = 0.0f;
+      for (int i = 0; i < 9; i++) worst = std::max(worst, std::fabs(hm[i] - golden[i]));
+      pass &= worst <= 1e-4f;
+      printf("\ncve_data: %d inliers, max |H - H.bin| %.2e %s\n", st.inliers, worst, worst <= 1e-4f ? "ok" : "FAILED");
+    } else {
+      printf("\nno cve_data here, golden H.bin check skipped\n");
+    }
+  }
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
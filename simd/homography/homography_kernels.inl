@@ -0,0 +1,37 @@
+// Homography scoring kernels, expanded per backend by xr_simd_foreach.h from
+// homography.h. Points are SoA (src x, src y, dst x, dst y), padded to a
+// multiple of kHomographyLanes with points that are never inliers.
+
+// squared reprojection error |H * src - dst|^2 of N points
+inline vf32 reproj_err2(vf32 sx, vf32 sy, vf32 dx, vf32 dy, const vf32 h[9]) {
+  vf32 w = fma(h[6], sx, fma(h[7], sy, h[8]));
+  vf32 inv = div(set1_f32(1.0f), w);
+  vf32 u = sub(mul(fma(h[0], sx, fma(h[1], sy, h[2])), inv), dx);
+  vf32 v = sub(mul(fma(h[3], sx, fma(h[4], sy, h[5])), inv), dy);
+  return fma(u, u, mul(v, v));
+}
+
+// number of points with error <= thr2; n is padded
+inline int count_inliers(const float* sx, const float* sy, const float* dx, const float* dy, int n, const float* h9,
+                         float thr2) {
+  vf32 h[9];
+  for (int i = 0; i < 9; i++) h[i] = set1_f32(h9[i]);
+  const vf32 t = set1_f32(thr2);
+  vi32 count = zero_i32();
+  for (int i = 0; i < n; i += vf32::N) {
+    vf32 e = reproj_err2(loadu(sx + i), loadu(sy + i), loadu(dx + i), loadu(dy + i), h);
+    // true lanes are -1
+    count = sub(count, as_i32(cmple(e, t)));
+  }
+  return reduce_add(count);
+}
+
+// squared errors of every point; n is padded
+inline void reproj_errors(const float* sx, const float* sy, const float* dx, const float* dy, int n, const float* h9,
+                          float* err2) {
+  vf32 h[9];
+  for (int i = 0; i < 9; i++) h[i] = set1_f32(h9[i]);
+  for (int i = 0; i < n; i += vf32::N) {
+    storeu(err2 + i, reproj_err2(loadu(sx + i), loadu(sy + i), loadu(dx + i), loadu(dy + i), h));
+  }
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+// Mixed-precision matrix multiply for weight-bound layers: B (the weights) is
+// stored as fp16 or 8-bit integers and A, C and all accumulation stay fp32.
+//
+//   fp16   hgemm, half the bytes of fp32, ~2e-4 relative error
+//   int8   symmetric, q in [-127, 127], x = q * scale
+//   uint8  asymmetric, q in [0, 255], x = (q - zero_point) * scale
+//
+// The 8-bit schemes take one scale (and zero point) for the whole matrix
+// (per-tensor) or one per output column (per-channel), which follows columns
+// with very different ranges much more closely.
+//
+// Short A (m <= kSmallM, the batch-1 GEMV case) is bound by reading B, so it
+// streams the narrow B once and widens it in registers. Longer A reuses every
+// element of B m times; there B is expanded to fp32 a KC x NC tile at a time
+// and handed to the packed sgemm, which costs k * n conversions against
+// 2 * m * n * k flops.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../gemm/gemm.h"
+#include "../xr_simd.h"
+
+namespace xr {
+namespace quant {
+
+constexpr int kSmallM = 4;
+
+#define XR_SIMD_KERNELS "quant/quant_kernels.inl"
+#include "../xr_simd_foreach.h"
+
+enum class QuantScheme {
+  kSymmetric,   // int8, zero point 0
+  kAsymmetric,  // uint8 with a zero point
+};
+
+struct QuantParams {
+  float scale = 1.0f;
+  int32_t zero_point = 0;
+};
+
+// Parameters covering [lo, hi]. The range is widened to include 0 so that 0
+// is exactly representable (zero padding stays zero after a round trip).
+inline QuantParams choose_params(float lo, float hi, QuantScheme scheme) {
+  lo = std::min(lo, 0.0f);
+  hi = std::max(hi, 0.0f);
+  QuantParams p;
+  if (scheme == QuantScheme::kSymmetric) {
+    const float amax = std::max(-lo, hi);
+    p.scale = amax > 0.0f ? amax / 127.0f : 1.0f;
+  } else {
+    p.scale = hi > lo ? (hi - lo) / 255.0f : 1.0f;
+    p.zero_point = std::min(255, std::max(0, (int)std::nearbyint(-lo / p.scale)));
+  }
+  return p;
+}
+
+// A rows x cols row-major matrix in 8 bits. scale and zero always hold cols
+// entries; per-tensor quantization repeats the same value.
+struct QuantizedMatrix {
+  int rows = 0, cols = 0;
+  QuantScheme scheme = QuantScheme::kSymmetric;
+  bool per_channel = false;
+  std::vector<int8_t> s8;   // kSymmetric data
+  std::vector<uint8_t> u8;  // kAsymmetric data
+  std::vector<float> scale;
+  std::vector<int32_t> zero;
+};
+
+inline int quant_threads(int threads) {
+#ifdef _OPENMP
+  return threads <= 0 ? omp_get_max_threads() : threads;
+#else
+  (void)threads;
+  return 1;
+#endif
+}
+
+// Quantizes B (rows x cols, row stride ldb); per_channel picks one scale per
+// column. Weights are quantized once, so the range scan stays scalar.
+inline QuantizedMatrix quantize(const float* b, int rows, int cols, int ldb, QuantScheme scheme, bool per_channel,
+                                int threads = 0) {
+  QuantizedMatrix q;
+  if (rows <= 0 || cols <= 0) return q;
+  q.rows = rows;
+  q.cols = cols;
+  q.scheme = scheme;
+  q.per_channel = per_channel;
+
+  std::vector<float> lo(cols, b[0]), hi(cols, b[0]);
+  for (int r = 0; r < rows; r++) {
+    const float* row = b + (size_t)r * ldb;
+    for (int j = 0; j < cols; j++) {
+      lo[j] = std::min(lo[j], row[j]);
+      hi[j] = std::max(hi[j], row[j]);
+    }
+  }
+  if (!per_channel) {
+    const float l = *std::min_element(lo.begin(), lo.end()), h = *std::max_element(hi.begin(), hi.end());
+    std::fill(lo.begin(), lo.end(), l);
+    std::fill(hi.begin(), hi.end(), h);
+  }
+  q.scale.resize(cols);
+  q.zero.resize(cols);
+  std::vector<float> inv_scale(cols);
+  for (int j = 0; j < cols; j++) {
+    QuantParams p = choose_params(lo[j], hi[j], scheme);
+    q.scale[j] = p.scale;
+    q.zero[j] = p.zero_point;
+    inv_scale[j] = 1.0f / p.scale;
+  }
+
+  if (scheme == QuantScheme::kSymmetric) {
+    q.s8.resize((size_t)rows * cols);
+    auto row_fn = XR_SIMD_DISPATCH(quantize_s8_row);
+#pragma omp parallel for schedule(static) num_threads(quant_threads(threads))
+    for (int r = 0; r < rows; r++) {
+      row_fn(b + (size_t)r * ldb, q.s8.data() + (size_t)r * cols, cols, inv_scale.data(), q.zero.data());
+    }
+  } else {
+    q.u8.resize((size_t)rows * cols);
+    auto row_fn = XR_SIMD_DISPATCH(quantize_u8_row);
+#pragma omp parallel for schedule(static) num_threads(quant_threads(threads))
+    for (int r = 0; r < rows; r++) {
+      row_fn(b + (size_t)r * ldb, q.u8.data() + (size_t)r * cols, cols, inv_scale.data(), q.zero.data());
+    }
+  }
+  return q;
+}
+
+// Expands q back to fp32 into b (row stride ldb).
+inline void dequantize(const QuantizedMatrix& q, float* b, int ldb, int threads = 0) {
+  auto s8_fn = XR_SIMD_DISPATCH(dequantize_s8_row);
+  auto u8_fn = XR_SIMD_DISPATCH(dequantize_u8_row);
+  const bool sym = q.scheme == QuantScheme::kSymmetric;
+#pragma omp parallel for schedule(static) num_threads(quant_threads(threads))
+  for (int r = 0; r < q.rows; r++) {
+    const size_t o = (size_t)r * q.cols;
+    if (sym) {
+      s8_fn(q.s8.data() + o, b + (size_t)r * ldb, q.cols, q.scale.data(), q.zero.data());
+    } else {
+      u8_fn(q.u8.data() + o, b + (size_t)r * ldb, q.cols, q.scale.data(), q.zero.data());
+    }
+  }
+}
+
+// fp32 <-> fp16 (IEEE binary16, round to nearest even) for n contiguous values
+inline void to_half(const float* x, uint16_t* h, size_t n) {
+  auto fn = XR_SIMD_DISPATCH(f32_to_f16_row);
+  for (size_t i = 0; i < n; i += 1 << 30) fn(x + i, h + i, (int)std::min<size_t>(n - i, 1 << 30));
+}
+
+inline void from_half(const uint16_t* h, float* x, size_t n) {
+  auto fn = XR_SIMD_DISPATCH(f16_to_f32_row);
+  for (size_t i = 0; i < n; i += 1 << 30) fn(h + i, x + i, (int)std::min<size_t>(n - i, 1 << 30));
+}
+
+// Runs small_m(j0, j1) over column slices of 64, one per thread, like the
+// unpacked path of sgemm.
+template <typename F>
+inline void for_each_slice(int n, int threads, F&& small_m) {
+  const int slices = std::max(1, std::min(threads, n / 64));
+#pragma omp parallel for schedule(static) num_threads(threads)
+  for (int s = 0; s < slices; s++) {
+    int j0 = (int)((int64_t)n * s / slices) / 64 * 64;
+    int j1 = s + 1 == slices ? n : (int)((int64_t)n * (s + 1) / slices) / 64 * 64;
+    small_m(j0, j1);
+  }
+}
+
+// C = A * B where unpack(p, j0, cols, dst) writes fp32 row p of B from column
+// j0 on. B is expanded one kKTile x kNTile tile at a time, small enough to
+// stay in L2/L3 while sgemm packs it.
+template <typename F>
+inline void gemm_unpacked_b(int m, int n, int k, const float* a, int lda, float* c, int ldc, int threads,
+                            F&& unpack) {
+  constexpr int kKTile = 256, kNTile = 2048;
+  const int kt = std::min(kKTile, k), nt = std::min(kNTile, n);
+  float* tile = (float*)xr::simd::aligned_malloc(sizeof(float) * kt * nt);
+  for (int jc = 0; jc < n; jc += kNTile) {
+    const int nc = std::min(kNTile, n - jc);
+    for (int pc = 0; pc < k; pc += kKTile) {
+      const int kc = std::min(kKTile, k - pc);
+#pragma omp parallel for schedule(static) num_threads(threads)
+      for (int p = 0; p < kc; p++) unpack(pc + p, jc, nc, tile + (size_t)p * nc);
+      xr::gemm::sgemm(false, false, m, nc, kc, 1.0f, a + pc, lda, tile, nc, pc == 0 ? 0.0f : 1.0f, c + jc, ldc,
+                      threads);
+    }
+  }
+  xr::simd::aligned_free(tile);
+}
+
+// C = A * B with B (k x n, row stride ldb) in fp16; A and C are fp32, all
+// row-major. threads <= 0 uses every OpenMP thread.
+inline void hgemm(int m, int n, int k, const float* a, int lda, const uint16_t* b, int ldb, float* c, int ldc,
+                  int threads = 0) {
+  if (m <= 0 || n <= 0) return;
+  if (k <= 0) {
+    for (int i = 0; i < m; i++) std::fill(c + (size_t)i * ldc, c + (size_t)i * ldc + n, 0.0f);
+    return;
+  }
+  threads = quant_threads(threads);
+  if (m <= kSmallM) {
+    auto gemv = XR_SIMD_DISPATCH(gemv_f16);
+    for_each_slice(n, threads, [&](int j0, int j1) { gemv(m, j1 - j0, k, a, lda, b + j0, ldb, c + j0, ldc); });
+    return;
+  }
+  auto row_fn = XR_SIMD_DISPATCH(f16_to_f32_row);
+  gemm_unpacked_b(m, n, k, a, lda, c, ldc, threads, [&](int p, int j0, int cols, float* dst) {
+    row_fn(b + (size_t)p * ldb + j0, dst, cols);
+  });
+}
+
+// C = A * B with B quantized (b.rows == k, b.cols == n). Returns false on a
+// shape mismatch.
+inline bool qgemm(int m, int n, int k, const float* a, int lda, const QuantizedMatrix& b, float* c, int ldc,
+                  int threads = 0) {
+  if (b.rows != k || b.cols != n) return false;
+  if (m <= 0 || n <= 0) return true;
+  if (k <= 0) {
+    for (int i = 0; i < m; i++) std::fill(c + (size_t)i * ldc, c + (size_t)i * ldc + n, 0.0f);
+    return true;
+  }
+  threads = quant_threads(threads);
+  const bool sym = b.scheme == QuantScheme::kSymmetric;
+  const float* scale = b.scale.data();
+  const int32_t* zero = b.zero.data();
+  if (m <= kSmallM) {
+    auto gemv_s8_fn = XR_SIMD_DISPATCH(gemv_s8);
+    auto gemv_u8_fn = XR_SIMD_DISPATCH(gemv_u8);
+    for_each_slice(n, threads, [&](int j0, int j1) {
+      if (sym) {
+        gemv_s8_fn(m, j1 - j0, k, a, lda, b.s8.data() + j0, n, scale + j0, nullptr, c + j0, ldc);
+      } else {
+        gemv_u8_fn(m, j1 - j0, k, a, lda, b.u8.data() + j0, n, scale + j0, zero + j0, c + j0, ldc);
+      }
+    });
+    return true;
+  }
+  auto s8_fn = XR_SIMD_DISPATCH(dequantize_s8_row);
+  auto u8_fn = XR_SIMD_DISPATCH(dequantize_u8_row);
+  gemm_unpacked_b(m, n, k, a, lda, c, ldc, threads, [&](int p, int j0, int cols, float* dst) {
+    const size_t o = (size_t)p * n + j0;
+    if (sym) {
+      s8_fn(b.s8.data() + o, dst, cols, scale + j0, zero + j0);
+    } else {
+      u8_fn(b.u8.data() + o, dst, cols, scale + j0, zero + j0);
+    }
+  });
+  return true;
+}
+
+}  // namespace quant
+}  // namespace xr
@@ -0,0 +1,200 @@
+#pragma once
+
+// Checks the fp16 and 8-bit paths on every backend this CPU can run:
+// conversions and quantize / dequantize must match a scalar reference bit for
+// bit, and hgemm / qgemm must match a double GEMM on the stored (rounded)
+// weights. Then reports what the narrow storage costs in accuracy against the
+// fp32 sgemm result, and what it buys in time for GEMV (batch 1, reading B
+// dominates) and GEMM (m = 256, flops dominate).
+//
+// g++ -O3 -fopenmp -std=c++17 main.cpp -o quant_demo
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "quant.h"
+
+namespace xr {
+namespace quant {
+
+// 24-bit values in [-1, 1) (so fp16 has to round them) scaled per column by 2^(j % 7 - 3), so per-channel
+// scales have something to win
+inline std::vector<float> quant_random(int rows, int cols, uint32_t seed, bool column_ranges) {
+  std::vector<float> v((size_t)rows * cols);
+  for (int r = 0; r < rows; r++) {
+    for (int j = 0; j < cols; j++) {
+      seed = seed * 1664525u + 1013904223u;
+      float x = (float)((int)(seed >> 8) - (1 << 23)) / (float)(1 << 23);
+      v[(size_t)r * cols + j] = column_ranges ? std::ldexp(x, j % 7 - 3) : x;
+    }
+  }
+  return v;
+}
+
+// relative L2 error of got against ref
+inline double quant_rel_err(const std::vector<float>& got, const std::vector<double>& ref) {
+  double num = 0.0, den = 0.0;
+  for (size_t i = 0; i < ref.size(); i++) {
+    num += (got[i] - ref[i]) * (got[i] - ref[i]);
+    den += ref[i] * ref[i];
+  }
+  return den > 0.0 ? std::sqrt(num / den) : std::sqrt(num);
+}
+
+inline std::vector<double> gemm_ref(int m, int n, int k, const std::vector<float>& a, const std::vector<float>& b) {
+  std::vector<double> c((size_t)m * n, 0.0);
+  for (int i = 0; i < m; i++) {
+    for (int p = 0; p < k; p++) {
+      const double aip = a[(size_t)i * k + p];
+      for (int j = 0; j < n; j++) c[(size_t)i * n + j] += aip * b[(size_t)p * n + j];
+    }
+  }
+  return c;
+}
+
+// bit-exact conversions on the current backend
+inline bool quant_check_convert() {
+  bool ok = true;
+  for (int n : {1, 7, 16, 33, 64, 100, 1000}) {
+    std::vector<float> x = quant_random(1, n, n, true), back(n);
+    x[0] = 65504.0f * 2.0f;  // overflows to inf
+    if (n > 1) x[1] = 1e-7f;  // fp16 subnormal
+    std::vector<uint16_t> h(n);
+    to_half(x.data(), h.data(), n);
+    from_half(h.data(), back.data(), n);
+    for (int i = 0; i < n; i++) {
+      ok &= h[i] == xr::simd::f32_to_f16(x[i]);
+      ok &= back[i] == xr::simd::f16_to_f32(h[i]);
+    }
+
+    for (QuantScheme scheme : {QuantScheme::kSymmetric, QuantScheme::kAsymmetric}) {
+      for (bool per_channel : {false, true}) {
+        const int rows = 3;
+        std::vector<float> b = quant_random(rows, n, 3 * n + 1, true), deq((size_t)rows * n);
+        QuantizedMatrix q = quantize(b.data(), rows, n, n, scheme, per_channel);
+        dequantize(q, deq.data(), n);
+        for (int r = 0; r < rows; r++) {
+          for (int j = 0; j < n; j++) {
+            const size_t i = (size_t)r * n + j;
+            const int32_t v = (int32_t)std::nearbyint(b[i] * (1.0f / q.scale[j])) + q.zero[j];
+            const int32_t stored = scheme == QuantScheme::kSymmetric ? q.s8[i] : q.u8[i];
+            const int32_t want = scheme == QuantScheme::kSymmetric ? std::min(127, std::max(-127, v))
+                                                                    : std::min(255, std::max(0, v));
+            ok &= stored == want;
+            ok &= deq[i] == (float)(stored - q.zero[j]) * q.scale[j];
+          }
+        }
+      }
+    }
+  }
+  return ok;
+}
+
+// worst error of hgemm / qgemm against a double GEMM on the same stored B
+inline double quant_check_gemm() {
+  double worst = 0.0;
+  const int shapes[][3] = {{1, 1, 1}, {1, 100, 37}, {3, 257, 64}, {4, 64, 300}, {5, 130, 70}, {64, 2100, 300}};
+  for (const auto& s : shapes) {
+    const int m = s[0], n = s[1], k = s[2];
+    std::vector<float> a = quant_random(m, k, 11 * m + k, false), b = quant_random(k, n, n, true);
+    std::vector<float> c((size_t)m * n), stored((size_t)k * n);
+
+    std::vector<uint16_t> h(b.size());
+    to_half(b.data(), h.data(), b.size());
+    from_half(h.data(), stored.data(), h.size());
+    hgemm(m, n, k, a.data(), k, h.data(), n, c.data(), n);
+    worst = std::max(worst, quant_rel_err(c, gemm_ref(m, n, k, a, stored)));
+
+    for (QuantScheme scheme : {QuantScheme::kSymmetric, QuantScheme::kAsymmetric}) {
+      QuantizedMatrix q = quantize(b.data(), k, n, n, scheme, true);
+      dequantize(q, stored.data(), n);
+      if (!qgemm(m, n, k, a.data(), k, q, c.data(), n)) return 1.0;
+      worst = std::max(worst, quant_rel_err(c, gemm_ref(m, n, k, a, stored)));
+    }
+  }
+  return worst;
+}
+
+inline double quant_now_ms() {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F>
+inline double quant_time_ms(F&& f) {
+  f();
+  int runs = 0;
+  double t0 = quant_now_ms();
+  do {
+    f();
+    runs++;
+  } while (quant_now_ms() - t0 < 100.0);
+  return (quant_now_ms() - t0) / runs;
+}
+
+}  // namespace quant
+}  // namespace xr
+
+inline int quantMain() {
+  using namespace xr::simd;
+  using namespace xr::quant;
+
+  const Isa all[] = {Isa::kScalar, Isa::kSSE42, Isa::kAVX2, Isa::kAVX512, Isa::kNEON};
+  const Isa initial = current_isa();
+  bool pass = true;
+  for (Isa isa : all) {
+    if (!set_isa(isa)) continue;
+    bool exact = quant_check_convert();
+    double worst = quant_check_gemm();
+    bool ok = exact && worst < 1e-5;
+    pass &= ok;
+    printf("%-7s convert %s, gemm rel err %.2e %s\n", isa_name(isa), exact ? "exact" : "MISMATCH", worst,
+           ok ? "ok" : "FAILED");
+  }
+  set_isa(initial);
+
+  // accuracy of each storage format against the fp32 result
+  const int k = 4096, n = 4096;
+  std::vector<float> b = quant_random(k, n, 5, true);
+  std::vector<uint16_t> h(b.size());
+  to_half(b.data(), h.data(), b.size());
+  QuantizedMatrix s8_tensor = quantize(b.data(), k, n, n, QuantScheme::kSymmetric, false);
+  QuantizedMatrix s8_channel = quantize(b.data(), k, n, n, QuantScheme::kSymmetric, true);
+  QuantizedMatrix u8_channel = quantize(b.data(), k, n, n, QuantScheme::kAsymmetric, true);
+
+  struct Variant {
+    const char* name;
+    double bytes_per_weight;
+    std::function<void(int, const float*, float*)> run;  // (m, A, C)
+  };
+  const Variant variants[] = {
+      {"fp32", 4.0, [&](int m, const float* a, float* c) { xr::gemm::sgemm(m, n, k, a, b.data(), c); }},
+      {"fp16", 2.0, [&](int m, const float* a, float* c) { hgemm(m, n, k, a, k, h.data(), n, c, n); }},
+      {"int8 tensor", 1.0, [&](int m, const float* a, float* c) { qgemm(m, n, k, a, k, s8_tensor, c, n); }},
+      {"int8 channel", 1.0, [&](int m, const float* a, float* c) { qgemm(m, n, k, a, k, s8_channel, c, n); }},
+      {"uint8 channel", 1.0, [&](int m, const float* a, float* c) { qgemm(m, n, k, a, k, u8_channel, c, n); }},
+  };
+
+  const int batches[] = {1, 256};
+  for (int m : batches) {
+    std::vector<float> a = quant_random(m, k, 9, false), c((size_t)m * n);
+    std::vector<double> ref((size_t)m * n);
+    variants[0].run(m, a.data(), c.data());
+    std::copy(c.begin(), c.end(), ref.begin());
+    printf("\nm %d, n %d, k %d (%s)\n", m, n, k, isa_name(current_isa()));
+    printf("%-14s %10s %10s %10s %10s\n", "", "rel err", "ms", "GB/s of B", "GFLOP/s");
+    for (const Variant& v : variants) {
+      v.run(m, a.data(), c.data());
+      double err = quant_rel_err(c, ref);
+      double ms = quant_time_ms([&] { v.run(m, a.data(), c.data()); });
+      printf("%-14s %10.2e %10.3f %10.2f %10.2f\n", v.name, err, ms, v.bytes_per_weight * k * n * 1e-6 / ms,
+             2.0 * m * n * k * 1e-6 / ms);
+    }
+  }
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
@@ -0,0 +1,178 @@
+// Mixed-precision kernels, expanded per backend by xr_simd_foreach.h from
+// quant.h. Storage is fp16, int8 or uint8; all arithmetic is fp32. Per-column
+// arrays (scale, inv_scale, zero) hold one entry per element of the row, so
+// per-tensor parameters are simply repeated. The scalar tails compute exactly
+// what the vector body does, so results do not depend on the width or the ISA.
+
+// fp32 <-> fp16, round to nearest even
+inline void f32_to_f16_row(const float* x, uint16_t* h, int n) {
+  int i = 0;
+  for (; i + vf32::N <= n; i += vf32::N) store_f16(h + i, loadu(x + i));
+  for (; i < n; i++) h[i] = ::xr::simd::f32_to_f16(x[i]);
+}
+
+inline void f16_to_f32_row(const uint16_t* h, float* x, int n) {
+  int i = 0;
+  for (; i + vf32::N <= n; i += vf32::N) storeu(x + i, load_f16(h + i));
+  for (; i < n; i++) x[i] = ::xr::simd::f16_to_f32(h[i]);
+}
+
+// round(x * inv_scale) + zero, still in 32 bits; cvt_i32 rounds to nearest
+// even like std::nearbyint in the tails
+inline vi32 quantize_i32(const float* x, const float* inv_scale, const int32_t* zero) {
+  return add(cvt_i32(mul(loadu(x), loadu(inv_scale))), loadu(zero));
+}
+
+inline int32_t quantize_one(float x, float inv_scale, int32_t zero) {
+  return (int32_t)std::nearbyint(x * inv_scale) + zero;
+}
+
+// int8 in [-127, 127]; -128 is left out so the range stays symmetric
+inline void quantize_s8_row(const float* x, int8_t* q, int n, const float* inv_scale, const int32_t* zero) {
+  constexpr int F = vf32::N;
+  const vi16 lo = set1_i16(-127), hi = set1_i16(127);
+  int i = 0;
+  for (; i + vi8::N <= n; i += vi8::N) {
+    vi32 a = quantize_i32(x + i, inv_scale + i, zero + i);
+    vi32 b = quantize_i32(x + i + F, inv_scale + i + F, zero + i + F);
+    vi32 c = quantize_i32(x + i + 2 * F, inv_scale + i + 2 * F, zero + i + 2 * F);
+    vi32 d = quantize_i32(x + i + 3 * F, inv_scale + i + 3 * F, zero + i + 3 * F);
+    vi16 ab = min(max(narrow_sat_i16(a, b), lo), hi);
+    vi16 cd = min(max(narrow_sat_i16(c, d), lo), hi);
+    storeu(q + i, narrow_sat_i8(ab, cd));
+  }
+  for (; i < n; i++) q[i] = (int8_t)std::min(127, std::max(-127, quantize_one(x[i], inv_scale[i], zero[i])));
+}
+
+inline void quantize_u8_row(const float* x, uint8_t* q, int n, const float* inv_scale, const int32_t* zero) {
+  constexpr int F = vf32::N;
+  int i = 0;
+  for (; i + vu8::N <= n; i += vu8::N) {
+    vi32 a = quantize_i32(x + i, inv_scale + i, zero + i);
+    vi32 b = quantize_i32(x + i + F, inv_scale + i + F, zero + i + F);
+    vi32 c = quantize_i32(x + i + 2 * F, inv_scale + i + 2 * F, zero + i + 2 * F);
+    vi32 d = quantize_i32(x + i + 3 * F, inv_scale + i + 3 * F, zero + i + 3 * F);
+    storeu(q + i, narrow_sat_u8(narrow_sat_i16(a, b), narrow_sat_i16(c, d)));
+  }
+  for (; i < n; i++) q[i] = (uint8_t)std::min(255, std::max(0, quantize_one(x[i], inv_scale[i], zero[i])));
+}
+
+// 4 * vf32::N stored values -> 4 fp32 vectors
+inline void load4_f32(const int8_t* p, vf32 out[4]) {
+  vi8 q = loadu(p);
+  vi16 lo = widen_lo(q), hi = widen_hi(q);
+  out[0] = cvt_f32(widen_lo(lo));
+  out[1] = cvt_f32(widen_hi(lo));
+  out[2] = cvt_f32(widen_lo(hi));
+  out[3] = cvt_f32(widen_hi(hi));
+}
+
+inline void load4_f32(const uint8_t* p, vf32 out[4]) {
+  vu8 q = loadu(p);
+  vu16 lo = widen_lo(q), hi = widen_hi(q);
+  out[0] = cvt_f32(widen_lo(lo));
+  out[1] = cvt_f32(widen_hi(lo));
+  out[2] = cvt_f32(widen_lo(hi));
+  out[3] = cvt_f32(widen_hi(hi));
+}
+
+// uint16_t storage is always fp16 here
+inline void load4_f32(const uint16_t* p, vf32 out[4]) {
+  for (int t = 0; t < 4; t++) out[t] = load_f16(p + t * vf32::N);
+}
+
+inline float load1_f32(int8_t q) { return (float)q; }
+inline float load1_f32(uint8_t q) { return (float)q; }
+inline float load1_f32(uint16_t h) { return ::xr::simd::f16_to_f32(h); }
+
+// x = (q - zero) * scale; the subtraction is exact in int32
+template <typename T>
+inline void dequantize_row(const T* q, float* x, int n, const float* scale, const int32_t* zero) {
+  constexpr int F = vf32::N;
+  int i = 0;
+  for (; i + 4 * F <= n; i += 4 * F) {
+    vf32 v[4];
+    load4_f32(q + i, v);
+    for (int t = 0; t < 4; t++) {
+      vf32 z = cvt_f32(loadu(zero + i + t * F));
+      storeu(x + i + t * F, mul(sub(v[t], z), loadu(scale + i + t * F)));
+    }
+  }
+  for (; i < n; i++) x[i] = (float)((int32_t)q[i] - zero[i]) * scale[i];
+}
+
+inline void dequantize_s8_row(const int8_t* q, float* x, int n, const float* scale, const int32_t* zero) {
+  dequantize_row(q, x, n, scale, zero);
+}
+
+inline void dequantize_u8_row(const uint8_t* q, float* x, int n, const float* scale, const int32_t* zero) {
+  dequantize_row(q, x, n, scale, zero);
+}
+
+// C = A * B for m <= kSmallM with B stored in T: B is streamed once and
+// widened in registers, so the bytes read are those of the narrow type. With
+// scale set, C[i][j] = scale[j] * (sum_p a_ip q_pj - zero[j] * sum_p a_ip),
+// which moves the zero point out of the inner loop. zero may be null.
+template <typename T>
+inline void gemv_narrow(int m, int n, int k, const float* a, ptrdiff_t lda, const T* b, ptrdiff_t ldb,
+                        const float* scale, const int32_t* zero, float* c, ptrdiff_t ldc) {
+  constexpr int kChunk = 4096;
+  constexpr int B = 4 * vf32::N;
+  alignas(64) float acc[kSmallM][kChunk];
+  float asum[kSmallM] = {};
+  for (int i = 0; i < m; i++) {
+    for (int p = 0; p < k; p++) asum[i] += a[i * lda + p];
+  }
+  for (int j0 = 0; j0 < n; j0 += kChunk) {
+    const int w = std::min(kChunk, n - j0);
+    const int wv = w / B * B;
+    for (int i = 0; i < m; i++) std::fill(acc[i], acc[i] + w, 0.0f);
+    for (int p = 0; p < k; p++) {
+      const T* brow = b + p * ldb + j0;
+      int j = 0;
+      for (; j < wv; j += B) {
+        vf32 v[4];
+        load4_f32(brow + j, v);
+        for (int i = 0; i < m; i++) {
+          const vf32 av = set1_f32(a[i * lda + p]);
+          float* row = acc[i] + j;
+          for (int t = 0; t < 4; t++) store(row + t * vf32::N, fma(av, v[t], load(row + t * vf32::N)));
+        }
+      }
+      for (; j < w; j++) {
+        const float bj = load1_f32(brow[j]);
+        for (int i = 0; i < m; i++) acc[i][j] += a[i * lda + p] * bj;
+      }
+    }
+    for (int i = 0; i < m; i++) {
+      float* crow = c + i * ldc + j0;
+      const vf32 vsum = set1_f32(asum[i]);
+      int j = 0;
+      for (; j + vf32::N <= w; j += vf32::N) {
+        vf32 r = load(acc[i] + j);
+        if (zero) r = sub(r, mul(cvt_f32(loadu(zero + j0 + j)), vsum));
+        storeu(crow + j, scale ? mul(r, loadu(scale + j0 + j)) : r);
+      }
+      for (; j < w; j++) {
+        float r = acc[i][j];
+        if (zero) r -= (float)zero[j0 + j] * asum[i];
+        crow[j] = scale ? r * scale[j0 + j] : r;
+      }
+    }
+  }
+}
+
+inline void gemv_f16(int m, int n, int k, const float* a, ptrdiff_t lda, const uint16_t* b, ptrdiff_t ldb, float* c,
+                     ptrdiff_t ldc) {
+  gemv_narrow(m, n, k, a, lda, b, ldb, nullptr, nullptr, c, ldc);
+}
+
+inline void gemv_s8(int m, int n, int k, const float* a, ptrdiff_t lda, const int8_t* b, ptrdiff_t ldb,
+                    const float* scale, const int32_t* zero, float* c, ptrdiff_t ldc) {
+  gemv_narrow(m, n, k, a, lda, b, ldb, scale, zero, c, ldc);
+}
+
+inline void gemv_u8(int m, int n, int k, const float* a, ptrdiff_t lda, const uint8_t* b, ptrdiff_t ldb,
+                    const float* scale, const int32_t* zero, float* c, ptrdiff_t ldc) {
+  gemv_narrow(m, n, k, a, lda, b, ldb, scale, zero, c, ldc);
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+// Scratch-memory planner for fused kernels. A fused kernel runs a fixed
+// sequence of stages, and each of its temporaries is used by a contiguous
+// run of them. The temporaries are declared with their size (from the shape
+// functions of the modules that use them, e.g. xr::flow::flow_pyramid_bytes)
+// and their first and last stage. plan_scratch gives every temporary an
+// offset in one arena so that two temporaries share bytes only when their
+// stages do not overlap:
+//
+//   - greedy by size: the largest temporaries are placed first, each into the
+//     tightest gap left between the already placed ones it overlaps in time,
+//     or above all of them
+//   - the plan reports the arena peak, the sum of all temporaries (what
+//     separate allocations would take) and the largest sum live in any one
+//     stage, which no plan can go below
+//
+// With guard > 0 every temporary gets guard canary bytes on each side.
+// scratch_arena_init fills them, and scratch_arena_check, run after any stage,
+// names the temporaries whose canaries were overwritten. This is a runtime
+// check that the shape functions are not too small for the kernels that use
+// the memory.
+//
+// Functions return false for arguments they do not support.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../xr_simd.h"
+
+namespace xr {
+namespace scratch {
+
+constexpr uint8_t kCanary = 0xA5;
+
+struct ScratchBuffer {
+  std::string name;
+  size_t bytes = 0;
+  size_t align = 64;
+  int first = 0, last = 0;  // stages that use it, inclusive
+  size_t offset = 0;        // in the arena, set by plan_scratch
+};
+
+struct ScratchPlan {
+  std::vector<ScratchBuffer> buffers;
+  std::vector<std::string> stages;
+  size_t guard = 0;  // canary bytes before and after every buffer
+  size_t peak = 0;   // arena bytes
+  size_t total = 0;  // every buffer on its own, guards included
+  size_t live = 0;   // most bytes live in one stage, guards included
+  std::vector<size_t> stage_bytes;  // bytes live per stage
+};
+
+inline int add_scratch_stage(ScratchPlan& p, const std::string& name) {
+  p.stages.push_back(name);
+  return (int)p.stages.size() - 1;
+}
+
+// Declares a temporary used by stages first..last; returns its index, or -1.
+inline int add_scratch(ScratchPlan& p, const std::string& name, size_t bytes, int first, int last,
+                       size_t align = 64) {
+  if (first < 0 || last < first || last >= (int)p.stages.size() || align == 0 || (align & (align - 1))) return -1;
+  ScratchBuffer b;
+  b.name = name;
+  b.bytes = bytes;
+  b.align = align;
+  b.first = first;
+  b.last = last;
+  p.buffers.push_back(b);
+  return (int)p.buffers.size() - 1;
+}
+
+inline size_t scratch_align_up(size_t x, size_t align) { return (x + align - 1) / align * align; }
+
+// Assigns the offsets. Buffer i then occupies [offset - guard, offset + bytes
+// + guard) of the arena.
+inline bool plan_scratch(ScratchPlan& p, size_t guard = 0) {
+  p.guard = guard;
+  p.peak = p.total = p.live = 0;
+  p.stage_bytes.assign(p.stages.size(), 0);
+  const int n = (int)p.buffers.size();
+  std::vector<int> order(n);
+  for (int i = 0; i < n; i++) {
+    const ScratchBuffer& b = p.buffers[i];
+    if (b.first < 0 || b.last < b.first || b.last >= (int)p.stages.size()) return false;
+    order[i] = i;
+    p.total += b.bytes + 2 * guard;
+    for (int s = b.first; s <= b.last; s++) p.stage_bytes[s] += b.bytes + 2 * guard;
+  }
+  for (size_t s : p.stage_bytes) p.live = std::max(p.live, s);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    const ScratchBuffer &x = p.buffers[a], &y = p.buffers[b];
+    if (x.bytes != y.bytes) return x.bytes > y.bytes;
+    return x.last - x.first > y.last - y.first;
+  });
+
+  // reserved [lo, hi) of the placed buffers, by offset
+  struct Range {
+    size_t lo, hi;
+  };
+  std::vector<int> placed;
+  std::vector<Range> busy;
+  for (int i : order) {
+    ScratchBuffer& b = p.buffers[i];
+    busy.clear();
+    for (int j : placed) {
+      const ScratchBuffer& o = p.buffers[j];
+      if (o.last < b.first || b.last < o.first) continue;
+      busy.push_back({o.offset - guard, o.offset + o.bytes + guard});
+    }
+    std::sort(busy.begin(), busy.end(), [](const Range& a, const Range& c) { return a.lo < c.lo; });
+
+    // tightest gap that fits, else above everything
+    size_t best = SIZE_MAX, best_gap = SIZE_MAX, lo = 0;
+    for (size_t k = 0; k <= busy.size(); k++) {
+      const size_t gap_end = k < busy.size() ? busy[k].lo : SIZE_MAX;
+      const size_t offset = scratch_align_up(lo + guard, b.align);
+      if (gap_end != SIZE_MAX && offset + b.bytes + guard <= gap_end && gap_end - lo < best_gap) {
+        best = offset;
+        best_gap = gap_end - lo;
+      } else if (gap_end == SIZE_MAX && best == SIZE_MAX) {
+        best = offset;
+      }
+      if (k < busy.size()) lo = std::max(lo, busy[k].hi);
+    }
+    b.offset = best;
+    p.peak = std::max(p.peak, b.offset + b.bytes + guard);
+    placed.push_back(i);
+  }
+  return true;
+}
+
+// true when no two buffers whose stages overlap share a byte (guards
+// included) and every offset honours its alignment
+inline bool scratch_plan_valid(const ScratchPlan& p) {
+  const size_t g = p.guard;
+  for (size_t i = 0; i < p.buffers.size(); i++) {
+    const ScratchBuffer& a = p.buffers[i];
+    if (a.offset % a.align != 0 || a.offset < g || a.offset + a.bytes + g > p.peak) return false;
+    for (size_t j = i + 1; j < p.buffers.size(); j++) {
+      const ScratchBuffer& b = p.buffers[j];
+      if (a.last < b.first || b.last < a.first) continue;
+      if (a.offset - g < b.offset + b.bytes + g && b.offset - g < a.offset + a.bytes + g) return false;
+    }
+  }
+  return true;
+}
+
+// One allocation of a plan's peak, aligned for every buffer of the plan.
+struct ScratchArena {
+  const ScratchPlan* plan = nullptr;
+  uint8_t* base = nullptr;
+  size_t bytes = 0;
+
+  ScratchArena() = default;
+  ScratchArena(const ScratchArena&) = delete;
+  ScratchArena& operator=(const ScratchArena&) = delete;
+  ~ScratchArena() { xr::simd::aligned_free(base); }
+
+  template <typename T>
+  T* get(int i) const {
+    return reinterpret_cast<T*>(base + plan->buffers[i].offset);
+  }
+  size_t size(int i) const { return plan->buffers[i].bytes; }
+};
+
+// Allocates the arena of a planned p (which must outlive it) and writes the
+// canaries.
+inline bool scratch_arena_init(ScratchArena& a, const ScratchPlan& p) {
+  size_t align = 64;
+  for (const ScratchBuffer& b : p.buffers) align = std::max(align, b.align);
+  xr::simd::aligned_free(a.base);
+  a.plan = &p;
+  a.bytes = p.peak;
+  a.base = static_cast<uint8_t*>(xr::simd::aligned_malloc(std::max<size_t>(p.peak, 1), align));
+  if (!a.base) return false;
+  for (const ScratchBuffer& b : p.buffers) {
+    std::memset(a.base + b.offset - p.guard, kCanary, p.guard);
+    std::memset(a.base + b.offset + b.bytes, kCanary, p.guard);
+  }
+  return true;
+}
+
+// Guards of the buffers live in stage (all buffers for stage < 0) that no
+// longer hold the canary, by buffer index. A guard shared with a buffer whose
+// lifetime does not overlap may legitimately be overwritten by it, so only
+// the live ones are checked; a stage that wrote past its buffer shows up
+// right after it runs.
+inline std::vector<int> scratch_arena_check(const ScratchArena& a, int stage = -1) {
+  std::vector<int> bad;
+  const ScratchPlan& p = *a.plan;
+  for (size_t i = 0; i < p.buffers.size(); i++) {
+    const ScratchBuffer& b = p.buffers[i];
+    if (stage >= 0 && (stage < b.first || stage > b.last)) continue;
+    const uint8_t* lo = a.base + b.offset - p.guard;
+    const uint8_t* hi = a.base + b.offset + b.bytes;
+    for (size_t k = 0; k < p.guard; k++) {
+      if (lo[k] != kCanary || hi[k] != kCanary) {
+        bad.push_back((int)i);
+        break;
+      }
+    }
+  }
+  return bad;
+}
+
+// Rewrites the canaries of the buffers whose lifetime starts at stage: a
+// buffer that took over bytes of one that has ended starts clean.
+inline void scratch_arena_enter(ScratchArena& a, int stage) {
+  const ScratchPlan& p = *a.plan;
+  for (const ScratchBuffer& b : p.buffers) {
+    if (b.first != stage) continue;
+    std::memset(a.base + b.offset - p.guard, kCanary, p.guard);
+    std::memset(a.base + b.offset + b.bytes, kCanary, p.guard);
+  }
+}
+
+}  // namespace scratch
+}  // namespace xr
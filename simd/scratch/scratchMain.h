@@ -0,0 +1,300 @@
+#pragma once
+
+// Checks the scratch planner and plans the temporaries of the stabilization
+// kernel (DSP/MTK's CustomKernel: LK, RANSAC, warp).
+//
+//   - random plans: no two temporaries live in the same stage may overlap
+//     (guards included), offsets are aligned, and the peak is between the
+//     largest single-stage total and the sum of everything
+//   - build_flow_pyramid in caller memory of exactly flow_pyramid_bytes and
+//     flow_pyramid_staging_bytes must succeed without writing past either and
+//     give the same levels as the allocating form, over a range of sizes and
+//     windows; one byte less must be refused
+//   - the 1080p plan is printed next to the device demo's hand-made sizes
+//     (main.cpp's lk_tmp_size loop, CustomKernel.json's 400000-byte tmp_buf).
+//     Both pyramids are live in the track stage, which sets the peak: the
+//     plan can only fold the staging, patch and RANSAC buffers into them
+//   - a frame pair runs fully in the arena: both pyramids and their staging,
+//     the LK patches, the RANSAC scratch and the point, status, mask and
+//     matrix temporaries. The canaries are checked after every stage, the
+//     results must match the allocating calls, and one byte written past a
+//     buffer on purpose must be reported
+//
+// g++ -O3 -fopenmp -std=c++17 main.cpp -o scratch_demo
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../flow/flow.h"
+#include "../homography/homography.h"
+#include "../warp/warp.h"
+#include "scratch.h"
+
+namespace xr {
+namespace scratch {
+
+// stage and buffer indices of stabilization_plan
+struct StabilizationPlan {
+  ScratchPlan plan;
+  int pyr_prev, pyr_next, staging_prev, staging_next, patches, next_pts, status, ransac, mask, h, map;
+};
+
+// The temporaries of one frame pair at width x height with count points,
+// threads LK threads. The stages run in order: prev pyramid, next pyramid,
+// track, homography, warp. Each pyramid build has its own staging image, so
+// the one of the prev pyramid can sit where the next pyramid goes later.
+inline void stabilization_plan(StabilizationPlan& s, int width, int height, int count, int threads,
+                               const xr::flow::LkParams& lk, const xr::homography::RansacParams& ransac,
+                               size_t guard) {
+  ScratchPlan& p = s.plan;
+  p = ScratchPlan();
+  const int prev = add_scratch_stage(p, "pyramid prev"), next = add_scratch_stage(p, "pyramid next");
+  const int track = add_scratch_stage(p, "track"), fit = add_scratch_stage(p, "homography");
+  const int warp = add_scratch_stage(p, "warp");
+  s.pyr_prev = add_scratch(p, "pyramid prev", xr::flow::flow_pyramid_bytes(width, height, lk, true), prev, track);
+  s.pyr_next = add_scratch(p, "pyramid next", xr::flow::flow_pyramid_bytes(width, height, lk, false), next, track);
+  const size_t staging = xr::flow::flow_pyramid_staging_bytes(width, height, lk);
+  s.staging_prev = add_scratch(p, "staging prev", staging, prev, prev);
+  s.staging_next = add_scratch(p, "staging next", staging, next, next);
+  s.patches = add_scratch(p, "lk patches", threads * xr::flow::flow_patch_bytes(lk), track, track);
+  s.next_pts = add_scratch(p, "next_pts", (size_t)count * 2 * sizeof(float), track, fit);
+  s.status = add_scratch(p, "status", (size_t)count, track, fit);
+  s.ransac = add_scratch(p, "ransac", xr::homography::ransac_scratch_bytes(count, ransac), fit, fit);
+  s.mask = add_scratch(p, "inlier mask", (size_t)count, fit, fit);
+  s.h = add_scratch(p, "H", 9 * sizeof(float), fit, warp);
+  s.map = add_scratch(p, "warp map", 9 * sizeof(float), warp, warp);
+  plan_scratch(p, guard);
+}
+
+inline void print_scratch_plan(const ScratchPlan& p) {
+  printf("  %-16s %12s %10s  stages\n", "buffer", "offset", "bytes");
+  for (const ScratchBuffer& b : p.buffers) {
+    printf("  %-16s %12zu %10zu  %s .. %s\n", b.name.c_str(), b.offset, b.bytes, p.stages[b.first].c_str(),
+           p.stages[b.last].c_str());
+  }
+  printf("  peak %zu bytes, largest stage %zu (the lower bound), separate buffers %zu\n", p.peak, p.live, p.total);
+}
+
+// bytes of a's padded levels, images and derivatives, equal to b's
+inline bool flow_pyramid_equal(const xr::flow::FlowPyramid& a, const xr::flow::FlowPyramid& b) {
+  if (a.levels.size() != b.levels.size()) return false;
+  for (size_t i = 0; i < a.levels.size(); i++) {
+    const auto &x = a.levels[i], &y = b.levels[i];
+    if (x.width != y.width || x.height != y.height || x.step != y.step || !x.dx != !y.dx) return false;
+    const size_t size = (size_t)x.step * (x.height + 2 * a.border_y);
+    if (std::memcmp(x.img, y.img, size) != 0) return false;
+    if (x.dx && (std::memcmp(x.dx, y.dx, size * sizeof(int16_t)) != 0 ||
+                 std::memcmp(x.dy, y.dy, size * sizeof(int16_t)) != 0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace scratch
+}  // namespace xr
+
+inline int scratchMain() {
+  using namespace xr::scratch;
+
+  bool pass = true;
+
+  // random plans
+  {
+    uint32_t seed = 1;
+    auto next = [&seed](uint32_t n) {
+      seed = seed * 1664525u + 1013904223u;
+      return (seed >> 8) % n;
+    };
+    bool ok = true;
+    double saving = 0.0;
+    const int trials = 500;
+    for (int t = 0; t < trials; t++) {
+      ScratchPlan p;
+      const int stages = 1 + next(8), buffers = 1 + next(24);
+      for (int s = 0; s < stages; s++) add_scratch_stage(p, "s");
+      for (int i = 0; i < buffers; i++) {
+        const int first = next(stages), last = first + next(stages - first);
+        add_scratch(p, "b", next(4) == 0 ? next(64) : 1 + next(1 << (4 + next(14))), first, last,
+                    (size_t)1 << next(8));
+      }
+      // alignment padding is the only way the peak can exceed the sum
+      ok &= plan_scratch(p, t % 2 ? 32 : 0) && scratch_plan_valid(p) && p.peak >= p.live &&
+            p.peak <= p.total + 255 * (size_t)buffers;
+      saving += (double)p.total / std::max<size_t>(p.peak, 1);
+    }
+    pass &= ok;
+    printf("random plans: %d plans valid, arena %.2fx smaller than separate buffers on average %s\n", trials,
+           saving / trials, ok ? "ok" : "FAILED");
+  }
+
+  // shape functions against build_flow_pyramid
+  {
+    bool ok = true;
+    std::vector<uint8_t> img(1920 * 1080);
+    for (size_t i = 0; i < img.size(); i++) img[i] = (uint8_t)(i * 2654435761u >> 24);
+    const size_t guard = 64;
+    // exactly bytes of the buffer plus a guard tail holding the canary
+    auto tail_intact = [&](const std::vector<uint8_t>& buf, size_t bytes) {
+      for (size_t k = bytes; k < bytes + guard; k++) {
+        if (buf[k] != kCanary) return false;
+      }
+      return true;
+    };
+    const int sizes[][2] = {{1920, 1080}, {640, 480}, {333, 217}, {64, 48}, {17, 400}};
+    for (const auto& sz : sizes) {
+      for (int win : {9, 21}) {
+        for (int level : {0, 3, 5}) {
+          for (bool derivs : {false, true}) {
+            xr::flow::LkParams lk;
+            lk.win_width = lk.win_height = win;
+            lk.max_level = level;
+            xr::flow::FlowPyramid pyr, in_scratch;
+            ok &= xr::flow::build_flow_pyramid(img.data(), sz[0], sz[0], sz[1], lk, derivs, pyr);
+            const size_t bytes = xr::flow::flow_pyramid_bytes(sz[0], sz[1], lk, derivs);
+            const size_t staging = xr::flow::flow_pyramid_staging_bytes(sz[0], sz[1], lk);
+            ok &= staging == (pyr.levels.size() > 1 ? (size_t)pyr.levels[1].width * pyr.levels[1].height : 0);
+            std::vector<uint8_t> mem(bytes + guard, kCanary), half(staging + guard, kCanary);
+            ok &= !xr::flow::build_flow_pyramid(img.data(), sz[0], sz[0], sz[1], lk, derivs, in_scratch, mem.data(),
+                                                bytes - 1, half.data(), staging);
+            ok &= staging == 0 || !xr::flow::build_flow_pyramid(img.data(), sz[0], sz[0], sz[1], lk, derivs,
+                                                                 in_scratch, mem.data(), bytes, half.data(),
+                                                                 staging - 1);
+            ok &= xr::flow::build_flow_pyramid(img.data(), sz[0], sz[0], sz[1], lk, derivs, in_scratch, mem.data(),
+                                               bytes, half.data(), staging);
+            ok &= tail_intact(mem, bytes) && tail_intact(half, staging) && flow_pyramid_equal(pyr, in_scratch);
+          }
+        }
+      }
+    }
+    pass &= ok;
+    printf("build_flow_pyramid fits flow_pyramid_bytes and flow_pyramid_staging_bytes exactly %s\n",
+           ok ? "ok" : "FAILED");
+  }
+
+  // the device demo's shapes
+  const int w = 1920, h = 1080, count = 500;
+  xr::flow::LkParams lk;
+  xr::homography::RansacParams ransac;
+#ifdef _OPENMP
+  const int threads = omp_get_max_threads();
+#else
+  const int threads = 1;
+#endif
+  StabilizationPlan sp;
+  stabilization_plan(sp, w, h, count, threads, lk, ransac, 64);
+  pass &= scratch_plan_valid(sp.plan);
+  {
+    int32_t lk_tmp_size = 0;
+    uint32_t pw = w, ph = h;
+    for (int i = 0; i <= lk.max_level; i++) {
+      pw = (pw + 1) >> 1;
+      ph = (ph + 1) >> 1;
+      lk_tmp_size += pw * ph;
+    }
+    lk_tmp_size *= 2;
+    printf("\nstabilization kernel, %dx%d, %d points, %d LK threads, 64-byte guards:\n", w, h, count, threads);
+    print_scratch_plan(sp.plan);
+    printf("  device demo by hand: tmp_buf_lk %d bytes (pyramids above the base), tmp_buf 400000 bytes shared\n",
+           lk_tmp_size);
+  }
+
+  // a frame pair through the arena
+  {
+    std::vector<uint8_t> prev((size_t)w * h), next_img(prev.size()), out(prev.size());
+    for (int y = 0; y < h; y++) {
+      for (int x = 0; x < w; x++) {
+        const float v = 60.0f * std::sin(x * 0.07f) * std::cos(y * 0.05f) + 40.0f * std::sin((x + 2 * y) * 0.013f);
+        prev[(size_t)y * w + x] = (uint8_t)(128.0f + v);
+      }
+    }
+    // the next frame is prev moved by (3, -2)
+    float truth[9] = {1, 0, 3, 0, 1, -2, 0, 0, 1}, inv[9];
+    xr::warp::invert_homography(truth, inv);
+    xr::warp::warp_perspective(prev.data(), w, w, h, next_img.data(), w, w, h, inv, 0);
+    std::vector<float> pts((size_t)count * 2);
+    for (int i = 0; i < count; i++) {
+      pts[2 * i] = 100.0f + (i % 25) * 68.0f;
+      pts[2 * i + 1] = 100.0f + (i / 25) * 42.0f;
+    }
+
+    ScratchArena arena;
+    bool ok = scratch_arena_init(arena, sp.plan);
+    std::vector<int> bad;
+    auto stage = [&](int s, auto&& fn) {
+      scratch_arena_enter(arena, s);
+      ok &= fn();
+      for (int i : scratch_arena_check(arena, s)) bad.push_back(i);
+    };
+    xr::flow::FlowPyramid pyr_prev, pyr_next;
+    stage(0, [&] {
+      return xr::flow::build_flow_pyramid(prev.data(), w, w, h, lk, true, pyr_prev, arena.get<uint8_t>(sp.pyr_prev),
+                                          arena.size(sp.pyr_prev), arena.get<uint8_t>(sp.staging_prev),
+                                          arena.size(sp.staging_prev), threads);
+    });
+    stage(1, [&] {
+      return xr::flow::build_flow_pyramid(next_img.data(), w, w, h, lk, false, pyr_next,
+                                          arena.get<uint8_t>(sp.pyr_next), arena.size(sp.pyr_next),
+                                          arena.get<uint8_t>(sp.staging_next), arena.size(sp.staging_next), threads);
+    });
+    stage(2, [&] {
+      return xr::flow::calc_optical_flow_pyr_lk(pyr_prev, pyr_next, pts.data(), count, arena.get<float>(sp.next_pts),
+                                                arena.get<uint8_t>(sp.status), lk, arena.get<int32_t>(sp.patches),
+                                                arena.size(sp.patches), threads);
+    });
+    // the same calls with their own memory, before the arena's pyramids are
+    // overwritten by the later stages
+    std::vector<float> ref_pts(pts.size());
+    std::vector<uint8_t> ref_status(count);
+    float ref_h[9] = {};
+    {
+      xr::flow::FlowPyramid own_prev, own_next;
+      ok &= xr::flow::build_flow_pyramid(prev.data(), w, w, h, lk, true, own_prev, threads) &&
+            xr::flow::build_flow_pyramid(next_img.data(), w, w, h, lk, false, own_next, threads) &&
+            flow_pyramid_equal(own_prev, pyr_prev) && flow_pyramid_equal(own_next, pyr_next) &&
+            xr::flow::calc_optical_flow_pyr_lk(own_prev, own_next, pts.data(), count, ref_pts.data(),
+                                               ref_status.data(), lk, threads) &&
+            xr::homography::find_homography_ransac(pts.data(), ref_pts.data(), count, ref_h, ransac);
+    }
+    stage(3, [&] {
+      return xr::homography::find_homography_ransac(pts.data(), arena.get<float>(sp.next_pts), count,
+                                                    arena.get<float>(sp.h), ransac, arena.get<uint8_t>(sp.ransac),
+                                                    arena.size(sp.ransac), arena.get<uint8_t>(sp.mask));
+    });
+    stage(4, [&] {
+      float* m = arena.get<float>(sp.map);
+      return xr::warp::invert_homography(arena.get<float>(sp.h), m) &&
+             xr::warp::warp_perspective(next_img.data(), w, w, h, out.data(), w, w, h, m, 0);
+    });
+    float err = 0.0f;
+    for (int i = 0; i < 9; i++) err = std::max(err, std::fabs(arena.get<float>(sp.h)[i] - truth[i]));
+    const bool same = std::memcmp(ref_pts.data(), arena.get<float>(sp.next_pts), ref_pts.size() * sizeof(float)) == 0 &&
+                      std::memcmp(ref_status.data(), arena.get<uint8_t>(sp.status), count) == 0 &&
+                      std::memcmp(ref_h, arena.get<float>(sp.h), sizeof(ref_h)) == 0;
+    ok &= bad.empty() && err < 0.05f && same;
+    // scratch one byte short is refused
+    {
+      float hm[9];
+      std::vector<float> np(pts.size());
+      std::vector<uint8_t> st(count);
+      ok &= !xr::flow::calc_optical_flow_pyr_lk(pyr_prev, pyr_next, pts.data(), count, np.data(), st.data(), lk,
+                                                arena.get<int32_t>(sp.patches), arena.size(sp.patches) - 1, threads);
+      ok &= !xr::homography::find_homography_ransac(pts.data(), ref_pts.data(), count, hm, ransac,
+                                                    arena.get<uint8_t>(sp.ransac), arena.size(sp.ransac) - 1);
+    }
+    // one byte past the status array while it is live
+    scratch_arena_enter(arena, 2);
+    arena.get<uint8_t>(sp.status)[count] = 0;
+    const std::vector<int> caught = scratch_arena_check(arena, 2);
+    ok &= caught.size() == 1 && caught[0] == sp.status;
+    pass &= ok;
+    printf("\narena run: pyramids, LK, RANSAC and warp entirely in the planned arena, canaries intact after every "
+           "stage, results %s the allocating calls', H off by %.4f, overrun of %s caught %s\n",
+           same ? "equal to" : "DIFFERENT from", err,
+           caught.empty() ? "nothing" : sp.plan.buffers[caught[0]].name.c_str(), ok ? "ok" : "FAILED");
+  }
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
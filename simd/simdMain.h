@@ -0,0 +1,63 @@
+#pragma once
+
+// Checks every compiled backend that can run on this CPU against plain loops,
+// then times a dispatched dot product per backend.
+//
+// g++ -O2 -std=c++17 main.cpp -o simd_demo      (no -m flags needed)
+// XR_SIMD_ISA=sse42 ./simd_demo                 (force a path)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "xr_simd.h"
+
+namespace xr {
+namespace simd_demo {
+
+#define XR_SIMD_KERNELS "simd_check.inl"
+#include "xr_simd_foreach.h"
+
+}  // namespace simd_demo
+}  // namespace xr
+
+inline int simdMain() {
+  using namespace xr::simd;
+
+  const CpuFeatures& f = cpu_features();
+  printf("cpu: sse4.2=%d avx2=%d fma=%d f16c=%d avx512f=%d bw=%d dq=%d vl=%d neon=%d\n", f.sse42, f.avx2,
+         f.fma, f.f16c, f.avx512f, f.avx512bw, f.avx512dq, f.avx512vl, f.neon);
+  printf("dispatch: %s (best %s)\n", isa_name(current_isa()), isa_name(best_supported_isa()));
+
+  const Isa all[] = {Isa::kScalar, Isa::kSSE42, Isa::kAVX2, Isa::kAVX512, Isa::kNEON};
+  const Isa initial = current_isa();
+  // small enough to stay in L2, so the dot product is compute bound
+  const size_t n = 1 << 14;
+  std::vector<float> a(n), b(n);
+  for (size_t i = 0; i < n; i++) {
+    a[i] = (float)(i % 7) * 0.25f;
+    b[i] = (float)(i % 5) * 0.5f;
+  }
+
+  bool pass = true;
+  for (Isa isa : all) {
+    if (!set_isa(isa)) continue;
+    bool ok = XR_SIMD_DISPATCH_IN(xr::simd_demo, check_ops)();
+    pass &= ok;
+
+    auto dot_fn = XR_SIMD_DISPATCH_IN(xr::simd_demo, dot);
+    const int iters = 2000;
+    float sum = 0.0f;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int it = 0; it < iters; it++) sum += dot_fn(a.data(), b.data(), n);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / iters;
+    printf("%-7s ops %s  dot %8.2f us  %6.2f GFLOP/s  (sum %.1f)\n", isa_name(isa), ok ? "ok    " : "FAILED",
+           ms * 1e3, 2.0 * n / (ms * 1e6), sum / iters);
+  }
+  set_isa(initial);
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
@@ -0,0 +1,361 @@
+// Kernel file for simdMain.h, expanded once per backend by xr_simd_foreach.h.
+// Every operation is checked against a plain loop over the backend's own lane
+// count, so the same file validates 128-, 256- and 512-bit backends.
+
+// inputs are large enough for one 512-bit vector of any type
+struct CheckData {
+  float f[2][16];
+  int32_t i32[2][16];
+  int16_t i16[2][32];
+  uint16_t u16[2][32];
+  uint8_t u8[2][64];
+  int8_t i8[2][64];
+};
+
+inline void fill_check_data(CheckData* d) {
+  uint32_t s = 12345;
+  auto next = [&s]() {
+    s = s * 1664525u + 1013904223u;
+    return s >> 8;
+  };
+  for (int k = 0; k < 2; k++) {
+    for (int i = 0; i < 16; i++) {
+      d->f[k][i] = (float)((int)(next() % 2001) - 1000) * 0.125f;
+      d->i32[k][i] = (int32_t)next() - (1 << 23);
+    }
+    for (int i = 0; i < 32; i++) {
+      d->i16[k][i] = (int16_t)next();
+      d->u16[k][i] = (uint16_t)next();
+    }
+    for (int i = 0; i < 64; i++) {
+      d->u8[k][i] = (uint8_t)next();
+      d->i8[k][i] = (int8_t)next();
+    }
+  }
+  // some equal lanes so compare-equal has true results
+  d->f[1][3] = d->f[0][3];
+  d->i32[1][5] = d->i32[0][5];
+  d->i16[1][7] = d->i16[0][7];
+  d->u16[1][2] = d->u16[0][2];
+  d->u8[1][9] = d->u8[0][9];
+}
+
+#define XR_CHECK(cond, what)                                    \
+  do {                                                          \
+    if (!(cond)) {                                              \
+      printf("  [%s] %s failed\n", isa_name(kIsa), what);       \
+      ok = false;                                               \
+    }                                                           \
+  } while (0)
+
+// apply a binary op to vectors of type V built from arrays a, b of element T
+// and compare every lane with expr (using x = a[i], y = b[i])
+#define XR_CHECK_BINARY(V, T, a, b, op, expr)                   \
+  do {                                                          \
+    T out[V::N];                                                \
+    storeu(out, op(loadu(a), loadu(b)));                        \
+    bool same = true;                                           \
+    for (int i = 0; i < V::N; i++) {                            \
+      T x = a[i], y = b[i];                                     \
+      (void)x;                                                  \
+      (void)y;                                                  \
+      if (out[i] != (T)(expr)) same = false;                    \
+    }                                                           \
+    XR_CHECK(same, #op " " #V);                                 \
+  } while (0)
+
+#define XR_MASK(T, c) ((c) ? (T)~(T)0 : (T)0)
+
+inline bool check_arithmetic(const CheckData& d) {
+  bool ok = true;
+  const float* fa = d.f[0];
+  const float* fb = d.f[1];
+  XR_CHECK_BINARY(vf32, float, fa, fb, add, x + y);
+  XR_CHECK_BINARY(vf32, float, fa, fb, sub, x - y);
+  XR_CHECK_BINARY(vf32, float, fa, fb, mul, x * y);
+  XR_CHECK_BINARY(vf32, float, fa, fb, min, std::min(x, y));
+  XR_CHECK_BINARY(vf32, float, fa, fb, max, std::max(x, y));
+  XR_CHECK_BINARY(vi32, int32_t, d.i32[0], d.i32[1], add, (uint32_t)x + (uint32_t)y);
+  XR_CHECK_BINARY(vi32, int32_t, d.i32[0], d.i32[1], sub, (uint32_t)x - (uint32_t)y);
+  XR_CHECK_BINARY(vi32, int32_t, d.i32[0], d.i32[1], mul, (uint32_t)x * (uint32_t)y);
+  XR_CHECK_BINARY(vi32, int32_t, d.i32[0], d.i32[1], min, std::min(x, y));
+  XR_CHECK_BINARY(vi32, int32_t, d.i32[0], d.i32[1], max, std::max(x, y));
+  XR_CHECK_BINARY(vi16, int16_t, d.i16[0], d.i16[1], add, x + y);
+  XR_CHECK_BINARY(vi16, int16_t, d.i16[0], d.i16[1], mul, x * y);
+  XR_CHECK_BINARY(vi16, int16_t, d.i16[0], d.i16[1], adds, std::min(32767, std::max(-32768, x + y)));
+  XR_CHECK_BINARY(vi16, int16_t, d.i16[0], d.i16[1], subs, std::min(32767, std::max(-32768, x - y)));
+  XR_CHECK_BINARY(vi16, int16_t, d.i16[0], d.i16[1], mulhi, (x * y) >> 16);
+  XR_CHECK_BINARY(vi16, int16_t, d.i16[0], d.i16[1], min, std::min(x, y));
+  XR_CHECK_BINARY(vu16, uint16_t, d.u16[0], d.u16[1], adds, std::min(65535, x + y));
+  XR_CHECK_BINARY(vu16, uint16_t, d.u16[0], d.u16[1], subs, std::max(0, x - y));
+  XR_CHECK_BINARY(vu16, uint16_t, d.u16[0], d.u16[1], mulhi, ((uint32_t)x * y) >> 16);
+  XR_CHECK_BINARY(vu16, uint16_t, d.u16[0], d.u16[1], avg, (x + y + 1) >> 1);
+  XR_CHECK_BINARY(vu16, uint16_t, d.u16[0], d.u16[1], max, std::max(x, y));
+  XR_CHECK_BINARY(vu8, uint8_t, d.u8[0], d.u8[1], add, x + y);
+  XR_CHECK_BINARY(vu8, uint8_t, d.u8[0], d.u8[1], adds, std::min(255, x + y));
+  XR_CHECK_BINARY(vu8, uint8_t, d.u8[0], d.u8[1], subs, std::max(0, x - y));
+  XR_CHECK_BINARY(vu8, uint8_t, d.u8[0], d.u8[1], avg, (x + y + 1) >> 1);
+  XR_CHECK_BINARY(vu8, uint8_t, d.u8[0], d.u8[1], min, std::min(x, y));
+  XR_CHECK_BINARY(vu8, uint8_t, d.u8[0], d.u8[1], bit_andnot, x & ~y);
+
+  float out[vf32::N];
+  storeu(out, fma(loadu(fa), loadu(fb), set1_f32(0.5f)));
+  bool close = true;
+  for (int i = 0; i < vf32::N; i++) {
+    if (std::fabs(out[i] - (fa[i] * fb[i] + 0.5f)) > 1e-3f) close = false;
+  }
+  XR_CHECK(close, "fma vf32");
+  storeu(out, sqrt(abs(loadu(fa))));
+  close = true;
+  for (int i = 0; i < vf32::N; i++) {
+    if (std::fabs(out[i] - std::sqrt(std::fabs(fa[i]))) > 1e-5f) close = false;
+  }
+  XR_CHECK(close, "sqrt/abs vf32");
+
+  int16_t s16[vi16::N];
+  storeu(s16, shr(loadu(d.i16[0]), 3));
+  bool same = true;
+  for (int i = 0; i < vi16::N; i++) same &= s16[i] == (int16_t)(d.i16[0][i] >> 3);
+  XR_CHECK(same, "shr vi16");
+  uint16_t su16[vu16::N];
+  storeu(su16, shl(shr(loadu(d.u16[0]), 5), 2));
+  same = true;
+  for (int i = 0; i < vu16::N; i++) same &= su16[i] == (uint16_t)((d.u16[0][i] >> 5) << 2);
+  XR_CHECK(same, "shl/shr vu16");
+  return ok;
+}
+
+inline bool check_compare(const CheckData& d) {
+  bool ok = true;
+  int32_t m32[vi32::N];
+  storeu(m32, as_i32(cmplt(loadu(d.f[0]), loadu(d.f[1]))));
+  bool same = true;
+  for (int i = 0; i < vi32::N; i++) same &= m32[i] == XR_MASK(int32_t, d.f[0][i] < d.f[1][i]);
+  XR_CHECK(same, "cmplt vf32");
+  storeu(m32, as_i32(cmpeq(loadu(d.f[0]), loadu(d.f[1]))));
+  same = true;
+  for (int i = 0; i < vi32::N; i++) same &= m32[i] == XR_MASK(int32_t, d.f[0][i] == d.f[1][i]);
+  XR_CHECK(same, "cmpeq vf32");
+
+  XR_CHECK_BINARY(vi32, int32_t, d.i32[0], d.i32[1], cmpgt, XR_MASK(int32_t, x > y));
+  XR_CHECK_BINARY(vi32, int32_t, d.i32[0], d.i32[1], cmpeq, XR_MASK(int32_t, x == y));
+  XR_CHECK_BINARY(vi16, int16_t, d.i16[0], d.i16[1], cmplt, XR_MASK(int16_t, x < y));
+  XR_CHECK_BINARY(vi16, int16_t, d.i16[0], d.i16[1], cmpeq, XR_MASK(int16_t, x == y));
+  XR_CHECK_BINARY(vu16, uint16_t, d.u16[0], d.u16[1], cmpgt, XR_MASK(uint16_t, x > y));
+  XR_CHECK_BINARY(vu16, uint16_t, d.u16[0], d.u16[1], cmpeq, XR_MASK(uint16_t, x == y));
+  XR_CHECK_BINARY(vu8, uint8_t, d.u8[0], d.u8[1], cmpgt, XR_MASK(uint8_t, x > y));
+  XR_CHECK_BINARY(vu8, uint8_t, d.u8[0], d.u8[1], cmpeq, XR_MASK(uint8_t, x == y));
+
+  // vbsl: max through select
+  float fo[vf32::N];
+  vf32 fa = loadu(d.f[0]), fb = loadu(d.f[1]);
+  storeu(fo, select(cmpgt(fa, fb), fa, fb));
+  same = true;
+  for (int i = 0; i < vf32::N; i++) same &= fo[i] == std::max(d.f[0][i], d.f[1][i]);
+  XR_CHECK(same, "select vf32");
+  uint8_t bo[vu8::N];
+  vu8 ba = loadu(d.u8[0]), bb = loadu(d.u8[1]);
+  storeu(bo, select(cmpgt(ba, bb), bb, ba));
+  same = true;
+  for (int i = 0; i < vu8::N; i++) same &= bo[i] == std::min(d.u8[0][i], d.u8[1][i]);
+  XR_CHECK(same, "select vu8");
+  return ok;
+}
+
+inline bool check_conversion(const CheckData& d) {
+  bool ok = true;
+  int32_t i32[vi32::N];
+  float f32[vf32::N];
+  storeu(i32, cvt_i32(mul(loadu(d.f[0]), set1_f32(0.5f))));
+  bool same = true;
+  for (int i = 0; i < vi32::N; i++) same &= i32[i] == (int32_t)std::nearbyint(d.f[0][i] * 0.5f);
+  XR_CHECK(same, "cvt_i32 (nearest even)");
+  storeu(i32, cvtt_i32(loadu(d.f[0])));
+  same = true;
+  for (int i = 0; i < vi32::N; i++) same &= i32[i] == (int32_t)d.f[0][i];
+  XR_CHECK(same, "cvtt_i32");
+  storeu(f32, cvt_f32(loadu(d.i32[0])));
+  same = true;
+  for (int i = 0; i < vf32::N; i++) same &= f32[i] == (float)d.i32[0][i];
+  XR_CHECK(same, "cvt_f32");
+
+  // widen then saturating narrow back must round trip
+  vu8 b = loadu(d.u8[0]);
+  uint8_t b_out[vu8::N];
+  storeu(b_out, narrow_sat_u8(widen_lo(b), widen_hi(b)));
+  XR_CHECK(std::memcmp(b_out, d.u8[0], sizeof(b_out)) == 0, "widen/narrow_sat_u8 vu16");
+  uint16_t u16[vu16::N];
+  storeu(u16, widen_hi(b));
+  same = true;
+  for (int i = 0; i < vu16::N; i++) same &= u16[i] == d.u8[0][i + vu16::N];
+  XR_CHECK(same, "widen_hi vu8");
+
+  vi16 s = loadu(d.i16[0]);
+  int16_t s_out[vi16::N];
+  storeu(s_out, narrow_sat_i16(widen_lo(s), widen_hi(s)));
+  XR_CHECK(std::memcmp(s_out, d.i16[0], sizeof(s_out)) == 0, "widen/narrow_sat_i16");
+
+  // saturation itself
+  storeu(b_out, narrow_sat_u8(loadu(d.i16[0]), loadu(d.i16[1])));
+  same = true;
+  for (int i = 0; i < vi16::N; i++) {
+    same &= b_out[i] == (uint8_t)std::min(255, std::max(0, (int)d.i16[0][i]));
+    same &= b_out[i + vi16::N] == (uint8_t)std::min(255, std::max(0, (int)d.i16[1][i]));
+  }
+  XR_CHECK(same, "narrow_sat_u8 vi16");
+  storeu(b_out, narrow_sat_u8(loadu(d.u16[0]), loadu(d.u16[1])));
+  same = true;
+  for (int i = 0; i < vu16::N; i++) {
+    same &= b_out[i] == (uint8_t)std::min(255, (int)d.u16[0][i]);
+    same &= b_out[i + vu16::N] == (uint8_t)std::min(255, (int)d.u16[1][i]);
+  }
+  XR_CHECK(same, "narrow_sat_u8 vu16");
+  storeu(u16, narrow_sat_u16(loadu(d.i32[0]), loadu(d.i32[1])));
+  same = true;
+  for (int i = 0; i < vi32::N; i++) {
+    same &= u16[i] == (uint16_t)std::min(65535, std::max(0, d.i32[0][i]));
+    same &= u16[i + vi32::N] == (uint16_t)std::min(65535, std::max(0, d.i32[1][i]));
+  }
+  XR_CHECK(same, "narrow_sat_u16 vi32");
+
+  vi8 c = loadu(d.i8[0]);
+  int8_t c_out[vi8::N];
+  storeu(c_out, narrow_sat_i8(widen_lo(c), widen_hi(c)));
+  XR_CHECK(std::memcmp(c_out, d.i8[0], sizeof(c_out)) == 0, "widen/narrow_sat_i8");
+  storeu(c_out, narrow_sat_i8(loadu(d.i16[0]), loadu(d.i16[1])));
+  same = true;
+  for (int i = 0; i < vi16::N; i++) {
+    same &= c_out[i] == (int8_t)std::min(127, std::max(-128, (int)d.i16[0][i]));
+    same &= c_out[i + vi16::N] == (int8_t)std::min(127, std::max(-128, (int)d.i16[1][i]));
+  }
+  XR_CHECK(same, "narrow_sat_i8 vi16");
+
+  // halves: exact values, a tie that rounds to even, overflow, subnormal, a
+  // signalling NaN with a payload (compared as bits)
+  float h_in[16];
+  uint16_t h[16];
+  for (int i = 0; i < 16; i++) h_in[i] = d.f[0][i];
+  h_in[0] = 1.0f + 1.0f / 2048.0f;
+  h_in[1] = 70000.0f;
+  h_in[2] = -3.0e-6f;
+  const uint32_t snan32 = 0xFF812345u;
+  std::memcpy(&h_in[3], &snan32, 4);
+  store_f16(h, loadu(h_in));
+  same = true;
+  for (int i = 0; i < vf32::N; i++) same &= h[i] == ::xr::simd::f32_to_f16(h_in[i]);
+  XR_CHECK(same, "store_f16");
+  h[3] = 0x7C15;  // half signalling NaN
+  storeu(f32, load_f16(h));
+  same = true;
+  for (int i = 0; i < vf32::N; i++) {
+    const float want = ::xr::simd::f16_to_f32(h[i]);
+    same &= std::memcmp(&f32[i], &want, 4) == 0;
+  }
+  XR_CHECK(same, "load_f16");
+  return ok;
+}
+
+#define XR_CHECK_PERMUTE(V, T, a, b)                                         \
+  do {                                                                       \
+    T lo[V::N], hi[V::N], ev[V::N], od[V::N];                                \
+    V va = loadu(a), vb = loadu(b);                                          \
+    storeu(lo, zip_lo(va, vb));                                              \
+    storeu(hi, zip_hi(va, vb));                                              \
+    storeu(ev, unzip_even(va, vb));                                          \
+    storeu(od, unzip_odd(va, vb));                                           \
+    bool same = true;                                                        \
+    const int h = V::N / 2;                                                  \
+    for (int i = 0; i < h; i++) {                                            \
+      same &= lo[2 * i] == a[i] && lo[2 * i + 1] == b[i];                    \
+      same &= hi[2 * i] == a[i + h] && hi[2 * i + 1] == b[i + h];            \
+      same &= ev[i] == a[2 * i] && ev[i + h] == b[2 * i];                    \
+      same &= od[i] == a[2 * i + 1] && od[i + h] == b[2 * i + 1];            \
+    }                                                                        \
+    XR_CHECK(same, "zip/unzip " #V);                                         \
+  } while (0)
+
+inline bool check_permute(const CheckData& d) {
+  bool ok = true;
+  XR_CHECK_PERMUTE(vf32, float, d.f[0], d.f[1]);
+  XR_CHECK_PERMUTE(vi32, int32_t, d.i32[0], d.i32[1]);
+  XR_CHECK_PERMUTE(vi16, int16_t, d.i16[0], d.i16[1]);
+  XR_CHECK_PERMUTE(vu16, uint16_t, d.u16[0], d.u16[1]);
+  XR_CHECK_PERMUTE(vu8, uint8_t, d.u8[0], d.u8[1]);
+
+  float fsum = 0.0f, fmin = d.f[0][0];
+  int32_t isum = 0;
+  for (int i = 0; i < vf32::N; i++) {
+    fsum += d.f[0][i];
+    fmin = std::min(fmin, d.f[0][i]);
+    isum = (int32_t)((uint32_t)isum + (uint32_t)d.i32[0][i]);
+  }
+  // inputs are multiples of 1/8 well inside float precision, so order does not matter
+  XR_CHECK(reduce_add(loadu(d.f[0])) == fsum, "reduce_add vf32");
+  XR_CHECK(reduce_min(loadu(d.f[0])) == fmin, "reduce_min vf32");
+  XR_CHECK(reduce_add(loadu(d.i32[0])) == isum, "reduce_add vi32");
+  return ok;
+}
+
+// load3 / load4 against a plain deinterleave, store3 / store4 must round trip,
+// gather_u16 against byte loads
+inline bool check_structure(const CheckData& d) {
+  bool ok = true;
+  uint8_t src[4 * 64], out[4 * 64], ch[4][64];
+  for (int i = 0; i < 4 * vu8::N; i++) src[i] = d.u8[i / 64][i % 64] ^ (uint8_t)i;
+  vu8x3 v3 = load3(src);
+  vu8x4 v4 = load4(src);
+  bool same = true;
+  for (int c = 0; c < 3; c++) {
+    storeu(ch[c], v3.v[c]);
+    for (int i = 0; i < vu8::N; i++) same &= ch[c][i] == src[3 * i + c];
+  }
+  XR_CHECK(same, "load3 vu8");
+  same = true;
+  for (int c = 0; c < 4; c++) {
+    storeu(ch[c], v4.v[c]);
+    for (int i = 0; i < vu8::N; i++) same &= ch[c][i] == src[4 * i + c];
+  }
+  XR_CHECK(same, "load4 vu8");
+  store3(out, v3);
+  XR_CHECK(std::memcmp(out, src, 3 * vu8::N) == 0, "store3 vu8");
+  store4(out, v4);
+  XR_CHECK(std::memcmp(out, src, 4 * vu8::N) == 0, "store4 vu8");
+
+  // byte pairs at scattered offsets, some overlapping
+  int32_t off[16], pairs[16];
+  for (int i = 0; i < vi32::N; i++) off[i] = (i * 37 + 5) % (3 * vu8::N);
+  storeu(pairs, gather_u16(src, loadu(off)));
+  same = true;
+  for (int i = 0; i < vi32::N; i++) same &= pairs[i] == (src[off[i]] | src[off[i] + 1] << 8);
+  XR_CHECK(same, "gather_u16");
+  return ok;
+}
+
+inline bool check_ops() {
+  CheckData d;
+  fill_check_data(&d);
+  bool ok = check_arithmetic(d);
+  ok &= check_compare(d);
+  ok &= check_conversion(d);
+  ok &= check_permute(d);
+  ok &= check_structure(d);
+  return ok;
+}
+
+// dot product used for the dispatch benchmark
+inline float dot(const float* a, const float* b, size_t n) {
+  vf32 acc0 = zero_f32(), acc1 = zero_f32();
+  size_t i = 0;
+  for (; i + 2 * vf32::N <= n; i += 2 * vf32::N) {
+    acc0 = fma(loadu(a + i), loadu(b + i), acc0);
+    acc1 = fma(loadu(a + i + vf32::N), loadu(b + i + vf32::N), acc1);
+  }
+  float sum = reduce_add(add(acc0, acc1));
+  for (; i < n; i++) sum += a[i] * b[i];
+  return sum;
+}
+
+#undef XR_CHECK
+#undef XR_CHECK_BINARY
+#undef XR_CHECK_PERMUTE
+#undef XR_MASK
@@ -0,0 +1,440 @@
+#pragma once
+
+// Frame-pipelined version of stream.h: the stabilization work of a frame is
+// split into three stages, each on its own thread with its own OpenMP budget,
+// joined by bounded FIFO queues:
+//
+//   track       pyramid, LK from the previous frame, corner re-detection
+//   homography  RANSAC on the tracked pairs
+//   warp        the frame warped onto the previous one, handed to the sink
+//
+// so the warp of frame k, the RANSAC of frame k + 1 and the tracking of frame
+// k + 2 run at the same time. Frames live in max_in_flight slots allocated by
+// pipeline_start; pipeline_submit blocks while every slot is in use, and a
+// stage blocks while its output queue is full, so a slow stage holds back
+// everything upstream of it instead of letting frames pile up.
+//
+// Unlike stream_push, the track stage cannot wait for the RANSAC of the frame
+// it just tracked, so it carries every point LK kept on the frame rather than
+// only the inliers; points on moving objects drop out when they are lost, and
+// every homography still rejects them as outliers.
+//
+// Every stage records how long each frame waited in its input queue and how
+// long the stage worked on it (log-scale histograms), how full the queue was at
+// each push, and how long its own output pushes were blocked.
+
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "stream.h"
+
+namespace xr {
+namespace stream {
+
+// Log-scale histogram of milliseconds. Bucket 0 holds values below 1 us; above
+// that, every octave [2^k, 2^(k+1)) us is split into kSub buckets of equal
+// ratio, and the last bucket holds everything from 2^kOctaves us on.
+// percentile interpolates log-linearly inside the bucket that holds the
+// quantile and clamps to the observed min and max, so its error is a
+// fraction of one sub-bucket (under 10%) instead of a whole octave.
+struct Histogram {
+  static constexpr int kSub = 8;
+  static constexpr int kOctaves = 25;  // up to 2^25 us, about 33 s
+  static constexpr int kBuckets = 1 + kOctaves * kSub + 1;
+  uint64_t counts[kBuckets] = {};
+  uint64_t n = 0;
+  double sum = 0.0, min = 0.0, max = 0.0;
+
+  // [lo, hi) of bucket b, in us
+  static double bucket_lo_us(int b) {
+    if (b == 0) return 0.0;
+    if (b == kBuckets - 1) return std::ldexp(1.0, kOctaves);
+    return std::ldexp(std::exp2((double)((b - 1) % kSub) / kSub), (b - 1) / kSub);
+  }
+  static double bucket_hi_us(int b) {
+    return b == kBuckets - 1 ? HUGE_VAL : b == 0 ? 1.0 : bucket_lo_us(b + 1);
+  }
+
+  void add(double ms) {
+    const double us = ms * 1000.0;
+    int b = 0;
+    if (us >= std::ldexp(1.0, kOctaves)) {
+      b = kBuckets - 1;
+    } else if (us >= 1.0) {
+      int e;
+      const double m = std::frexp(us, &e);  // us = m * 2^e, m in [0.5, 1)
+      const int sub = std::min(kSub - 1, (int)(std::log2(2.0 * m) * kSub));
+      b = 1 + (e - 1) * kSub + sub;
+    }
+    counts[b]++;
+    min = n ? std::min(min, ms) : ms;
+    max = n ? std::max(max, ms) : ms;
+    n++;
+    sum += ms;
+  }
+  double mean() const { return n ? sum / n : 0.0; }
+  // p-th quantile: log-linear inside its bucket (linear in bucket 0), within
+  // [min, max]
+  double percentile(double p) const {
+    if (n == 0) return 0.0;
+    const double rank = std::min(std::max(p, 0.0), 1.0) * (double)n;
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; b++) {
+      if (counts[b] == 0) continue;
+      if ((double)(seen + counts[b]) >= rank || b == kBuckets - 1) {
+        const double frac = std::min(1.0, std::max(0.0, (rank - (double)seen) / (double)counts[b]));
+        const double lo = std::max(bucket_lo_us(b), min * 1000.0);
+        const double hi = std::min(bucket_hi_us(b), max * 1000.0);
+        double us;
+        if (hi <= lo) {
+          us = lo;
+        } else if (lo <= 0.0) {
+          us = lo + (hi - lo) * frac;
+        } else {
+          us = lo * std::pow(hi / lo, frac);
+        }
+        return std::min(max, std::max(min, us / 1000.0));
+      }
+      seen += counts[b];
+    }
+    return max;
+  }
+  // the non-empty buckets as "lo-hi:count" in ms, space separated
+  std::string buckets() const {
+    std::string out;
+    char item[64];
+    for (int b = 0; b < kBuckets; b++) {
+      if (counts[b] == 0) continue;
+      if (b == kBuckets - 1) {
+        snprintf(item, sizeof(item), "%s%.3g-:%llu", out.empty() ? "" : " ", bucket_lo_us(b) / 1000.0,
+                 (unsigned long long)counts[b]);
+      } else {
+        snprintf(item, sizeof(item), "%s%.3g-%.3g:%llu", out.empty() ? "" : " ", bucket_lo_us(b) / 1000.0,
+                 bucket_hi_us(b) / 1000.0, (unsigned long long)counts[b]);
+      }
+      out += item;
+    }
+    return out;
+  }
+};
+
+// FIFO of at most capacity items. push blocks while it is full, pop while it
+// is empty; after close, push fails and pop drains what is left.
+template <typename T>
+class BoundedQueue {
+ public:
+  void reset(int capacity) {
+    std::lock_guard<std::mutex> lock(m_);
+    capacity_ = std::max(1, capacity);
+    items_.clear();
+    closed_ = false;
+    depth_.assign(capacity_ + 1, 0);
+    blocked_ms_ = 0.0;
+  }
+
+  bool push(T v) {
+    std::unique_lock<std::mutex> lock(m_);
+    if ((int)items_.size() >= capacity_ && !closed_) {
+      const double t0 = stream_now_ms();
+      not_full_.wait(lock, [this] { return (int)items_.size() < capacity_ || closed_; });
+      blocked_ms_ += stream_now_ms() - t0;
+    }
+    if (closed_) return false;
+    depth_[items_.size()]++;
+    items_.push_back(std::move(v));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
+
+  bool pop(T& v) {
+    std::unique_lock<std::mutex> lock(m_);
+    not_empty_.wait(lock, [this] { return !items_.empty() || closed_; });
+    if (items_.empty()) return false;
+    v = std::move(items_.front());
+    items_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return true;
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      closed_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  int capacity() const { return capacity_; }
+  // depth()[d]: pushes that found d items already queued
+  std::vector<uint64_t> depth() const {
+    std::lock_guard<std::mutex> lock(m_);
+    return depth_;
+  }
+  // total time push spent waiting for room
+  double blocked_ms() const {
+    std::lock_guard<std::mutex> lock(m_);
+    return blocked_ms_;
+  }
+
+ private:
+  mutable std::mutex m_;
+  std::condition_variable not_full_, not_empty_;
+  std::deque<T> items_;
+  int capacity_ = 1;
+  bool closed_ = false;
+  std::vector<uint64_t> depth_;
+  double blocked_ms_ = 0.0;
+};
+
+struct PipelineParams {
+  StreamParams stream;  // tracking, RANSAC and detection settings; threads and warp.threads are ignored
+  int track_threads = 1;
+  int homography_threads = 1;
+  int warp_threads = 1;
+  int max_in_flight = 3;   // frame slots: submitted and not yet through the sink
+  int queue_capacity = 2;  // between two stages
+};
+
+// The sink runs on the warp thread, in submission order; out holds the warped
+// frame (the frame itself when there is no estimate) until the sink returns.
+using FrameSink = std::function<void(int64_t index, const uint8_t* out, int out_step, const FrameStats& stats)>;
+
+struct StageReport {
+  const char* name = "";
+  int threads = 1;
+  Histogram wait;     // time frames sat in the input queue
+  Histogram service;  // time the stage worked on a frame
+  std::vector<uint64_t> depth;  // input queue occupancy seen by each push
+  double blocked_ms = 0.0;      // time the stage's output pushes were blocked
+};
+
+struct PipelineReport {
+  StageReport stages[3];
+  Histogram latency;          // submit to sink return
+  double submit_blocked_ms = 0.0;  // pipeline_submit waiting for a free slot
+  int64_t frames = 0;
+  double ms = 0.0;  // first submit to last sink return
+};
+
+struct FrameSlot {
+  int64_t index = 0;
+  std::vector<uint8_t> frame, out;
+  std::vector<float> prev_pts, next_pts;  // the tracked pairs
+  int count = 0;
+  FrameStats stats;
+  double submitted = 0.0, queued = 0.0;  // stream_now_ms of submit and of the last enqueue
+};
+
+struct Pipeline {
+  PipelineParams params;
+  int width = 0, height = 0;
+  Stream track;  // pyramids and carried points of the track stage
+  std::vector<FrameSlot> slots;
+  BoundedQueue<int> free_slots, to_track, to_homography, to_warp;
+  FrameSink sink;
+  std::thread threads[3];
+  PipelineReport report;
+  int64_t submitted = 0;
+  double first_submit = 0.0;
+  std::atomic<bool> failed{false};
+  bool running = false;
+};
+
+// pyramid, LK and re-detection of frame f against the previous frame
+inline void pipeline_track(Pipeline& p, FrameSlot& f) {
+  Stream& s = p.track;
+  const StreamParams& sp = p.params.stream;
+  const int threads = p.params.track_threads;
+  const double t0 = stream_now_ms();
+  const int cur = s.prev ^ 1;
+  f.count = 0;
+  if (!xr::flow::build_flow_pyramid(f.frame.data(), p.width, p.width, p.height, sp.lk, true, s.pyr[cur], threads)) {
+    p.failed = true;
+    return;
+  }
+  const double t1 = stream_now_ms();
+  f.stats.ms.pyramid = t1 - t0;
+
+  int kept = 0;
+  if (s.frames > 0 && s.count > 0) {
+    if (!xr::flow::calc_optical_flow_pyr_lk(s.pyr[s.prev], s.pyr[cur], s.prev_pts.data(), s.count,
+                                            s.next_pts.data(), s.status.data(), sp.lk, threads)) {
+      p.failed = true;
+      return;
+    }
+    for (int i = 0; i < s.count; i++) {
+      const float x = s.next_pts[2 * i], y = s.next_pts[2 * i + 1];
+      if (!s.status[i] || !(x >= 0.0f && y >= 0.0f && x <= p.width - 1.0f && y <= p.height - 1.0f)) continue;
+      f.prev_pts[2 * kept] = s.prev_pts[2 * i];
+      f.prev_pts[2 * kept + 1] = s.prev_pts[2 * i + 1];
+      f.next_pts[2 * kept] = s.next_pts[2 * kept] = x;
+      f.next_pts[2 * kept + 1] = s.next_pts[2 * kept + 1] = y;
+      kept++;
+    }
+  }
+  f.count = kept;
+  f.stats.tracked = kept;
+  const double t2 = stream_now_ms();
+  f.stats.ms.track = t2 - t1;
+
+  s.prev = cur;
+  s.prev_pts.swap(s.next_pts);
+  s.count = kept;
+  if (s.count < sp.min_points) f.stats.detected = detect_corners(s, cur, threads) > 0;
+  f.stats.points = s.count;
+  s.frames++;
+  f.stats.ms.detect = stream_now_ms() - t2;
+}
+
+inline void pipeline_homography(Pipeline& p, FrameSlot& f) {
+  const double t0 = stream_now_ms();
+  if (f.count >= 4) {
+    xr::homography::RansacStats rs;
+    f.stats.has_h = xr::homography::find_homography_ransac(f.prev_pts.data(), f.next_pts.data(), f.count, f.stats.h,
+                                                           p.params.stream.ransac, nullptr, &rs, nullptr,
+                                                           p.params.homography_threads);
+    if (f.stats.has_h) {
+      f.stats.inliers = rs.inliers;
+    } else {
+      const FrameStats identity;
+      std::copy(identity.h, identity.h + 9, f.stats.h);
+    }
+  }
+  f.stats.ms.homography = stream_now_ms() - t0;
+}
+
+inline void pipeline_warp(Pipeline& p, FrameSlot& f) {
+  const double t0 = stream_now_ms();
+  if (f.stats.has_h) {
+    xr::omp::OmpConfig cfg = p.params.stream.warp;
+    cfg.threads = p.params.warp_threads;
+    xr::warp::warp_perspective(f.frame.data(), p.width, p.width, p.height, f.out.data(), p.width, p.width, p.height,
+                               f.stats.h, p.params.stream.border, cfg);
+  } else {
+    std::copy(f.frame.begin(), f.frame.end(), f.out.begin());
+  }
+  f.stats.ms.warp = stream_now_ms() - t0;
+}
+
+// One stage thread: pop a slot, work on it, pass it on. The warp stage passes
+// it to the sink and back to the free list.
+inline void pipeline_stage(Pipeline& p, int stage) {
+  BoundedQueue<int>* in[3] = {&p.to_track, &p.to_homography, &p.to_warp};
+  BoundedQueue<int>* out[3] = {&p.to_homography, &p.to_warp, &p.free_slots};
+  StageReport& r = p.report.stages[stage];
+  int i;
+  while (in[stage]->pop(i)) {
+    FrameSlot& f = p.slots[i];
+    const double t0 = stream_now_ms();
+    r.wait.add(t0 - f.queued);
+    if (stage == 0) {
+      pipeline_track(p, f);
+    } else if (stage == 1) {
+      pipeline_homography(p, f);
+    } else {
+      pipeline_warp(p, f);
+    }
+    const double t1 = stream_now_ms();
+    r.service.add(t1 - t0);
+    if (stage == 2) {
+      f.stats.ms.total = t1 - f.submitted;
+      if (p.sink) p.sink(f.index, f.out.data(), p.width, f.stats);
+      const double done = stream_now_ms();
+      p.report.latency.add(done - f.submitted);
+      p.report.frames++;
+      p.report.ms = done - p.first_submit;
+    }
+    f.queued = stream_now_ms();
+    out[stage]->push(i);
+  }
+  if (stage < 2) out[stage]->close();
+}
+
+// Allocates the slots and starts the three stage threads. Budgets below 1 are
+// taken as 1.
+inline bool pipeline_start(Pipeline& p, int width, int height, const PipelineParams& params, FrameSink sink) {
+  if (p.running || params.max_in_flight < 1 || params.queue_capacity < 1) return false;
+  if (!stream_init(p.track, width, height, params.stream)) return false;
+  p.params = params;
+  p.params.track_threads = std::max(1, params.track_threads);
+  p.params.homography_threads = std::max(1, params.homography_threads);
+  p.params.warp_threads = std::max(1, params.warp_threads);
+  p.width = width;
+  p.height = height;
+  p.sink = std::move(sink);
+  p.slots.assign(params.max_in_flight, FrameSlot());
+  for (FrameSlot& f : p.slots) {
+    f.frame.resize((size_t)width * height);
+    f.out.resize(f.frame.size());
+    f.prev_pts.resize((size_t)params.stream.max_points * 2);
+    f.next_pts.resize(f.prev_pts.size());
+  }
+  p.free_slots.reset(params.max_in_flight);
+  for (int i = 0; i < params.max_in_flight; i++) p.free_slots.push(i);
+  p.to_track.reset(params.queue_capacity);
+  p.to_homography.reset(params.queue_capacity);
+  p.to_warp.reset(params.queue_capacity);
+  p.report = PipelineReport();
+  const char* names[3] = {"track", "homography", "warp"};
+  const int budgets[3] = {p.params.track_threads, p.params.homography_threads, p.params.warp_threads};
+  for (int s = 0; s < 3; s++) {
+    p.report.stages[s].name = names[s];
+    p.report.stages[s].threads = budgets[s];
+  }
+  p.submitted = 0;
+  p.failed = false;
+  p.running = true;
+  for (int s = 0; s < 3; s++) p.threads[s] = std::thread(pipeline_stage, std::ref(p), s);
+  return true;
+}
+
+// Copies the frame into a free slot, waiting for one if all are in flight.
+inline bool pipeline_submit(Pipeline& p, const uint8_t* frame, int step) {
+  if (!p.running || !frame || step < p.width) return false;
+  const double t0 = stream_now_ms();
+  if (p.submitted == 0) p.first_submit = t0;
+  int i;
+  if (!p.free_slots.pop(i)) return false;
+  p.report.submit_blocked_ms += stream_now_ms() - t0;
+  FrameSlot& f = p.slots[i];
+  for (int y = 0; y < p.height; y++) {
+    std::memcpy(f.frame.data() + (size_t)y * p.width, frame + (ptrdiff_t)y * step, p.width);
+  }
+  f.index = p.submitted++;
+  f.stats = FrameStats();
+  f.submitted = t0;
+  f.queued = stream_now_ms();
+  return p.to_track.push(i);
+}
+
+// Drains every submitted frame through the sink, stops the threads and fills
+// in the queue statistics of the report. Returns false if a stage failed.
+inline bool pipeline_finish(Pipeline& p) {
+  if (!p.running) return false;
+  p.to_track.close();
+  for (std::thread& t : p.threads) t.join();
+  p.free_slots.close();
+  BoundedQueue<int>* in[3] = {&p.to_track, &p.to_homography, &p.to_warp};
+  BoundedQueue<int>* out[3] = {&p.to_homography, &p.to_warp, &p.free_slots};
+  for (int s = 0; s < 3; s++) {
+    p.report.stages[s].depth = in[s]->depth();
+    p.report.stages[s].blocked_ms = s < 2 ? out[s]->blocked_ms() : 0.0;
+  }
+  p.running = false;
+  return !p.failed;
+}
+
+}  // namespace stream
+}  // namespace xr
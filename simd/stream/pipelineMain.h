@@ -0,0 +1,114 @@
+#pragma once
+
+// Runs the synthetic 1080p pan of streamMain.h through the frame pipeline:
+// every H must again be within 1 px of the true inter-frame motion and frames
+// must reach the sink in order. Compares stream_push with every thread, the
+// pipeline with one frame in flight (stages never overlap) and the pipeline
+// with overlapping frames, and prints the per-stage report: thread budget,
+// queue wait and service time (mean, and p50, p99 interpolated in the
+// log-scale histograms, followed by the raw bucket counts as lo-hi ms:count),
+// input queue depth at each push, and time blocked by back-pressure.
+//
+// g++ -O3 -fopenmp -std=c++17 main.cpp -o pipeline_demo
+
+#include <cstdio>
+#include <vector>
+
+#include "pipeline.h"
+#include "streamMain.h"
+
+namespace xr {
+namespace stream {
+
+inline void pipeline_print(const PipelineReport& r) {
+  printf("  %-11s %3s %20s %27s %12s %9s\n", "stage", "thr", "wait ms mean/p50/p99", "service ms mean/p50/p99",
+         "depth 0/1/..", "blocked");
+  for (const StageReport& s : r.stages) {
+    char depth[64];
+    int len = 0;
+    for (size_t d = 0; d < s.depth.size() && len < (int)sizeof(depth) - 1; d++) {
+      len += snprintf(depth + len, sizeof(depth) - len, d ? "/%llu" : "%llu", (unsigned long long)s.depth[d]);
+    }
+    printf("  %-11s %3d %6.2f %6.2f %6.2f %8.2f %8.2f %8.2f %12s %9.1f\n", s.name, s.threads, s.wait.mean(),
+           s.wait.percentile(0.5), s.wait.percentile(0.99), s.service.mean(), s.service.percentile(0.5),
+           s.service.percentile(0.99), depth, s.blocked_ms);
+    printf("      wait buckets    %s\n", s.wait.buckets().c_str());
+    printf("      service buckets %s\n", s.service.buckets().c_str());
+  }
+  printf("  latency ms mean %.2f p50 %.2f p99 %.2f max %.2f, submit blocked %.1f ms\n", r.latency.mean(),
+         r.latency.percentile(0.5), r.latency.percentile(0.99), r.latency.max, r.submit_blocked_ms);
+  printf("      latency buckets %s\n", r.latency.buckets().c_str());
+}
+
+}  // namespace stream
+}  // namespace xr
+
+inline int pipelineMain() {
+  using namespace xr::stream;
+
+  bool pass = true;
+  const int w = 1920, h = 1080, frames = 90;
+  const int scene_w = w + 10 * frames + 120, scene_h = h + 440;
+  const std::vector<uint8_t> scene = stream_scene(scene_w, scene_h, 7);
+  std::vector<std::vector<uint8_t>> video(frames, std::vector<uint8_t>((size_t)w * h));
+  for (int k = 0; k < frames; k++) {
+    double m[9];
+    float mf[9];
+    stream_camera(k, w, h, m);
+    for (int i = 0; i < 9; i++) mf[i] = (float)m[i];
+    xr::warp::warp_perspective(scene.data(), scene_w, scene_w, scene_h, video[k].data(), w, w, h, mf, 0);
+  }
+#ifdef _OPENMP
+  const int all = omp_get_max_threads();
+#else
+  const int all = 1;
+#endif
+
+  {
+    StreamParams params;
+    std::vector<uint8_t> out((size_t)w * h);
+    Stream s;
+    stream_init(s, w, h, params);
+    const double t0 = stream_now_ms();
+    for (int k = 0; k < frames; k++) pass &= stream_push(s, video[k].data(), w, out.data(), w);
+    printf("stream_push, %d threads: %.1f fps\n", all, 1000.0 * frames / (stream_now_ms() - t0));
+  }
+
+  // half the threads track, a quarter fit homographies, the rest warp
+  PipelineParams params;
+  params.track_threads = std::max(1, all / 2);
+  params.homography_threads = std::max(1, all / 4);
+  params.warp_threads = std::max(1, all - params.track_threads - params.homography_threads);
+  for (int in_flight : {1, 3}) {
+    params.max_in_flight = in_flight;
+    int64_t expect = 0;
+    int estimated = 0, detections = 0;
+    float worst_err = 0.0f;
+    bool ordered = true;
+    Pipeline p;
+    const FrameSink sink = [&](int64_t index, const uint8_t*, int, const FrameStats& st) {
+      ordered &= index == expect++;
+      if (index == 0) return;
+      detections += st.detected;
+      if (st.has_h) {
+        float truth[9];
+        stream_truth((int)index, w, h, truth);
+        worst_err = std::max(worst_err, stream_distance(st.h, truth, w, h));
+        estimated++;
+      }
+    };
+    bool ok = pipeline_start(p, w, h, params, sink);
+    for (int k = 0; k < frames && ok; k++) ok &= pipeline_submit(p, video[k].data(), w);
+    ok &= pipeline_finish(p);
+    ok &= ordered && p.report.frames == frames && estimated == frames - 1 && worst_err < 1.0f;
+    pass &= ok;
+    printf("\npipeline, %d frame%s in flight: %.1f fps, H on %d, worst %.3f px from truth, re-detected on %d "
+           "frames %s\n",
+           in_flight, in_flight > 1 ? "s" : "", 1000.0 * p.report.frames / p.report.ms, estimated, worst_err,
+           detections, ok ? "ok" : "FAILED");
+    pipeline_print(p.report);
+  }
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
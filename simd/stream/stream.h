@@ -0,0 +1,276 @@
+#pragma once
+
+// Video-stream mode of the stabilization pipeline of DSP/MTK's device demo
+// (LK tracking, RANSAC homography, bilinear warp), on the host. The device
+// demo handles one frame pair in isolation; here consecutive frames share
+// their work:
+//
+//   - every frame's pyramid (with derivatives) is built once, into one of two
+//     FlowPyramid slots. Frame k's pyramid is the "next" of pair (k - 1, k)
+//     and the "prev" of pair (k, k + 1); the roles swap by flipping an index,
+//     and the slots keep their memory, so steady state allocates nothing
+//   - the points tracked into frame k (RANSAC inliers, so moving objects drop
+//     out) are the points tracked out of it, swapped with the previous set
+//     rather than copied
+//   - new corners are detected only when fewer than min_points survive: the
+//     Shi-Tomasi response of the frame's level-0 Scharr derivatives, already
+//     in the pyramid, strongest per grid cell, in cells no point occupies
+//   - H maps the previous frame's points onto the current frame's, as
+//     cv::findHomography and the device; the output is the current frame
+//     warped back onto the previous one (m = H for xr::warp)
+//
+// stream_push reports the time of every stage. Functions return false for
+// arguments they do not support.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../flow/flow.h"
+#include "../homography/homography.h"
+#include "../warp/warp.h"
+
+namespace xr {
+namespace stream {
+
+struct StreamParams {
+  xr::flow::LkParams lk;
+  xr::homography::RansacParams ransac;
+  int max_points = 500;   // points per frame, as the device demo
+  int min_points = 300;   // re-detect when fewer survive a frame
+  int cell = 32;          // at most one new corner per cell x cell block
+  float quality = 0.01f;  // corners weaker than this share of the strongest are dropped
+  uint8_t border = 0;     // warp border value
+  xr::omp::OmpConfig warp;
+  int threads = 0;  // <= 0 uses every OpenMP thread
+};
+
+// milliseconds per stage of one stream_push
+struct StageTimes {
+  double pyramid = 0.0, track = 0.0, homography = 0.0, warp = 0.0, detect = 0.0, total = 0.0;
+};
+
+struct FrameStats {
+  int tracked = 0;         // points tracked from the previous frame
+  int inliers = 0;         // of them, RANSAC inliers
+  int points = 0;          // points carried to the next frame
+  bool detected = false;   // new corners were added on this frame
+  bool has_h = false;      // false on the first frame and when too few points tracked
+  float h[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  StageTimes ms;
+};
+
+struct Corner {
+  float response;
+  int x, y;
+};
+
+struct Stream {
+  StreamParams params;
+  int width = 0, height = 0;
+  int frames = 0;
+  xr::flow::FlowPyramid pyr[2];
+  int prev = 0;  // slot of the last frame; the other one is rebuilt
+  int count = 0;
+  std::vector<float> prev_pts, next_pts;  // interleaved, max_points each
+  std::vector<uint8_t> status, inlier;
+  std::vector<Corner> corners;     // one candidate per cell
+  std::vector<uint8_t> occupied;   // per cell
+};
+
+inline double stream_now_ms() {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Sizes every buffer for width x height frames; the stream then allocates only
+// while the first two pyramids are built.
+inline bool stream_init(Stream& s, int width, int height, const StreamParams& params) {
+  if (width < 16 || height < 16 || params.max_points < 4 || params.cell < 4) return false;
+  if (params.min_points > params.max_points || !(params.quality >= 0.0f)) return false;
+  s.params = params;
+  s.width = width;
+  s.height = height;
+  s.frames = 0;
+  s.prev = 0;
+  s.count = 0;
+  s.prev_pts.assign((size_t)params.max_points * 2, 0.0f);
+  s.next_pts.assign(s.prev_pts.size(), 0.0f);
+  s.status.assign(params.max_points, 0);
+  s.inlier.assign(params.max_points, 0);
+  const int cells_x = (width + params.cell - 1) / params.cell, cells_y = (height + params.cell - 1) / params.cell;
+  s.corners.resize((size_t)cells_x * cells_y);
+  s.occupied.resize(s.corners.size());
+  return true;
+}
+
+// Minimum eigenvalue of the 3x3-summed structure tensor at (x, y).
+inline float shi_tomasi(const xr::flow::LkLevel& l, int x, int y) {
+  int32_t a = 0, b = 0, c = 0;
+  for (int dy = -1; dy <= 1; dy++) {
+    const int16_t* gx = l.dx + (y + dy) * l.dstep + x;
+    const int16_t* gy = l.dy + (y + dy) * l.dstep + x;
+    for (int dx = -1; dx <= 1; dx++) {
+      a += gx[dx] * gx[dx];
+      b += gx[dx] * gy[dx];
+      c += gy[dx] * gy[dx];
+    }
+  }
+  const float h = (float)(a - c) * 0.5f;
+  return (float)(a + c) * 0.5f - std::sqrt(h * h + (float)b * b);
+}
+
+// Adds up to max_points - s.count corners of pyramid slot pyr to s.prev_pts:
+// the strongest of every free cell, strongest cells first, ties by position.
+// Returns the number added.
+inline int detect_corners(Stream& s, int pyr, int threads) {
+#ifndef _OPENMP
+  (void)threads;
+#endif
+  const StreamParams& p = s.params;
+  const xr::flow::LkLevel l = s.pyr[pyr].view(0);
+  const int cells_x = (s.width + p.cell - 1) / p.cell, cells = (int)s.corners.size();
+  std::fill(s.occupied.begin(), s.occupied.end(), 0);
+  for (int i = 0; i < s.count; i++) {
+    const int cx = (int)s.prev_pts[2 * i] / p.cell, cy = (int)s.prev_pts[2 * i + 1] / p.cell;
+    if (cx >= 0 && cy >= 0 && cx < cells_x && cy * cells_x + cx < cells) s.occupied[cy * cells_x + cx] = 1;
+  }
+
+  // keep the window of the tracker inside the frame
+  const int margin = std::max(p.lk.win_width, p.lk.win_height) / 2 + 1;
+#pragma omp parallel for schedule(dynamic, 4) num_threads(threads)
+  for (int i = 0; i < cells; i++) {
+    Corner best = {0.0f, -1, -1};
+    if (!s.occupied[i]) {
+      const int x0 = std::max(margin, i % cells_x * p.cell), y0 = std::max(margin, i / cells_x * p.cell);
+      const int x1 = std::min(s.width - margin, (i % cells_x + 1) * p.cell);
+      const int y1 = std::min(s.height - margin, (i / cells_x + 1) * p.cell);
+      for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+          const float r = shi_tomasi(l, x, y);
+          if (r > best.response) best = {r, x, y};
+        }
+      }
+    }
+    s.corners[i] = best;
+  }
+
+  float strongest = 0.0f;
+  int n = 0;
+  for (int i = 0; i < cells; i++) {
+    if (s.corners[i].x < 0) continue;
+    strongest = std::max(strongest, s.corners[i].response);
+    s.corners[n++] = s.corners[i];
+  }
+  const float floor = strongest * p.quality;
+  const int want = std::min(n, p.max_points - s.count);
+  std::partial_sort(s.corners.begin(), s.corners.begin() + want, s.corners.begin() + n,
+                    [](const Corner& a, const Corner& b) {
+                      if (a.response != b.response) return a.response > b.response;
+                      return a.y != b.y ? a.y < b.y : a.x < b.x;
+                    });
+  int added = 0;
+  for (; added < want && s.corners[added].response > floor; added++) {
+    s.prev_pts[2 * (s.count + added)] = (float)s.corners[added].x;
+    s.prev_pts[2 * (s.count + added) + 1] = (float)s.corners[added].y;
+  }
+  s.count += added;
+  return added;
+}
+
+// Feeds the next frame (width x height of stream_init, step in bytes). When
+// out is set it receives the frame warped onto the previous one; the first
+// frame, and a frame without an estimate, is copied unchanged.
+inline bool stream_push(Stream& s, const uint8_t* frame, int step, uint8_t* out = nullptr, int out_step = 0,
+                        FrameStats* stats = nullptr) {
+  if (!frame || s.width <= 0 || step < s.width || (out && out_step < s.width)) return false;
+  const StreamParams& p = s.params;
+#ifdef _OPENMP
+  const int threads = p.threads <= 0 ? omp_get_max_threads() : p.threads;
+#else
+  const int threads = 1;
+#endif
+  FrameStats st;
+  const double t0 = stream_now_ms();
+  const int cur = s.prev ^ 1;
+  if (!xr::flow::build_flow_pyramid(frame, step, s.width, s.height, p.lk, true, s.pyr[cur], threads)) return false;
+  const double t1 = stream_now_ms();
+  st.ms.pyramid = t1 - t0;
+
+  int kept = 0;
+  if (s.frames > 0 && s.count > 0) {
+    if (!xr::flow::calc_optical_flow_pyr_lk(s.pyr[s.prev], s.pyr[cur], s.prev_pts.data(), s.count,
+                                            s.next_pts.data(), s.status.data(), p.lk, threads)) {
+      return false;
+    }
+    // compact the pairs that are still on the frame
+    for (int i = 0; i < s.count; i++) {
+      const float x = s.next_pts[2 * i], y = s.next_pts[2 * i + 1];
+      if (!s.status[i] || !(x >= 0.0f && y >= 0.0f && x <= s.width - 1.0f && y <= s.height - 1.0f)) continue;
+      s.prev_pts[2 * kept] = s.prev_pts[2 * i];
+      s.prev_pts[2 * kept + 1] = s.prev_pts[2 * i + 1];
+      s.next_pts[2 * kept] = x;
+      s.next_pts[2 * kept + 1] = y;
+      kept++;
+    }
+  }
+  st.tracked = kept;
+  const double t2 = stream_now_ms();
+  st.ms.track = t2 - t1;
+
+  if (kept >= 4) {
+    xr::homography::RansacStats rs;
+    st.has_h = xr::homography::find_homography_ransac(s.prev_pts.data(), s.next_pts.data(), kept, st.h, p.ransac,
+                                                      s.inlier.data(), &rs, nullptr, threads);
+    if (st.has_h) {
+      st.inliers = rs.inliers;
+      int n = 0;
+      for (int i = 0; i < kept; i++) {
+        if (!s.inlier[i]) continue;
+        s.next_pts[2 * n] = s.next_pts[2 * i];
+        s.next_pts[2 * n + 1] = s.next_pts[2 * i + 1];
+        n++;
+      }
+      kept = n;
+    } else {
+      const FrameStats identity;
+      std::copy(identity.h, identity.h + 9, st.h);
+    }
+  }
+  const double t3 = stream_now_ms();
+  st.ms.homography = t3 - t2;
+
+  if (out) {
+    if (st.has_h) {
+      xr::warp::warp_perspective(frame, step, s.width, s.height, out, out_step, s.width, s.height, st.h, p.border,
+                                 p.warp);
+    } else {
+      for (int y = 0; y < s.height; y++) {
+        std::memcpy(out + (ptrdiff_t)y * out_step, frame + (ptrdiff_t)y * step, s.width);
+      }
+    }
+  }
+  const double t4 = stream_now_ms();
+  st.ms.warp = t4 - t3;
+
+  // the current frame becomes the previous one
+  s.prev = cur;
+  s.prev_pts.swap(s.next_pts);
+  s.count = kept;
+  if (s.count < p.min_points) st.detected = detect_corners(s, cur, threads) > 0;
+  st.points = s.count;
+  s.frames++;
+  const double t5 = stream_now_ms();
+  st.ms.detect = t5 - t4;
+  st.ms.total = t5 - t0;
+  if (stats) *stats = st;
+  return true;
+}
+
+}  // namespace stream
+}  // namespace xr
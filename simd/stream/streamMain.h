@@ -0,0 +1,171 @@
+#pragma once
+
+// Runs the stabilization stream on a synthetic 1080p video: a textured scene
+// filmed by a camera that pans (points leave the frame, so corners have to be
+// re-detected now and then) with a small rotation and translation jitter. Every
+// estimated H must map the frame within 1 px of the true inter-frame motion.
+// Reports the sustained fps, the mean and worst latency of every stage, and
+// the same frames handled pair by pair in isolation (fresh stream per pair:
+// both pyramids rebuilt, buffers allocated, corners detected), as the device
+// demo does.
+//
+// g++ -O3 -fopenmp -std=c++17 main.cpp -o stream_demo
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "stream.h"
+
+namespace xr {
+namespace stream {
+
+// noise box-blurred twice, stretched back to 0..255
+inline std::vector<uint8_t> stream_scene(int w, int h, uint32_t seed) {
+  std::vector<float> a((size_t)w * h), b(a.size());
+  for (auto& x : a) {
+    seed = seed * 1664525u + 1013904223u;
+    x = (float)(seed >> 24);
+  }
+  const int r = 2;
+  for (int pass = 0; pass < 2; pass++) {
+    for (int y = 0; y < h; y++) {
+      for (int x = 0; x < w; x++) {
+        float s = 0.0f;
+        for (int k = -r; k <= r; k++) s += a[(size_t)y * w + std::min(w - 1, std::max(0, x + k))];
+        b[(size_t)y * w + x] = s / (2 * r + 1);
+      }
+    }
+    for (int y = 0; y < h; y++) {
+      for (int x = 0; x < w; x++) {
+        float s = 0.0f;
+        for (int k = -r; k <= r; k++) s += b[(size_t)std::min(h - 1, std::max(0, y + k)) * w + x];
+        a[(size_t)y * w + x] = s / (2 * r + 1);
+      }
+    }
+  }
+  std::vector<uint8_t> img(a.size());
+  for (size_t i = 0; i < a.size(); i++) {
+    img[i] = (uint8_t)std::min(255.0f, std::max(0.0f, (a[i] - 127.5f) * 6.0f + 127.5f));
+  }
+  return img;
+}
+
+// camera of frame k: maps frame pixels to scene pixels
+inline void stream_camera(int k, int w, int h, double m[9]) {
+  const double deg = 0.6 * std::sin(k * 0.9) + 0.3 * std::sin(k * 2.3);
+  const double tx = 40.0 + 10.0 * k + 3.0 * std::sin(k * 1.7), ty = 200.0 + 6.0 * std::sin(k * 0.7);
+  const double c = std::cos(deg * 0.017453292519943295), s = std::sin(deg * 0.017453292519943295);
+  const double cx = w * 0.5, cy = h * 0.5;
+  const double a[9] = {c, -s, cx - c * cx + s * cy + tx, s, c, cy - s * cx - c * cy + ty, 0.0, 0.0, 1.0};
+  for (int i = 0; i < 9; i++) m[i] = a[i];
+}
+
+// true H from frame k - 1 to frame k: camera(k)^-1 * camera(k - 1)
+inline void stream_truth(int k, int w, int h, float hm[9]) {
+  double a[9], b[9];
+  stream_camera(k - 1, w, h, a);
+  stream_camera(k, w, h, b);
+  // b is a rigid motion: its inverse is the transposed rotation
+  const double inv[9] = {b[0], b[3], -(b[0] * b[2] + b[3] * b[5]), b[1], b[4], -(b[1] * b[2] + b[4] * b[5]),
+                         0.0,  0.0,  1.0};
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      hm[3 * r + c] = (float)(inv[3 * r] * a[c] + inv[3 * r + 1] * a[3 + c] + inv[3 * r + 2] * a[6 + c]);
+    }
+  }
+}
+
+// largest distance between the two maps over a grid on the frame
+inline float stream_distance(const float a[9], const float b[9], int w, int h) {
+  float worst = 0.0f;
+  for (int y = 0; y <= 8; y++) {
+    for (int x = 0; x <= 8; x++) {
+      const float px = x * w / 8.0f, py = y * h / 8.0f;
+      const float wa = a[6] * px + a[7] * py + a[8], wb = b[6] * px + b[7] * py + b[8];
+      const float du = (a[0] * px + a[1] * py + a[2]) / wa - (b[0] * px + b[1] * py + b[2]) / wb;
+      const float dv = (a[3] * px + a[4] * py + a[5]) / wa - (b[3] * px + b[4] * py + b[5]) / wb;
+      worst = std::max(worst, std::hypot(du, dv));
+    }
+  }
+  return worst;
+}
+
+}  // namespace stream
+}  // namespace xr
+
+inline int streamMain() {
+  using namespace xr::stream;
+
+  bool pass = true;
+  const int w = 1920, h = 1080, frames = 90;
+  const int scene_w = w + 10 * frames + 120, scene_h = h + 440;
+  const std::vector<uint8_t> scene = stream_scene(scene_w, scene_h, 7);
+  std::vector<std::vector<uint8_t>> video(frames, std::vector<uint8_t>((size_t)w * h));
+  for (int k = 0; k < frames; k++) {
+    double m[9];
+    float mf[9];
+    stream_camera(k, w, h, m);
+    for (int i = 0; i < 9; i++) mf[i] = (float)m[i];
+    xr::warp::warp_perspective(scene.data(), scene_w, scene_w, scene_h, video[k].data(), w, w, h, mf, 0);
+  }
+
+  StreamParams params;
+  std::vector<uint8_t> out((size_t)w * h);
+  Stream s;
+  stream_init(s, w, h, params);
+  StageTimes sum, worst;
+  int detections = 0, estimated = 0, points = 0;
+  float worst_err = 0.0f;
+  for (int k = 0; k < frames; k++) {
+    FrameStats st;
+    pass &= stream_push(s, video[k].data(), w, out.data(), w, &st);
+    if (k == 0) continue;  // the first frame only builds its pyramid and detects
+    detections += st.detected;
+    points += st.tracked;
+    if (st.has_h) {
+      float truth[9];
+      stream_truth(k, w, h, truth);
+      worst_err = std::max(worst_err, stream_distance(st.h, truth, w, h));
+      estimated++;
+    }
+    double* sv[] = {&sum.pyramid, &sum.track, &sum.homography, &sum.warp, &sum.detect, &sum.total};
+    double* wv[] = {&worst.pyramid, &worst.track, &worst.homography, &worst.warp, &worst.detect, &worst.total};
+    const double v[] = {st.ms.pyramid, st.ms.track, st.ms.homography, st.ms.warp, st.ms.detect, st.ms.total};
+    for (int i = 0; i < 6; i++) {
+      *sv[i] += v[i];
+      *wv[i] = std::max(*wv[i], v[i]);
+    }
+  }
+  const int n = frames - 1;
+  const bool ok = estimated == n && worst_err < 1.0f && detections > 0 && detections < n / 2;
+  pass &= ok;
+  printf("stream, %d frames 1920x1080: H on %d, worst %.3f px from truth, %.0f points tracked on average, "
+         "re-detected on %d frames %s\n",
+         frames, estimated, worst_err, (double)points / n, detections, ok ? "ok" : "FAILED");
+  printf("  sustained %.1f fps (all threads)\n", 1000.0 * n / sum.total);
+  printf("  stage ms     mean   worst\n");
+  const char* names[] = {"pyramid", "track", "homography", "warp", "detect", "total"};
+  const double mean[] = {sum.pyramid, sum.track, sum.homography, sum.warp, sum.detect, sum.total};
+  const double most[] = {worst.pyramid, worst.track, worst.homography, worst.warp, worst.detect, worst.total};
+  for (int i = 0; i < 6; i++) printf("  %-11s %6.2f  %6.2f\n", names[i], mean[i] / n, most[i]);
+
+  // the device demo's way: every pair on its own
+  {
+    double total = 0.0;
+    for (int k = 1; k < frames; k++) {
+      const double t0 = stream_now_ms();
+      Stream pair;
+      FrameStats st;
+      stream_init(pair, w, h, params);
+      stream_push(pair, video[k - 1].data(), w);
+      stream_push(pair, video[k].data(), w, out.data(), w, &st);
+      total += stream_now_ms() - t0;
+      pass &= st.has_h;
+    }
+    printf("\npair by pair: %.1f fps, %.2f ms per frame\n", 1000.0 * n / total, total / n);
+  }
+
+  printf("%s\n", pass ? "Test Passed!" : "Test Failed!");
+  return pass ? 0 : -1;
+}
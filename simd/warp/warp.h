@@ -0,0 +1,196 @@
+#pragma once
+
+// Perspective warp of 8-bit images, bilinear with a constant border: the host
+// version of the device's mtkapi_warpperspective_bl_u8, and the integer
+// counterpart of the float warp in openMP/omp_image.h.
+//
+//   - m maps destination pixels to source pixels. The numerators X, Y and the
+//     denominator W of the map are int32 fixed point (X and Y with shift_xy
+//     fractional bits, W with shift_w), exact per pixel and stepped along a
+//     row by integer adds; each pixel then costs one float division per axis
+//     and is rounded to 1/32 pixel
+//   - the 1/32 fractions give integer weights (32 - fx)(32 - fy), fx(32 - fy),
+//     (32 - fx)fy, fx fy summing to 1024; out = (sum + 512) >> 10
+//   - the output is cut into tiles (xr::omp::for_each_tile and its
+//     OmpConfig), spread over OpenMP threads
+//   - a tile whose corners all land well inside the source (W positive) runs
+//     the fast kernel: two gathers of byte pairs per vector, no bounds checks.
+//     Other tiles run the masked kernel, where taps outside the source are
+//     replaced by the border value under a per-lane mask.
+//
+// Every step is either exact or a single correctly rounded IEEE operation
+// (int -> float, divide, times a power of two, round to nearest), so every
+// backend, every tiling and warp_perspective_ref give the same bytes.
+// Steps are in bytes. Functions return false for arguments they do not
+// support.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "../../openMP/omp_image.h"
+#include "../xr_simd.h"
+
+namespace xr {
+namespace warp {
+
+// Fixed-point form of m over a dst_w x dst_h output.
+struct WarpFixed {
+  double m[9];
+  int shift_xy, shift_w;
+  int32_t step[3];  // X, Y, W per output column
+  float scale;      // 32 * 2^(shift_w - shift_xy): X / W * scale is in 1/32 pixel
+};
+
+struct WarpJob {
+  const uint8_t* src;
+  ptrdiff_t src_step;
+  int src_w, src_h;
+  uint8_t* dst;
+  ptrdiff_t dst_step;
+  uint8_t border;
+  float max_x, max_y;  // clamp of the 1/32 pixel coordinates, (size + 1) * 32
+  WarpFixed f;
+};
+
+// Exact X, Y, W of output pixel (x, y).
+inline void warp_xyw(const WarpFixed& f, int x, int y, int32_t xyw[3]) {
+  for (int k = 0; k < 3; k++) {
+    const int shift = k == 2 ? f.shift_w : f.shift_xy;
+    const int64_t row = std::llround(std::ldexp(f.m[3 * k + 1] * y + f.m[3 * k + 2], shift));
+    xyw[k] = (int32_t)(row + (int64_t)x * f.step[k]);
+  }
+}
+
+// Source position of one pixel in 1/32 pixel units, clamped so far-away
+// points stay in int range (they read border anyway). W == 0 maps outside.
+inline void warp_coord(const WarpJob& j, const int32_t xyw[3], int32_t* sx, int32_t* sy) {
+  if (xyw[2] == 0) {
+    *sx = *sy = -64;
+    return;
+  }
+  const float w = (float)xyw[2];
+  *sx = (int32_t)std::nearbyint(std::min(std::max((float)xyw[0] / w * j.f.scale, -64.0f), j.max_x));
+  *sy = (int32_t)std::nearbyint(std::min(std::max((float)xyw[1] / w * j.f.scale, -64.0f), j.max_y));
+}
+
+inline uint8_t warp_sample(const WarpJob& j, int32_t sx, int32_t sy) {
+  const int ix = sx >> 5, iy = sy >> 5, fx = sx & 31, fy = sy & 31;
+  auto tap = [&](int x, int y) -> int {
+    return x >= 0 && x < j.src_w && y >= 0 && y < j.src_h ? j.src[(ptrdiff_t)y * j.src_step + x] : j.border;
+  };
+  const int v = tap(ix, iy) * (32 - fx) * (32 - fy) + tap(ix + 1, iy) * fx * (32 - fy) +
+                tap(ix, iy + 1) * (32 - fx) * fy + tap(ix + 1, iy + 1) * fx * fy;
+  return (uint8_t)((v + 512) >> 10);
+}
+
+#define XR_SIMD_KERNELS "warp/warp_kernels.inl"
+#include "../xr_simd_foreach.h"
+
+// Picks the shifts so X, Y and W stay below 2^29 in magnitude over the whole
+// output (the map is linear in x and y, so the corners bound it); false when
+// m needs more range than int32 has.
+inline bool warp_fixed(const float m[9], int dst_w, int dst_h, WarpFixed& f) {
+  for (int i = 0; i < 9; i++) {
+    f.m[i] = m[i];
+    if (!std::isfinite(f.m[i])) return false;
+  }
+  double max_xy = 0.0, max_w = 0.0;
+  for (int c = 0; c < 4; c++) {
+    const double x = c & 1 ? dst_w : 0, y = c & 2 ? dst_h : 0;
+    max_xy = std::max(max_xy, std::fabs(f.m[0] * x + f.m[1] * y + f.m[2]));
+    max_xy = std::max(max_xy, std::fabs(f.m[3] * x + f.m[4] * y + f.m[5]));
+    max_w = std::max(max_w, std::fabs(f.m[6] * x + f.m[7] * y + f.m[8]));
+  }
+  f.shift_xy = std::min(24, 28 - (int)std::ceil(std::log2(max_xy + 1.0)));
+  f.shift_w = std::min(30, 28 - (int)std::ceil(std::log2(max_w + 1e-30)));
+  if (f.shift_xy < 0 || f.shift_w < 0) return false;
+  f.step[0] = (int32_t)std::llround(std::ldexp(f.m[0], f.shift_xy));
+  f.step[1] = (int32_t)std::llround(std::ldexp(f.m[3], f.shift_xy));
+  f.step[2] = (int32_t)std::llround(std::ldexp(f.m[6], f.shift_w));
+  f.scale = (float)std::ldexp(32.0, f.shift_w - f.shift_xy);
+  return true;
+}
+
+// True when every tap of every pixel of the tile is inside the source with
+// room for the gathers' 4-byte reads: the corners, mapped exactly, must land
+// one pixel inside [0, src_w - 4] x [0, src_h - 2] with W positive. Since the
+// map of a tile with W > 0 is convex, the inside of the tile follows.
+inline bool warp_tile_inside(const WarpJob& j, int x0, int y0, int x1, int y1) {
+  const double* m = j.f.m;
+  for (int c = 0; c < 4; c++) {
+    const double x = c & 1 ? x1 - 1 : x0, y = c & 2 ? y1 - 1 : y0;
+    const double w = m[6] * x + m[7] * y + m[8];
+    if (!(w > 1e-6)) return false;
+    const double sx = (m[0] * x + m[1] * y + m[2]) / w, sy = (m[3] * x + m[4] * y + m[5]) / w;
+    if (!(sx >= 1.0 && sx <= j.src_w - 5.0 && sy >= 1.0 && sy <= j.src_h - 3.0)) return false;
+  }
+  return true;
+}
+
+inline bool warp_job(const uint8_t* src, int src_step, int src_w, int src_h, uint8_t* dst, int dst_step, int dst_w,
+                     int dst_h, const float m[9], uint8_t border, WarpJob& j) {
+  if (!src || !dst || src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) return false;
+  if (src_step < src_w || dst_step < dst_w || (int64_t)src_step * (src_h + 1) > INT32_MAX) return false;
+  if (!warp_fixed(m, dst_w, dst_h, j.f)) return false;
+  j.src = src;
+  j.src_step = src_step;
+  j.src_w = src_w;
+  j.src_h = src_h;
+  j.dst = dst;
+  j.dst_step = dst_step;
+  j.border = border;
+  j.max_x = (float)(src_w + 1) * 32.0f;
+  j.max_y = (float)(src_h + 1) * 32.0f;
+  return true;
+}
+
+// Plain per-pixel loop of the same math, the reference the tiled version must
+// match byte for byte.
+inline bool warp_perspective_ref(const uint8_t* src, int src_step, int src_w, int src_h, uint8_t* dst, int dst_step,
+                                 int dst_w, int dst_h, const float m[9], uint8_t border) {
+  WarpJob j;
+  if (!warp_job(src, src_step, src_w, src_h, dst, dst_step, dst_w, dst_h, m, border, j)) return false;
+  for (int y = 0; y < dst_h; y++) {
+    for (int x = 0; x < dst_w; x++) {
+      int32_t xyw[3], sx, sy;
+      warp_xyw(j.f, x, y, xyw);
+      warp_coord(j, xyw, &sx, &sy);
+      dst[(ptrdiff_t)y * dst_step + x] = warp_sample(j, sx, sy);
+    }
+  }
+  return true;
+}
+
+// Tiled SIMD warp; cfg sets the threads, the schedule and the tile size.
+inline bool warp_perspective(const uint8_t* src, int src_step, int src_w, int src_h, uint8_t* dst, int dst_step,
+                             int dst_w, int dst_h, const float m[9], uint8_t border,
+                             const xr::omp::OmpConfig& cfg = xr::omp::OmpConfig()) {
+  WarpJob j;
+  if (!warp_job(src, src_step, src_w, src_h, dst, dst_step, dst_w, dst_h, m, border, j)) return false;
+  auto fast = XR_SIMD_DISPATCH(warp_tile_fast);
+  auto masked = XR_SIMD_DISPATCH(warp_tile_masked);
+  xr::omp::for_each_tile(dst_w, dst_h, cfg, [&](int x0, int y0, int x1, int y1) {
+    (warp_tile_inside(j, x0, y0, x1, y1) ? fast : masked)(j, x0, y0, x1, y1);
+  });
+  return true;
+}
+
+// Inverse of a 3x3 matrix, scaled so inv[8] = 1 when possible. Use it on a
+// homography that maps source to destination (cv::findHomography's
+// convention) to get the m warp_perspective wants.
+inline bool invert_homography(const float h[9], float inv[9]) {
+  const double a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7], l = h[8];
+  const double r[9] = {e * l - f * k, c * k - b * l, b * f - c * e, f * g - d * l, a * l - c * g,
+                       c * d - a * f, d * k - e * g, b * g - a * k, a * e - b * d};
+  const double det = a * r[0] + b * r[3] + c * r[6];
+  if (std::fabs(det) < 1e-300) return false;
+  const double s = std::fabs(r[8]) > 1e-12 * std::fabs(det) ? r[8] : det;
+  for (int i = 0; i < 9; i++) inv[i] = (float)(r[i] / s);
+  return true;
+}
+
+}  // namespace warp
+}  // namespace xr
@@ -0,0 +1,120 @@
+// Perspective warp kernels, expanded per backend by xr_simd_foreach.h from
+// warp.h. A tile is walked row by row; X, Y, W of a vector of pixels start
+// from the exact row values and step by whole vectors with integer adds, the
+// same numbers warp_xyw gives pixel by pixel.
+
+// 1/32 pixel source coordinates of a vector, as warp_coord. W == 0 lanes
+// divide by 1 and are then replaced, so no lane ever converts a NaN.
+inline void warp_coords(const WarpJob& j, vi32 X, vi32 Y, vi32 W, vi32* sx, vi32* sy) {
+  const vi32 zero = cmpeq(W, zero_i32()), outside = set1_i32(-64);
+  const vf32 w = cvt_f32(select(zero, set1_i32(1), W));
+  const vf32 scale = set1_f32(j.f.scale), lo = set1_f32(-64.0f);
+  const vf32 fx = min(max(mul(div(cvt_f32(X), w), scale), lo), set1_f32(j.max_x));
+  const vf32 fy = min(max(mul(div(cvt_f32(Y), w), scale), lo), set1_f32(j.max_y));
+  *sx = select(zero, outside, cvt_i32(fx));
+  *sy = select(zero, outside, cvt_i32(fy));
+}
+
+// ((t00 (32 - fx) + t01 fx)(32 - fy) + (t10 (32 - fx) + t11 fx) fy + 512) >> 10,
+// the reference sum regrouped
+inline vi32 warp_blend(vi32 t00, vi32 t01, vi32 t10, vi32 t11, vi32 fx, vi32 fy) {
+  const vi32 k32 = set1_i32(32);
+  const vi32 gx = sub(k32, fx), gy = sub(k32, fy);
+  const vi32 top = add(mul(t00, gx), mul(t01, fx)), bottom = add(mul(t10, gx), mul(t11, fx));
+  return shr(add(add(mul(top, gy), mul(bottom, fy)), set1_i32(512)), 10);
+}
+
+inline void warp_store(uint8_t* p, const vi32 g[4]) {
+  storeu(p, narrow_sat_u8(narrow_sat_i16(g[0], g[1]), narrow_sat_i16(g[2], g[3])));
+}
+
+// X, Y, W of pixels x .. x + N - 1 of row y, and their step per vector
+inline void warp_row_start(const WarpJob& j, int x, int y, vi32 v[3], vi32 dv[3]) {
+  int32_t xyw[3], lane[16];
+  warp_xyw(j.f, x, y, xyw);
+  for (int i = 0; i < vi32::N; i++) lane[i] = i;
+  const vi32 iota = loadu(lane);
+  for (int k = 0; k < 3; k++) {
+    v[k] = add(set1_i32(xyw[k]), mul(iota, set1_i32(j.f.step[k])));
+    dv[k] = set1_i32(vi32::N * j.f.step[k]);
+  }
+}
+
+inline void warp_tail(const WarpJob& j, uint8_t* row, int x, int x1, int y) {
+  for (; x < x1; x++) {
+    int32_t xyw[3], sx, sy;
+    warp_xyw(j.f, x, y, xyw);
+    warp_coord(j, xyw, &sx, &sy);
+    row[x] = warp_sample(j, sx, sy);
+  }
+}
+
+// Tile whose taps are all inside the source with 2 bytes to spare on the
+// right (warp_tile_inside): one byte-pair gather per source row gives both
+// taps of that row.
+inline void warp_tile_fast(const WarpJob& j, int x0, int y0, int x1, int y1) {
+  const vi32 step = set1_i32((int32_t)j.src_step), k31 = set1_i32(31), lo8 = set1_i32(0xFF);
+  for (int y = y0; y < y1; y++) {
+    uint8_t* row = j.dst + y * j.dst_step;
+    vi32 v[3], dv[3];
+    warp_row_start(j, x0, y, v, dv);
+    int x = x0;
+    for (; x + vu8::N <= x1; x += vu8::N) {
+      vi32 g[4];
+      for (int k = 0; k < 4; k++) {
+        vi32 sx, sy;
+        warp_coords(j, v[0], v[1], v[2], &sx, &sy);
+        const vi32 off = add(mul(shr(sy, 5), step), shr(sx, 5));
+        const vi32 p0 = gather_u16(j.src, off), p1 = gather_u16(j.src + j.src_step, off);
+        g[k] = warp_blend(bit_and(p0, lo8), shr(p0, 8), bit_and(p1, lo8), shr(p1, 8), bit_and(sx, k31),
+                          bit_and(sy, k31));
+        for (int c = 0; c < 3; c++) v[c] = add(v[c], dv[c]);
+      }
+      warp_store(row + x, g);
+    }
+    warp_tail(j, row, x, x1, y);
+  }
+}
+
+// taps at clamped offsets, one load per lane
+inline vi32 warp_taps(const uint8_t* src, vi32 off) {
+  int32_t o[16], t[16];
+  storeu(o, off);
+  for (int i = 0; i < vi32::N; i++) t[i] = src[o[i]];
+  return loadu(t);
+}
+
+// Any tile: taps outside the source are read at a clamped position and then
+// replaced by the border under the lane mask x in [0, w) and y in [0, h).
+inline void warp_tile_masked(const WarpJob& j, int x0, int y0, int x1, int y1) {
+  const vi32 step = set1_i32((int32_t)j.src_step), k31 = set1_i32(31), one = set1_i32(1), zero = zero_i32();
+  const vi32 w = set1_i32(j.src_w), h = set1_i32(j.src_h), border = set1_i32(j.border);
+  const vi32 wmax = set1_i32(j.src_w - 1), hmax = set1_i32(j.src_h - 1), neg = set1_i32(-1);
+  for (int y = y0; y < y1; y++) {
+    uint8_t* row = j.dst + y * j.dst_step;
+    vi32 v[3], dv[3];
+    warp_row_start(j, x0, y, v, dv);
+    int x = x0;
+    for (; x + vu8::N <= x1; x += vu8::N) {
+      vi32 g[4];
+      for (int k = 0; k < 4; k++) {
+        vi32 sx, sy;
+        warp_coords(j, v[0], v[1], v[2], &sx, &sy);
+        const vi32 ix[2] = {shr(sx, 5), add(shr(sx, 5), one)}, iy[2] = {shr(sy, 5), add(shr(sy, 5), one)};
+        vi32 t[2][2];
+        for (int r = 0; r < 2; r++) {
+          const vi32 in_y = bit_and(cmpgt(iy[r], neg), cmplt(iy[r], h));
+          const vi32 base = mul(min(max(iy[r], zero), hmax), step);
+          for (int c = 0; c < 2; c++) {
+            const vi32 in = bit_and(in_y, bit_and(cmpgt(ix[c], neg), cmplt(ix[c], w)));
+            t[r][c] = select(in, warp_taps(j.src, add(base, min(max(ix[c], zero), wmax))), border);
+          }
+        }
+        g[k] = warp_blend(t[0][0], t[0][1], t[1][0], t[1][1], bit_and(sx, k31), bit_and(sy, k31));
+        for (int c = 0; c < 3; c++) v[c] = add(v[c], dv[c]);
+      }
+      warp_store(row + x, g);
+    }
+    warp_tail(j, row, x, x1, y);
+  }
+}
@@ -0,0 +1,409 @@
+#pragma once
+
+// Header-only SIMD wrapper with runtime ISA dispatch.
+//
+// Every backend lives in its own namespace (xr::simd::scalar, sse42, avx2,
+// avx512, neon) and exposes the same vector types (vf32, vi32, vi16, vu16,
+// vu8, vi8, each with a static lane count N) and the same free functions, so a
+// kernel written once against the unqualified names compiles for all of them.
+// See xr_simd_foreach.h for how a kernel file is expanded per backend and
+// XR_SIMD_DISPATCH for picking the best expansion at runtime.
+//
+// The translation unit itself needs no -mavx2 / -march flags: each backend is
+// wrapped in a target region so one binary carries all x86 paths and the CPUID
+// check decides which one runs. Set XR_SIMD_ISA=scalar|sse42|avx2|avx512|neon
+// in the environment to force a (supported) path.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define XR_SIMD_X86 1
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC 12 warns about the _mm512_undefined_* placeholders inside its own headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#else
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define XR_SIMD_X86 0
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define XR_SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define XR_SIMD_NEON 0
+#endif
+
+// Target regions. GCC and clang refuse to inline an intrinsic into a function
+// compiled for a lower ISA, so every function of a backend (and every kernel
+// expanded for it) must carry the matching target attribute.
+#define XR_SIMD_PRAGMA(x) _Pragma(#x)
+#if defined(__clang__)
+#define XR_SIMD_TARGET_BEGIN(t) XR_SIMD_PRAGMA(clang attribute push(__attribute__((target(t))), apply_to = function))
+#define XR_SIMD_TARGET_END XR_SIMD_PRAGMA(clang attribute pop)
+#elif defined(__GNUC__)
+#define XR_SIMD_TARGET_BEGIN(t) XR_SIMD_PRAGMA(GCC push_options) XR_SIMD_PRAGMA(GCC target(t))
+#define XR_SIMD_TARGET_END XR_SIMD_PRAGMA(GCC pop_options)
+#else
+// MSVC allows every intrinsic in every function
+#define XR_SIMD_TARGET_BEGIN(t)
+#define XR_SIMD_TARGET_END
+#endif
+
+#define XR_SIMD_TARGETS_SSE42 "sse4.2,popcnt"
+#define XR_SIMD_TARGETS_AVX2 "avx2,fma,f16c,popcnt"
+#define XR_SIMD_TARGETS_AVX512 "avx512f,avx512bw,avx512dq,avx512vl,avx2,fma,f16c,popcnt"
+
+// Preprocessor ids of the backends, XR_SIMD_TARGET is set to one of these
+// while a kernel file is being expanded.
+#define XR_SIMD_TARGET_SCALAR 0
+#define XR_SIMD_TARGET_SSE42 1
+#define XR_SIMD_TARGET_AVX2 2
+#define XR_SIMD_TARGET_AVX512 3
+#define XR_SIMD_TARGET_NEON 4
+
+namespace xr {
+namespace simd {
+
+enum class Isa : int {
+  kScalar = XR_SIMD_TARGET_SCALAR,
+  kSSE42 = XR_SIMD_TARGET_SSE42,
+  kAVX2 = XR_SIMD_TARGET_AVX2,
+  kAVX512 = XR_SIMD_TARGET_AVX512,
+  kNEON = XR_SIMD_TARGET_NEON,
+};
+
+inline const char* isa_name(Isa isa) {
+  switch (isa) {
+    case Isa::kScalar: return "scalar";
+    case Isa::kSSE42: return "sse42";
+    case Isa::kAVX2: return "avx2";
+    case Isa::kAVX512: return "avx512";
+    case Isa::kNEON: return "neon";
+  }
+  return "unknown";
+}
+
+// returns false and leaves isa untouched for an unknown name
+inline bool parse_isa(const char* name, Isa* isa) {
+  for (int i = XR_SIMD_TARGET_SCALAR; i <= XR_SIMD_TARGET_NEON; i++) {
+    if (std::strcmp(name, isa_name((Isa)i)) == 0) {
+      *isa = (Isa)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+struct CpuFeatures {
+  bool sse42 = false;
+  bool avx2 = false;
+  bool fma = false;
+  bool f16c = false;
+  bool avx512f = false;
+  bool avx512bw = false;
+  bool avx512dq = false;
+  bool avx512vl = false;
+  bool neon = false;
+};
+
+namespace detail {
+
+#if XR_SIMD_X86
+inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int r[4];
+  __cpuidex(r, (int)leaf, (int)subleaf);
+  for (int i = 0; i < 4; i++) regs[i] = (uint32_t)r[i];
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0: which register states the OS saves on context switch
+inline uint64_t xgetbv0() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif
+
+inline CpuFeatures detect_cpu_features() {
+  CpuFeatures f;
+#if XR_SIMD_X86
+  uint32_t r[4];
+  cpuid(0, 0, r);
+  uint32_t max_leaf = r[0];
+  cpuid(1, 0, r);
+  uint32_t ecx1 = r[2];
+  f.sse42 = (ecx1 >> 20) & 1;
+  bool osxsave = (ecx1 >> 27) & 1;
+  bool avx = (ecx1 >> 28) & 1;
+  uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+  // XMM | YMM state, plus opmask | ZMM_Hi256 | Hi16_ZMM for AVX-512
+  bool os_avx = (xcr0 & 0x6) == 0x6;
+  bool os_avx512 = (xcr0 & 0xE6) == 0xE6;
+  if (avx && os_avx) {
+    f.fma = (ecx1 >> 12) & 1;
+    f.f16c = (ecx1 >> 29) & 1;
+    if (max_leaf >= 7) {
+      cpuid(7, 0, r);
+      uint32_t ebx7 = r[1];
+      f.avx2 = (ebx7 >> 5) & 1;
+      if (os_avx512) {
+        f.avx512f = (ebx7 >> 16) & 1;
+        f.avx512dq = (ebx7 >> 17) & 1;
+        f.avx512bw = (ebx7 >> 30) & 1;
+        f.avx512vl = (ebx7 >> 31) & 1;
+      }
+    }
+  }
+#endif
+#if XR_SIMD_NEON
+  // Advanced SIMD is mandatory on AArch64
+  f.neon = true;
+#endif
+  return f;
+}
+
+}  // namespace detail
+
+inline const CpuFeatures& cpu_features() {
+  static const CpuFeatures features = detail::detect_cpu_features();
+  return features;
+}
+
+// true if the backend is compiled in and the CPU/OS can run it
+inline bool isa_supported(Isa isa) {
+  const CpuFeatures& f = cpu_features();
+  switch (isa) {
+    case Isa::kScalar: return true;
+    case Isa::kSSE42: return XR_SIMD_X86 && f.sse42;
+    case Isa::kAVX2: return XR_SIMD_X86 && f.avx2 && f.fma && f.f16c;
+    case Isa::kAVX512:
+      return XR_SIMD_X86 && f.avx512f && f.avx512bw && f.avx512dq && f.avx512vl && f.fma && f.f16c;
+    case Isa::kNEON: return XR_SIMD_NEON && f.neon;
+  }
+  return false;
+}
+
+inline Isa best_supported_isa() {
+  const Isa order[] = {Isa::kAVX512, Isa::kAVX2, Isa::kSSE42, Isa::kNEON};
+  for (Isa isa : order) {
+    if (isa_supported(isa)) return isa;
+  }
+  return Isa::kScalar;
+}
+
+namespace detail {
+
+inline Isa& active_isa() {
+  static Isa isa = [] {
+    Isa best = best_supported_isa();
+    const char* env = std::getenv("XR_SIMD_ISA");
+    if (env == nullptr || env[0] == '\0') return best;
+    Isa forced;
+    if (!parse_isa(env, &forced)) {
+      fprintf(stderr, "XR_SIMD_ISA=%s is not a known ISA, using %s\n", env, isa_name(best));
+      return best;
+    }
+    if (!isa_supported(forced)) {
+      fprintf(stderr, "XR_SIMD_ISA=%s is not supported here, using %s\n", env, isa_name(best));
+      return best;
+    }
+    return forced;
+  }();
+  return isa;
+}
+
+}  // namespace detail
+
+// The ISA XR_SIMD_DISPATCH currently picks.
+inline Isa current_isa() { return detail::active_isa(); }
+
+// Force a path, e.g. to benchmark scalar vs SIMD in one run. Returns false
+// (and changes nothing) if the ISA cannot run on this machine.
+inline bool set_isa(Isa isa) {
+  if (!isa_supported(isa)) return false;
+  detail::active_isa() = isa;
+  return true;
+}
+
+// Pick the function for current_isa(), falling back to the next lower backend
+// that was compiled in. scalar_fn must not be null.
+template <typename F>
+inline F choose_target(F scalar_fn, F sse42_fn, F avx2_fn, F avx512_fn, F neon_fn) {
+  switch (current_isa()) {
+    case Isa::kAVX512:
+      if (avx512_fn) return avx512_fn;
+      // fall through
+    case Isa::kAVX2:
+      if (avx2_fn) return avx2_fn;
+      // fall through
+    case Isa::kSSE42:
+      if (sse42_fn) return sse42_fn;
+      break;
+    case Isa::kNEON:
+      if (neon_fn) return neon_fn;
+      break;
+    case Isa::kScalar:
+      break;
+  }
+  return scalar_fn;
+}
+
+// Aligned heap memory for load()/store(), which need vector-size alignment
+// (64 bytes covers every backend).
+inline void* aligned_malloc(size_t bytes, size_t align = 64) {
+#if defined(_MSC_VER)
+  return _aligned_malloc(bytes, align);
+#else
+  void* p = nullptr;
+  if (posix_memalign(&p, align, bytes ? bytes : align) != 0) return nullptr;
+  return p;
+#endif
+}
+
+inline void aligned_free(void* p) {
+#if defined(_MSC_VER)
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+// IEEE binary16 <-> float for one value, round to nearest even, with
+// subnormals and infinities. NaNs are quieted and keep the top payload bits,
+// as F16C's vcvtps2ph / vcvtph2ps do, so every backend gives the same bits.
+// Backends without a hardware conversion use these per lane.
+inline uint16_t f32_to_f16(float f) {
+  uint32_t x;
+  std::memcpy(&x, &f, 4);
+  const uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+  const uint32_t a = x & 0x7FFFFFFF;
+  if (a > 0x7F800000) return sign | 0x7E00 | ((a >> 13) & 0x3FF);
+  if (a == 0x7F800000) return sign | 0x7C00;
+  // 65520 and up round to infinity
+  if (a >= 0x477FF000) return sign | 0x7C00;
+  if (a < 0x38800000) {
+    // below the smallest normal half: count units of 2^-24, rounded to even
+    float v;
+    std::memcpy(&v, &a, 4);
+    return sign | (uint16_t)std::nearbyint(v * 16777216.0f);
+  }
+  // rebias the exponent (127 -> 15) and round 23 mantissa bits to 10
+  const uint32_t m = a - 0x38000000;
+  return sign | (uint16_t)((m + 0xFFF + ((m >> 13) & 1)) >> 13);
+}
+
+inline float f16_to_f32(uint16_t h) {
+  const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+  const uint32_t e = (h >> 10) & 0x1F, m = h & 0x3FF;
+  uint32_t bits;
+  if (e == 0) {
+    float v = (float)m * (1.0f / 16777216.0f);
+    std::memcpy(&bits, &v, 4);
+    bits |= sign;
+  } else if (e == 31) {
+    bits = sign | 0x7F800000 | (m << 13) | (m ? 0x400000 : 0);
+  } else {
+    bits = sign | ((e + 112) << 23) | (m << 13);
+  }
+  float f;
+  std::memcpy(&f, &bits, 4);
+  return f;
+}
+
+namespace detail {
+
+// Byte shuffles for load3 / store3 on x86, one 48-byte group (16 pixels of 3
+// bytes) per 128-bit lane; -128 zeroes the byte.
+//   load[c][s][b]:  byte b of channel c, taken from source block s
+//   store[j][c][t]: byte t of output block j, taken from channel c
+struct Shuffle3 {
+  int8_t load[3][3][16];
+  int8_t store[3][3][16];
+};
+
+constexpr Shuffle3 make_shuffle3() {
+  Shuffle3 m{};
+  for (int c = 0; c < 3; c++) {
+    for (int s = 0; s < 3; s++) {
+      for (int b = 0; b < 16; b++) {
+        const int pos = 3 * b + c;
+        m.load[c][s][b] = (int8_t)(pos / 16 == s ? pos % 16 : -128);
+      }
+    }
+  }
+  for (int j = 0; j < 3; j++) {
+    for (int c = 0; c < 3; c++) {
+      for (int t = 0; t < 16; t++) {
+        const int pos = 16 * j + t;
+        m.store[j][c][t] = (int8_t)(pos % 3 == c ? pos / 3 : -128);
+      }
+    }
+  }
+  return m;
+}
+
+inline constexpr Shuffle3 kShuffle3 = make_shuffle3();
+
+// 4 x 4 byte transpose for load4 / store4 (its own inverse)
+alignas(16) inline constexpr int8_t kTranspose4[16] = {0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15};
+
+}  // namespace detail
+
+}  // namespace simd
+}  // namespace xr
+
+#include "xr_simd_scalar.h"
+#if XR_SIMD_X86
+#include "xr_simd_sse42.h"
+#include "xr_simd_avx2.h"
+#include "xr_simd_avx512.h"
+#endif
+#if XR_SIMD_NEON
+#include "xr_simd_neon.h"
+#endif
+
+// Address of the best expansion of a kernel produced by xr_simd_foreach.h.
+// XR_SIMD_DISPATCH is used from the namespace the kernel file was expanded in,
+// XR_SIMD_DISPATCH_IN from anywhere else:
+//   auto fn = XR_SIMD_DISPATCH(box_filter_rows);
+//   auto fn = XR_SIMD_DISPATCH_IN(::xr::box, box_filter_rows);
+#if XR_SIMD_X86
+#define XR_SIMD_DISPATCH_IN(ns, fn)                                                                   \
+  ::xr::simd::choose_target<decltype(&ns::scalar::fn)>(&ns::scalar::fn, &ns::sse42::fn, &ns::avx2::fn, \
+                                                       &ns::avx512::fn, nullptr)
+#define XR_SIMD_DISPATCH(fn) \
+  ::xr::simd::choose_target<decltype(&scalar::fn)>(&scalar::fn, &sse42::fn, &avx2::fn, &avx512::fn, nullptr)
+#elif XR_SIMD_NEON
+#define XR_SIMD_DISPATCH_IN(ns, fn) \
+  ::xr::simd::choose_target<decltype(&ns::scalar::fn)>(&ns::scalar::fn, nullptr, nullptr, nullptr, &ns::neon::fn)
+#define XR_SIMD_DISPATCH(fn) \
+  ::xr::simd::choose_target<decltype(&scalar::fn)>(&scalar::fn, nullptr, nullptr, nullptr, &neon::fn)
+#else
+#define XR_SIMD_DISPATCH_IN(ns, fn) \
+  ::xr::simd::choose_target<decltype(&ns::scalar::fn)>(&ns::scalar::fn, nullptr, nullptr, nullptr, nullptr)
+#define XR_SIMD_DISPATCH(fn) \
+  ::xr::simd::choose_target<decltype(&scalar::fn)>(&scalar::fn, nullptr, nullptr, nullptr, nullptr)
+#endif
@@ -0,0 +1,397 @@
+#pragma once
+
+// AVX2 + FMA backend, 256-bit vectors. Included from xr_simd.h on x86 only.
+// Most 256-bit integer instructions work on two independent 128-bit lanes, so
+// zip/unzip/narrow add a cross-lane permute to keep the whole-vector semantics
+// of the scalar backend.
+
+XR_SIMD_TARGET_BEGIN(XR_SIMD_TARGETS_AVX2)
+
+namespace xr {
+namespace simd {
+namespace avx2 {
+
+constexpr Isa kIsa = Isa::kAVX2;
+constexpr int kVectorBytes = 32;
+
+struct vf32 { __m256 v; static constexpr int N = 8; };
+struct vi32 { __m256i v; static constexpr int N = 8; };
+struct vi16 { __m256i v; static constexpr int N = 16; };
+struct vu16 { __m256i v; static constexpr int N = 16; };
+struct vu8 { __m256i v; static constexpr int N = 32; };
+struct vi8 { __m256i v; static constexpr int N = 32; };
+
+// channels of interleaved bytes, see load3 / load4
+struct vu8x3 { vu8 v[3]; };
+struct vu8x4 { vu8 v[4]; };
+
+// ---------------------------------------------------------------- memory
+
+inline vf32 loadu(const float* p) { return {_mm256_loadu_ps(p)}; }
+inline vi32 loadu(const int32_t* p) { return {_mm256_loadu_si256((const __m256i*)p)}; }
+inline vi16 loadu(const int16_t* p) { return {_mm256_loadu_si256((const __m256i*)p)}; }
+inline vu16 loadu(const uint16_t* p) { return {_mm256_loadu_si256((const __m256i*)p)}; }
+inline vu8 loadu(const uint8_t* p) { return {_mm256_loadu_si256((const __m256i*)p)}; }
+inline vi8 loadu(const int8_t* p) { return {_mm256_loadu_si256((const __m256i*)p)}; }
+
+inline vf32 load(const float* p) { return {_mm256_load_ps(p)}; }
+inline vi32 load(const int32_t* p) { return {_mm256_load_si256((const __m256i*)p)}; }
+inline vi16 load(const int16_t* p) { return {_mm256_load_si256((const __m256i*)p)}; }
+inline vu16 load(const uint16_t* p) { return {_mm256_load_si256((const __m256i*)p)}; }
+inline vu8 load(const uint8_t* p) { return {_mm256_load_si256((const __m256i*)p)}; }
+inline vi8 load(const int8_t* p) { return {_mm256_load_si256((const __m256i*)p)}; }
+
+inline void storeu(float* p, vf32 a) { _mm256_storeu_ps(p, a.v); }
+inline void storeu(int32_t* p, vi32 a) { _mm256_storeu_si256((__m256i*)p, a.v); }
+inline void storeu(int16_t* p, vi16 a) { _mm256_storeu_si256((__m256i*)p, a.v); }
+inline void storeu(uint16_t* p, vu16 a) { _mm256_storeu_si256((__m256i*)p, a.v); }
+inline void storeu(uint8_t* p, vu8 a) { _mm256_storeu_si256((__m256i*)p, a.v); }
+inline void storeu(int8_t* p, vi8 a) { _mm256_storeu_si256((__m256i*)p, a.v); }
+
+inline void store(float* p, vf32 a) { _mm256_store_ps(p, a.v); }
+inline void store(int32_t* p, vi32 a) { _mm256_store_si256((__m256i*)p, a.v); }
+inline void store(int16_t* p, vi16 a) { _mm256_store_si256((__m256i*)p, a.v); }
+inline void store(uint16_t* p, vu16 a) { _mm256_store_si256((__m256i*)p, a.v); }
+inline void store(uint8_t* p, vu8 a) { _mm256_store_si256((__m256i*)p, a.v); }
+inline void store(int8_t* p, vi8 a) { _mm256_store_si256((__m256i*)p, a.v); }
+
+inline vf32 set1_f32(float x) { return {_mm256_set1_ps(x)}; }
+inline vi32 set1_i32(int32_t x) { return {_mm256_set1_epi32(x)}; }
+inline vi16 set1_i16(int16_t x) { return {_mm256_set1_epi16(x)}; }
+inline vu16 set1_u16(uint16_t x) { return {_mm256_set1_epi16((short)x)}; }
+inline vu8 set1_u8(uint8_t x) { return {_mm256_set1_epi8((char)x)}; }
+inline vi8 set1_i8(int8_t x) { return {_mm256_set1_epi8(x)}; }
+
+inline vf32 zero_f32() { return {_mm256_setzero_ps()}; }
+inline vi32 zero_i32() { return {_mm256_setzero_si256()}; }
+inline vi16 zero_i16() { return {_mm256_setzero_si256()}; }
+inline vu16 zero_u16() { return {_mm256_setzero_si256()}; }
+inline vu8 zero_u8() { return {_mm256_setzero_si256()}; }
+inline vi8 zero_i8() { return {_mm256_setzero_si256()}; }
+
+// ---------------------------------------------------------------- arithmetic
+
+#define XR_SIMD_AVX2_BINARY(name, V, intrin) \
+  inline V name(V a, V b) { return {intrin(a.v, b.v)}; }
+
+XR_SIMD_AVX2_BINARY(add, vf32, _mm256_add_ps)
+XR_SIMD_AVX2_BINARY(add, vi32, _mm256_add_epi32)
+XR_SIMD_AVX2_BINARY(add, vi16, _mm256_add_epi16)
+XR_SIMD_AVX2_BINARY(add, vu16, _mm256_add_epi16)
+XR_SIMD_AVX2_BINARY(add, vu8, _mm256_add_epi8)
+XR_SIMD_AVX2_BINARY(sub, vf32, _mm256_sub_ps)
+XR_SIMD_AVX2_BINARY(sub, vi32, _mm256_sub_epi32)
+XR_SIMD_AVX2_BINARY(sub, vi16, _mm256_sub_epi16)
+XR_SIMD_AVX2_BINARY(sub, vu16, _mm256_sub_epi16)
+XR_SIMD_AVX2_BINARY(sub, vu8, _mm256_sub_epi8)
+XR_SIMD_AVX2_BINARY(mul, vf32, _mm256_mul_ps)
+XR_SIMD_AVX2_BINARY(mul, vi32, _mm256_mullo_epi32)
+XR_SIMD_AVX2_BINARY(mul, vi16, _mm256_mullo_epi16)
+XR_SIMD_AVX2_BINARY(mul, vu16, _mm256_mullo_epi16)
+XR_SIMD_AVX2_BINARY(div, vf32, _mm256_div_ps)
+
+XR_SIMD_AVX2_BINARY(adds, vi16, _mm256_adds_epi16)
+XR_SIMD_AVX2_BINARY(adds, vu16, _mm256_adds_epu16)
+XR_SIMD_AVX2_BINARY(adds, vu8, _mm256_adds_epu8)
+XR_SIMD_AVX2_BINARY(subs, vi16, _mm256_subs_epi16)
+XR_SIMD_AVX2_BINARY(subs, vu16, _mm256_subs_epu16)
+XR_SIMD_AVX2_BINARY(subs, vu8, _mm256_subs_epu8)
+
+XR_SIMD_AVX2_BINARY(mulhi, vi16, _mm256_mulhi_epi16)
+XR_SIMD_AVX2_BINARY(mulhi, vu16, _mm256_mulhi_epu16)
+XR_SIMD_AVX2_BINARY(avg, vu16, _mm256_avg_epu16)
+XR_SIMD_AVX2_BINARY(avg, vu8, _mm256_avg_epu8)
+
+XR_SIMD_AVX2_BINARY(min, vf32, _mm256_min_ps)
+XR_SIMD_AVX2_BINARY(min, vi32, _mm256_min_epi32)
+XR_SIMD_AVX2_BINARY(min, vi16, _mm256_min_epi16)
+XR_SIMD_AVX2_BINARY(min, vu16, _mm256_min_epu16)
+XR_SIMD_AVX2_BINARY(min, vu8, _mm256_min_epu8)
+XR_SIMD_AVX2_BINARY(max, vf32, _mm256_max_ps)
+XR_SIMD_AVX2_BINARY(max, vi32, _mm256_max_epi32)
+XR_SIMD_AVX2_BINARY(max, vi16, _mm256_max_epi16)
+XR_SIMD_AVX2_BINARY(max, vu16, _mm256_max_epu16)
+XR_SIMD_AVX2_BINARY(max, vu8, _mm256_max_epu8)
+
+inline vf32 fma(vf32 a, vf32 b, vf32 c) { return {_mm256_fmadd_ps(a.v, b.v, c.v)}; }
+
+inline vf32 abs(vf32 a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+inline vi32 abs(vi32 a) { return {_mm256_abs_epi32(a.v)}; }
+inline vi16 abs(vi16 a) { return {_mm256_abs_epi16(a.v)}; }
+inline vf32 sqrt(vf32 a) { return {_mm256_sqrt_ps(a.v)}; }
+
+inline vi32 shl(vi32 a, int n) { return {_mm256_sll_epi32(a.v, _mm_cvtsi32_si128(n))}; }
+inline vi16 shl(vi16 a, int n) { return {_mm256_sll_epi16(a.v, _mm_cvtsi32_si128(n))}; }
+inline vu16 shl(vu16 a, int n) { return {_mm256_sll_epi16(a.v, _mm_cvtsi32_si128(n))}; }
+inline vi32 shr(vi32 a, int n) { return {_mm256_sra_epi32(a.v, _mm_cvtsi32_si128(n))}; }
+inline vi16 shr(vi16 a, int n) { return {_mm256_sra_epi16(a.v, _mm_cvtsi32_si128(n))}; }
+inline vu16 shr(vu16 a, int n) { return {_mm256_srl_epi16(a.v, _mm_cvtsi32_si128(n))}; }
+
+// ---------------------------------------------------------------- bitwise
+
+#define XR_SIMD_AVX2_ALL_INT(name, intrin) \
+  XR_SIMD_AVX2_BINARY(name, vi32, intrin)  \
+  XR_SIMD_AVX2_BINARY(name, vi16, intrin)  \
+  XR_SIMD_AVX2_BINARY(name, vu16, intrin)  \
+  XR_SIMD_AVX2_BINARY(name, vu8, intrin)
+
+XR_SIMD_AVX2_BINARY(bit_and, vf32, _mm256_and_ps)
+XR_SIMD_AVX2_BINARY(bit_or, vf32, _mm256_or_ps)
+XR_SIMD_AVX2_BINARY(bit_xor, vf32, _mm256_xor_ps)
+XR_SIMD_AVX2_ALL_INT(bit_and, _mm256_and_si256)
+XR_SIMD_AVX2_ALL_INT(bit_or, _mm256_or_si256)
+XR_SIMD_AVX2_ALL_INT(bit_xor, _mm256_xor_si256)
+inline vf32 bit_andnot(vf32 a, vf32 b) { return {_mm256_andnot_ps(b.v, a.v)}; }
+inline vi32 bit_andnot(vi32 a, vi32 b) { return {_mm256_andnot_si256(b.v, a.v)}; }
+inline vi16 bit_andnot(vi16 a, vi16 b) { return {_mm256_andnot_si256(b.v, a.v)}; }
+inline vu16 bit_andnot(vu16 a, vu16 b) { return {_mm256_andnot_si256(b.v, a.v)}; }
+inline vu8 bit_andnot(vu8 a, vu8 b) { return {_mm256_andnot_si256(b.v, a.v)}; }
+
+// ---------------------------------------------------------------- compare / select
+
+inline vf32 cmpeq(vf32 a, vf32 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)}; }
+inline vf32 cmplt(vf32 a, vf32 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+inline vf32 cmple(vf32 a, vf32 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)}; }
+inline vf32 cmpgt(vf32 a, vf32 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+inline vf32 cmpge(vf32 a, vf32 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)}; }
+XR_SIMD_AVX2_BINARY(cmpeq, vi32, _mm256_cmpeq_epi32)
+XR_SIMD_AVX2_BINARY(cmpgt, vi32, _mm256_cmpgt_epi32)
+inline vi32 cmplt(vi32 a, vi32 b) { return {_mm256_cmpgt_epi32(b.v, a.v)}; }
+XR_SIMD_AVX2_BINARY(cmpeq, vi16, _mm256_cmpeq_epi16)
+XR_SIMD_AVX2_BINARY(cmpgt, vi16, _mm256_cmpgt_epi16)
+inline vi16 cmplt(vi16 a, vi16 b) { return {_mm256_cmpgt_epi16(b.v, a.v)}; }
+XR_SIMD_AVX2_BINARY(cmpeq, vu16, _mm256_cmpeq_epi16)
+XR_SIMD_AVX2_BINARY(cmpeq, vu8, _mm256_cmpeq_epi8)
+inline vu16 cmpgt(vu16 a, vu16 b) {
+  const __m256i bias = _mm256_set1_epi16((short)0x8000);
+  return {_mm256_cmpgt_epi16(_mm256_xor_si256(a.v, bias), _mm256_xor_si256(b.v, bias))};
+}
+inline vu8 cmpgt(vu8 a, vu8 b) {
+  const __m256i bias = _mm256_set1_epi8((char)0x80);
+  return {_mm256_cmpgt_epi8(_mm256_xor_si256(a.v, bias), _mm256_xor_si256(b.v, bias))};
+}
+
+// mask must be a compare result, see the SSE4.2 backend
+inline vf32 select(vf32 mask, vf32 a, vf32 b) { return {_mm256_blendv_ps(b.v, a.v, mask.v)}; }
+inline vi32 select(vi32 mask, vi32 a, vi32 b) { return {_mm256_blendv_epi8(b.v, a.v, mask.v)}; }
+inline vi16 select(vi16 mask, vi16 a, vi16 b) { return {_mm256_blendv_epi8(b.v, a.v, mask.v)}; }
+inline vu16 select(vu16 mask, vu16 a, vu16 b) { return {_mm256_blendv_epi8(b.v, a.v, mask.v)}; }
+inline vu8 select(vu8 mask, vu8 a, vu8 b) { return {_mm256_blendv_epi8(b.v, a.v, mask.v)}; }
+
+// ---------------------------------------------------------------- conversion
+
+inline vf32 cvt_f32(vi32 a) { return {_mm256_cvtepi32_ps(a.v)}; }
+inline vi32 cvt_i32(vf32 a) { return {_mm256_cvtps_epi32(a.v)}; }
+inline vi32 cvtt_i32(vf32 a) { return {_mm256_cvttps_epi32(a.v)}; }
+
+inline vf32 load_f16(const uint16_t* p) { return {_mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)p))}; }
+inline void store_f16(uint16_t* p, vf32 a) {
+  _mm_storeu_si128((__m128i*)p, _mm256_cvtps_ph(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+// 32-bit gather, upper two bytes dropped: reads 4 bytes at each p + off[i]
+inline vi32 gather_u16(const uint8_t* p, vi32 off) {
+  return {_mm256_and_si256(_mm256_i32gather_epi32((const int*)p, off.v, 1), _mm256_set1_epi32(0xFFFF))};
+}
+
+inline vf32 as_f32(vi32 a) { return {_mm256_castsi256_ps(a.v)}; }
+inline vi32 as_i32(vf32 a) { return {_mm256_castps_si256(a.v)}; }
+inline vi32 as_i32(vu16 a) { return {a.v}; }
+inline vu16 as_u16(vi32 a) { return {a.v}; }
+inline vu16 as_u16(vi16 a) { return {a.v}; }
+inline vu16 as_u16(vu8 a) { return {a.v}; }
+inline vi16 as_i16(vu16 a) { return {a.v}; }
+inline vi16 as_i16(vu8 a) { return {a.v}; }
+inline vu8 as_u8(vu16 a) { return {a.v}; }
+inline vu8 as_u8(vi16 a) { return {a.v}; }
+inline vu8 as_u8(vi8 a) { return {a.v}; }
+inline vi8 as_i8(vu8 a) { return {a.v}; }
+
+inline vu16 widen_lo(vu8 a) { return {_mm256_cvtepu8_epi16(_mm256_castsi256_si128(a.v))}; }
+inline vu16 widen_hi(vu8 a) { return {_mm256_cvtepu8_epi16(_mm256_extracti128_si256(a.v, 1))}; }
+inline vi16 widen_lo(vi8 a) { return {_mm256_cvtepi8_epi16(_mm256_castsi256_si128(a.v))}; }
+inline vi16 widen_hi(vi8 a) { return {_mm256_cvtepi8_epi16(_mm256_extracti128_si256(a.v, 1))}; }
+inline vi32 widen_lo(vi16 a) { return {_mm256_cvtepi16_epi32(_mm256_castsi256_si128(a.v))}; }
+inline vi32 widen_hi(vi16 a) { return {_mm256_cvtepi16_epi32(_mm256_extracti128_si256(a.v, 1))}; }
+inline vi32 widen_lo(vu16 a) { return {_mm256_cvtepu16_epi32(_mm256_castsi256_si128(a.v))}; }
+inline vi32 widen_hi(vu16 a) { return {_mm256_cvtepu16_epi32(_mm256_extracti128_si256(a.v, 1))}; }
+
+// packs interleave the 64-bit halves as a0 b0 a1 b1, reorder to a0 a1 b0 b1
+#define XR_SIMD_AVX2_FIX_LANES(x) _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 1, 2, 0))
+
+inline vu8 narrow_sat_u8(vi16 a, vi16 b) { return {XR_SIMD_AVX2_FIX_LANES(_mm256_packus_epi16(a.v, b.v))}; }
+inline vu8 narrow_sat_u8(vu16 a, vu16 b) {
+  __m256i m = _mm256_set1_epi16(255);
+  __m256i p = _mm256_packus_epi16(_mm256_min_epu16(a.v, m), _mm256_min_epu16(b.v, m));
+  return {XR_SIMD_AVX2_FIX_LANES(p)};
+}
+inline vi8 narrow_sat_i8(vi16 a, vi16 b) { return {XR_SIMD_AVX2_FIX_LANES(_mm256_packs_epi16(a.v, b.v))}; }
+inline vi16 narrow_sat_i16(vi32 a, vi32 b) { return {XR_SIMD_AVX2_FIX_LANES(_mm256_packs_epi32(a.v, b.v))}; }
+inline vu16 narrow_sat_u16(vi32 a, vi32 b) { return {XR_SIMD_AVX2_FIX_LANES(_mm256_packus_epi32(a.v, b.v))}; }
+
+// ---------------------------------------------------------------- permute
+
+// in-lane unpack gives [lo0 | lo1] and [hi0 | hi1]; zip_lo is lo0 hi0, zip_hi is lo1 hi1
+#define XR_SIMD_AVX2_ZIP(V, lo, hi)                                                             \
+  inline V zip_lo(V a, V b) { return {_mm256_permute2x128_si256(lo(a.v, b.v), hi(a.v, b.v), 0x20)}; } \
+  inline V zip_hi(V a, V b) { return {_mm256_permute2x128_si256(lo(a.v, b.v), hi(a.v, b.v), 0x31)}; }
+
+inline vf32 zip_lo(vf32 a, vf32 b) {
+  return {_mm256_permute2f128_ps(_mm256_unpacklo_ps(a.v, b.v), _mm256_unpackhi_ps(a.v, b.v), 0x20)};
+}
+inline vf32 zip_hi(vf32 a, vf32 b) {
+  return {_mm256_permute2f128_ps(_mm256_unpacklo_ps(a.v, b.v), _mm256_unpackhi_ps(a.v, b.v), 0x31)};
+}
+XR_SIMD_AVX2_ZIP(vi32, _mm256_unpacklo_epi32, _mm256_unpackhi_epi32)
+XR_SIMD_AVX2_ZIP(vi16, _mm256_unpacklo_epi16, _mm256_unpackhi_epi16)
+XR_SIMD_AVX2_ZIP(vu16, _mm256_unpacklo_epi16, _mm256_unpackhi_epi16)
+XR_SIMD_AVX2_ZIP(vu8, _mm256_unpacklo_epi8, _mm256_unpackhi_epi8)
+
+inline vf32 unzip_even(vf32 a, vf32 b) {
+  __m256 t = _mm256_shuffle_ps(a.v, b.v, _MM_SHUFFLE(2, 0, 2, 0));
+  return {_mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(t), _MM_SHUFFLE(3, 1, 2, 0)))};
+}
+inline vf32 unzip_odd(vf32 a, vf32 b) {
+  __m256 t = _mm256_shuffle_ps(a.v, b.v, _MM_SHUFFLE(3, 1, 3, 1));
+  return {_mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(t), _MM_SHUFFLE(3, 1, 2, 0)))};
+}
+inline vi32 unzip_even(vi32 a, vi32 b) { return as_i32(unzip_even(as_f32(a), as_f32(b))); }
+inline vi32 unzip_odd(vi32 a, vi32 b) { return as_i32(unzip_odd(as_f32(a), as_f32(b))); }
+
+namespace detail {
+
+inline __m256i split_even_odd16(__m256i a) {
+  const __m256i m = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+                                     0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+  return _mm256_shuffle_epi8(a, m);
+}
+inline __m256i split_even_odd8(__m256i a) {
+  const __m256i m = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                                     0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+  return _mm256_shuffle_epi8(a, m);
+}
+
+}  // namespace detail
+
+// per lane [even | odd] for a and b, then pick the 64-bit halves
+#define XR_SIMD_AVX2_UNZIP(V, split)                                                             \
+  inline V unzip_even(V a, V b) {                                                                \
+    return {XR_SIMD_AVX2_FIX_LANES(_mm256_unpacklo_epi64(split(a.v), split(b.v)))};              \
+  }                                                                                              \
+  inline V unzip_odd(V a, V b) {                                                                 \
+    return {XR_SIMD_AVX2_FIX_LANES(_mm256_unpackhi_epi64(split(a.v), split(b.v)))};              \
+  }
+
+XR_SIMD_AVX2_UNZIP(vi16, detail::split_even_odd16)
+XR_SIMD_AVX2_UNZIP(vu16, detail::split_even_odd16)
+XR_SIMD_AVX2_UNZIP(vu8, detail::split_even_odd8)
+
+// ---------------------------------------------------------------- structure load / store
+
+// load3 splits 3 * N interleaved bytes (RGBRGB...) into one vector per channel
+// and store3 interleaves them back, NEON vld3q / vst3q; load4 / store4 do the
+// same for 4 channels. No alignment needed.
+//
+// x86 has no structure loads. Source register k holds the 16-byte blocks
+// k, k + K, k + 2K, ... in its 128-bit lanes, so every lane sees one whole
+// group of 16 pixels and the rest is in-lane byte shuffles: three pshufb per
+// channel for 3 bytes, a 4 x 4 byte then 4 x 4 dword transpose for 4.
+
+namespace detail {
+
+inline __m256i load_blocks(const uint8_t* p, int k, int K) {
+  __m128i lo = _mm_loadu_si128((const __m128i*)(p + 16 * k));
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), _mm_loadu_si128((const __m128i*)(p + 16 * (k + K))), 1);
+}
+
+inline void store_blocks(uint8_t* p, int k, int K, __m256i x) {
+  _mm_storeu_si128((__m128i*)(p + 16 * k), _mm256_castsi256_si128(x));
+  _mm_storeu_si128((__m128i*)(p + 16 * (k + K)), _mm256_extracti128_si256(x, 1));
+}
+
+inline __m256i shuffle_table(const int8_t* m) {
+  return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)m));
+}
+
+// RGBA RGBA RGBA RGBA <-> RRRR GGGG BBBB AAAA in every lane
+inline __m256i transpose_bytes4(const __m256i& a) {
+  return _mm256_shuffle_epi8(a, shuffle_table(::xr::simd::detail::kTranspose4));
+}
+
+// 4 x 4 transpose of 32-bit elements in every lane
+inline void transpose_dwords4(__m256i& a, __m256i& b, __m256i& c, __m256i& d) {
+  __m256i t0 = _mm256_unpacklo_epi32(a, b), t1 = _mm256_unpackhi_epi32(a, b);
+  __m256i t2 = _mm256_unpacklo_epi32(c, d), t3 = _mm256_unpackhi_epi32(c, d);
+  a = _mm256_unpacklo_epi64(t0, t2);
+  b = _mm256_unpackhi_epi64(t0, t2);
+  c = _mm256_unpacklo_epi64(t1, t3);
+  d = _mm256_unpackhi_epi64(t1, t3);
+}
+
+}  // namespace detail
+
+inline vu8x3 load3(const uint8_t* p) {
+  const auto& m = ::xr::simd::detail::kShuffle3.load;
+  __m256i s[3] = {detail::load_blocks(p, 0, 3), detail::load_blocks(p, 1, 3), detail::load_blocks(p, 2, 3)};
+  vu8x3 r;
+  for (int c = 0; c < 3; c++) {
+    __m256i x = _mm256_or_si256(_mm256_shuffle_epi8(s[0], detail::shuffle_table(m[c][0])),
+                                _mm256_shuffle_epi8(s[1], detail::shuffle_table(m[c][1])));
+    r.v[c].v = _mm256_or_si256(x, _mm256_shuffle_epi8(s[2], detail::shuffle_table(m[c][2])));
+  }
+  return r;
+}
+inline vu8x4 load4(const uint8_t* p) {
+  __m256i s[4];
+  for (int k = 0; k < 4; k++) s[k] = detail::transpose_bytes4(detail::load_blocks(p, k, 4));
+  detail::transpose_dwords4(s[0], s[1], s[2], s[3]);
+  return {{{s[0]}, {s[1]}, {s[2]}, {s[3]}}};
+}
+inline void store3(uint8_t* p, vu8x3 a) {
+  const auto& m = ::xr::simd::detail::kShuffle3.store;
+  for (int j = 0; j < 3; j++) {
+    __m256i x = _mm256_or_si256(_mm256_shuffle_epi8(a.v[0].v, detail::shuffle_table(m[j][0])),
+                                _mm256_shuffle_epi8(a.v[1].v, detail::shuffle_table(m[j][1])));
+    detail::store_blocks(p, j, 3, _mm256_or_si256(x, _mm256_shuffle_epi8(a.v[2].v, detail::shuffle_table(m[j][2]))));
+  }
+}
+inline void store4(uint8_t* p, vu8x4 a) {
+  __m256i s[4] = {a.v[0].v, a.v[1].v, a.v[2].v, a.v[3].v};
+  detail::transpose_dwords4(s[0], s[1], s[2], s[3]);
+  for (int k = 0; k < 4; k++) detail::store_blocks(p, k, 4, detail::transpose_bytes4(s[k]));
+}
+
+// ---------------------------------------------------------------- reduction
+
+inline float reduce_add(vf32 a) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+inline int32_t reduce_add(vi32 a) {
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(a.v), _mm256_extracti128_si256(a.v, 1));
+  s = _mm_add_epi32(s, _mm_unpackhi_epi64(s, s));
+  return _mm_cvtsi128_si32(_mm_add_epi32(s, _mm_shuffle_epi32(s, 1)));
+}
+inline float reduce_min(vf32 a) {
+  __m128 s = _mm_min_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+  s = _mm_min_ps(s, _mm_movehl_ps(s, s));
+  return _mm_cvtss_f32(_mm_min_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+inline float reduce_max(vf32 a) {
+  __m128 s = _mm_max_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+  s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+  return _mm_cvtss_f32(_mm_max_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+
+#undef XR_SIMD_AVX2_BINARY
+#undef XR_SIMD_AVX2_ALL_INT
+#undef XR_SIMD_AVX2_FIX_LANES
+#undef XR_SIMD_AVX2_ZIP
+#undef XR_SIMD_AVX2_UNZIP
+
+}  // namespace avx2
+}  // namespace simd
+}  // namespace xr
+
+XR_SIMD_TARGET_END
@@ -0,0 +1,409 @@
+#pragma once
+
+// AVX-512 (F/BW/DQ/VL) backend, 512-bit vectors. Included from xr_simd.h on
+// x86 only. Compares produce k-masks in hardware; they are expanded to vector
+// masks here so kernels see the same mask-as-vector model as on NEON/SSE.
+
+XR_SIMD_TARGET_BEGIN(XR_SIMD_TARGETS_AVX512)
+
+namespace xr {
+namespace simd {
+namespace avx512 {
+
+constexpr Isa kIsa = Isa::kAVX512;
+constexpr int kVectorBytes = 64;
+
+struct vf32 { __m512 v; static constexpr int N = 16; };
+struct vi32 { __m512i v; static constexpr int N = 16; };
+struct vi16 { __m512i v; static constexpr int N = 32; };
+struct vu16 { __m512i v; static constexpr int N = 32; };
+struct vu8 { __m512i v; static constexpr int N = 64; };
+struct vi8 { __m512i v; static constexpr int N = 64; };
+
+// channels of interleaved bytes, see load3 / load4
+struct vu8x3 { vu8 v[3]; };
+struct vu8x4 { vu8 v[4]; };
+
+// ---------------------------------------------------------------- memory
+
+inline vf32 loadu(const float* p) { return {_mm512_loadu_ps(p)}; }
+inline vi32 loadu(const int32_t* p) { return {_mm512_loadu_si512(p)}; }
+inline vi16 loadu(const int16_t* p) { return {_mm512_loadu_si512(p)}; }
+inline vu16 loadu(const uint16_t* p) { return {_mm512_loadu_si512(p)}; }
+inline vu8 loadu(const uint8_t* p) { return {_mm512_loadu_si512(p)}; }
+inline vi8 loadu(const int8_t* p) { return {_mm512_loadu_si512(p)}; }
+
+inline vf32 load(const float* p) { return {_mm512_load_ps(p)}; }
+inline vi32 load(const int32_t* p) { return {_mm512_load_si512(p)}; }
+inline vi16 load(const int16_t* p) { return {_mm512_load_si512(p)}; }
+inline vu16 load(const uint16_t* p) { return {_mm512_load_si512(p)}; }
+inline vu8 load(const uint8_t* p) { return {_mm512_load_si512(p)}; }
+inline vi8 load(const int8_t* p) { return {_mm512_load_si512(p)}; }
+
+inline void storeu(float* p, vf32 a) { _mm512_storeu_ps(p, a.v); }
+inline void storeu(int32_t* p, vi32 a) { _mm512_storeu_si512(p, a.v); }
+inline void storeu(int16_t* p, vi16 a) { _mm512_storeu_si512(p, a.v); }
+inline void storeu(uint16_t* p, vu16 a) { _mm512_storeu_si512(p, a.v); }
+inline void storeu(uint8_t* p, vu8 a) { _mm512_storeu_si512(p, a.v); }
+inline void storeu(int8_t* p, vi8 a) { _mm512_storeu_si512(p, a.v); }
+
+inline void store(float* p, vf32 a) { _mm512_store_ps(p, a.v); }
+inline void store(int32_t* p, vi32 a) { _mm512_store_si512(p, a.v); }
+inline void store(int16_t* p, vi16 a) { _mm512_store_si512(p, a.v); }
+inline void store(uint16_t* p, vu16 a) { _mm512_store_si512(p, a.v); }
+inline void store(uint8_t* p, vu8 a) { _mm512_store_si512(p, a.v); }
+inline void store(int8_t* p, vi8 a) { _mm512_store_si512(p, a.v); }
+
+inline vf32 set1_f32(float x) { return {_mm512_set1_ps(x)}; }
+inline vi32 set1_i32(int32_t x) { return {_mm512_set1_epi32(x)}; }
+inline vi16 set1_i16(int16_t x) { return {_mm512_set1_epi16(x)}; }
+inline vu16 set1_u16(uint16_t x) { return {_mm512_set1_epi16((short)x)}; }
+inline vu8 set1_u8(uint8_t x) { return {_mm512_set1_epi8((char)x)}; }
+inline vi8 set1_i8(int8_t x) { return {_mm512_set1_epi8(x)}; }
+
+inline vf32 zero_f32() { return {_mm512_setzero_ps()}; }
+inline vi32 zero_i32() { return {_mm512_setzero_si512()}; }
+inline vi16 zero_i16() { return {_mm512_setzero_si512()}; }
+inline vu16 zero_u16() { return {_mm512_setzero_si512()}; }
+inline vu8 zero_u8() { return {_mm512_setzero_si512()}; }
+inline vi8 zero_i8() { return {_mm512_setzero_si512()}; }
+
+// ---------------------------------------------------------------- arithmetic
+
+#define XR_SIMD_AVX512_BINARY(name, V, intrin) \
+  inline V name(V a, V b) { return {intrin(a.v, b.v)}; }
+
+XR_SIMD_AVX512_BINARY(add, vf32, _mm512_add_ps)
+XR_SIMD_AVX512_BINARY(add, vi32, _mm512_add_epi32)
+XR_SIMD_AVX512_BINARY(add, vi16, _mm512_add_epi16)
+XR_SIMD_AVX512_BINARY(add, vu16, _mm512_add_epi16)
+XR_SIMD_AVX512_BINARY(add, vu8, _mm512_add_epi8)
+XR_SIMD_AVX512_BINARY(sub, vf32, _mm512_sub_ps)
+XR_SIMD_AVX512_BINARY(sub, vi32, _mm512_sub_epi32)
+XR_SIMD_AVX512_BINARY(sub, vi16, _mm512_sub_epi16)
+XR_SIMD_AVX512_BINARY(sub, vu16, _mm512_sub_epi16)
+XR_SIMD_AVX512_BINARY(sub, vu8, _mm512_sub_epi8)
+XR_SIMD_AVX512_BINARY(mul, vf32, _mm512_mul_ps)
+XR_SIMD_AVX512_BINARY(mul, vi32, _mm512_mullo_epi32)
+XR_SIMD_AVX512_BINARY(mul, vi16, _mm512_mullo_epi16)
+XR_SIMD_AVX512_BINARY(mul, vu16, _mm512_mullo_epi16)
+XR_SIMD_AVX512_BINARY(div, vf32, _mm512_div_ps)
+
+XR_SIMD_AVX512_BINARY(adds, vi16, _mm512_adds_epi16)
+XR_SIMD_AVX512_BINARY(adds, vu16, _mm512_adds_epu16)
+XR_SIMD_AVX512_BINARY(adds, vu8, _mm512_adds_epu8)
+XR_SIMD_AVX512_BINARY(subs, vi16, _mm512_subs_epi16)
+XR_SIMD_AVX512_BINARY(subs, vu16, _mm512_subs_epu16)
+XR_SIMD_AVX512_BINARY(subs, vu8, _mm512_subs_epu8)
+
+XR_SIMD_AVX512_BINARY(mulhi, vi16, _mm512_mulhi_epi16)
+XR_SIMD_AVX512_BINARY(mulhi, vu16, _mm512_mulhi_epu16)
+XR_SIMD_AVX512_BINARY(avg, vu16, _mm512_avg_epu16)
+XR_SIMD_AVX512_BINARY(avg, vu8, _mm512_avg_epu8)
+
+XR_SIMD_AVX512_BINARY(min, vf32, _mm512_min_ps)
+XR_SIMD_AVX512_BINARY(min, vi32, _mm512_min_epi32)
+XR_SIMD_AVX512_BINARY(min, vi16, _mm512_min_epi16)
+XR_SIMD_AVX512_BINARY(min, vu16, _mm512_min_epu16)
+XR_SIMD_AVX512_BINARY(min, vu8, _mm512_min_epu8)
+XR_SIMD_AVX512_BINARY(max, vf32, _mm512_max_ps)
+XR_SIMD_AVX512_BINARY(max, vi32, _mm512_max_epi32)
+XR_SIMD_AVX512_BINARY(max, vi16, _mm512_max_epi16)
+XR_SIMD_AVX512_BINARY(max, vu16, _mm512_max_epu16)
+XR_SIMD_AVX512_BINARY(max, vu8, _mm512_max_epu8)
+
+inline vf32 fma(vf32 a, vf32 b, vf32 c) { return {_mm512_fmadd_ps(a.v, b.v, c.v)}; }
+
+inline vf32 abs(vf32 a) { return {_mm512_abs_ps(a.v)}; }
+inline vi32 abs(vi32 a) { return {_mm512_abs_epi32(a.v)}; }
+inline vi16 abs(vi16 a) { return {_mm512_abs_epi16(a.v)}; }
+inline vf32 sqrt(vf32 a) { return {_mm512_sqrt_ps(a.v)}; }
+
+inline vi32 shl(vi32 a, int n) { return {_mm512_sll_epi32(a.v, _mm_cvtsi32_si128(n))}; }
+inline vi16 shl(vi16 a, int n) { return {_mm512_sll_epi16(a.v, _mm_cvtsi32_si128(n))}; }
+inline vu16 shl(vu16 a, int n) { return {_mm512_sll_epi16(a.v, _mm_cvtsi32_si128(n))}; }
+inline vi32 shr(vi32 a, int n) { return {_mm512_sra_epi32(a.v, _mm_cvtsi32_si128(n))}; }
+inline vi16 shr(vi16 a, int n) { return {_mm512_sra_epi16(a.v, _mm_cvtsi32_si128(n))}; }
+inline vu16 shr(vu16 a, int n) { return {_mm512_srl_epi16(a.v, _mm_cvtsi32_si128(n))}; }
+
+// ---------------------------------------------------------------- bitwise
+
+#define XR_SIMD_AVX512_ALL_INT(name, intrin) \
+  XR_SIMD_AVX512_BINARY(name, vi32, intrin)  \
+  XR_SIMD_AVX512_BINARY(name, vi16, intrin)  \
+  XR_SIMD_AVX512_BINARY(name, vu16, intrin)  \
+  XR_SIMD_AVX512_BINARY(name, vu8, intrin)
+
+XR_SIMD_AVX512_BINARY(bit_and, vf32, _mm512_and_ps)
+XR_SIMD_AVX512_BINARY(bit_or, vf32, _mm512_or_ps)
+XR_SIMD_AVX512_BINARY(bit_xor, vf32, _mm512_xor_ps)
+XR_SIMD_AVX512_ALL_INT(bit_and, _mm512_and_si512)
+XR_SIMD_AVX512_ALL_INT(bit_or, _mm512_or_si512)
+XR_SIMD_AVX512_ALL_INT(bit_xor, _mm512_xor_si512)
+inline vf32 bit_andnot(vf32 a, vf32 b) { return {_mm512_andnot_ps(b.v, a.v)}; }
+inline vi32 bit_andnot(vi32 a, vi32 b) { return {_mm512_andnot_si512(b.v, a.v)}; }
+inline vi16 bit_andnot(vi16 a, vi16 b) { return {_mm512_andnot_si512(b.v, a.v)}; }
+inline vu16 bit_andnot(vu16 a, vu16 b) { return {_mm512_andnot_si512(b.v, a.v)}; }
+inline vu8 bit_andnot(vu8 a, vu8 b) { return {_mm512_andnot_si512(b.v, a.v)}; }
+
+// ---------------------------------------------------------------- compare / select
+
+inline vf32 f32_mask(__mmask16 k) { return {_mm512_castsi512_ps(_mm512_movm_epi32(k))}; }
+
+inline vf32 cmpeq(vf32 a, vf32 b) { return f32_mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_EQ_OQ)); }
+inline vf32 cmplt(vf32 a, vf32 b) { return f32_mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ)); }
+inline vf32 cmple(vf32 a, vf32 b) { return f32_mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ)); }
+inline vf32 cmpgt(vf32 a, vf32 b) { return f32_mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ)); }
+inline vf32 cmpge(vf32 a, vf32 b) { return f32_mask(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ)); }
+
+#define XR_SIMD_AVX512_CMP(name, V, cmp, movm) \
+  inline V name(V a, V b) { return {movm(cmp(a.v, b.v))}; }
+
+XR_SIMD_AVX512_CMP(cmpeq, vi32, _mm512_cmpeq_epi32_mask, _mm512_movm_epi32)
+XR_SIMD_AVX512_CMP(cmpgt, vi32, _mm512_cmpgt_epi32_mask, _mm512_movm_epi32)
+XR_SIMD_AVX512_CMP(cmplt, vi32, _mm512_cmplt_epi32_mask, _mm512_movm_epi32)
+XR_SIMD_AVX512_CMP(cmpeq, vi16, _mm512_cmpeq_epi16_mask, _mm512_movm_epi16)
+XR_SIMD_AVX512_CMP(cmpgt, vi16, _mm512_cmpgt_epi16_mask, _mm512_movm_epi16)
+XR_SIMD_AVX512_CMP(cmplt, vi16, _mm512_cmplt_epi16_mask, _mm512_movm_epi16)
+XR_SIMD_AVX512_CMP(cmpeq, vu16, _mm512_cmpeq_epu16_mask, _mm512_movm_epi16)
+XR_SIMD_AVX512_CMP(cmpgt, vu16, _mm512_cmpgt_epu16_mask, _mm512_movm_epi16)
+XR_SIMD_AVX512_CMP(cmpeq, vu8, _mm512_cmpeq_epu8_mask, _mm512_movm_epi8)
+XR_SIMD_AVX512_CMP(cmpgt, vu8, _mm512_cmpgt_epu8_mask, _mm512_movm_epi8)
+
+// mask must be a compare result: only the top bit of each lane is read
+inline vf32 select(vf32 mask, vf32 a, vf32 b) {
+  return {_mm512_mask_blend_ps(_mm512_movepi32_mask(_mm512_castps_si512(mask.v)), b.v, a.v)};
+}
+inline vi32 select(vi32 mask, vi32 a, vi32 b) {
+  return {_mm512_mask_blend_epi32(_mm512_movepi32_mask(mask.v), b.v, a.v)};
+}
+inline vi16 select(vi16 mask, vi16 a, vi16 b) {
+  return {_mm512_mask_blend_epi16(_mm512_movepi16_mask(mask.v), b.v, a.v)};
+}
+inline vu16 select(vu16 mask, vu16 a, vu16 b) {
+  return {_mm512_mask_blend_epi16(_mm512_movepi16_mask(mask.v), b.v, a.v)};
+}
+inline vu8 select(vu8 mask, vu8 a, vu8 b) {
+  return {_mm512_mask_blend_epi8(_mm512_movepi8_mask(mask.v), b.v, a.v)};
+}
+
+// ---------------------------------------------------------------- conversion
+
+inline vf32 cvt_f32(vi32 a) { return {_mm512_cvtepi32_ps(a.v)}; }
+inline vi32 cvt_i32(vf32 a) { return {_mm512_cvtps_epi32(a.v)}; }
+inline vi32 cvtt_i32(vf32 a) { return {_mm512_cvttps_epi32(a.v)}; }
+
+inline vf32 load_f16(const uint16_t* p) { return {_mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)p))}; }
+inline void store_f16(uint16_t* p, vf32 a) {
+  _mm256_storeu_si256((__m256i*)p, _mm512_cvtps_ph(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+// 32-bit gather, upper two bytes dropped: reads 4 bytes at each p + off[i]
+inline vi32 gather_u16(const uint8_t* p, vi32 off) {
+  return {_mm512_and_si512(_mm512_i32gather_epi32(off.v, p, 1), _mm512_set1_epi32(0xFFFF))};
+}
+
+inline vf32 as_f32(vi32 a) { return {_mm512_castsi512_ps(a.v)}; }
+inline vi32 as_i32(vf32 a) { return {_mm512_castps_si512(a.v)}; }
+inline vi32 as_i32(vu16 a) { return {a.v}; }
+inline vu16 as_u16(vi32 a) { return {a.v}; }
+inline vu16 as_u16(vi16 a) { return {a.v}; }
+inline vu16 as_u16(vu8 a) { return {a.v}; }
+inline vi16 as_i16(vu16 a) { return {a.v}; }
+inline vi16 as_i16(vu8 a) { return {a.v}; }
+inline vu8 as_u8(vu16 a) { return {a.v}; }
+inline vu8 as_u8(vi16 a) { return {a.v}; }
+inline vu8 as_u8(vi8 a) { return {a.v}; }
+inline vi8 as_i8(vu8 a) { return {a.v}; }
+
+inline vu16 widen_lo(vu8 a) { return {_mm512_cvtepu8_epi16(_mm512_castsi512_si256(a.v))}; }
+inline vu16 widen_hi(vu8 a) { return {_mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(a.v, 1))}; }
+inline vi16 widen_lo(vi8 a) { return {_mm512_cvtepi8_epi16(_mm512_castsi512_si256(a.v))}; }
+inline vi16 widen_hi(vi8 a) { return {_mm512_cvtepi8_epi16(_mm512_extracti64x4_epi64(a.v, 1))}; }
+inline vi32 widen_lo(vi16 a) { return {_mm512_cvtepi16_epi32(_mm512_castsi512_si256(a.v))}; }
+inline vi32 widen_hi(vi16 a) { return {_mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(a.v, 1))}; }
+inline vi32 widen_lo(vu16 a) { return {_mm512_cvtepu16_epi32(_mm512_castsi512_si256(a.v))}; }
+inline vi32 widen_hi(vu16 a) { return {_mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(a.v, 1))}; }
+
+namespace detail {
+
+// packs give 64-bit halves a0 b0 a1 b1 a2 b2 a3 b3, reorder to a0..a3 b0..b3
+inline __m512i fix_pack_lanes(__m512i x) {
+  return _mm512_permutexvar_epi64(_mm512_set_epi64(7, 5, 3, 1, 6, 4, 2, 0), x);
+}
+
+}  // namespace detail
+
+inline vu8 narrow_sat_u8(vi16 a, vi16 b) { return {detail::fix_pack_lanes(_mm512_packus_epi16(a.v, b.v))}; }
+inline vu8 narrow_sat_u8(vu16 a, vu16 b) {
+  __m512i m = _mm512_set1_epi16(255);
+  return {detail::fix_pack_lanes(_mm512_packus_epi16(_mm512_min_epu16(a.v, m), _mm512_min_epu16(b.v, m)))};
+}
+inline vi8 narrow_sat_i8(vi16 a, vi16 b) { return {detail::fix_pack_lanes(_mm512_packs_epi16(a.v, b.v))}; }
+inline vi16 narrow_sat_i16(vi32 a, vi32 b) { return {detail::fix_pack_lanes(_mm512_packs_epi32(a.v, b.v))}; }
+inline vu16 narrow_sat_u16(vi32 a, vi32 b) { return {detail::fix_pack_lanes(_mm512_packus_epi32(a.v, b.v))}; }
+
+// ---------------------------------------------------------------- permute
+
+namespace detail {
+
+// lo / hi are the in-lane unpacks; take their 128-bit lanes in zip order
+inline __m512i zip_lo_lanes(__m512i lo, __m512i hi) {
+  return _mm512_permutex2var_epi64(lo, _mm512_set_epi64(11, 10, 3, 2, 9, 8, 1, 0), hi);
+}
+inline __m512i zip_hi_lanes(__m512i lo, __m512i hi) {
+  return _mm512_permutex2var_epi64(lo, _mm512_set_epi64(15, 14, 7, 6, 13, 12, 5, 4), hi);
+}
+
+inline __m512i split_even_odd16(__m512i a) {
+  const __m512i m = _mm512_broadcast_i32x4(
+      _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15));
+  return _mm512_shuffle_epi8(a, m);
+}
+inline __m512i split_even_odd8(__m512i a) {
+  const __m512i m = _mm512_broadcast_i32x4(
+      _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15));
+  return _mm512_shuffle_epi8(a, m);
+}
+
+}  // namespace detail
+
+inline vf32 zip_lo(vf32 a, vf32 b) {
+  __m512i lo = _mm512_castps_si512(_mm512_unpacklo_ps(a.v, b.v));
+  __m512i hi = _mm512_castps_si512(_mm512_unpackhi_ps(a.v, b.v));
+  return {_mm512_castsi512_ps(detail::zip_lo_lanes(lo, hi))};
+}
+inline vf32 zip_hi(vf32 a, vf32 b) {
+  __m512i lo = _mm512_castps_si512(_mm512_unpacklo_ps(a.v, b.v));
+  __m512i hi = _mm512_castps_si512(_mm512_unpackhi_ps(a.v, b.v));
+  return {_mm512_castsi512_ps(detail::zip_hi_lanes(lo, hi))};
+}
+
+#define XR_SIMD_AVX512_ZIP(V, lo, hi)                                                          \
+  inline V zip_lo(V a, V b) { return {detail::zip_lo_lanes(lo(a.v, b.v), hi(a.v, b.v))}; } \
+  inline V zip_hi(V a, V b) { return {detail::zip_hi_lanes(lo(a.v, b.v), hi(a.v, b.v))}; }
+
+XR_SIMD_AVX512_ZIP(vi32, _mm512_unpacklo_epi32, _mm512_unpackhi_epi32)
+XR_SIMD_AVX512_ZIP(vi16, _mm512_unpacklo_epi16, _mm512_unpackhi_epi16)
+XR_SIMD_AVX512_ZIP(vu16, _mm512_unpacklo_epi16, _mm512_unpackhi_epi16)
+XR_SIMD_AVX512_ZIP(vu8, _mm512_unpacklo_epi8, _mm512_unpackhi_epi8)
+
+inline vf32 unzip_even(vf32 a, vf32 b) {
+  const __m512i idx = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+  return {_mm512_permutex2var_ps(a.v, idx, b.v)};
+}
+inline vf32 unzip_odd(vf32 a, vf32 b) {
+  const __m512i idx = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+  return {_mm512_permutex2var_ps(a.v, idx, b.v)};
+}
+inline vi32 unzip_even(vi32 a, vi32 b) { return as_i32(unzip_even(as_f32(a), as_f32(b))); }
+inline vi32 unzip_odd(vi32 a, vi32 b) { return as_i32(unzip_odd(as_f32(a), as_f32(b))); }
+
+// per lane [even | odd], then gather the even (odd) 64-bit halves of a then b
+#define XR_SIMD_AVX512_UNZIP(V, split)                                                           \
+  inline V unzip_even(V a, V b) {                                                                \
+    return {_mm512_permutex2var_epi64(split(a.v), _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0), split(b.v))}; \
+  }                                                                                              \
+  inline V unzip_odd(V a, V b) {                                                                 \
+    return {_mm512_permutex2var_epi64(split(a.v), _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1), split(b.v))}; \
+  }
+
+XR_SIMD_AVX512_UNZIP(vi16, detail::split_even_odd16)
+XR_SIMD_AVX512_UNZIP(vu16, detail::split_even_odd16)
+XR_SIMD_AVX512_UNZIP(vu8, detail::split_even_odd8)
+
+// ---------------------------------------------------------------- structure load / store
+
+// load3 splits 3 * N interleaved bytes (RGBRGB...) into one vector per channel
+// and store3 interleaves them back, NEON vld3q / vst3q; load4 / store4 do the
+// same for 4 channels. No alignment needed.
+//
+// x86 has no structure loads. Source register k holds the 16-byte blocks
+// k, k + K, k + 2K, ... in its 128-bit lanes, so every lane sees one whole
+// group of 16 pixels and the rest is in-lane byte shuffles: three pshufb per
+// channel for 3 bytes, a 4 x 4 byte then 4 x 4 dword transpose for 4.
+
+namespace detail {
+
+inline __m512i load_blocks(const uint8_t* p, int k, int K) {
+  __m512i x = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i*)(p + 16 * k)));
+  x = _mm512_inserti32x4(x, _mm_loadu_si128((const __m128i*)(p + 16 * (k + K))), 1);
+  x = _mm512_inserti32x4(x, _mm_loadu_si128((const __m128i*)(p + 16 * (k + 2 * K))), 2);
+  return _mm512_inserti32x4(x, _mm_loadu_si128((const __m128i*)(p + 16 * (k + 3 * K))), 3);
+}
+
+inline void store_blocks(uint8_t* p, int k, int K, __m512i x) {
+  _mm_storeu_si128((__m128i*)(p + 16 * k), _mm512_castsi512_si128(x));
+  _mm_storeu_si128((__m128i*)(p + 16 * (k + K)), _mm512_extracti32x4_epi32(x, 1));
+  _mm_storeu_si128((__m128i*)(p + 16 * (k + 2 * K)), _mm512_extracti32x4_epi32(x, 2));
+  _mm_storeu_si128((__m128i*)(p + 16 * (k + 3 * K)), _mm512_extracti32x4_epi32(x, 3));
+}
+
+inline __m512i shuffle_table(const int8_t* m) { return _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)m)); }
+
+// RGBA RGBA RGBA RGBA <-> RRRR GGGG BBBB AAAA in every lane
+inline __m512i transpose_bytes4(const __m512i& a) {
+  return _mm512_shuffle_epi8(a, shuffle_table(::xr::simd::detail::kTranspose4));
+}
+
+// 4 x 4 transpose of 32-bit elements in every lane
+inline void transpose_dwords4(__m512i& a, __m512i& b, __m512i& c, __m512i& d) {
+  __m512i t0 = _mm512_unpacklo_epi32(a, b), t1 = _mm512_unpackhi_epi32(a, b);
+  __m512i t2 = _mm512_unpacklo_epi32(c, d), t3 = _mm512_unpackhi_epi32(c, d);
+  a = _mm512_unpacklo_epi64(t0, t2);
+  b = _mm512_unpackhi_epi64(t0, t2);
+  c = _mm512_unpacklo_epi64(t1, t3);
+  d = _mm512_unpackhi_epi64(t1, t3);
+}
+
+}  // namespace detail
+
+inline vu8x3 load3(const uint8_t* p) {
+  const auto& m = ::xr::simd::detail::kShuffle3.load;
+  __m512i s[3] = {detail::load_blocks(p, 0, 3), detail::load_blocks(p, 1, 3), detail::load_blocks(p, 2, 3)};
+  vu8x3 r;
+  for (int c = 0; c < 3; c++) {
+    __m512i x = _mm512_or_si512(_mm512_shuffle_epi8(s[0], detail::shuffle_table(m[c][0])),
+                                _mm512_shuffle_epi8(s[1], detail::shuffle_table(m[c][1])));
+    r.v[c].v = _mm512_or_si512(x, _mm512_shuffle_epi8(s[2], detail::shuffle_table(m[c][2])));
+  }
+  return r;
+}
+inline vu8x4 load4(const uint8_t* p) {
+  __m512i s[4];
+  for (int k = 0; k < 4; k++) s[k] = detail::transpose_bytes4(detail::load_blocks(p, k, 4));
+  detail::transpose_dwords4(s[0], s[1], s[2], s[3]);
+  return {{{s[0]}, {s[1]}, {s[2]}, {s[3]}}};
+}
+inline void store3(uint8_t* p, vu8x3 a) {
+  const auto& m = ::xr::simd::detail::kShuffle3.store;
+  for (int j = 0; j < 3; j++) {
+    __m512i x = _mm512_or_si512(_mm512_shuffle_epi8(a.v[0].v, detail::shuffle_table(m[j][0])),
+                                _mm512_shuffle_epi8(a.v[1].v, detail::shuffle_table(m[j][1])));
+    detail::store_blocks(p, j, 3, _mm512_or_si512(x, _mm512_shuffle_epi8(a.v[2].v, detail::shuffle_table(m[j][2]))));
+  }
+}
+inline void store4(uint8_t* p, vu8x4 a) {
+  __m512i s[4] = {a.v[0].v, a.v[1].v, a.v[2].v, a.v[3].v};
+  detail::transpose_dwords4(s[0], s[1], s[2], s[3]);
+  for (int k = 0; k < 4; k++) detail::store_blocks(p, k, 4, detail::transpose_bytes4(s[k]));
+}
+
+// ---------------------------------------------------------------- reduction
+
+inline float reduce_add(vf32 a) { return _mm512_reduce_add_ps(a.v); }
+inline int32_t reduce_add(vi32 a) { return _mm512_reduce_add_epi32(a.v); }
+inline float reduce_min(vf32 a) { return _mm512_reduce_min_ps(a.v); }
+inline float reduce_max(vf32 a) { return _mm512_reduce_max_ps(a.v); }
+
+#undef XR_SIMD_AVX512_BINARY
+#undef XR_SIMD_AVX512_ALL_INT
+#undef XR_SIMD_AVX512_CMP
+#undef XR_SIMD_AVX512_ZIP
+#undef XR_SIMD_AVX512_UNZIP
+
+}  // namespace avx512
+}  // namespace simd
+}  // namespace xr
+
+XR_SIMD_TARGET_END
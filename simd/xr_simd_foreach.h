@@ -0,0 +1,71 @@
+// No include guard: this file is included once per kernel file.
+//
+// Expands the file named by XR_SIMD_KERNELS once per compiled backend, each
+// copy in a sub-namespace named after the backend and inside that backend's
+// target region, with the backend's vector API visible unqualified:
+//
+//   namespace xr { namespace box {
+//   #define XR_SIMD_KERNELS "boxFilter/box_filter_simd.inl"
+//   #include "../xr_simd_foreach.h"
+//   }}
+//
+// gives xr::box::scalar::f, xr::box::avx2::f, ... for every f in the kernel
+// file; XR_SIMD_DISPATCH(f) in xr::box then selects one at runtime. Like any
+// quoted include, XR_SIMD_KERNELS is looked up next to this file first and
+// then on the include path. The kernel file may test XR_SIMD_TARGET against
+// XR_SIMD_TARGET_* for ISA-specific code.
+// Templates in the kernel file must be instantiated inside it as well, since
+// only code generated inside the target region gets the target attribute.
+
+#ifndef XR_SIMD_KERNELS
+#error "define XR_SIMD_KERNELS before including xr_simd_foreach.h"
+#endif
+
+#define XR_SIMD_TARGET XR_SIMD_TARGET_SCALAR
+namespace scalar {
+using namespace ::xr::simd::scalar;
+#include XR_SIMD_KERNELS
+}  // namespace scalar
+#undef XR_SIMD_TARGET
+
+#if XR_SIMD_X86
+
+#define XR_SIMD_TARGET XR_SIMD_TARGET_SSE42
+XR_SIMD_TARGET_BEGIN(XR_SIMD_TARGETS_SSE42)
+namespace sse42 {
+using namespace ::xr::simd::sse42;
+#include XR_SIMD_KERNELS
+}  // namespace sse42
+XR_SIMD_TARGET_END
+#undef XR_SIMD_TARGET
+
+#define XR_SIMD_TARGET XR_SIMD_TARGET_AVX2
+XR_SIMD_TARGET_BEGIN(XR_SIMD_TARGETS_AVX2)
+namespace avx2 {
+using namespace ::xr::simd::avx2;
+#include XR_SIMD_KERNELS
+}  // namespace avx2
+XR_SIMD_TARGET_END
+#undef XR_SIMD_TARGET
+
+#define XR_SIMD_TARGET XR_SIMD_TARGET_AVX512
+XR_SIMD_TARGET_BEGIN(XR_SIMD_TARGETS_AVX512)
+namespace avx512 {
+using namespace ::xr::simd::avx512;
+#include XR_SIMD_KERNELS
+}  // namespace avx512
+XR_SIMD_TARGET_END
+#undef XR_SIMD_TARGET
+
+#endif  // XR_SIMD_X86
+
+#if XR_SIMD_NEON
+#define XR_SIMD_TARGET XR_SIMD_TARGET_NEON
+namespace neon {
+using namespace ::xr::simd::neon;
+#include XR_SIMD_KERNELS
+}  // namespace neon
+#undef XR_SIMD_TARGET
+#endif
+
+#undef XR_SIMD_KERNELS
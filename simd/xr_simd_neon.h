@@ -0,0 +1,280 @@
+#pragma once
+
+// NEON backend for AArch64, 128-bit vectors. Advanced SIMD is part of the
+// base ISA there, so no target region is needed. The functions map almost
+// one to one onto the intrinsic families listed in NEON/readme.md.
+
+namespace xr {
+namespace simd {
+namespace neon {
+
+constexpr Isa kIsa = Isa::kNEON;
+constexpr int kVectorBytes = 16;
+
+struct vf32 { float32x4_t v; static constexpr int N = 4; };
+struct vi32 { int32x4_t v; static constexpr int N = 4; };
+struct vi16 { int16x8_t v; static constexpr int N = 8; };
+struct vu16 { uint16x8_t v; static constexpr int N = 8; };
+struct vu8 { uint8x16_t v; static constexpr int N = 16; };
+struct vi8 { int8x16_t v; static constexpr int N = 16; };
+
+// channels of interleaved bytes, see load3 / load4
+struct vu8x3 { vu8 v[3]; };
+struct vu8x4 { vu8 v[4]; };
+
+// ---------------------------------------------------------------- memory
+
+// vld1q/vst1q have no alignment requirement, load/store only document intent
+inline vf32 loadu(const float* p) { return {vld1q_f32(p)}; }
+inline vi32 loadu(const int32_t* p) { return {vld1q_s32(p)}; }
+inline vi16 loadu(const int16_t* p) { return {vld1q_s16(p)}; }
+inline vu16 loadu(const uint16_t* p) { return {vld1q_u16(p)}; }
+inline vu8 loadu(const uint8_t* p) { return {vld1q_u8(p)}; }
+inline vi8 loadu(const int8_t* p) { return {vld1q_s8(p)}; }
+
+inline vf32 load(const float* p) { return loadu(p); }
+inline vi32 load(const int32_t* p) { return loadu(p); }
+inline vi16 load(const int16_t* p) { return loadu(p); }
+inline vu16 load(const uint16_t* p) { return loadu(p); }
+inline vu8 load(const uint8_t* p) { return loadu(p); }
+inline vi8 load(const int8_t* p) { return loadu(p); }
+
+inline void storeu(float* p, vf32 a) { vst1q_f32(p, a.v); }
+inline void storeu(int32_t* p, vi32 a) { vst1q_s32(p, a.v); }
+inline void storeu(int16_t* p, vi16 a) { vst1q_s16(p, a.v); }
+inline void storeu(uint16_t* p, vu16 a) { vst1q_u16(p, a.v); }
+inline void storeu(uint8_t* p, vu8 a) { vst1q_u8(p, a.v); }
+inline void storeu(int8_t* p, vi8 a) { vst1q_s8(p, a.v); }
+
+inline void store(float* p, vf32 a) { storeu(p, a); }
+inline void store(int32_t* p, vi32 a) { storeu(p, a); }
+inline void store(int16_t* p, vi16 a) { storeu(p, a); }
+inline void store(uint16_t* p, vu16 a) { storeu(p, a); }
+inline void store(uint8_t* p, vu8 a) { storeu(p, a); }
+inline void store(int8_t* p, vi8 a) { storeu(p, a); }
+
+inline vf32 set1_f32(float x) { return {vdupq_n_f32(x)}; }
+inline vi32 set1_i32(int32_t x) { return {vdupq_n_s32(x)}; }
+inline vi16 set1_i16(int16_t x) { return {vdupq_n_s16(x)}; }
+inline vu16 set1_u16(uint16_t x) { return {vdupq_n_u16(x)}; }
+inline vu8 set1_u8(uint8_t x) { return {vdupq_n_u8(x)}; }
+inline vi8 set1_i8(int8_t x) { return {vdupq_n_s8(x)}; }
+
+inline vf32 zero_f32() { return set1_f32(0.0f); }
+inline vi32 zero_i32() { return set1_i32(0); }
+inline vi16 zero_i16() { return set1_i16(0); }
+inline vu16 zero_u16() { return set1_u16(0); }
+inline vu8 zero_u8() { return set1_u8(0); }
+inline vi8 zero_i8() { return set1_i8(0); }
+
+// ---------------------------------------------------------------- arithmetic
+
+#define XR_SIMD_NEON_BINARY(name, V, intrin) \
+  inline V name(V a, V b) { return {intrin(a.v, b.v)}; }
+
+#define XR_SIMD_NEON_ALL(name, op)                \
+  XR_SIMD_NEON_BINARY(name, vf32, op##_f32)       \
+  XR_SIMD_NEON_BINARY(name, vi32, op##_s32)       \
+  XR_SIMD_NEON_BINARY(name, vi16, op##_s16)       \
+  XR_SIMD_NEON_BINARY(name, vu16, op##_u16)       \
+  XR_SIMD_NEON_BINARY(name, vu8, op##_u8)
+
+XR_SIMD_NEON_ALL(add, vaddq)
+XR_SIMD_NEON_ALL(sub, vsubq)
+XR_SIMD_NEON_ALL(min, vminq)
+XR_SIMD_NEON_ALL(max, vmaxq)
+XR_SIMD_NEON_BINARY(mul, vf32, vmulq_f32)
+XR_SIMD_NEON_BINARY(mul, vi32, vmulq_s32)
+XR_SIMD_NEON_BINARY(mul, vi16, vmulq_s16)
+XR_SIMD_NEON_BINARY(mul, vu16, vmulq_u16)
+XR_SIMD_NEON_BINARY(div, vf32, vdivq_f32)
+
+XR_SIMD_NEON_BINARY(adds, vi16, vqaddq_s16)
+XR_SIMD_NEON_BINARY(adds, vu16, vqaddq_u16)
+XR_SIMD_NEON_BINARY(adds, vu8, vqaddq_u8)
+XR_SIMD_NEON_BINARY(subs, vi16, vqsubq_s16)
+XR_SIMD_NEON_BINARY(subs, vu16, vqsubq_u16)
+XR_SIMD_NEON_BINARY(subs, vu8, vqsubq_u8)
+
+// widening multiply, keep the high 16 bits
+inline vi16 mulhi(vi16 a, vi16 b) {
+  int32x4_t lo = vmull_s16(vget_low_s16(a.v), vget_low_s16(b.v));
+  int32x4_t hi = vmull_high_s16(a.v, b.v);
+  return {vshrn_high_n_s32(vshrn_n_s32(lo, 16), hi, 16)};
+}
+inline vu16 mulhi(vu16 a, vu16 b) {
+  uint32x4_t lo = vmull_u16(vget_low_u16(a.v), vget_low_u16(b.v));
+  uint32x4_t hi = vmull_high_u16(a.v, b.v);
+  return {vshrn_high_n_u32(vshrn_n_u32(lo, 16), hi, 16)};
+}
+XR_SIMD_NEON_BINARY(avg, vu16, vrhaddq_u16)
+XR_SIMD_NEON_BINARY(avg, vu8, vrhaddq_u8)
+
+// vfmaq(c, a, b) = c + a * b, fused
+inline vf32 fma(vf32 a, vf32 b, vf32 c) { return {vfmaq_f32(c.v, a.v, b.v)}; }
+
+inline vf32 abs(vf32 a) { return {vabsq_f32(a.v)}; }
+inline vi32 abs(vi32 a) { return {vabsq_s32(a.v)}; }
+inline vi16 abs(vi16 a) { return {vabsq_s16(a.v)}; }
+inline vf32 sqrt(vf32 a) { return {vsqrtq_f32(a.v)}; }
+
+// vshl by a negative count shifts right (arithmetic for signed types)
+inline vi32 shl(vi32 a, int n) { return {vshlq_s32(a.v, vdupq_n_s32(n))}; }
+inline vi16 shl(vi16 a, int n) { return {vshlq_s16(a.v, vdupq_n_s16((int16_t)n))}; }
+inline vu16 shl(vu16 a, int n) { return {vshlq_u16(a.v, vdupq_n_s16((int16_t)n))}; }
+inline vi32 shr(vi32 a, int n) { return {vshlq_s32(a.v, vdupq_n_s32(-n))}; }
+inline vi16 shr(vi16 a, int n) { return {vshlq_s16(a.v, vdupq_n_s16((int16_t)-n))}; }
+inline vu16 shr(vu16 a, int n) { return {vshlq_u16(a.v, vdupq_n_s16((int16_t)-n))}; }
+
+// ---------------------------------------------------------------- bitwise
+
+#define XR_SIMD_NEON_ALL_INT(name, op)            \
+  XR_SIMD_NEON_BINARY(name, vi32, op##_s32)       \
+  XR_SIMD_NEON_BINARY(name, vi16, op##_s16)       \
+  XR_SIMD_NEON_BINARY(name, vu16, op##_u16)       \
+  XR_SIMD_NEON_BINARY(name, vu8, op##_u8)
+
+XR_SIMD_NEON_ALL_INT(bit_and, vandq)
+XR_SIMD_NEON_ALL_INT(bit_or, vorrq)
+XR_SIMD_NEON_ALL_INT(bit_xor, veorq)
+// vbic(a, b) = a & ~b
+XR_SIMD_NEON_ALL_INT(bit_andnot, vbicq)
+
+#define XR_SIMD_NEON_F32_BITWISE(name, op)                                                  \
+  inline vf32 name(vf32 a, vf32 b) {                                                        \
+    return {vreinterpretq_f32_u32(op(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))}; \
+  }
+
+XR_SIMD_NEON_F32_BITWISE(bit_and, vandq_u32)
+XR_SIMD_NEON_F32_BITWISE(bit_or, vorrq_u32)
+XR_SIMD_NEON_F32_BITWISE(bit_xor, veorq_u32)
+XR_SIMD_NEON_F32_BITWISE(bit_andnot, vbicq_u32)
+
+// ---------------------------------------------------------------- compare / select
+
+#define XR_SIMD_NEON_CMP_F32(name, op) \
+  inline vf32 name(vf32 a, vf32 b) { return {vreinterpretq_f32_u32(op(a.v, b.v))}; }
+
+XR_SIMD_NEON_CMP_F32(cmpeq, vceqq_f32)
+XR_SIMD_NEON_CMP_F32(cmplt, vcltq_f32)
+XR_SIMD_NEON_CMP_F32(cmple, vcleq_f32)
+XR_SIMD_NEON_CMP_F32(cmpgt, vcgtq_f32)
+XR_SIMD_NEON_CMP_F32(cmpge, vcgeq_f32)
+inline vi32 cmpeq(vi32 a, vi32 b) { return {vreinterpretq_s32_u32(vceqq_s32(a.v, b.v))}; }
+inline vi32 cmpgt(vi32 a, vi32 b) { return {vreinterpretq_s32_u32(vcgtq_s32(a.v, b.v))}; }
+inline vi32 cmplt(vi32 a, vi32 b) { return {vreinterpretq_s32_u32(vcltq_s32(a.v, b.v))}; }
+inline vi16 cmpeq(vi16 a, vi16 b) { return {vreinterpretq_s16_u16(vceqq_s16(a.v, b.v))}; }
+inline vi16 cmpgt(vi16 a, vi16 b) { return {vreinterpretq_s16_u16(vcgtq_s16(a.v, b.v))}; }
+inline vi16 cmplt(vi16 a, vi16 b) { return {vreinterpretq_s16_u16(vcltq_s16(a.v, b.v))}; }
+XR_SIMD_NEON_BINARY(cmpeq, vu16, vceqq_u16)
+XR_SIMD_NEON_BINARY(cmpgt, vu16, vcgtq_u16)
+XR_SIMD_NEON_BINARY(cmpeq, vu8, vceqq_u8)
+XR_SIMD_NEON_BINARY(cmpgt, vu8, vcgtq_u8)
+
+// vbsl is a true bitwise select, any mask works
+inline vf32 select(vf32 mask, vf32 a, vf32 b) { return {vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)}; }
+inline vi32 select(vi32 mask, vi32 a, vi32 b) { return {vbslq_s32(vreinterpretq_u32_s32(mask.v), a.v, b.v)}; }
+inline vi16 select(vi16 mask, vi16 a, vi16 b) { return {vbslq_s16(vreinterpretq_u16_s16(mask.v), a.v, b.v)}; }
+inline vu16 select(vu16 mask, vu16 a, vu16 b) { return {vbslq_u16(mask.v, a.v, b.v)}; }
+inline vu8 select(vu8 mask, vu8 a, vu8 b) { return {vbslq_u8(mask.v, a.v, b.v)}; }
+
+// ---------------------------------------------------------------- conversion
+
+inline vf32 cvt_f32(vi32 a) { return {vcvtq_f32_s32(a.v)}; }
+inline vi32 cvt_i32(vf32 a) { return {vcvtnq_s32_f32(a.v)}; }
+inline vi32 cvtt_i32(vf32 a) { return {vcvtq_s32_f32(a.v)}; }
+
+inline vf32 load_f16(const uint16_t* p) { return {vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(p)))}; }
+inline void store_f16(uint16_t* p, vf32 a) { vst1_u16(p, vreinterpret_u16_f16(vcvt_f16_f32(a.v))); }
+
+// no gather on NEON: one 16-bit load per lane
+inline vi32 gather_u16(const uint8_t* p, vi32 off) {
+  int32_t o[4];
+  vst1q_s32(o, off.v);
+  uint16_t v[4];
+  for (int i = 0; i < 4; i++) std::memcpy(&v[i], p + o[i], 2);
+  return {vreinterpretq_s32_u32(vmovl_u16(vld1_u16(v)))};
+}
+
+inline vf32 as_f32(vi32 a) { return {vreinterpretq_f32_s32(a.v)}; }
+inline vi32 as_i32(vf32 a) { return {vreinterpretq_s32_f32(a.v)}; }
+inline vi32 as_i32(vu16 a) { return {vreinterpretq_s32_u16(a.v)}; }
+inline vu16 as_u16(vi32 a) { return {vreinterpretq_u16_s32(a.v)}; }
+inline vu16 as_u16(vi16 a) { return {vreinterpretq_u16_s16(a.v)}; }
+inline vu16 as_u16(vu8 a) { return {vreinterpretq_u16_u8(a.v)}; }
+inline vi16 as_i16(vu16 a) { return {vreinterpretq_s16_u16(a.v)}; }
+inline vi16 as_i16(vu8 a) { return {vreinterpretq_s16_u8(a.v)}; }
+inline vu8 as_u8(vu16 a) { return {vreinterpretq_u8_u16(a.v)}; }
+inline vu8 as_u8(vi16 a) { return {vreinterpretq_u8_s16(a.v)}; }
+inline vu8 as_u8(vi8 a) { return {vreinterpretq_u8_s8(a.v)}; }
+inline vi8 as_i8(vu8 a) { return {vreinterpretq_s8_u8(a.v)}; }
+
+inline vu16 widen_lo(vu8 a) { return {vmovl_u8(vget_low_u8(a.v))}; }
+inline vu16 widen_hi(vu8 a) { return {vmovl_high_u8(a.v)}; }
+inline vi16 widen_lo(vi8 a) { return {vmovl_s8(vget_low_s8(a.v))}; }
+inline vi16 widen_hi(vi8 a) { return {vmovl_high_s8(a.v)}; }
+inline vi32 widen_lo(vi16 a) { return {vmovl_s16(vget_low_s16(a.v))}; }
+inline vi32 widen_hi(vi16 a) { return {vmovl_high_s16(a.v)}; }
+inline vi32 widen_lo(vu16 a) { return {vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(a.v)))}; }
+inline vi32 widen_hi(vu16 a) { return {vreinterpretq_s32_u32(vmovl_high_u16(a.v))}; }
+
+inline vu8 narrow_sat_u8(vi16 a, vi16 b) { return {vqmovun_high_s16(vqmovun_s16(a.v), b.v)}; }
+inline vu8 narrow_sat_u8(vu16 a, vu16 b) { return {vqmovn_high_u16(vqmovn_u16(a.v), b.v)}; }
+inline vi8 narrow_sat_i8(vi16 a, vi16 b) { return {vqmovn_high_s16(vqmovn_s16(a.v), b.v)}; }
+inline vi16 narrow_sat_i16(vi32 a, vi32 b) { return {vqmovn_high_s32(vqmovn_s32(a.v), b.v)}; }
+inline vu16 narrow_sat_u16(vi32 a, vi32 b) { return {vqmovun_high_s32(vqmovun_s32(a.v), b.v)}; }
+
+// ---------------------------------------------------------------- permute
+
+#define XR_SIMD_NEON_PERMUTE(V, sfx)                                                \
+  inline V zip_lo(V a, V b) { return {vzip1q_##sfx(a.v, b.v)}; }                    \
+  inline V zip_hi(V a, V b) { return {vzip2q_##sfx(a.v, b.v)}; }                    \
+  inline V unzip_even(V a, V b) { return {vuzp1q_##sfx(a.v, b.v)}; }                \
+  inline V unzip_odd(V a, V b) { return {vuzp2q_##sfx(a.v, b.v)}; }
+
+XR_SIMD_NEON_PERMUTE(vf32, f32)
+XR_SIMD_NEON_PERMUTE(vi32, s32)
+XR_SIMD_NEON_PERMUTE(vi16, s16)
+XR_SIMD_NEON_PERMUTE(vu16, u16)
+XR_SIMD_NEON_PERMUTE(vu8, u8)
+
+// ---------------------------------------------------------------- structure load / store
+
+// load3 splits 3 * N interleaved bytes (RGBRGB...) into one vector per channel
+// and store3 interleaves them back, NEON vld3q / vst3q; load4 / store4 do the
+// same for 4 channels. No alignment needed.
+
+inline vu8x3 load3(const uint8_t* p) {
+  uint8x16x3_t t = vld3q_u8(p);
+  return {{{t.val[0]}, {t.val[1]}, {t.val[2]}}};
+}
+inline vu8x4 load4(const uint8_t* p) {
+  uint8x16x4_t t = vld4q_u8(p);
+  return {{{t.val[0]}, {t.val[1]}, {t.val[2]}, {t.val[3]}}};
+}
+inline void store3(uint8_t* p, vu8x3 a) {
+  uint8x16x3_t t = {{a.v[0].v, a.v[1].v, a.v[2].v}};
+  vst3q_u8(p, t);
+}
+inline void store4(uint8_t* p, vu8x4 a) {
+  uint8x16x4_t t = {{a.v[0].v, a.v[1].v, a.v[2].v, a.v[3].v}};
+  vst4q_u8(p, t);
+}
+
+// ---------------------------------------------------------------- reduction
+
+inline float reduce_add(vf32 a) { return vaddvq_f32(a.v); }
+inline int32_t reduce_add(vi32 a) { return vaddvq_s32(a.v); }
+inline float reduce_min(vf32 a) { return vminvq_f32(a.v); }
+inline float reduce_max(vf32 a) { return vmaxvq_f32(a.v); }
+
+#undef XR_SIMD_NEON_BINARY
+#undef XR_SIMD_NEON_ALL
+#undef XR_SIMD_NEON_ALL_INT
+#undef XR_SIMD_NEON_F32_BITWISE
+#undef XR_SIMD_NEON_CMP_F32
+#undef XR_SIMD_NEON_PERMUTE
+
+}  // namespace neon
+}  // namespace simd
+}  // namespace xr
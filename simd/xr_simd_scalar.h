@@ -0,0 +1,369 @@
+#pragma once
+
+// Portable 128-bit emulation. Every other backend must produce the same
+// results as this one (up to the rounding of fma/div/sqrt and the order of
+// float reductions), so it doubles as the reference when checking a kernel.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace xr {
+namespace simd {
+namespace scalar {
+
+constexpr Isa kIsa = Isa::kScalar;
+constexpr int kVectorBytes = 16;
+
+struct vf32 { float v[4]; static constexpr int N = 4; };
+struct vi32 { int32_t v[4]; static constexpr int N = 4; };
+struct vi16 { int16_t v[8]; static constexpr int N = 8; };
+struct vu16 { uint16_t v[8]; static constexpr int N = 8; };
+struct vu8 { uint8_t v[16]; static constexpr int N = 16; };
+struct vi8 { int8_t v[16]; static constexpr int N = 16; };
+
+// channels of interleaved bytes, see load3 / load4
+struct vu8x3 { vu8 v[3]; };
+struct vu8x4 { vu8 v[4]; };
+
+namespace detail {
+
+inline uint32_t bits(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, 4);
+  return u;
+}
+
+inline float from_bits(uint32_t u) {
+  float f;
+  std::memcpy(&f, &u, 4);
+  return f;
+}
+
+template <typename T, typename Lo, typename Hi>
+inline T sat(int64_t x, Lo lo, Hi hi) {
+  return (T)(x < lo ? lo : (x > hi ? hi : x));
+}
+
+}  // namespace detail
+
+// The integer types share one implementation per operation; only vf32 needs
+// its own because bitwise ops and masks go through the float bit pattern.
+#define XR_SIMD_SCALAR_MAP1(V, expr)      \
+  V r;                                    \
+  for (int i = 0; i < V::N; i++) {        \
+    r.v[i] = expr;                        \
+  }                                       \
+  return r
+
+// ---------------------------------------------------------------- memory
+
+inline vf32 loadu(const float* p) { vf32 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+inline vi32 loadu(const int32_t* p) { vi32 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+inline vi16 loadu(const int16_t* p) { vi16 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+inline vu16 loadu(const uint16_t* p) { vu16 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+inline vu8 loadu(const uint8_t* p) { vu8 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+inline vi8 loadu(const int8_t* p) { vi8 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+
+inline vf32 load(const float* p) { return loadu(p); }
+inline vi32 load(const int32_t* p) { return loadu(p); }
+inline vi16 load(const int16_t* p) { return loadu(p); }
+inline vu16 load(const uint16_t* p) { return loadu(p); }
+inline vu8 load(const uint8_t* p) { return loadu(p); }
+inline vi8 load(const int8_t* p) { return loadu(p); }
+
+inline void storeu(float* p, vf32 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline void storeu(int32_t* p, vi32 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline void storeu(int16_t* p, vi16 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline void storeu(uint16_t* p, vu16 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline void storeu(uint8_t* p, vu8 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline void storeu(int8_t* p, vi8 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+
+inline void store(float* p, vf32 a) { storeu(p, a); }
+inline void store(int32_t* p, vi32 a) { storeu(p, a); }
+inline void store(int16_t* p, vi16 a) { storeu(p, a); }
+inline void store(uint16_t* p, vu16 a) { storeu(p, a); }
+inline void store(uint8_t* p, vu8 a) { storeu(p, a); }
+inline void store(int8_t* p, vi8 a) { storeu(p, a); }
+
+inline vf32 set1_f32(float x) { XR_SIMD_SCALAR_MAP1(vf32, x); }
+inline vi32 set1_i32(int32_t x) { XR_SIMD_SCALAR_MAP1(vi32, x); }
+inline vi16 set1_i16(int16_t x) { XR_SIMD_SCALAR_MAP1(vi16, x); }
+inline vu16 set1_u16(uint16_t x) { XR_SIMD_SCALAR_MAP1(vu16, x); }
+inline vu8 set1_u8(uint8_t x) { XR_SIMD_SCALAR_MAP1(vu8, x); }
+inline vi8 set1_i8(int8_t x) { XR_SIMD_SCALAR_MAP1(vi8, x); }
+
+inline vf32 zero_f32() { return set1_f32(0.0f); }
+inline vi32 zero_i32() { return set1_i32(0); }
+inline vi16 zero_i16() { return set1_i16(0); }
+inline vu16 zero_u16() { return set1_u16(0); }
+inline vu8 zero_u8() { return set1_u8(0); }
+inline vi8 zero_i8() { return set1_i8(0); }
+
+// ---------------------------------------------------------------- arithmetic
+
+#define XR_SIMD_SCALAR_BINARY(name, V, T, expr) \
+  inline V name(V a, V b) { XR_SIMD_SCALAR_MAP1(V, (T)(expr)); }
+
+#define XR_SIMD_SCALAR_ALL_INT(name, expr)            \
+  XR_SIMD_SCALAR_BINARY(name, vi32, int32_t, expr)    \
+  XR_SIMD_SCALAR_BINARY(name, vi16, int16_t, expr)    \
+  XR_SIMD_SCALAR_BINARY(name, vu16, uint16_t, expr)   \
+  XR_SIMD_SCALAR_BINARY(name, vu8, uint8_t, expr)
+
+// wrapping integer add/sub go through uint32_t so overflow is well defined
+XR_SIMD_SCALAR_BINARY(add, vf32, float, a.v[i] + b.v[i])
+XR_SIMD_SCALAR_ALL_INT(add, (uint32_t)a.v[i] + (uint32_t)b.v[i])
+XR_SIMD_SCALAR_BINARY(sub, vf32, float, a.v[i] - b.v[i])
+XR_SIMD_SCALAR_ALL_INT(sub, (uint32_t)a.v[i] - (uint32_t)b.v[i])
+XR_SIMD_SCALAR_BINARY(mul, vf32, float, a.v[i] * b.v[i])
+XR_SIMD_SCALAR_BINARY(mul, vi32, int32_t, (uint32_t)a.v[i] * (uint32_t)b.v[i])
+XR_SIMD_SCALAR_BINARY(mul, vi16, int16_t, (uint32_t)a.v[i] * (uint32_t)b.v[i])
+XR_SIMD_SCALAR_BINARY(mul, vu16, uint16_t, (uint32_t)a.v[i] * (uint32_t)b.v[i])
+XR_SIMD_SCALAR_BINARY(div, vf32, float, a.v[i] / b.v[i])
+
+XR_SIMD_SCALAR_BINARY(adds, vi16, int16_t, detail::sat<int16_t>((int64_t)a.v[i] + b.v[i], INT16_MIN, INT16_MAX))
+XR_SIMD_SCALAR_BINARY(adds, vu16, uint16_t, detail::sat<uint16_t>((int64_t)a.v[i] + b.v[i], 0, UINT16_MAX))
+XR_SIMD_SCALAR_BINARY(adds, vu8, uint8_t, detail::sat<uint8_t>((int64_t)a.v[i] + b.v[i], 0, UINT8_MAX))
+XR_SIMD_SCALAR_BINARY(subs, vi16, int16_t, detail::sat<int16_t>((int64_t)a.v[i] - b.v[i], INT16_MIN, INT16_MAX))
+XR_SIMD_SCALAR_BINARY(subs, vu16, uint16_t, detail::sat<uint16_t>((int64_t)a.v[i] - b.v[i], 0, UINT16_MAX))
+XR_SIMD_SCALAR_BINARY(subs, vu8, uint8_t, detail::sat<uint8_t>((int64_t)a.v[i] - b.v[i], 0, UINT8_MAX))
+
+// high half of the 32-bit product
+XR_SIMD_SCALAR_BINARY(mulhi, vi16, int16_t, ((int32_t)a.v[i] * b.v[i]) >> 16)
+XR_SIMD_SCALAR_BINARY(mulhi, vu16, uint16_t, ((uint32_t)a.v[i] * b.v[i]) >> 16)
+
+// rounding average (a + b + 1) >> 1
+XR_SIMD_SCALAR_BINARY(avg, vu16, uint16_t, ((uint32_t)a.v[i] + b.v[i] + 1) >> 1)
+XR_SIMD_SCALAR_BINARY(avg, vu8, uint8_t, ((uint32_t)a.v[i] + b.v[i] + 1) >> 1)
+
+XR_SIMD_SCALAR_BINARY(min, vf32, float, std::min(a.v[i], b.v[i]))
+XR_SIMD_SCALAR_ALL_INT(min, std::min(a.v[i], b.v[i]))
+XR_SIMD_SCALAR_BINARY(max, vf32, float, std::max(a.v[i], b.v[i]))
+XR_SIMD_SCALAR_ALL_INT(max, std::max(a.v[i], b.v[i]))
+
+// a * b + c, NEON vmla. Fused only where the backend has FMA, so results may
+// differ from the scalar reference in the last bit.
+inline vf32 fma(vf32 a, vf32 b, vf32 c) { XR_SIMD_SCALAR_MAP1(vf32, a.v[i] * b.v[i] + c.v[i]); }
+
+inline vf32 abs(vf32 a) { XR_SIMD_SCALAR_MAP1(vf32, std::fabs(a.v[i])); }
+inline vi32 abs(vi32 a) { XR_SIMD_SCALAR_MAP1(vi32, (int32_t)(a.v[i] < 0 ? 0u - (uint32_t)a.v[i] : (uint32_t)a.v[i])); }
+inline vi16 abs(vi16 a) { XR_SIMD_SCALAR_MAP1(vi16, (int16_t)(a.v[i] < 0 ? -a.v[i] : a.v[i])); }
+inline vf32 sqrt(vf32 a) { XR_SIMD_SCALAR_MAP1(vf32, std::sqrt(a.v[i])); }
+
+inline vi32 shl(vi32 a, int n) { XR_SIMD_SCALAR_MAP1(vi32, (int32_t)((uint32_t)a.v[i] << n)); }
+inline vi16 shl(vi16 a, int n) { XR_SIMD_SCALAR_MAP1(vi16, (int16_t)((uint32_t)a.v[i] << n)); }
+inline vu16 shl(vu16 a, int n) { XR_SIMD_SCALAR_MAP1(vu16, (uint16_t)((uint32_t)a.v[i] << n)); }
+// arithmetic for signed, logical for unsigned
+inline vi32 shr(vi32 a, int n) { XR_SIMD_SCALAR_MAP1(vi32, a.v[i] >> n); }
+inline vi16 shr(vi16 a, int n) { XR_SIMD_SCALAR_MAP1(vi16, (int16_t)(a.v[i] >> n)); }
+inline vu16 shr(vu16 a, int n) { XR_SIMD_SCALAR_MAP1(vu16, (uint16_t)(a.v[i] >> n)); }
+
+// ---------------------------------------------------------------- bitwise
+
+XR_SIMD_SCALAR_ALL_INT(bit_and, a.v[i] & b.v[i])
+XR_SIMD_SCALAR_ALL_INT(bit_or, a.v[i] | b.v[i])
+XR_SIMD_SCALAR_ALL_INT(bit_xor, a.v[i] ^ b.v[i])
+// a & ~b, NEON vbic
+XR_SIMD_SCALAR_ALL_INT(bit_andnot, a.v[i] & ~b.v[i])
+XR_SIMD_SCALAR_BINARY(bit_and, vf32, float, detail::from_bits(detail::bits(a.v[i]) & detail::bits(b.v[i])))
+XR_SIMD_SCALAR_BINARY(bit_or, vf32, float, detail::from_bits(detail::bits(a.v[i]) | detail::bits(b.v[i])))
+XR_SIMD_SCALAR_BINARY(bit_xor, vf32, float, detail::from_bits(detail::bits(a.v[i]) ^ detail::bits(b.v[i])))
+XR_SIMD_SCALAR_BINARY(bit_andnot, vf32, float, detail::from_bits(detail::bits(a.v[i]) & ~detail::bits(b.v[i])))
+
+// ---------------------------------------------------------------- compare / select
+
+// Masks are vectors of the compared type with all bits set in true lanes.
+#define XR_SIMD_SCALAR_CMP_F32(name, op) \
+  XR_SIMD_SCALAR_BINARY(name, vf32, float, detail::from_bits(a.v[i] op b.v[i] ? 0xFFFFFFFFu : 0u))
+#define XR_SIMD_SCALAR_CMP_INT(name, V, T, op) XR_SIMD_SCALAR_BINARY(name, V, T, a.v[i] op b.v[i] ? ~(T)0 : (T)0)
+
+XR_SIMD_SCALAR_CMP_F32(cmpeq, ==)
+XR_SIMD_SCALAR_CMP_F32(cmplt, <)
+XR_SIMD_SCALAR_CMP_F32(cmple, <=)
+XR_SIMD_SCALAR_CMP_F32(cmpgt, >)
+XR_SIMD_SCALAR_CMP_F32(cmpge, >=)
+XR_SIMD_SCALAR_CMP_INT(cmpeq, vi32, int32_t, ==)
+XR_SIMD_SCALAR_CMP_INT(cmpgt, vi32, int32_t, >)
+XR_SIMD_SCALAR_CMP_INT(cmplt, vi32, int32_t, <)
+XR_SIMD_SCALAR_CMP_INT(cmpeq, vi16, int16_t, ==)
+XR_SIMD_SCALAR_CMP_INT(cmpgt, vi16, int16_t, >)
+XR_SIMD_SCALAR_CMP_INT(cmplt, vi16, int16_t, <)
+XR_SIMD_SCALAR_CMP_INT(cmpeq, vu16, uint16_t, ==)
+XR_SIMD_SCALAR_CMP_INT(cmpgt, vu16, uint16_t, >)
+XR_SIMD_SCALAR_CMP_INT(cmpeq, vu8, uint8_t, ==)
+XR_SIMD_SCALAR_CMP_INT(cmpgt, vu8, uint8_t, >)
+
+// mask ? a : b per bit, NEON vbsl
+inline vf32 select(vf32 mask, vf32 a, vf32 b) { return bit_or(bit_and(mask, a), bit_andnot(b, mask)); }
+inline vi32 select(vi32 mask, vi32 a, vi32 b) { return bit_or(bit_and(mask, a), bit_andnot(b, mask)); }
+inline vi16 select(vi16 mask, vi16 a, vi16 b) { return bit_or(bit_and(mask, a), bit_andnot(b, mask)); }
+inline vu16 select(vu16 mask, vu16 a, vu16 b) { return bit_or(bit_and(mask, a), bit_andnot(b, mask)); }
+inline vu8 select(vu8 mask, vu8 a, vu8 b) { return bit_or(bit_and(mask, a), bit_andnot(b, mask)); }
+
+// ---------------------------------------------------------------- conversion
+
+inline vf32 cvt_f32(vi32 a) { XR_SIMD_SCALAR_MAP1(vf32, (float)a.v[i]); }
+// round to nearest even; out-of-range inputs are backend specific
+inline vi32 cvt_i32(vf32 a) { XR_SIMD_SCALAR_MAP1(vi32, (int32_t)std::nearbyint(a.v[i])); }
+// truncate toward zero
+inline vi32 cvtt_i32(vf32 a) { XR_SIMD_SCALAR_MAP1(vi32, (int32_t)a.v[i]); }
+
+// vf32::N IEEE halves <-> floats, round to nearest even, F16C vcvtph2ps /
+// vcvtps2ph and NEON vcvt_f32_f16 / vcvt_f16_f32
+inline vf32 load_f16(const uint16_t* p) { XR_SIMD_SCALAR_MAP1(vf32, f16_to_f32(p[i])); }
+inline void store_f16(uint16_t* p, vf32 a) {
+  for (int i = 0; i < vf32::N; i++) p[i] = f32_to_f16(a.v[i]);
+}
+
+// Two adjacent bytes per lane: lane i = p[off[i]] | p[off[i] + 1] << 8.
+inline vi32 gather_u16(const uint8_t* p, vi32 off) { XR_SIMD_SCALAR_MAP1(vi32, p[off.v[i]] | p[off.v[i] + 1] << 8); }
+
+// Bit reinterpretation between types of the same width, NEON vreinterpretq.
+template <typename To, typename From>
+inline To bitcast(From a) {
+  static_assert(sizeof(To) == sizeof(From), "bitcast needs equal vector sizes");
+  To r;
+  std::memcpy(&r, &a, sizeof(r));
+  return r;
+}
+
+inline vf32 as_f32(vi32 a) { return bitcast<vf32>(a); }
+inline vi32 as_i32(vf32 a) { return bitcast<vi32>(a); }
+inline vi32 as_i32(vu16 a) { return bitcast<vi32>(a); }
+inline vu16 as_u16(vi32 a) { return bitcast<vu16>(a); }
+inline vu16 as_u16(vi16 a) { return bitcast<vu16>(a); }
+inline vu16 as_u16(vu8 a) { return bitcast<vu16>(a); }
+inline vi16 as_i16(vu16 a) { return bitcast<vi16>(a); }
+inline vi16 as_i16(vu8 a) { return bitcast<vi16>(a); }
+inline vu8 as_u8(vu16 a) { return bitcast<vu8>(a); }
+inline vu8 as_u8(vi16 a) { return bitcast<vu8>(a); }
+inline vu8 as_u8(vi8 a) { return bitcast<vu8>(a); }
+inline vi8 as_i8(vu8 a) { return bitcast<vi8>(a); }
+
+// Widen the low / high half, NEON vmovl.
+#define XR_SIMD_SCALAR_WIDEN(Out, In, T)                                           \
+  inline Out widen_lo(In a) { XR_SIMD_SCALAR_MAP1(Out, (T)a.v[i]); }               \
+  inline Out widen_hi(In a) { XR_SIMD_SCALAR_MAP1(Out, (T)a.v[i + Out::N]); }
+
+XR_SIMD_SCALAR_WIDEN(vu16, vu8, uint16_t)
+XR_SIMD_SCALAR_WIDEN(vi16, vi8, int16_t)
+XR_SIMD_SCALAR_WIDEN(vi32, vi16, int32_t)
+XR_SIMD_SCALAR_WIDEN(vi32, vu16, int32_t)
+
+// Saturating narrow of two vectors into one: a fills the low half, b the
+// high half (NEON vqmovn / vqmovun followed by vcombine).
+#define XR_SIMD_SCALAR_NARROW(name, Out, In, T, lo, hi)                                        \
+  inline Out name(In a, In b) {                                                                \
+    Out r;                                                                                     \
+    for (int i = 0; i < In::N; i++) {                                                          \
+      r.v[i] = detail::sat<T>(a.v[i], lo, hi);                                                 \
+      r.v[i + In::N] = detail::sat<T>(b.v[i], lo, hi);                                         \
+    }                                                                                          \
+    return r;                                                                                  \
+  }
+
+XR_SIMD_SCALAR_NARROW(narrow_sat_u8, vu8, vi16, uint8_t, 0, UINT8_MAX)
+XR_SIMD_SCALAR_NARROW(narrow_sat_u8, vu8, vu16, uint8_t, 0, UINT8_MAX)
+XR_SIMD_SCALAR_NARROW(narrow_sat_i8, vi8, vi16, int8_t, INT8_MIN, INT8_MAX)
+XR_SIMD_SCALAR_NARROW(narrow_sat_i16, vi16, vi32, int16_t, INT16_MIN, INT16_MAX)
+XR_SIMD_SCALAR_NARROW(narrow_sat_u16, vu16, vi32, uint16_t, 0, UINT16_MAX)
+
+// ---------------------------------------------------------------- permute
+
+// Interleave the low / high halves of a and b across the whole vector:
+// zip_lo = a0 b0 a1 b1 ..., NEON vzip1q / vzip2q.
+// Deinterleave the concatenation a:b: unzip_even = a0 a2 ... b0 b2 ...,
+// NEON vuzp1q / vuzp2q.
+#define XR_SIMD_SCALAR_PERMUTE(V)                               \
+  inline V zip_lo(V a, V b) {                                   \
+    V r;                                                        \
+    for (int i = 0; i < V::N / 2; i++) {                        \
+      r.v[2 * i] = a.v[i];                                      \
+      r.v[2 * i + 1] = b.v[i];                                  \
+    }                                                           \
+    return r;                                                   \
+  }                                                             \
+  inline V zip_hi(V a, V b) {                                   \
+    V r;                                                        \
+    for (int i = 0; i < V::N / 2; i++) {                        \
+      r.v[2 * i] = a.v[i + V::N / 2];                           \
+      r.v[2 * i + 1] = b.v[i + V::N / 2];                       \
+    }                                                           \
+    return r;                                                   \
+  }                                                             \
+  inline V unzip_even(V a, V b) {                               \
+    V r;                                                        \
+    for (int i = 0; i < V::N / 2; i++) {                        \
+      r.v[i] = a.v[2 * i];                                      \
+      r.v[i + V::N / 2] = b.v[2 * i];                           \
+    }                                                           \
+    return r;                                                   \
+  }                                                             \
+  inline V unzip_odd(V a, V b) {                                \
+    V r;                                                        \
+    for (int i = 0; i < V::N / 2; i++) {                        \
+      r.v[i] = a.v[2 * i + 1];                                  \
+      r.v[i + V::N / 2] = b.v[2 * i + 1];                       \
+    }                                                           \
+    return r;                                                   \
+  }
+
+XR_SIMD_SCALAR_PERMUTE(vf32)
+XR_SIMD_SCALAR_PERMUTE(vi32)
+XR_SIMD_SCALAR_PERMUTE(vi16)
+XR_SIMD_SCALAR_PERMUTE(vu16)
+XR_SIMD_SCALAR_PERMUTE(vu8)
+
+// ---------------------------------------------------------------- structure load / store
+
+// load3 splits 3 * N interleaved bytes (RGBRGB...) into one vector per channel
+// and store3 interleaves them back, NEON vld3q / vst3q; load4 / store4 do the
+// same for 4 channels. No alignment needed.
+
+inline vu8x3 load3(const uint8_t* p) {
+  vu8x3 r;
+  for (int i = 0; i < vu8::N; i++) {
+    for (int c = 0; c < 3; c++) r.v[c].v[i] = p[3 * i + c];
+  }
+  return r;
+}
+inline vu8x4 load4(const uint8_t* p) {
+  vu8x4 r;
+  for (int i = 0; i < vu8::N; i++) {
+    for (int c = 0; c < 4; c++) r.v[c].v[i] = p[4 * i + c];
+  }
+  return r;
+}
+inline void store3(uint8_t* p, vu8x3 a) {
+  for (int i = 0; i < vu8::N; i++) {
+    for (int c = 0; c < 3; c++) p[3 * i + c] = a.v[c].v[i];
+  }
+}
+inline void store4(uint8_t* p, vu8x4 a) {
+  for (int i = 0; i < vu8::N; i++) {
+    for (int c = 0; c < 4; c++) p[4 * i + c] = a.v[c].v[i];
+  }
+}
+
+// ---------------------------------------------------------------- reduction
+
+// The float reductions use a pairwise tree whose order is backend specific.
+inline float reduce_add(vf32 a) { return (a.v[0] + a.v[2]) + (a.v[1] + a.v[3]); }
+inline int32_t reduce_add(vi32 a) { return (int32_t)((uint32_t)a.v[0] + a.v[1] + a.v[2] + a.v[3]); }
+inline float reduce_min(vf32 a) { return std::min(std::min(a.v[0], a.v[1]), std::min(a.v[2], a.v[3])); }
+inline float reduce_max(vf32 a) { return std::max(std::max(a.v[0], a.v[1]), std::max(a.v[2], a.v[3])); }
+
+#undef XR_SIMD_SCALAR_MAP1
+#undef XR_SIMD_SCALAR_BINARY
+#undef XR_SIMD_SCALAR_ALL_INT
+#undef XR_SIMD_SCALAR_CMP_F32
+#undef XR_SIMD_SCALAR_CMP_INT
+#undef XR_SIMD_SCALAR_WIDEN
+#undef XR_SIMD_SCALAR_NARROW
+#undef XR_SIMD_SCALAR_PERMUTE
+
+}  // namespace scalar
+}  // namespace simd
+}  // namespace xr